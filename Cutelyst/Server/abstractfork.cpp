@@ -17,6 +17,15 @@ AbstractFork::AbstractFork(QObject *parent)
 {
 }
 
+void AbstractFork::workerReady()
+{
+}
+
+void AbstractFork::counters(QVariantMap &counters) const
+{
+    Q_UNUSED(counters)
+}
+
 void AbstractFork::setTouchReload(const QStringList &paths)
 {
     m_touchReloadPaths = paths;
@@ -6,6 +6,7 @@
 #define ABSTRACTFORK_H
 
 #include <QObject>
+#include <QVariantMap>
 
 class QTimer;
 class QFileSystemWatcher;
@@ -44,6 +45,16 @@ public:
      */
     virtual void restart() = 0;
 
+    /**
+     * Called on worker processes once all their engines are accepting connections
+     */
+    virtual void workerReady();
+
+    /**
+     * Adds the counters of the process management, like the workers ready to take requests
+     */
+    virtual void counters(QVariantMap &counters) const;
+
     void setTouchReload(const QStringList &paths);
 
     void installTouchReload();
@@ -52,6 +63,8 @@ public:
 Q_SIGNALS:
     void forked(int workerId);
     void shutdown();
+    // Log files were moved, like by logrotate
+    void reopenLogs();
 
 protected:
     void fileChanged(const QString &path);
@@ -0,0 +1,461 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "accesslog.h"
+
+#include <Cutelyst/Context>
+#include <Cutelyst/Response>
+#include <Cutelyst/enginerequest.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QIODevice>
+
+using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+constexpr auto FlushInterval = std::chrono::milliseconds{100};
+
+static_assert(std::has_single_bit(AccessLogBuffer::Capacity));
+
+struct Variable {
+    QLatin1StringView name;
+    AccessLogField::Type type;
+};
+
+constexpr Variable Variables[] = {
+    {"remote_addr"_L1, AccessLogField::Type::RemoteAddr},
+    {"remote_port"_L1, AccessLogField::Type::RemotePort},
+    {"remote_user"_L1, AccessLogField::Type::RemoteUser},
+    {"time_local"_L1, AccessLogField::Type::TimeLocal},
+    {"time_iso8601"_L1, AccessLogField::Type::TimeIso8601},
+    {"msec"_L1, AccessLogField::Type::Msec},
+    {"request"_L1, AccessLogField::Type::Request},
+    {"request_method"_L1, AccessLogField::Type::RequestMethod},
+    {"request_uri"_L1, AccessLogField::Type::RequestUri},
+    {"uri"_L1, AccessLogField::Type::Uri},
+    {"args"_L1, AccessLogField::Type::Args},
+    {"query_string"_L1, AccessLogField::Type::Args},
+    {"server_protocol"_L1, AccessLogField::Type::ServerProtocol},
+    {"status"_L1, AccessLogField::Type::Status},
+    {"body_bytes_sent"_L1, AccessLogField::Type::BodyBytesSent},
+    {"request_length"_L1, AccessLogField::Type::RequestLength},
+    {"request_time"_L1, AccessLogField::Type::RequestTime},
+    {"upstream_response_time"_L1, AccessLogField::Type::UpstreamResponseTime},
+    {"host"_L1, AccessLogField::Type::Host},
+    {"pid"_L1, AccessLogField::Type::Pid},
+};
+
+// Escapes like nginx does, so that a line can't be forged by the client
+void appendEscaped(QByteArray &line, QByteArrayView value)
+{
+    if (value.isEmpty()) {
+        line.append('-');
+        return;
+    }
+
+    constexpr char hex[] = "0123456789ABCDEF";
+    for (const char ch : value) {
+        const auto byte = quint8(ch);
+        if (byte < 0x20 || byte >= 0x7f || ch == '"' || ch == '\\') {
+            const char escaped[] = {'\\', 'x', hex[byte >> 4], hex[byte & 0xf]};
+            line.append(escaped, sizeof(escaped));
+        } else {
+            line.append(ch);
+        }
+    }
+}
+
+// Seconds with a milliseconds resolution
+void appendSeconds(QByteArray &line, std::chrono::nanoseconds elapsed)
+{
+    const auto msecs = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+    line.append(QByteArray::number(msecs / 1000));
+    line.append('.');
+    const auto fraction = msecs % 1000;
+    line.append(fraction < 10 ? "00" : fraction < 100 ? "0" : "");
+    line.append(QByteArray::number(fraction));
+}
+
+// Formatting the time is slow, a thread formats it once a second
+struct TimeCache {
+    qint64 second = -1;
+    QByteArray local;
+    QByteArray iso8601;
+
+    void update(std::chrono::system_clock::duration sinceEpoch)
+    {
+        const qint64 now = std::chrono::duration_cast<std::chrono::seconds>(sinceEpoch).count();
+        if (now == second) {
+            return;
+        }
+        second = now;
+
+        const QDateTime time = QDateTime::fromSecsSinceEpoch(now);
+        const int offset     = qAbs(time.offsetFromUtc()) / 60;
+
+        // Month names of the C locale, like 10/Oct/2000:13:55:36 -0700
+        local = time.toString(u"dd/MMM/yyyy:HH:mm:ss "_s).toLatin1();
+        local.append(time.offsetFromUtc() < 0 ? '-' : '+');
+        local.append(QByteArray::number(offset / 60).rightJustified(2, '0'));
+        local.append(QByteArray::number(offset % 60).rightJustified(2, '0'));
+
+        iso8601 = time.toString(Qt::ISODate).toLatin1();
+    }
+};
+
+thread_local TimeCache timeCache;
+} // namespace
+
+AccessLogBuffer::AccessLogBuffer(AccessLog *log)
+    : m_data(std::make_unique<char[]>(Capacity))
+    , m_log(log)
+{
+}
+
+void AccessLogBuffer::log(EngineRequest *request)
+{
+    Context *c = request->context;
+    if (!c) {
+        return;
+    }
+
+    const auto now        = std::chrono::steady_clock::now();
+    const auto sinceEpoch = std::chrono::system_clock::now().time_since_epoch();
+    Response *response    = c->response();
+
+    QByteArray &line = m_line;
+    line.resize(0);
+    for (const AccessLogField &field : m_log->m_fields) {
+        switch (field.type) {
+        case AccessLogField::Type::Text:
+            line.append(field.text);
+            break;
+        case AccessLogField::Type::RemoteAddr:
+            line.append(request->remoteAddress.toString().toLatin1());
+            break;
+        case AccessLogField::Type::RemotePort:
+            line.append(QByteArray::number(request->remotePort));
+            break;
+        case AccessLogField::Type::RemoteUser:
+            appendEscaped(line, request->remoteUser.toUtf8());
+            break;
+        case AccessLogField::Type::TimeLocal:
+            timeCache.update(sinceEpoch);
+            line.append(timeCache.local);
+            break;
+        case AccessLogField::Type::TimeIso8601:
+            timeCache.update(sinceEpoch);
+            line.append(timeCache.iso8601);
+            break;
+        case AccessLogField::Type::Msec:
+            appendSeconds(line, sinceEpoch);
+            break;
+        case AccessLogField::Type::Request:
+            appendEscaped(line, request->method);
+            line.append(' ');
+            [[fallthrough]];
+        case AccessLogField::Type::RequestUri:
+            appendEscaped(line, request->path.toUtf8());
+            if (!request->query.isEmpty()) {
+                line.append('?');
+                appendEscaped(line, request->query);
+            }
+            if (field.type == AccessLogField::Type::Request) {
+                line.append(' ');
+                appendEscaped(line, request->protocol);
+            }
+            break;
+        case AccessLogField::Type::RequestMethod:
+            appendEscaped(line, request->method);
+            break;
+        case AccessLogField::Type::Uri:
+            appendEscaped(line, request->path.toUtf8());
+            break;
+        case AccessLogField::Type::Args:
+            appendEscaped(line, request->query);
+            break;
+        case AccessLogField::Type::ServerProtocol:
+            appendEscaped(line, request->protocol);
+            break;
+        case AccessLogField::Type::Status:
+            line.append(QByteArray::number(response->status()));
+            break;
+        case AccessLogField::Type::BodyBytesSent:
+            line.append(QByteArray::number(qMax<qint64>(response->size(), 0)));
+            break;
+        case AccessLogField::Type::RequestLength:
+            line.append(QByteArray::number(request->body ? request->body->size() : 0));
+            break;
+        case AccessLogField::Type::RequestTime:
+            appendSeconds(line, now - request->startOfRequest);
+            break;
+        case AccessLogField::Type::UpstreamResponseTime:
+            if (request->startOfProcessing == TimePointSteady{}) {
+                line.append('-');
+            } else {
+                appendSeconds(line, now - request->startOfProcessing);
+            }
+            break;
+        case AccessLogField::Type::Host:
+        {
+            const QByteArray host = request->headers.host();
+            appendEscaped(line, host.isEmpty() ? request->serverAddress : host);
+        } break;
+        case AccessLogField::Type::Pid:
+            line.append(QByteArray::number(QCoreApplication::applicationPid()));
+            break;
+        case AccessLogField::Type::HttpHeader:
+            appendEscaped(line, request->headers.header(field.text));
+            break;
+        case AccessLogField::Type::SentHttpHeader:
+            appendEscaped(line, response->headers().header(field.text));
+            break;
+        }
+    }
+    line.append('\n');
+
+    if (push(line)) {
+        m_lines.store(m_lines.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    } else {
+        m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
+
+bool AccessLogBuffer::push(const QByteArray &line)
+{
+    const auto len    = size_t(line.size());
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    const size_t used = head - m_tail.load(std::memory_order_acquire);
+    if (Capacity - used < len) {
+        m_log->wake();
+        return false;
+    }
+
+    const size_t offset = head & (Capacity - 1);
+    const size_t first  = std::min(len, Capacity - offset);
+    std::memcpy(m_data.get() + offset, line.constData(), first);
+    std::memcpy(m_data.get(), line.constData() + first, len - first);
+    m_head.store(head + len, std::memory_order_release);
+
+    if (used + len > Capacity / 2) {
+        m_log->wake();
+    }
+    return true;
+}
+
+void AccessLogBuffer::drain(QByteArray &batch)
+{
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    const size_t len  = m_head.load(std::memory_order_acquire) - tail;
+    if (!len) {
+        return;
+    }
+
+    const size_t offset = tail & (Capacity - 1);
+    const size_t first  = std::min(len, Capacity - offset);
+    batch.append(m_data.get() + offset, qsizetype(first));
+    batch.append(m_data.get(), qsizetype(len - first));
+    m_tail.store(tail + len, std::memory_order_release);
+}
+
+AccessLog::AccessLog(const QString &path, const std::vector<AccessLogField> &fields)
+    : m_fields(fields)
+    , m_file(path)
+{
+}
+
+AccessLog::~AccessLog()
+{
+    stop();
+}
+
+bool AccessLog::parseFormat(const QString &format,
+                            std::vector<AccessLogField> &fields,
+                            QString *error)
+{
+    fields.clear();
+
+    const auto isNameChar = [](QChar ch) {
+        return (ch >= u'a' && ch <= u'z') || (ch >= u'0' && ch <= u'9') || ch == u'_';
+    };
+
+    QString text;
+    qsizetype pos = 0;
+    while (pos < format.size()) {
+        const QChar ch = format.at(pos);
+        if (ch != u'$') {
+            text.append(ch);
+            ++pos;
+            continue;
+        }
+
+        // Both $name and ${name}, the later to have it followed by name characters
+        const bool braced     = pos + 1 < format.size() && format.at(pos + 1) == u'{';
+        qsizetype end         = pos + (braced ? 2 : 1);
+        const qsizetype begin = end;
+        while (end < format.size() && isNameChar(format.at(end))) {
+            ++end;
+        }
+        const QString name = format.mid(begin, end - begin);
+        if (braced) {
+            if (end == format.size() || format.at(end) != u'}') {
+                *error = format.mid(pos, end - pos);
+                return false;
+            }
+            ++end;
+        }
+
+        AccessLogField field;
+        if (name.startsWith("http_"_L1) && name.size() > 5) {
+            field.type = AccessLogField::Type::HttpHeader;
+            field.text = name.mid(5).replace(u'_', u'-').toLatin1();
+        } else if (name.startsWith("sent_http_"_L1) && name.size() > 10) {
+            field.type = AccessLogField::Type::SentHttpHeader;
+            field.text = name.mid(10).replace(u'_', u'-').toLatin1();
+        } else {
+            const auto it = std::ranges::find_if(
+                Variables, [&name](const Variable &variable) { return variable.name == name; });
+            if (it == std::end(Variables)) {
+                *error = format.mid(pos, end - pos);
+                return false;
+            }
+            field.type = it->type;
+        }
+
+        if (!text.isEmpty()) {
+            fields.push_back({AccessLogField::Type::Text, std::exchange(text, {}).toUtf8()});
+        }
+        fields.push_back(std::move(field));
+        pos = end;
+    }
+
+    if (!text.isEmpty()) {
+        fields.push_back({AccessLogField::Type::Text, text.toUtf8()});
+    }
+    return true;
+}
+
+bool AccessLog::start(int threads)
+{
+    if (!open()) {
+        return false;
+    }
+
+    for (int i = 0; i < threads; ++i) {
+        m_buffers.push_back(std::make_unique<AccessLogBuffer>(this));
+    }
+    m_thread = std::thread(&AccessLog::run, this);
+    return true;
+}
+
+AccessLogBuffer *AccessLog::buffer(int workerCore) const
+{
+    return m_buffers.at(size_t(workerCore)).get();
+}
+
+void AccessLog::stop()
+{
+    if (!m_thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wakeup.notify_one();
+    m_thread.join();
+}
+
+void AccessLog::reopen()
+{
+    m_reopen.store(true, std::memory_order_relaxed);
+    std::lock_guard lock(m_mutex);
+    m_wakeup.notify_one();
+}
+
+void AccessLog::counters(QVariantMap &counters) const
+{
+    quint64 lines   = 0;
+    quint64 dropped = 0;
+    for (const auto &buffer : m_buffers) {
+        lines += buffer->lines();
+        dropped += buffer->dropped();
+    }
+    counters.insert(u"access_log_lines"_s, lines);
+    counters.insert(u"access_log_dropped"_s, dropped);
+}
+
+void AccessLog::wake()
+{
+    if (!m_wake.exchange(true, std::memory_order_relaxed)) {
+        std::lock_guard lock(m_mutex);
+        m_wakeup.notify_one();
+    }
+}
+
+bool AccessLog::open()
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered)) {
+        std::cerr << "Failed to open access log file " << qPrintable(m_file.fileName()) << ": "
+                  << qPrintable(m_file.errorString()) << '\n';
+        return false;
+    }
+    return true;
+}
+
+void AccessLog::run()
+{
+    QByteArray batch;
+    quint64 reportedDropped = 0;
+
+    std::unique_lock lock(m_mutex);
+    bool stop = false;
+    while (!stop) {
+        m_wakeup.wait_for(lock, FlushInterval, [this] {
+            return m_stop || m_wake.load(std::memory_order_relaxed) ||
+                   m_reopen.load(std::memory_order_relaxed);
+        });
+        stop = m_stop;
+        lock.unlock();
+
+        m_wake.store(false, std::memory_order_relaxed);
+        if (m_reopen.exchange(false, std::memory_order_relaxed)) {
+            m_file.close();
+            open();
+        }
+
+        for (const auto &buffer : m_buffers) {
+            buffer->drain(batch);
+        }
+
+        // A single write per batch, so that lines of other workers are not interleaved
+        if (!batch.isEmpty() && m_file.isOpen() && m_file.write(batch) != batch.size()) {
+            std::cerr << "Failed to write access log file " << qPrintable(m_file.fileName())
+                      << ": " << qPrintable(m_file.errorString()) << '\n';
+        }
+        // Keeps the capacity for the next batch
+        batch.resize(0);
+
+        quint64 dropped = 0;
+        for (const auto &buffer : m_buffers) {
+            dropped += buffer->dropped();
+        }
+        if (dropped != reportedDropped) {
+            std::cerr << "Access log buffer full, dropped " << (dropped - reportedDropped)
+                      << " lines" << '\n';
+            reportedDropped = dropped;
+        }
+
+        lock.lock();
+    }
+}
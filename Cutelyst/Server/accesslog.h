@@ -0,0 +1,175 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVariantMap>
+
+namespace Cutelyst {
+
+class AccessLog;
+class EngineRequest;
+
+/**
+ * Part of an access log format, either literal text or a variable.
+ */
+struct AccessLogField {
+    enum class Type : quint8 {
+        Text,
+        RemoteAddr,
+        RemotePort,
+        RemoteUser,
+        TimeLocal,
+        TimeIso8601,
+        Msec,
+        Request,
+        RequestMethod,
+        RequestUri,
+        Uri,
+        Args,
+        ServerProtocol,
+        Status,
+        BodyBytesSent,
+        RequestLength,
+        RequestTime,
+        UpstreamResponseTime,
+        Host,
+        Pid,
+        HttpHeader,
+        SentHttpHeader,
+    };
+
+    Type type;
+    // The text, or the header name of HttpHeader and SentHttpHeader
+    QByteArray text;
+};
+
+/**
+ * Lines logged by an engine thread, a ring of bytes with a single producer, the engine
+ * thread, and a single consumer, the writer thread of the AccessLog.
+ */
+class AccessLogBuffer
+{
+public:
+    explicit AccessLogBuffer(AccessLog *log);
+
+    /**
+     * Formats and queues the line of \a request once its response is finished.
+     * The line is dropped when the buffer is full.
+     */
+    void log(EngineRequest *request);
+
+    /**
+     * Appends the queued lines to \a batch, only called by the writer thread.
+     */
+    void drain(QByteArray &batch);
+
+    [[nodiscard]] quint64 lines() const noexcept
+    {
+        return m_lines.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] quint64 dropped() const noexcept
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    static constexpr size_t Capacity = 1024 * 1024;
+
+private:
+    bool push(const QByteArray &line);
+
+    std::unique_ptr<char[]> m_data;
+    AccessLog *m_log;
+    // Scratch line, reused to avoid allocating for every request
+    QByteArray m_line;
+    // Only written by the engine thread
+    alignas(64) std::atomic<size_t> m_head{0};
+    std::atomic<quint64> m_lines{0};
+    std::atomic<quint64> m_dropped{0};
+    // Only written by the writer thread
+    alignas(64) std::atomic<size_t> m_tail{0};
+};
+
+/**
+ * Access log of a worker process, each engine thread formats its lines into its own
+ * AccessLogBuffer and a background thread writes the lines of all of them in batches,
+ * so that requests never wait for the disk.
+ *
+ * The format uses nginx like variables, like <tt>$remote_addr "$request" $status</tt>.
+ */
+class AccessLog
+{
+public:
+    /**
+     * Combined log format of nginx and Apache, used when no format is set.
+     */
+    static constexpr auto DefaultFormat = "$remote_addr - $remote_user [$time_local] \"$request\" "
+                                          "$status $body_bytes_sent \"$http_referer\" "
+                                          "\"$http_user_agent\"";
+
+    AccessLog(const QString &path, const std::vector<AccessLogField> &fields);
+    ~AccessLog();
+
+    /**
+     * Parses \a format into \a fields, returns false and sets \a error to the unknown
+     * variable if it is invalid.
+     */
+    static bool
+        parseFormat(const QString &format, std::vector<AccessLogField> &fields, QString *error);
+
+    /**
+     * Opens the file and starts the writer thread with a buffer for each of
+     * the \a threads engine threads, returns false if the file can't be written.
+     */
+    bool start(int threads);
+
+    /**
+     * Returns the buffer of the engine thread \a workerCore.
+     */
+    AccessLogBuffer *buffer(int workerCore) const;
+
+    /**
+     * Writes the lines still queued and stops the writer thread.
+     */
+    void stop();
+
+    /**
+     * Makes the writer thread reopen the file, after it was moved by logrotate.
+     */
+    void reopen();
+
+    [[nodiscard]] const std::vector<AccessLogField> &fields() const noexcept { return m_fields; }
+
+    void counters(QVariantMap &counters) const;
+
+private:
+    friend class AccessLogBuffer;
+
+    // Wakes the writer up before its next flush, when a buffer is filling up
+    void wake();
+    void run();
+    bool open();
+
+    std::vector<AccessLogField> m_fields;
+    std::vector<std::unique_ptr<AccessLogBuffer>> m_buffers;
+    QFile m_file;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::atomic<bool> m_wake{false};
+    std::atomic<bool> m_reopen{false};
+    bool m_stop = false;
+};
+
+} // namespace Cutelyst
@@ -0,0 +1,139 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "fastcgiwriter.h"
+
+#include <QIODevice>
+
+using namespace Cutelyst;
+
+namespace {
+
+constexpr auto FCGI_VERSION_1        = 1;
+constexpr auto FCGI_END_REQUEST      = 3;
+constexpr auto FCGI_STDOUT           = 6;
+constexpr auto FCGI_REQUEST_COMPLETE = 0;
+
+constexpr char Padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+inline quint8 paddingLength(quint16 len)
+{
+    return quint8(((len + 7) & ~7) - len);
+}
+
+inline QByteArray &scratchBuffer()
+{
+    static thread_local QByteArray buffer = ([]() -> QByteArray {
+        QByteArray ret;
+        ret.reserve(FastCGIWriter::CoalesceSize + 1024);
+        return ret;
+    }());
+    return buffer;
+}
+
+inline void appendHeader(QByteArray &buffer, quint8 type, quint16 requestId, quint16 len)
+{
+    const char header[8] = {
+        char(FCGI_VERSION_1),
+        char(type),
+        char(requestId >> 8),
+        char(requestId),
+        char(len >> 8),
+        char(len),
+        char(paddingLength(len)),
+        0,
+    };
+    buffer.append(header, sizeof(header));
+}
+
+inline void appendEndRequest(QByteArray &buffer, quint16 requestId, quint8 protocolStatus)
+{
+    // appStatus is always 0
+    const char body[8] = {0, 0, 0, 0, char(protocolStatus), 0, 0, 0};
+    appendHeader(buffer, FCGI_END_REQUEST, requestId, sizeof(body));
+    buffer.append(body, sizeof(body));
+}
+
+// Writes what was assembled so far, the buffer is always left empty for the next caller
+inline bool flush(QIODevice *io, QByteArray &buffer)
+{
+    if (buffer.isEmpty()) {
+        return true;
+    }
+    const bool ret = io->write(buffer) == buffer.size();
+    buffer.resize(0);
+    return ret;
+}
+
+inline bool appendContent(QIODevice *io, QByteArray &buffer, const char *data, qsizetype len)
+{
+    if (len < FastCGIWriter::CoalesceSize) {
+        buffer.append(data, len);
+        return true;
+    }
+    return flush(io, buffer) && io->write(data, len) == len;
+}
+
+} // namespace
+
+bool FastCGIWriter::writeRecord(QIODevice *io,
+                                quint8 type,
+                                quint16 requestId,
+                                const char *data,
+                                quint16 len)
+{
+    QByteArray &buffer = scratchBuffer();
+    appendHeader(buffer, type, requestId, len);
+    if (!appendContent(io, buffer, data, len)) {
+        return false;
+    }
+    buffer.append(Padding, paddingLength(len));
+    return flush(io, buffer);
+}
+
+bool FastCGIWriter::writeEndRequest(QIODevice *io, quint16 requestId, quint8 protocolStatus)
+{
+    QByteArray &buffer = scratchBuffer();
+    appendEndRequest(buffer, requestId, protocolStatus);
+    return flush(io, buffer);
+}
+
+bool FastCGIWriter::writeStdout(QIODevice *io,
+                                quint16 requestId,
+                                QByteArrayView prefix,
+                                QByteArrayView data,
+                                bool endRequest)
+{
+    QByteArray &buffer = scratchBuffer();
+
+    // An empty FCGI_STDOUT record would end the stream
+    qsizetype prefixPos = 0;
+    qsizetype dataPos   = 0;
+    while (prefixPos < prefix.size() || dataPos < data.size()) {
+        // fastcgi records are limited to 64k
+        const auto len = quint16(
+            qMin<qsizetype>(prefix.size() - prefixPos + data.size() - dataPos, 0xffff));
+        appendHeader(buffer, FCGI_STDOUT, requestId, len);
+
+        const qsizetype fromPrefix = qMin<qsizetype>(len, prefix.size() - prefixPos);
+        buffer.append(prefix.data() + prefixPos, fromPrefix);
+        prefixPos += fromPrefix;
+
+        const qsizetype fromData = len - fromPrefix;
+        if (fromData && !appendContent(io, buffer, data.data() + dataPos, fromData)) {
+            buffer.resize(0);
+            return false;
+        }
+        dataPos += fromData;
+
+        buffer.append(Padding, paddingLength(len));
+    }
+
+    if (endRequest) {
+        appendHeader(buffer, FCGI_STDOUT, requestId, 0);
+        appendEndRequest(buffer, requestId, FCGI_REQUEST_COMPLETE);
+    }
+
+    return flush(io, buffer);
+}
@@ -0,0 +1,48 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef FASTCGIWRITER_H
+#define FASTCGIWRITER_H
+
+#include <QByteArrayView>
+
+class QIODevice;
+
+namespace Cutelyst {
+
+/**
+ * Writes FastCGI records, the record header, content and padding are assembled in a
+ * single buffer so each record costs one QIODevice::write() instead of three.
+ *
+ * Contents of at least CoalesceSize bytes are written in place as copying them
+ * would cost more than the extra write calls.
+ */
+class FastCGIWriter
+{
+public:
+    static constexpr qsizetype CoalesceSize = 16 * 1024;
+
+    static bool writeRecord(QIODevice *io,
+                            quint8 type,
+                            quint16 requestId,
+                            const char *data,
+                            quint16 len);
+
+    static bool writeEndRequest(QIODevice *io, quint16 requestId, quint8 protocolStatus);
+
+    /**
+     * Writes \a prefix followed by \a data as FCGI_STDOUT records, both share records so
+     * the response headers travel with the first body bytes. When \a endRequest is set the
+     * stream is terminated and a FCGI_END_REQUEST is appended to the same write.
+     */
+    static bool writeStdout(QIODevice *io,
+                            quint16 requestId,
+                            QByteArrayView prefix,
+                            QByteArrayView data,
+                            bool endRequest);
+};
+
+} // namespace Cutelyst
+
+#endif // FASTCGIWRITER_H
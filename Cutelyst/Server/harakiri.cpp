@@ -0,0 +1,192 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "harakiri.h"
+
+#include <Cutelyst/Action>
+#include <Cutelyst/Application>
+#include <Cutelyst/Context>
+#include <Cutelyst/Request>
+
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+#include <QAbstractEventDispatcher>
+#include <QCoreApplication>
+
+#if defined(Q_OS_LINUX) && __has_include(<execinfo.h>)
+#    define HAS_BACKTRACE
+#    include <execinfo.h>
+#    include <sys/syscall.h>
+#endif
+
+using namespace Cutelyst;
+
+namespace {
+constexpr auto CheckInterval = std::chrono::seconds{1};
+constexpr int MaxFrames      = 64;
+
+qint64 monotonicMsecs()
+{
+    // Same clock in every process, so the master can compare it with the workers'
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void copyText(char *dest, const QByteArray &text)
+{
+    qstrncpy(dest, text.constData(), HarakiriSlot::TextSize);
+}
+
+#ifdef HAS_BACKTRACE
+int backtraceSignal()
+{
+    return SIGRTMIN;
+}
+
+void backtraceHandler(int)
+{
+    void *frames[MaxFrames];
+    const int count = backtrace(frames, MaxFrames);
+    backtrace_symbols_fd(frames, count, STDERR_FILENO);
+}
+#endif
+} // namespace
+
+HarakiriTracker::HarakiriTracker(HarakiriSlot *slot, Application *app, QObject *parent)
+    : QObject(parent)
+    , m_slot(slot)
+    , m_app(app)
+{
+}
+
+void HarakiriTracker::start()
+{
+    m_slot->pid = QCoreApplication::applicationPid();
+#ifdef HAS_BACKTRACE
+    m_slot->tid = qint64(syscall(SYS_gettid));
+#endif
+
+    connect(m_app, &Application::beforeDispatch, this, &HarakiriTracker::beforeDispatch);
+    connect(m_app, &Application::afterDispatch, this, &HarakiriTracker::finished);
+
+    // Async actions return to the event loop, the thread isn't stuck while they wait
+    auto dispatcher = QAbstractEventDispatcher::instance();
+    if (dispatcher) {
+        connect(dispatcher,
+                &QAbstractEventDispatcher::aboutToBlock,
+                this,
+                &HarakiriTracker::finished);
+    }
+}
+
+void HarakiriTracker::beforeDispatch(Context *c)
+{
+    m_slot->started.store(0, std::memory_order_release);
+
+    Request *request = c->request();
+    copyText(m_slot->request, request->method() + ' ' + request->path().toUtf8());
+    copyText(m_slot->action, c->action() ? c->action()->reverse().toUtf8() : QByteArray());
+
+    m_slot->started.store(monotonicMsecs(), std::memory_order_release);
+}
+
+void HarakiriTracker::finished()
+{
+    m_slot->started.store(0, std::memory_order_relaxed);
+}
+
+HarakiriMonitor::HarakiriMonitor(HarakiriSlot *table,
+                                 int count,
+                                 std::chrono::seconds timeout,
+                                 QObject *parent)
+    : QThread(parent)
+    , m_table(table)
+    , m_timeout(timeout)
+    , m_count(count)
+{
+}
+
+HarakiriMonitor::~HarakiriMonitor()
+{
+    requestInterruption();
+    wait();
+}
+
+quint64 HarakiriMonitor::reported() const
+{
+    return m_reported.load(std::memory_order_relaxed);
+}
+
+qint64 HarakiriMonitor::check(HarakiriSlot *slot, std::chrono::seconds timeout)
+{
+    const qint64 started = slot->started.load(std::memory_order_acquire);
+    if (started == 0 || started == slot->reported.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+
+    const qint64 elapsed = monotonicMsecs() - started;
+    if (elapsed < std::chrono::milliseconds{timeout}.count()) {
+        return 0;
+    }
+
+    const auto text = [](const char *data) {
+        return QByteArray(data, qsizetype(qstrnlen(data, HarakiriSlot::TextSize)));
+    };
+    const QByteArray action  = text(slot->action);
+    const QByteArray request = text(slot->request);
+    if (slot->started.load(std::memory_order_acquire) != started) {
+        // Finished, or another request started, while it was read
+        return 0;
+    }
+    slot->reported = started;
+
+    const qint64 pid = slot->pid;
+    const qint64 tid = slot->tid;
+    std::cerr << "HARAKIRI on worker pid " << pid << " thread " << tid << ": \""
+              << request.constData() << "\" (action: " << action.constData() << ") running for "
+              << elapsed / 1000 << " s" << '\n';
+
+#ifdef HAS_BACKTRACE
+    // The handler runs on the stuck thread and prints its backtrace to stderr
+    if (tid) {
+        syscall(SYS_tgkill, pid_t(pid), pid_t(tid), backtraceSignal());
+    }
+#endif
+
+    return pid;
+}
+
+void HarakiriMonitor::installBacktraceHandler()
+{
+#ifdef HAS_BACKTRACE
+    // The first call loads libgcc, which would allocate inside the signal handler
+    void *frame;
+    backtrace(&frame, 1);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(struct sigaction));
+    action.sa_handler = backtraceHandler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags |= SA_RESTART;
+    sigaction(backtraceSignal(), &action, nullptr);
+#endif
+}
+
+void HarakiriMonitor::run()
+{
+    while (!isInterruptionRequested()) {
+        for (int i = 0; i < m_count; ++i) {
+            if (check(m_table + i, m_timeout)) {
+                m_reported.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        msleep(std::chrono::milliseconds{CheckInterval}.count());
+    }
+}
+
+#include "moc_harakiri.cpp"
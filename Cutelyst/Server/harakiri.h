@@ -0,0 +1,99 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include <QObject>
+#include <QThread>
+
+namespace Cutelyst {
+
+class Application;
+class Context;
+
+/**
+ * Request an engine thread is processing, it lives in memory shared with the master
+ * which reads it to find requests running for longer than the harakiri timeout.
+ */
+struct HarakiriSlot {
+    static constexpr int TextSize = 256;
+
+    // Monotonic msecs the request started at, 0 while the thread waits for events
+    std::atomic<qint64> started{0};
+    // Last started value reported, so each request is reported once
+    std::atomic<qint64> reported{0};
+    std::atomic<qint64> pid{0};
+    std::atomic<qint64> tid{0};
+    // Only written while started is 0
+    char action[TextSize]{};
+    char request[TextSize]{};
+};
+
+/**
+ * Fills a HarakiriSlot with the requests of the application of the thread it lives in.
+ */
+class HarakiriTracker final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit HarakiriTracker(HarakiriSlot *slot, Application *app, QObject *parent = nullptr);
+
+    /**
+     * Starts tracking, it must be called from the thread of the engine.
+     */
+    void start();
+
+private:
+    void beforeDispatch(Context *c);
+    void finished();
+
+    HarakiriSlot *m_slot;
+    Application *m_app;
+};
+
+/**
+ * Checks the slots of a process that has no master to do it, from a thread of its own as
+ * the stuck threads can't.
+ */
+class HarakiriMonitor final : public QThread
+{
+    Q_OBJECT
+public:
+    explicit HarakiriMonitor(HarakiriSlot *table,
+                             int count,
+                             std::chrono::seconds timeout,
+                             QObject *parent = nullptr);
+    ~HarakiriMonitor() override;
+
+    /**
+     * Returns the number of requests reported so far.
+     */
+    quint64 reported() const;
+
+    /**
+     * Reports the request of \a slot if it is running for longer than \a timeout, logging
+     * it and making the stuck thread print its backtrace. Returns the pid of the process
+     * running it, or 0 if it was not reported.
+     */
+    static qint64 check(HarakiriSlot *slot, std::chrono::seconds timeout);
+
+    /**
+     * Makes the threads of this process print their backtrace when check() asks them.
+     */
+    static void installBacktraceHandler();
+
+protected:
+    void run() override;
+
+private:
+    HarakiriSlot *m_table;
+    std::atomic<quint64> m_reported{0};
+    std::chrono::seconds m_timeout;
+    int m_count;
+};
+
+} // namespace Cutelyst
@@ -292,7 +292,8 @@ void HPack::encodeHeaders(int status, const Headers &headers, QByteArray &buf, S
         }
     }
 
-    if (!hasDate) {
+    // Informational responses are followed by the final one which carries the Date
+    if (!hasDate && status >= 200) {
         const QByteArray date = engine->lastDate().mid(8);
         if (date.length() != 29) {
             // This should never happen but...
@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "loadmonitor.h"
+
+#include "metrics.h"
+
+#include <QAbstractEventDispatcher>
+
+using namespace Cutelyst;
+
+namespace {
+constexpr auto LagInterval = std::chrono::milliseconds{100};
+} // namespace
+
+LoadMonitor::LoadMonitor(WorkerLoad *load, MetricsRecorder *metrics, QObject *parent)
+    : QObject(parent)
+    , m_load(load)
+    , m_metrics(metrics)
+{
+    m_lagTimer.setInterval(LagInterval);
+    m_lagTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_lagTimer, &QTimer::timeout, this, &LoadMonitor::checkLag);
+}
+
+void LoadMonitor::start()
+{
+    auto dispatcher = QAbstractEventDispatcher::instance();
+    if (dispatcher && m_load) {
+        connect(dispatcher, &QAbstractEventDispatcher::awake, this, &LoadMonitor::awake);
+        connect(
+            dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, &LoadMonitor::aboutToBlock);
+    }
+
+    // Called from an event handler, so the loop is awake
+    m_busy.start();
+    m_lag.start();
+    m_lagTimer.start();
+}
+
+void LoadMonitor::awake()
+{
+    if (!m_busy.isValid()) {
+        m_busy.start();
+    }
+}
+
+void LoadMonitor::aboutToBlock()
+{
+    if (m_busy.isValid()) {
+        m_load->busyNsecs.fetch_add(m_busy.nsecsElapsed(), std::memory_order_relaxed);
+        m_busy.invalidate();
+    }
+}
+
+void LoadMonitor::checkLag()
+{
+    const qint64 lagNsecs = m_lag.nsecsElapsed() - std::chrono::nanoseconds{LagInterval}.count();
+    m_lag.start();
+
+    if (m_metrics) {
+        // Timers may fire slightly early
+        m_metrics->recordLag(quint64(qMax<qint64>(lagNsecs, 0)));
+    }
+
+    if (!m_load) {
+        return;
+    }
+
+    const qint64 lag = lagNsecs / 1000;
+    qint64 current   = m_load->maxLagUsecs.load(std::memory_order_relaxed);
+    while (lag > current &&
+           !m_load->maxLagUsecs.compare_exchange_weak(current, lag, std::memory_order_relaxed)) {
+    }
+}
+
+#include "moc_loadmonitor.cpp"
@@ -0,0 +1,59 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <atomic>
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+namespace Cutelyst {
+
+class MetricsRecorder;
+
+/**
+ * Load of a worker process, it lives in memory shared with the master which
+ * reads it to decide when to spawn or stop workers.
+ */
+struct WorkerLoad {
+    // Time all event loops of the worker spent not waiting for events
+    std::atomic<qint64> busyNsecs{0};
+    // Highest delay a timer fired with since the master last read it
+    std::atomic<qint64> maxLagUsecs{0};
+};
+
+/**
+ * Measures the event loop of the thread it lives in, the busy time comes from
+ * the dispatcher awake() and aboutToBlock() signals and the lag from a timer
+ * that should fire at a fixed interval.
+ *
+ * The load is only measured when \a load is set and the lag is also recorded in
+ * the histogram of \a metrics when it's set.
+ */
+class LoadMonitor final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LoadMonitor(WorkerLoad *load, MetricsRecorder *metrics, QObject *parent = nullptr);
+
+    /**
+     * Starts measuring, it must be called from the thread of the event loop.
+     */
+    void start();
+
+private:
+    void awake();
+    void aboutToBlock();
+    void checkLag();
+
+    WorkerLoad *m_load;
+    MetricsRecorder *m_metrics;
+    QTimer m_lagTimer;
+    QElapsedTimer m_busy;
+    QElapsedTimer m_lag;
+};
+
+} // namespace Cutelyst
@@ -70,10 +70,16 @@ void LocalServer::setProtocol(Protocol *protocol)
     m_protocol = protocol;
 }
 
+void LocalServer::setProxyProtocol(bool enable)
+{
+    m_proxyProtocol = enable;
+}
+
 LocalServer *LocalServer::createServer(ServerEngine *engine) const
 {
     auto server = new LocalServer(m_server, engine);
     server->setProtocol(m_protocol);
+    server->setProxyProtocol(m_proxyProtocol);
     server->m_engine = engine;
 
 #ifdef Q_OS_UNIX
@@ -119,6 +125,20 @@ void LocalServer::resumeAccepting()
 }
 
 void LocalServer::incomingConnection(quintptr handle)
+{
+    if (m_proxyProtocol) {
+        // A proxy in front of a local socket still knows the real client address
+        auto accept = [this](qintptr handle, const ProxyProtocol::Header &header) {
+            acceptConnection(handle, &header);
+        };
+        const std::chrono::seconds timeout{m_server->socketTimeout()};
+        ProxyProtocol::read(qintptr(handle), timeout, this, accept);
+    } else {
+        acceptConnection(qintptr(handle), nullptr);
+    }
+}
+
+void LocalServer::acceptConnection(qintptr handle, const ProxyProtocol::Header *proxy)
 {
     auto sock       = new LocalSocket(m_engine, this);
     sock->protoData = m_protocol->createData(sock);
@@ -134,10 +154,14 @@ void LocalServer::incomingConnection(quintptr handle)
         }
     });
 
-    if (Q_LIKELY(sock->setSocketDescriptor(qintptr(handle)))) {
+    if (Q_LIKELY(sock->setSocketDescriptor(handle))) {
         sock->proto = m_protocol;
 
         sock->serverAddress = "localhost"_ba;
+        if (proxy) {
+            proxy->applyTo(sock);
+            sock->protoData->setupNewConnection(sock);
+        }
         if (++m_processing) {
             m_engine->startSocketTimeout();
         }
@@ -4,6 +4,8 @@
  */
 #pragma once
 
+#include "proxyprotocol.h"
+
 #include <QLocalServer>
 
 class QSocketNotifier;
@@ -20,6 +22,7 @@ public:
     explicit LocalServer(Server *server, QObject *parent = nullptr);
 
     void setProtocol(Protocol *protocol);
+    void setProxyProtocol(bool enable);
 
     LocalServer *createServer(ServerEngine *engine) const;
 
@@ -36,6 +39,7 @@ public:
     Protocol *protocol() const;
 
 private:
+    void acceptConnection(qintptr handle, const ProxyProtocol::Header *proxy);
     QSocketNotifier *socketDescriptorNotifier() const;
 #ifdef Q_OS_UNIX
     void socketNotifierActivated();
@@ -48,6 +52,7 @@ private:
     Protocol *m_protocol = nullptr;
     qintptr m_socket     = -1;
     int m_processing     = 0;
+    bool m_proxyProtocol = false;
 };
 
 } // namespace Cutelyst
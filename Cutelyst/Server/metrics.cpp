@@ -0,0 +1,338 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "metrics.h"
+
+#include "Cutelyst/enginerequest.h"
+
+#include <Cutelyst/Action>
+#include <Cutelyst/Context>
+#include <Cutelyst/Response>
+
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <tuple>
+
+#ifdef Q_OS_UNIX
+#    include <sys/mman.h>
+#endif
+
+using namespace Cutelyst;
+
+namespace {
+const char *const ProtocolNames[] = {
+    "unknown",
+    "http/1.1",
+    "websocket",
+    "h2",
+    "fastcgi",
+    "uwsgi",
+};
+
+const char *const StatusClassNames[] = {
+    "unknown",
+    "1xx",
+    "2xx",
+    "3xx",
+    "4xx",
+    "5xx",
+};
+
+QByteArray labelValue(const char *text)
+{
+    QByteArray ret(text);
+    ret.replace('\\', "\\\\");
+    ret.replace('"', "\\\"");
+    ret.replace('\n', "\\n");
+    return ret;
+}
+
+// Histograms of every thread merged, in the OpenMetrics text format
+struct Histogram {
+    quint64 sum = 0;
+    std::array<quint64, MetricsHistogram::BucketCount> buckets{};
+
+    void add(const MetricsHistogram &histogram)
+    {
+        sum += histogram.sum.load(std::memory_order_relaxed);
+        for (int b = 0; b < MetricsHistogram::BucketCount; ++b) {
+            buckets[b] += histogram.buckets[b].load(std::memory_order_relaxed);
+        }
+    }
+
+    void render(QByteArray &out, const QByteArray &name, const QByteArray &labels) const
+    {
+        const QByteArray prefix = labels.isEmpty() ? QByteArray{} : labels + ',';
+        const QByteArray braces = labels.isEmpty() ? QByteArray{} : '{' + labels + '}';
+
+        // Counted from the buckets, so that the total always matches them
+        quint64 count = 0;
+        for (int b = 0; b < MetricsHistogram::BucketCount - 1; ++b) {
+            count += buckets[b];
+            const double le = double(MetricsHistogram::upperBound(b)) / 1e6;
+            out.append(name + "_bucket{" + prefix + "le=\"" + QByteArray::number(le, 'g', 6) +
+                       "\"} " + QByteArray::number(count) + '\n');
+        }
+        count += buckets[MetricsHistogram::BucketCount - 1];
+        out.append(name + "_bucket{" + prefix + "le=\"+Inf\"} " + QByteArray::number(count) +
+                   '\n');
+        out.append(name + "_count" + braces + ' ' + QByteArray::number(count) + '\n');
+        out.append(name + "_sum" + braces + ' ' + QByteArray::number(double(sum) / 1e9, 'g', 12) +
+                   '\n');
+    }
+};
+
+void addHistogram(MetricsHistogram &to, const MetricsHistogram &from)
+{
+    // Only the master writes the retired series
+    to.sum.store(to.sum.load(std::memory_order_relaxed) + from.sum.load(std::memory_order_relaxed),
+                 std::memory_order_relaxed);
+    for (int b = 0; b < MetricsHistogram::BucketCount; ++b) {
+        to.buckets[b].store(to.buckets[b].load(std::memory_order_relaxed) +
+                                from.buckets[b].load(std::memory_order_relaxed),
+                            std::memory_order_relaxed);
+    }
+}
+
+MetricsSeries *retiredSeries(MetricsRetired *retired, const MetricsSeries &series)
+{
+    const int used = retired->used.load(std::memory_order_relaxed);
+    for (int s = 0; s < used; ++s) {
+        MetricsSeries *ret = retired->series + s;
+        if (ret->statusClass == series.statusClass && ret->protocol == series.protocol &&
+            qstrncmp(ret->action, series.action, MetricsSeries::ActionSize) == 0) {
+            return ret;
+        }
+    }
+
+    // The last series takes every other one once they are all used
+    MetricsSeries *ret = retired->series + qMin(used, MetricsRetired::MaxSeries - 1);
+    if (used == MetricsRetired::MaxSeries - 1) {
+        qstrncpy(ret->action, "(other)", MetricsSeries::ActionSize);
+    } else if (used < MetricsRetired::MaxSeries - 1) {
+        memcpy(ret->action, series.action, MetricsSeries::ActionSize);
+        ret->statusClass = series.statusClass;
+        ret->protocol    = series.protocol;
+    }
+    if (used < MetricsRetired::MaxSeries) {
+        retired->used.store(used + 1, std::memory_order_relaxed);
+    }
+    return ret;
+}
+
+QByteArray metricName(const QString &key)
+{
+    QByteArray ret = "cutelyst_" + key.toLatin1();
+    for (char &ch : ret) {
+        if (!std::isalnum(static_cast<unsigned char>(ch)) && ch != '_') {
+            ch = '_';
+        }
+    }
+    return ret;
+}
+} // namespace
+
+quint64 MetricsHistogram::upperBound(int bucket)
+{
+    const int exponent = bucket / 2 + 3;
+    return (quint64(1) << exponent) + (quint64(bucket % 2 + 1) << (exponent - 1));
+}
+
+MetricsRecorder::MetricsRecorder(MetricsTable *table)
+    : m_table(table)
+{
+}
+
+void MetricsRecorder::record(EngineRequest *request, Protocol::Type protocol)
+{
+    Context *c = request->context;
+    if (!c) {
+        return;
+    }
+
+    const auto elapsed = std::chrono::steady_clock::now() - request->startOfRequest;
+    record(c->action(),
+           c->response()->status(),
+           protocol,
+           quint64(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+}
+
+MetricsSeries *MetricsRecorder::createSeries(const Action *action, int statusClass, int protocol)
+{
+    const int used = m_table->used.load(std::memory_order_relaxed);
+    if (used == MetricsTable::MaxSeries - 1) {
+        // The last series takes every request once the table is full
+        if (!m_overflow) {
+            m_overflow = m_table->series + used;
+            qstrncpy(m_overflow->action, "(other)", MetricsSeries::ActionSize);
+            m_table->used.store(used + 1, std::memory_order_release);
+        }
+        return m_overflow;
+    } else if (used == MetricsTable::MaxSeries) {
+        return m_overflow;
+    }
+
+    MetricsSeries *series = m_table->series + used;
+    if (action) {
+        qstrncpy(series->action, action->reverse().toUtf8().constData(), MetricsSeries::ActionSize);
+    }
+    series->statusClass = quint8(statusClass);
+    series->protocol    = quint8(protocol);
+    m_table->used.store(used + 1, std::memory_order_release);
+
+    return series;
+}
+
+Metrics::Metrics(int slots, int threads)
+    : m_size(sizeof(MetricsTable) * size_t(slots * threads) + sizeof(MetricsRetired))
+    , m_slots(slots)
+    , m_threads(threads)
+{
+#ifdef Q_OS_UNIX
+    // Shared with the worker processes, pages are only backed once a thread records into them
+    void *memory =
+        mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        std::cerr << "Failed to allocate the metrics: " << strerror(errno) << '\n';
+        return;
+    }
+#else
+    void *memory = ::operator new(m_size);
+#endif
+
+    m_tables = static_cast<MetricsTable *>(memory);
+    for (int i = 0; i < slots * threads; ++i) {
+        new (m_tables + i) MetricsTable;
+    }
+    m_retired = new (m_tables + slots * threads) MetricsRetired;
+}
+
+Metrics::~Metrics()
+{
+    if (m_tables) {
+#ifdef Q_OS_UNIX
+        munmap(m_tables, m_size);
+#else
+        ::operator delete(m_tables);
+#endif
+    }
+}
+
+void Metrics::postFork(int slot)
+{
+    if (!m_tables) {
+        return;
+    }
+
+    m_recorders.clear();
+    for (int core = 0; core < m_threads; ++core) {
+        MetricsTable *table = m_tables + slot * m_threads + core;
+        // A new worker starts counting from zero
+        new (table) MetricsTable;
+        m_recorders.emplace_back(std::make_unique<MetricsRecorder>(table));
+    }
+}
+
+void Metrics::retireSlot(int slot)
+{
+    if (!m_tables || slot < 0 || slot >= m_slots) {
+        return;
+    }
+
+    // Renders retry while it changes, so they never count a table twice or not at all
+    const quint32 sequence = m_retired->sequence.load(std::memory_order_relaxed);
+    m_retired->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (int core = 0; core < m_threads; ++core) {
+        MetricsTable *table = m_tables + slot * m_threads + core;
+        const int used      = table->used.load(std::memory_order_acquire);
+        for (int s = 0; s < used; ++s) {
+            addHistogram(*retiredSeries(m_retired, table->series[s]), table->series[s]);
+        }
+        addHistogram(m_retired->eventLoopLag, table->eventLoopLag);
+        new (table) MetricsTable;
+    }
+
+    m_retired->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+MetricsRecorder *Metrics::recorder(int workerCore) const
+{
+    if (size_t(workerCore) >= m_recorders.size()) {
+        return nullptr;
+    }
+    return m_recorders[size_t(workerCore)].get();
+}
+
+QByteArray Metrics::render(const QVariantMap &counters) const
+{
+    // Merges the series of every thread with the same labels
+    std::map<std::tuple<QByteArray, int, int>, Histogram> histograms;
+    Histogram lag;
+    const auto addSeries = [&histograms](const MetricsSeries *series, int used) {
+        for (int s = 0; s < used; ++s) {
+            const QByteArray action(
+                series[s].action, qsizetype(qstrnlen(series[s].action, MetricsSeries::ActionSize)));
+            histograms[{action, series[s].statusClass, series[s].protocol}].add(series[s]);
+        }
+    };
+
+    quint32 sequence = 0;
+    do {
+        histograms.clear();
+        lag = {};
+        if (!m_tables) {
+            break;
+        }
+
+        sequence = m_retired->sequence.load(std::memory_order_acquire);
+        addSeries(m_retired->series, m_retired->used.load(std::memory_order_relaxed));
+        lag.add(m_retired->eventLoopLag);
+        for (int i = 0; i < m_slots * m_threads; ++i) {
+            const MetricsTable &table = m_tables[i];
+            addSeries(table.series, table.used.load(std::memory_order_acquire));
+            lag.add(table.eventLoopLag);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence & 1) || m_retired->sequence.load(std::memory_order_relaxed) != sequence);
+
+    QByteArray ret;
+    ret.reserve(4096);
+    ret.append("# TYPE cutelyst_request_duration_seconds histogram\n"
+               "# UNIT cutelyst_request_duration_seconds seconds\n"
+               "# HELP cutelyst_request_duration_seconds Time from receiving a request to "
+               "finishing its response.\n");
+    for (const auto &[key, histogram] : histograms) {
+        const auto &[action, statusClass, protocol] = key;
+
+        const QByteArray labels = "action=\"" + labelValue(action.constData()) +
+                                  "\",status=\"" + StatusClassNames[statusClass] +
+                                  "\",protocol=\"" + ProtocolNames[protocol] + '"';
+        histogram.render(ret, "cutelyst_request_duration_seconds", labels);
+    }
+
+    ret.append("# TYPE cutelyst_event_loop_lag_seconds histogram\n"
+               "# UNIT cutelyst_event_loop_lag_seconds seconds\n"
+               "# HELP cutelyst_event_loop_lag_seconds Time a timer of the engine event loops "
+               "fired past its scheduled time.\n");
+    lag.render(ret, "cutelyst_event_loop_lag_seconds", {});
+
+    for (const auto &[key, value] : counters.asKeyValueRange()) {
+        bool ok;
+        const double number = value.toDouble(&ok);
+        if (!ok) {
+            continue;
+        }
+
+        const QByteArray name = metricName(key);
+        ret.append("# TYPE " + name + " unknown\n" + name + ' ' +
+                   QByteArray::number(number, 'g', 15) + '\n');
+    }
+
+    ret.append("# EOF\n");
+    return ret;
+}
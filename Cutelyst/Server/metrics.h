@@ -0,0 +1,196 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include "protocol.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <vector>
+
+#include <QByteArray>
+#include <QHash>
+#include <QVariantMap>
+
+namespace Cutelyst {
+
+class Action;
+class EngineRequest;
+
+/**
+ * Latency histogram with two buckets per power of two microseconds, like a HDR histogram
+ * with one significant bit. Only its engine thread writes it, readers merge the histograms
+ * when they are scraped.
+ */
+struct MetricsHistogram {
+    static constexpr int BucketCount = 48;
+
+    // Nanoseconds
+    std::atomic<quint64> sum{0};
+    std::atomic<quint64> buckets[BucketCount]{};
+
+    inline void record(quint64 nsecs)
+    {
+        auto &bucket = buckets[bucketOf(nsecs)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum.store(sum.load(std::memory_order_relaxed) + nsecs, std::memory_order_relaxed);
+    }
+
+    static inline int bucketOf(quint64 nsecs)
+    {
+        const quint64 usecs = nsecs / 1000;
+        if (usecs < 8) {
+            return 0;
+        }
+        const int exponent = int(std::bit_width(usecs)) - 1;
+        const int index    = (exponent - 3) * 2 + int((usecs >> (exponent - 1)) & 1);
+        return std::min(index, BucketCount - 1);
+    }
+
+    /**
+     * Returns the microseconds \a bucket counts values below of.
+     */
+    static quint64 upperBound(int bucket);
+};
+
+/**
+ * Latency histogram of the requests of an action, status class and protocol.
+ */
+struct MetricsSeries : MetricsHistogram {
+    static constexpr int ActionSize = 96;
+
+    char action[ActionSize]{};
+    quint8 statusClass = 0;
+    quint8 protocol    = 0;
+};
+
+/**
+ * Series of an engine thread, on UNIX it lives in memory shared by every worker process.
+ */
+struct MetricsTable {
+    static constexpr int MaxSeries = 128;
+
+    // Series are published by increasing it, their labels don't change after that
+    std::atomic<int> used{0};
+    MetricsSeries series[MaxSeries];
+    // How late the timer of the event loop fires
+    MetricsHistogram eventLoopLag;
+};
+
+/**
+ * Series of the worker processes that exited, the master adds their tables up here before
+ * the slots are reused, so that the exported counters never go backwards.
+ */
+struct MetricsRetired {
+    static constexpr int MaxSeries = 1024;
+
+    // Odd while the master adds a table
+    std::atomic<quint32> sequence{0};
+    std::atomic<int> used{0};
+    MetricsSeries series[MaxSeries];
+    MetricsHistogram eventLoopLag;
+};
+
+/**
+ * Records the requests of an engine thread, the series of each action are looked up in a
+ * hash local to the thread so that a request costs a lookup and a few relaxed stores.
+ */
+class MetricsRecorder
+{
+public:
+    explicit MetricsRecorder(MetricsTable *table);
+
+    /**
+     * Records \a request, that was served with \a protocol, once its response is finished.
+     */
+    void record(EngineRequest *request, Protocol::Type protocol);
+
+    /**
+     * Records a request dispatched to \a action that took \a nsecs and was answered
+     * with \a status.
+     */
+    inline void
+        record(const Action *action, quint16 status, Protocol::Type protocol, quint64 nsecs)
+    {
+        const int statusClass = status >= 100 && status < 600 ? status / 100 : 0;
+        series(action, statusClass, int(protocol))->record(nsecs);
+    }
+
+    /**
+     * Records that a timer of the event loop fired \a nsecs later than scheduled.
+     */
+    inline void recordLag(quint64 nsecs) { m_table->eventLoopLag.record(nsecs); }
+
+private:
+    static constexpr int StatusClasses = 6;
+    static constexpr int Protocols     = int(Protocol::Type::Uwsgi) + 1;
+
+    inline MetricsSeries *series(const Action *action, int statusClass, int protocol)
+    {
+        auto &byStatus      = m_series[action];
+        MetricsSeries *&ret = byStatus[statusClass * Protocols + protocol];
+        if (Q_UNLIKELY(!ret)) {
+            ret = createSeries(action, statusClass, protocol);
+        }
+        return ret;
+    }
+
+    MetricsSeries *createSeries(const Action *action, int statusClass, int protocol);
+
+    QHash<const Action *, std::array<MetricsSeries *, StatusClasses * Protocols>> m_series;
+    MetricsTable *m_table;
+    MetricsSeries *m_overflow = nullptr;
+};
+
+/**
+ * Request latency histograms of every worker process and engine thread, allocated before
+ * forking and rendered in the OpenMetrics text format.
+ *
+ * Each worker process has its own slot, handed out by the master, so that replacements
+ * don't reset the tables of the workers they replace while those still drain.
+ */
+class Metrics
+{
+public:
+    explicit Metrics(int slots, int threads);
+    ~Metrics();
+
+    /**
+     * Takes the tables of \a slot, counted from 0, in the process that runs its engines.
+     */
+    void postFork(int slot);
+
+    /**
+     * Called by the master once the worker that had \a slot exited, its tables are added to
+     * those of the previously exited workers and cleared before another worker takes them.
+     */
+    void retireSlot(int slot);
+
+    /**
+     * Returns the recorder of the engine thread \a workerCore of this worker.
+     */
+    MetricsRecorder *recorder(int workerCore) const;
+
+    /**
+     * Returns the histograms of all workers merged, followed by the numeric \a counters.
+     */
+    QByteArray render(const QVariantMap &counters) const;
+
+    static constexpr auto ContentType = "application/openmetrics-text; version=1.0.0; "
+                                        "charset=utf-8";
+
+private:
+    std::vector<std::unique_ptr<MetricsRecorder>> m_recorders;
+    MetricsTable *m_tables     = nullptr;
+    MetricsRetired *m_retired = nullptr;
+    size_t m_size;
+    int m_slots;
+    int m_threads;
+};
+
+} // namespace Cutelyst
@@ -73,7 +73,7 @@ class Protocol
 {
     Q_GADGET
 public:
-    enum class Type { Unknown, Http11, Http11Websocket, Http2, FastCGI1 };
+    enum class Type { Unknown, Http11, Http11Websocket, Http2, FastCGI1, Uwsgi };
     Q_ENUM(Type)
 
     Protocol(const Server *server);
@@ -4,6 +4,7 @@
  */
 #include "protocolfastcgi.h"
 
+#include "fastcgiwriter.h"
 #include "server.h"
 #include "socket.h"
 
@@ -14,6 +15,10 @@
 #include <QLoggingCategory>
 #include <QTemporaryFile>
 
+#ifdef Q_OS_UNIX
+#    include <sys/resource.h>
+#endif
+
 Q_LOGGING_CATEGORY(C_SERVER_FCGI, "cutelyst.server.fcgi", QtWarningMsg)
 
 namespace {
@@ -23,25 +28,34 @@ namespace {
 constexpr auto FCGI_VERSION_1 = 1;
 
 /*
- * Values for type component of FCGI_Header
+ * Values for type component of FCGI_Header,
+ * FCGI_END_REQUEST and FCGI_STDOUT are only written by FastCGIWriter
  */
-constexpr auto FCGI_BEGIN_REQUEST = 1;
-constexpr auto FCGI_PARAMS        = 4;
-constexpr auto FCGI_STDIN         = 5;
-constexpr auto FCGI_STDOUT        = 6;
+constexpr auto FCGI_BEGIN_REQUEST     = 1;
+constexpr auto FCGI_ABORT_REQUEST     = 2;
+constexpr auto FCGI_PARAMS            = 4;
+constexpr auto FCGI_STDIN             = 5;
+constexpr auto FCGI_GET_VALUES        = 9;
+constexpr auto FCGI_GET_VALUES_RESULT = 10;
+constexpr auto FCGI_UNKNOWN_TYPE      = 11;
 
 /*
  * Mask for flags component of FCGI_BeginRequestBody
  */
 constexpr auto FCGI_KEEP_CONN = 1;
 
-constexpr auto WSGI_OK    = 0;
-constexpr auto WSGI_AGAIN = 1;
-constexpr auto WSGI_BODY  = 2;
-constexpr auto WSGI_ERROR = -1;
+/*
+ * Values for role component of FCGI_BeginRequestBody
+ */
+constexpr auto FCGI_RESPONDER = 1;
 
-#define FCGI_ALIGNMENT 8
-#define FCGI_ALIGN(n) (((n) + (FCGI_ALIGNMENT - 1)) & ~(FCGI_ALIGNMENT - 1))
+/*
+ * Values for protocolStatus component of FCGI_EndRequestBody
+ */
+constexpr auto FCGI_REQUEST_COMPLETE = 0;
+constexpr auto FCGI_CANT_MPX_CONN    = 1;
+constexpr auto FCGI_OVERLOADED       = 2;
+constexpr auto FCGI_UNKNOWN_ROLE     = 3;
 
 struct fcgi_record {
     quint8 version;
@@ -69,13 +83,46 @@ struct fcgi_begin_request_body {
 #else
 __attribute__((__packed__));
 #endif
+
+// Reads the 1 or 4 bytes length of a name-value pair at pos
+bool readLength(const char *buf, quint32 len, quint32 &pos, quint32 &length)
+{
+    if (pos >= len) {
+        return false;
+    }
+
+    const auto octet = static_cast<quint8>(buf[pos]);
+    if (octet > 127) {
+        if (pos + 4 > len) {
+            return false;
+        }
+
+        // Ignore first bit
+        length = net_be32(&buf[pos]) ^ 0x80000000;
+        pos += 4;
+    } else {
+        length = octet;
+        ++pos;
+    }
+    return true;
+}
 } // namespace
 
 using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
 
 ProtocolFastCGI::ProtocolFastCGI(Server *server)
     : Protocol(server)
+    , m_maxConnections(0xffff)
+    , m_maxRequests(qMax(1U, server->fastcgiMaxRequests()))
 {
+#ifdef Q_OS_UNIX
+    // Connections are only limited by the file descriptors we can open
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        m_maxConnections = quint32(qMin<rlim_t>(limit.rlim_cur, 0xffffffff));
+    }
+#endif
 }
 
 ProtocolFastCGI::~ProtocolFastCGI()
@@ -87,25 +134,12 @@ Protocol::Type ProtocolFastCGI::type() const
     return Protocol::Type::FastCGI1;
 }
 
-quint16 ProtocolFastCGI::addHeader(ProtoRequestFastCGI *request,
-                                   const char *key,
-                                   quint16 keylen,
-                                   const char *val,
-                                   quint16 vallen) const
+void ProtocolFastCGI::addHeader(FastCGIRequest *request,
+                                const char *key,
+                                quint16 keylen,
+                                char *val,
+                                quint16 vallen) const
 {
-    char *buffer          = request->buffer + request->pktsize;
-    const char *watermark = request->buffer + m_bufferSize;
-
-    if (buffer + keylen + vallen + 2 + 2 >= watermark) {
-        qCWarning(C_SERVER_FCGI,
-                  "unable to add %.*s=%.*s to wsgi packet, consider increasing buffer size",
-                  keylen,
-                  key,
-                  vallen,
-                  val);
-        return 0;
-    }
-
     if (keylen > 5 && memcmp(key, "HTTP_", 5) == 0) {
         const auto value = QByteArray(val, vallen);
         if (!request->headerHost && memcmp(key + 5, "HOST", 4) == 0) {
@@ -122,10 +156,10 @@ quint16 ProtocolFastCGI::addHeader(ProtoRequestFastCGI *request,
         const char *pch = static_cast<const char *>(memchr(val, '?', vallen));
         if (pch) {
             int pos = int(pch - val);
-            request->setPath(const_cast<char *>(val), pos);
+            request->setPath(val, pos);
             request->query = QByteArray(pch + 1, vallen - pos - 1);
         } else {
-            request->setPath(const_cast<char *>(val), vallen);
+            request->setPath(val, vallen);
             request->query = QByteArray();
         }
     } else if (memcmp(key, "SERVER_PROTOCOL", 15) == 0) {
@@ -147,58 +181,23 @@ quint16 ProtocolFastCGI::addHeader(ProtoRequestFastCGI *request,
     // #ifdef DEBUG
     //     qCDebug(C_SERVER_FCGI, "add server var: %.*s = %.*s", keylen, key, vallen, val);
     // #endif
-
-    return keylen + vallen + 2 + 2;
 }
 
-int ProtocolFastCGI::parseHeaders(ProtoRequestFastCGI *request, const char *buf, quint16 len) const
+int ProtocolFastCGI::parseHeaders(FastCGIRequest *request, char *buf, quint32 len) const
 {
     quint32 j = 0;
     while (j < len) {
         quint32 keylen;
-        auto octet = static_cast<quint8>(buf[j]);
-        if (octet > 127) {
-            if (j + 4 >= len) {
-                return -1;
-            }
-
-            // Ignore first bit
-            keylen = net_be32(&buf[j]) ^ 0x80000000;
-            j += 4;
-        } else {
-            if (++j >= len) {
-                return -1;
-            }
-            keylen = octet;
-        }
-
         quint32 vallen;
-        octet = static_cast<quint8>(buf[j]);
-        if (octet > 127) {
-            if (j + 4 >= len) {
-                return -1;
-            }
-
-            // Ignore first bit
-            vallen = net_be32(&buf[j]) ^ 0x80000000;
-            j += 4;
-        } else {
-            if (++j >= len) {
-                return -1;
-            }
-            vallen = octet;
+        if (!readLength(buf, len, j, keylen) || !readLength(buf, len, j, vallen)) {
+            return -1;
         }
 
         if (j + (keylen + vallen) > len || keylen > 0xffff || vallen > 0xffff) {
             return -1;
         }
 
-        quint16 pktsize =
-            addHeader(request, buf + j, quint16(keylen), buf + j + keylen, quint16(vallen));
-        if (pktsize == 0) {
-            return -1;
-        }
-        request->pktsize += pktsize;
+        addHeader(request, buf + j, quint16(keylen), buf + j + keylen, quint16(vallen));
 
         j += keylen + vallen;
     }
@@ -206,80 +205,177 @@ int ProtocolFastCGI::parseHeaders(ProtoRequestFastCGI *request, const char *buf,
     return 0;
 }
 
-int ProtocolFastCGI::processPacket(ProtoRequestFastCGI *request) const
+bool ProtocolFastCGI::processRecords(Socket *sock, ProtoRequestFastCGI *protoRequest) const
 {
-    Q_FOREVER
-    {
-        if (request->buf_size >= int(sizeof(struct fcgi_record))) {
-            const auto *fr = reinterpret_cast<struct fcgi_record *>(request->buffer);
-
-            quint8 fcgi_type    = fr->type;
-            auto fcgi_len       = quint16(fr->cl0 | (fr->cl1 << 8));
-            qint32 fcgi_all_len = sizeof(struct fcgi_record) + fcgi_len + fr->pad;
-            request->stream_id  = quint16(fr->req0 | (fr->req1 << 8));
-
-            // if STDIN, end of the loop
-            if (fcgi_type == FCGI_STDIN) {
-                if (fcgi_len == 0) {
-                    memmove(request->buffer,
-                            request->buffer + fcgi_all_len,
-                            size_t(request->buf_size - fcgi_all_len));
-                    request->buf_size -= fcgi_all_len;
-                    return WSGI_OK;
-                }
+    int pos  = 0;
+    bool ret = true;
+    while (protoRequest->buf_size - pos >= int(sizeof(struct fcgi_record))) {
+        const char *record = protoRequest->buffer + pos;
+        const auto *fr     = reinterpret_cast<const struct fcgi_record *>(record);
+
+        const auto contentLength = quint16(fr->cl0 | (fr->cl1 << 8));
+        const auto requestId     = quint16(fr->req0 | (fr->req1 << 8));
+        const int recordLength   = int(sizeof(struct fcgi_record)) + contentLength + fr->pad;
+        const int available      = protoRequest->buf_size - pos;
+
+        if (fr->version != FCGI_VERSION_1) {
+            ret = false;
+            break;
+        }
 
-                int content_size = request->buf_size - int(sizeof(struct fcgi_record));
-                if (!writeBody(request,
-                               request->buffer + sizeof(struct fcgi_record),
-                               qMin(content_size, int(fcgi_len)))) {
-                    return WSGI_ERROR;
+        if (available < recordLength) {
+            if (fr->type == FCGI_STDIN && contentLength) {
+                // Stream the body instead of waiting for the whole record
+                const int received      = available - int(sizeof(struct fcgi_record));
+                const int content       = qMin(received, int(contentLength));
+                FastCGIRequest *request = protoRequest->requests.value(requestId);
+                if (request && !request->dispatched &&
+                    !writeBody(request, record + sizeof(struct fcgi_record), content)) {
+                    ret = false;
+                    break;
                 }
 
-                if (content_size < fcgi_len) {
-                    // we still need the rest of the pkt body
-                    request->connState = ProtoRequestFastCGI::ContentBody;
-                    request->pktsize   = quint16(fcgi_len - content_size);
-                    request->buf_size  = fr->pad;
-                    return WSGI_BODY;
-                }
+                protoRequest->stdinRequest = request && !request->dispatched ? request : nullptr;
+                protoRequest->pktsize      = quint16(contentLength - content);
+                protoRequest->padding      = quint8(fr->pad - (received - content));
+                protoRequest->connState    = ProtoRequestFastCGI::ContentBody;
+                pos                        = protoRequest->buf_size;
+            } else if (recordLength > m_bufferSize) {
+                qCWarning(C_SERVER_FCGI) << "FastCGI record of" << recordLength
+                                         << "bytes doesn't fit, consider increasing buffer size";
+                ret = false;
+            }
+            break;
+        }
 
-                memmove(request->buffer,
-                        request->buffer + fcgi_all_len,
-                        size_t(request->buf_size - fcgi_all_len));
-                request->buf_size -= fcgi_all_len;
-            } else if (request->buf_size >= fcgi_all_len) {
-                // PARAMS ? (ignore other types)
-                if (fcgi_type == FCGI_PARAMS) {
-                    if (parseHeaders(
-                            request, request->buffer + sizeof(struct fcgi_record), fcgi_len)) {
-                        return WSGI_ERROR;
-                    }
-                } else if (fcgi_type == FCGI_BEGIN_REQUEST) {
-                    const auto *brb = reinterpret_cast<struct fcgi_begin_request_body *>(
-                        request->buffer + sizeof(struct fcgi_begin_request_body));
-                    request->headerConnection = (brb->flags & FCGI_KEEP_CONN)
-                                                    ? ProtoRequestFastCGI::HeaderConnection::Keep
-                                                    : ProtoRequestFastCGI::HeaderConnection::Close;
-                    request->contentLength    = -1;
-                    request->headers          = Cutelyst::Headers();
-                    request->connState        = ProtoRequestFastCGI::MethodLine;
-                }
+        if (!processRecord(sock,
+                           protoRequest,
+                           fr->type,
+                           requestId,
+                           record + sizeof(struct fcgi_record),
+                           contentLength)) {
+            ret = false;
+            break;
+        }
+        pos += recordLength;
+    }
 
-                memmove(request->buffer,
-                        request->buffer + fcgi_all_len,
-                        size_t(request->buf_size - fcgi_all_len));
-                request->buf_size -= fcgi_all_len;
-            } else {
-                break;
-            }
+    if (pos) {
+        protoRequest->buf_size -= pos;
+        memmove(protoRequest->buffer, protoRequest->buffer + pos, size_t(protoRequest->buf_size));
+    }
+
+    return ret;
+}
+
+bool ProtocolFastCGI::processRecord(Socket *sock,
+                                    ProtoRequestFastCGI *protoRequest,
+                                    quint8 type,
+                                    quint16 requestId,
+                                    const char *content,
+                                    quint16 len) const
+{
+    if (requestId == 0) {
+        // Management records
+        if (type == FCGI_GET_VALUES) {
+            writeValues(protoRequest->io, content, len);
         } else {
+            const char body[8] = {char(type)};
+            FastCGIWriter::writeRecord(
+                protoRequest->io, FCGI_UNKNOWN_TYPE, 0, body, sizeof(body));
+        }
+        return true;
+    }
+
+    FastCGIRequest *request = protoRequest->requests.value(requestId);
+    switch (type) {
+    case FCGI_BEGIN_REQUEST:
+    {
+        if (request || len < int(sizeof(struct fcgi_begin_request_body))) {
+            return false;
+        }
+
+        const auto *brb     = reinterpret_cast<const struct fcgi_begin_request_body *>(content);
+        const bool keepConn = brb->flags & FCGI_KEEP_CONN;
+        if (net_be16(content) != FCGI_RESPONDER) {
+            FastCGIWriter::writeEndRequest(protoRequest->io, requestId, FCGI_UNKNOWN_ROLE);
+            break;
+        }
+
+        if (quint32(protoRequest->requests.size()) >= m_maxRequests) {
+            ++m_rejectedRequests;
+            FastCGIWriter::writeEndRequest(protoRequest->io,
+                                           requestId,
+                                           m_maxRequests == 1 ? FCGI_CANT_MPX_CONN
+                                                              : FCGI_OVERLOADED);
+            if (!keepConn) {
+                sock->connectionClose();
+            }
+            break;
+        }
+
+        if (!protoRequest->requests.isEmpty()) {
+            ++m_multiplexedRequests;
+        }
+
+        request = new FastCGIRequest(requestId, keepConn, protoRequest);
+        if (useStats) {
+            request->startOfRequest = std::chrono::steady_clock::now();
+        }
+        protoRequest->requests.insert(requestId, request);
+        break;
+    }
+    case FCGI_ABORT_REQUEST:
+        // Requests being processed send FCGI_END_REQUEST once they finish
+        if (request && !request->dispatched) {
+            protoRequest->requests.remove(requestId);
+            delete request;
+            FastCGIWriter::writeEndRequest(protoRequest->io, requestId, FCGI_REQUEST_COMPLETE);
+        }
+        break;
+    case FCGI_PARAMS:
+        // Records of rejected requests are ignored
+        if (!request || request->dispatched) {
+            break;
+        }
+
+        if (len) {
+            if (request->params.size() + len > m_bufferSize) {
+                qCWarning(C_SERVER_FCGI)
+                    << "FastCGI params don't fit, consider increasing buffer size";
+                return false;
+            }
+            request->params.append(content, len);
+        } else if (parseHeaders(request, request->params.data(), quint32(request->params.size()))) {
+            return false;
+        }
+        break;
+    case FCGI_STDIN:
+        if (!request || request->dispatched) {
             break;
         }
+
+        if (len) {
+            return writeBody(request, content, len);
+        }
+
+        // An empty record ends the stream, the request is complete
+        request->params     = {};
+        request->dispatched = true;
+        sock->requestStarted(request);
+        if (request->body) {
+            request->body->seek(0);
+        }
+        sock->engine->processRequest(request);
+        break;
+    default:
+        break;
     }
-    return WSGI_AGAIN; // read again
+
+    return true;
 }
 
-bool ProtocolFastCGI::writeBody(ProtoRequestFastCGI *request, char *buf, qint64 len) const
+bool ProtocolFastCGI::writeBody(FastCGIRequest *request, const char *buf, qint64 len) const
 {
     if (!request->body) {
         request->body = createBody(request->contentLength);
@@ -291,101 +387,108 @@ bool ProtocolFastCGI::writeBody(ProtoRequestFastCGI *request, char *buf, qint64
     return request->body->write(buf, len) == len;
 }
 
-qint64 ProtocolFastCGI::readBody(Socket *sock, QIODevice *io, qint64 bytesAvailable) const
+qint64 ProtocolFastCGI::readBody(ProtoRequestFastCGI *protoRequest,
+                                 QIODevice *io,
+                                 qint64 bytesAvailable) const
 {
-    auto request    = static_cast<ProtoRequestFastCGI *>(sock->protoData);
-    QIODevice *body = request->body;
-    int &pad        = request->buf_size;
-    while (bytesAvailable && request->pktsize + pad) {
-        // We need to read and ignore ending PAD data
-        qint64 len = io->read(m_postBuffer,
-                              qMin(m_postBufferSize, static_cast<qint64>(request->pktsize + pad)));
-        if (len == -1) {
-            sock->connectionClose();
+    // The buffer was fully consumed before switching to ContentBody so it's free to use
+    while (bytesAvailable && protoRequest->pktsize + protoRequest->padding) {
+        const qint64 len = io->read(
+            protoRequest->buffer,
+            qMin(qint64(m_bufferSize), qint64(protoRequest->pktsize + protoRequest->padding)));
+        if (len <= 0) {
+            protoRequest->sock->connectionClose();
             return -1;
         }
         bytesAvailable -= len;
 
-        if (len > request->pktsize) {
-            // We read past pktsize, so possibly PAD data was read too.
-            pad -= len - request->pktsize;
-            len              = request->pktsize;
-            request->pktsize = 0;
-        } else {
-            request->pktsize -= len;
-        }
+        // We need to read and ignore ending PAD data
+        const qint64 content = qMin(len, qint64(protoRequest->pktsize));
+        protoRequest->pktsize -= quint16(content);
+        protoRequest->padding -= quint8(len - content);
 
-        body->write(m_postBuffer, len);
+        if (content && protoRequest->stdinRequest &&
+            !writeBody(protoRequest->stdinRequest, protoRequest->buffer, content)) {
+            protoRequest->sock->connectionClose();
+            return -1;
+        }
     }
 
-    if (request->pktsize + pad == 0) {
-        request->connState = ProtoRequestFastCGI::MethodLine;
+    if (protoRequest->pktsize + protoRequest->padding == 0) {
+        protoRequest->connState    = ProtoRequestFastCGI::MethodLine;
+        protoRequest->stdinRequest = nullptr;
     }
 
     return bytesAvailable;
 }
 
-void ProtocolFastCGI::parse(Socket *sock, QIODevice *io) const
+void ProtocolFastCGI::writeValues(QIODevice *io, const char *content, quint16 len) const
 {
-    // Post buffering
-    auto request = static_cast<ProtoRequestFastCGI *>(sock->protoData);
-    if (request->status & Cutelyst::EngineRequest::Async) {
-        return;
-    }
-
-    qint64 bytesAvailable = io->bytesAvailable();
-    if (request->connState == ProtoRequestFastCGI::ContentBody) {
-        bytesAvailable = readBody(sock, io, bytesAvailable);
-        if (bytesAvailable == -1) {
-            return;
+    QByteArray result;
+
+    quint32 pos = 0;
+    quint32 nameLen;
+    quint32 valueLen;
+    while (readLength(content, len, pos, nameLen) && readLength(content, len, pos, valueLen) &&
+           pos + nameLen + valueLen <= len) {
+        const QByteArrayView name(content + pos, nameLen);
+        pos += nameLen + valueLen;
+
+        QByteArray value;
+        if (name == "FCGI_MAX_CONNS") {
+            value = QByteArray::number(m_maxConnections);
+        } else if (name == "FCGI_MAX_REQS") {
+            value = QByteArray::number(m_maxRequests);
+        } else if (name == "FCGI_MPXS_CONNS") {
+            value = m_maxRequests > 1 ? "1"_ba : "0"_ba;
+        } else {
+            // Unknown variables are left out of the reply
+            continue;
         }
-    }
 
-    do {
-        qint64 len =
-            io->read(request->buffer + request->buf_size, m_bufferSize - request->buf_size);
-        bytesAvailable -= len;
+        result.append(char(name.size()));
+        result.append(char(value.size()));
+        result.append(name);
+        result.append(value);
+    }
 
-        if (len > 0) {
-            request->buf_size += len;
+    FastCGIWriter::writeRecord(
+        io, FCGI_GET_VALUES_RESULT, 0, result.constData(), quint16(result.size()));
+}
 
-            if (useStats && request->startOfRequest == TimePointSteady{}) {
-                request->startOfRequest = std::chrono::steady_clock::now();
-            }
+void ProtocolFastCGI::parse(Socket *sock, QIODevice *io) const
+{
+    auto protoRequest = static_cast<ProtoRequestFastCGI *>(sock->protoData);
 
-            if (request->buf_size < int(sizeof(struct fcgi_record))) {
-                // not enough data
-                continue;
+    qint64 bytesAvailable = io->bytesAvailable();
+    while (bytesAvailable > 0) {
+        if (protoRequest->connState == ProtoRequestFastCGI::ContentBody) {
+            bytesAvailable = readBody(protoRequest, io, bytesAvailable);
+            if (bytesAvailable == -1) {
+                return;
             }
+            continue;
+        }
 
-            int ret = processPacket(request);
-            if (ret == WSGI_AGAIN) {
-                continue;
-            } else if (ret == WSGI_OK) {
-                sock->processing++;
-                if (request->body) {
-                    request->body->seek(0);
-                }
-                sock->engine->processRequest(request);
-                if (request->status & Cutelyst::EngineRequest::Async) {
-                    return; // We are in async mode
-                }
-            } else if (ret == WSGI_BODY) {
-                bytesAvailable = readBody(sock, io, bytesAvailable);
-                if (bytesAvailable == -1) {
-                    return;
-                }
-            } else {
-                qCWarning(C_SERVER_FCGI) << "Failed to parse packet from"
-                                         << sock->remoteAddress.toString() << sock->remotePort;
-                // On error disconnect immediately
-                io->close();
-            }
-        } else {
+        const qint64 len = io->read(protoRequest->buffer + protoRequest->buf_size,
+                                    m_bufferSize - protoRequest->buf_size);
+        if (len <= 0) {
             qCWarning(C_SERVER_FCGI) << "Failed to read from socket" << io->errorString();
             break;
         }
-    } while (bytesAvailable);
+        bytesAvailable -= len;
+        protoRequest->buf_size += int(len);
+
+        // Each request id has it's own EngineRequest, so requests that went
+        // async don't stop other ones multiplexed on the connection
+        if (!processRecords(sock, protoRequest)) {
+            qCWarning(C_SERVER_FCGI) << "Failed to parse packet from"
+                                     << sock->remoteAddress.toString() << sock->remotePort;
+            // On error disconnect immediately
+            io->close();
+            return;
+        }
+    }
 }
 
 ProtocolData *ProtocolFastCGI::createData(Socket *sock) const
@@ -393,6 +496,12 @@ ProtocolData *ProtocolFastCGI::createData(Socket *sock) const
     return new ProtoRequestFastCGI(sock, m_bufferSize);
 }
 
+void ProtocolFastCGI::counters(QVariantMap &counters) const
+{
+    counters.insert(u"fastcgi_multiplexed_requests"_s, m_multiplexedRequests.load());
+    counters.insert(u"fastcgi_rejected_requests"_s, m_rejectedRequests.load());
+}
+
 ProtoRequestFastCGI::ProtoRequestFastCGI(Socket *sock, int bufferSize)
     : ProtocolData(sock, bufferSize)
 {
@@ -400,25 +509,40 @@ ProtoRequestFastCGI::ProtoRequestFastCGI(Socket *sock, int bufferSize)
 
 ProtoRequestFastCGI::~ProtoRequestFastCGI()
 {
+    qDeleteAll(requests);
 }
 
 void ProtoRequestFastCGI::setupNewConnection(Socket *sock)
 {
-    serverAddress = sock->serverAddress;
-    remoteAddress = sock->remoteAddress;
-    remotePort    = sock->remotePort;
+    Q_UNUSED(sock)
+}
+
+FastCGIRequest::FastCGIRequest(quint16 _requestId,
+                               bool _keepConn,
+                               ProtoRequestFastCGI *_protoRequest)
+    : protoRequest(_protoRequest)
+    , requestId(_requestId)
+    , keepConn(_keepConn)
+{
+    serverAddress = _protoRequest->sock->serverAddress;
+    remoteAddress = _protoRequest->sock->remoteAddress;
+    remotePort    = _protoRequest->sock->remotePort;
 }
 
-bool ProtoRequestFastCGI::writeHeaders(quint16 status, const Cutelyst::Headers &headers)
+FastCGIRequest::~FastCGIRequest()
 {
-    static thread_local QByteArray headerBuffer = ([]() -> QByteArray {
-        QByteArray ret;
-        ret.reserve(1024);
-        return ret;
-    }());
+    // Once dispatched the body belongs to the context
+    if (!context) {
+        delete body;
+    }
+}
 
-    headerBuffer.resize(0);
-    headerBuffer.append(QByteArrayLiteral("Status: ") + QByteArray::number(status));
+bool FastCGIRequest::writeHeaders(quint16 status, const Cutelyst::Headers &headers)
+{
+    // Headers are held until the first body write or the end of the request so they
+    // share a record with them
+    output.reserve(1024);
+    output.append(QByteArrayLiteral("Status: ") + QByteArray::number(status));
 
     const auto headersData = headers.data();
 
@@ -428,112 +552,59 @@ bool ProtoRequestFastCGI::writeHeaders(quint16 status, const Cutelyst::Headers &
             hasDate = true;
         }
 
-        headerBuffer.append("\r\n");
-        headerBuffer.append(key);
-        headerBuffer.append(": ");
-        headerBuffer.append(value);
+        output.append("\r\n");
+        output.append(key);
+        output.append(": ");
+        output.append(value);
     }
 
     if (!hasDate) {
-        headerBuffer.append(static_cast<ServerEngine *>(sock->engine)->lastDate());
+        output.append(static_cast<ServerEngine *>(protoRequest->sock->engine)->lastDate());
     }
-    headerBuffer.append("\r\n\r\n", 4);
+    output.append("\r\n\r\n", 4);
 
-    return doWrite(headerBuffer.constData(), headerBuffer.size()) != -1;
+    return true;
 }
 
-qint64 ProtoRequestFastCGI::doWrite(const char *data, qint64 len)
+qint64 FastCGIRequest::doWrite(const char *data, qint64 len)
 {
-    // reset for next write
-    qint64 write_pos            = 0;
-    quint32 proto_parser_status = 0;
-
-    Q_FOREVER
-    {
-        // fastcgi packets are limited to 64k
-        quint8 padding = 0;
-
-        if (proto_parser_status == 0) {
-            quint16 fcgi_len;
-            if (len - write_pos < 0xffff) {
-                fcgi_len = quint16(len - write_pos);
-            } else {
-                fcgi_len = 0xffff;
-            }
-            proto_parser_status = fcgi_len;
-
-            struct fcgi_record fr;
-            fr.version = FCGI_VERSION_1;
-            fr.type    = FCGI_STDOUT;
-
-            fr.req1 = quint8(stream_id >> 8);
-            fr.req0 = quint8(stream_id);
-
-            quint16 padded_len = FCGI_ALIGN(fcgi_len);
-            if (padded_len > fcgi_len) {
-                padding = quint8(padded_len - fcgi_len);
-            }
-            fr.pad = padding;
-
-            fr.reserved = 0;
-            fr.cl1      = quint8(fcgi_len >> 8);
-            fr.cl0      = quint8(fcgi_len);
-            if (io->write(reinterpret_cast<const char *>(&fr), sizeof(struct fcgi_record)) !=
-                sizeof(struct fcgi_record)) {
-                return -1;
-            }
-        }
-
-        qint64 wlen = io->write(data + write_pos, proto_parser_status);
-        if (padding) {
-            io->write("\0\0\0\0\0\0\0\0\0", padding);
-        }
+    // Unless the application is streaming, small responses are written in a single
+    // call together with FCGI_END_REQUEST
+    if (!(status & EngineRequest::IOWrite) &&
+        output.size() + len < FastCGIWriter::CoalesceSize) {
+        output.append(data, len);
+        return len;
+    }
 
-        if (wlen > 0) {
-            write_pos += wlen;
-            proto_parser_status -= wlen;
-            if (write_pos == len) {
-                return write_pos;
-            }
-            continue;
-        }
-        if (wlen < 0) {
-            qCWarning(C_SERVER_FCGI) << "Writing socket error" << io->errorString();
-        }
+    if (!FastCGIWriter::writeStdout(
+            protoRequest->io, requestId, output, QByteArrayView(data, len), false)) {
+        qCWarning(C_SERVER_FCGI) << "Writing socket error" << protoRequest->io->errorString();
         return -1;
     }
+    output.clear();
+    return len;
 }
 
-#define FCGI_END_REQUEST_DATA "\1\x06\0\1\0\0\0\0\1\3\0\1\0\x08\0\0\0\0\0\0\0\0\0\0"
-
-void ProtoRequestFastCGI::processingFinished()
+void FastCGIRequest::processingFinished()
 {
-    char end_request[] = FCGI_END_REQUEST_DATA;
-    const char *sid    = reinterpret_cast<char *>(&stream_id);
-    // update with request id
-    end_request[2]  = sid[1];
-    end_request[3]  = sid[0];
-    end_request[10] = sid[1];
-    end_request[11] = sid[0];
-    io->write(end_request, 24);
+    ProtoRequestFastCGI *connection = protoRequest;
+    Socket *sock                    = connection->sock;
+    const bool closeConnection      = !keepConn;
+
+    FastCGIWriter::writeStdout(connection->io, requestId, output, {}, true);
+    sock->requestCompleted(this, Protocol::Type::FastCGI1);
+
+    connection->requests.remove(requestId);
+    delete this;
 
     if (!sock->requestFinished()) {
         // disconnected
         return;
     }
 
-    if (headerConnection == ProtoRequestFastCGI::HeaderConnection::Close) {
+    if (closeConnection) {
         // Web server did not set FCGI_KEEP_CONN
         sock->connectionClose();
-        return;
-    }
-
-    const auto size = buf_size;
-    resetData();
-    buf_size = size;
-
-    if (status & EngineRequest::Async && buf_size) {
-        sock->proto->parse(sock, io);
     }
 }
 
@@ -10,21 +10,20 @@
 
 #include <Cutelyst/Context>
 
+#include <QHash>
 #include <QObject>
 
+#include <atomic>
+
 namespace Cutelyst {
 
 class Server;
-class ProtoRequestFastCGI final
-    : public ProtocolData
-    , public Cutelyst::EngineRequest
+class ProtoRequestFastCGI;
+class FastCGIRequest final : public Cutelyst::EngineRequest
 {
-    Q_GADGET
 public:
-    ProtoRequestFastCGI(Socket *sock, int bufferSize);
-    ~ProtoRequestFastCGI() override;
-
-    void setupNewConnection(Socket *sock) override;
+    FastCGIRequest(quint16 requestId, bool keepConn, ProtoRequestFastCGI *protoRequest);
+    ~FastCGIRequest() override;
 
     bool writeHeaders(quint16 status, const Cutelyst::Headers &headers) override final;
 
@@ -34,28 +33,46 @@ public:
 
     void processingFinished() override final;
 
+    // FCGI_PARAMS stream, name-value pairs might be split across records
+    QByteArray params;
+    // Response headers and body not yet written as FCGI_STDOUT
+    QByteArray output;
+    ProtoRequestFastCGI *protoRequest;
+    qint64 contentLength = -1;
+    quint16 requestId;
+    bool keepConn;
+    bool headerHost = false;
+    bool dispatched = false;
+};
+
+class ProtoRequestFastCGI final : public ProtocolData
+{
+    Q_GADGET
+public:
+    ProtoRequestFastCGI(Socket *sock, int bufferSize);
+    ~ProtoRequestFastCGI() override;
+
+    void setupNewConnection(Socket *sock) override;
+
     void resetData() override final
     {
         ProtocolData::resetData();
 
-        // EngineRequest
-        // If we deleteLater the context, there might
-        // be an event that tries to finalize the request
-        // and it will encounter a null context pointer
-        delete context;
-        context = nullptr;
-        body    = nullptr;
+        // Deleting the request also deletes it's context
+        qDeleteAll(requests);
+        requests.clear();
 
-        startOfRequest = TimePointSteady{};
-        status         = InitialState;
-
-        stream_id = 0;
-        pktsize   = 0;
+        stdinRequest = nullptr;
+        pktsize      = 0;
+        padding      = 0;
     }
 
-public:
-    quint16 stream_id = 0;
-    quint16 pktsize   = 0;
+    // Requests multiplexed on this connection by their request id
+    QHash<quint16, FastCGIRequest *> requests;
+    // Request receiving the FCGI_STDIN record being read, null if it was rejected
+    FastCGIRequest *stdinRequest = nullptr;
+    quint16 pktsize              = 0;
+    quint8 padding               = 0;
 };
 
 class ProtocolFastCGI final : public Protocol
@@ -66,20 +83,35 @@ public:
 
     Type type() const override;
 
-    inline qint64 readBody(Socket *socket, QIODevice *io, qint64 bytesAvailable) const;
     void parse(Socket *sock, QIODevice *io) const override final;
 
     ProtocolData *createData(Socket *sock) const override final;
 
+    void counters(QVariantMap &counters) const;
+
+    quint32 m_maxConnections;
+    quint32 m_maxRequests;
+
+    mutable std::atomic<quint64> m_multiplexedRequests = 0;
+    mutable std::atomic<quint64> m_rejectedRequests    = 0;
+
 private:
-    inline quint16 addHeader(ProtoRequestFastCGI *request,
-                             const char *key,
-                             quint16 keylen,
-                             const char *val,
-                             quint16 vallen) const;
-    inline int parseHeaders(ProtoRequestFastCGI *request, const char *buf, quint16 len) const;
-    inline int processPacket(ProtoRequestFastCGI *request) const;
-    inline bool writeBody(ProtoRequestFastCGI *request, char *buf, qint64 len) const;
+    inline void addHeader(FastCGIRequest *request,
+                          const char *key,
+                          quint16 keylen,
+                          char *val,
+                          quint16 vallen) const;
+    inline int parseHeaders(FastCGIRequest *request, char *buf, quint32 len) const;
+    inline bool processRecords(Socket *sock, ProtoRequestFastCGI *protoRequest) const;
+    inline bool processRecord(Socket *sock,
+                              ProtoRequestFastCGI *protoRequest,
+                              quint8 type,
+                              quint16 requestId,
+                              const char *content,
+                              quint16 len) const;
+    inline bool writeBody(FastCGIRequest *request, const char *buf, qint64 len) const;
+    inline qint64 readBody(ProtoRequestFastCGI *protoRequest, QIODevice *io, qint64 bytes) const;
+    void writeValues(QIODevice *io, const char *content, quint16 len) const;
 };
 
 } // namespace Cutelyst
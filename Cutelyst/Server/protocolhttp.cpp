@@ -7,6 +7,7 @@
 #include "protocolhttp2.h"
 #include "protocolwebsocket.h"
 #include "server.h"
+#include "serverengine.h"
 #include "socket.h"
 
 #include <Cutelyst/Context>
@@ -191,6 +192,11 @@ void ProtocolHttp::parse(Socket *sock, QIODevice *io) const
     }
 }
 
+void ProtocolHttp::counters(QVariantMap &counters) const
+{
+    m_websocketProto->counters(counters);
+}
+
 ProtocolData *ProtocolHttp::createData(Socket *sock) const
 {
     return new ProtoRequestHttp(sock, m_bufferSize);
@@ -209,7 +215,7 @@ bool ProtocolHttp::processRequest(Socket *sock, QIODevice *io) const
         return false;
     }
 
-    ++sock->processing;
+    sock->requestStarted(request);
     sock->engine->processRequest(request);
 
     if (request->websocketUpgraded) {
@@ -329,6 +335,8 @@ ProtoRequestHttp::ProtoRequestHttp(Socket *sock, int bufferSize)
 
 ProtoRequestHttp::~ProtoRequestHttp()
 {
+    delete websocket_deflate;
+    webSocketReleaseHeldBack();
 }
 
 void ProtoRequestHttp::setupNewConnection(Socket *sock)
@@ -347,7 +355,21 @@ bool ProtoRequestHttp::writeHeaders(quint16 status, const Cutelyst::Headers &hea
 
     QByteArray data = http11StatusMessage(status);
 
-    const auto headersData                                = headers.data();
+    const auto headersData = headers.data();
+    if (status == Cutelyst::Response::EarlyHints) {
+        // Informational responses are not final, they must not touch the
+        // connection state nor carry a Date, the final response follows
+        for (const auto &[key, value] : headersData) {
+            data.append("\r\n");
+            data.append(key);
+            data.append(": ");
+            data.append(value);
+        }
+        data.append("\r\n\r\n", 4);
+
+        return io->write(data) == data.size();
+    }
+
     ProtoRequestHttp::HeaderConnection fallbackConnection = headerConnection;
     headerConnection = ProtoRequestHttp::HeaderConnection::NotSet;
 
@@ -399,6 +421,8 @@ qint64 ProtoRequestHttp::doWrite(const char *data, qint64 len)
 
 void ProtoRequestHttp::processingFinished()
 {
+    sock->requestCompleted(this, Protocol::Type::Http11);
+
     if (websocketUpgraded) {
         // need 2 byte header
         websocket_need  = 2;
@@ -441,10 +465,7 @@ bool ProtoRequestHttp::webSocketSendTextMessage(const QString &message)
         return false;
     }
 
-    const QByteArray rawMessage = message.toUtf8();
-    const QByteArray headers    = ProtocolWebSocket::createWebsocketHeader(
-        ProtoRequestHttp::OpCodeText, quint64(rawMessage.size()));
-    return doWrite(headers) == headers.size() && doWrite(rawMessage) == rawMessage.size();
+    return webSocketSendMessage(ProtoRequestHttp::OpCodeText, message.toUtf8());
 }
 
 bool ProtoRequestHttp::webSocketSendBinaryMessage(const QByteArray &message)
@@ -456,9 +477,7 @@ bool ProtoRequestHttp::webSocketSendBinaryMessage(const QByteArray &message)
         return false;
     }
 
-    const QByteArray headers = ProtocolWebSocket::createWebsocketHeader(
-        ProtoRequestHttp::OpCodeBinary, quint64(message.size()));
-    return doWrite(headers) == headers.size() && doWrite(message) == message.size();
+    return webSocketSendMessage(ProtoRequestHttp::OpCodeBinary, message);
 }
 
 bool ProtoRequestHttp::webSocketSendPing(const QByteArray &payload)
@@ -483,6 +502,9 @@ bool ProtoRequestHttp::webSocketClose(quint16 code, const QString &reason)
         return false;
     }
 
+    // Nothing may follow a close frame, messages still held back are never sent
+    webSocketReleaseHeldBack();
+
     const QByteArray reply = ProtocolWebSocket::createWebsocketCloseReply(reason, code);
     bool ret               = doWrite(reply) == reply.size();
     sock->requestFinished();
@@ -490,8 +512,223 @@ bool ProtoRequestHttp::webSocketClose(quint16 code, const QString &reason)
     return ret;
 }
 
+bool ProtoRequestHttp::webSocketSendFrame(const QByteArray &frame)
+{
+    if (headerConnection != ProtoRequestHttp::HeaderConnection::Upgrade) {
+        return false;
+    }
+
+    if (frame.isEmpty()) {
+        return false;
+    }
+
+    // Uncompressed frames are valid even when permessage-deflate was negotiated
+    return webSocketQueueMessage({
+        .opcode  = quint8(frame.at(0) & 0x0f),
+        .encoded = true,
+        .payload = frame,
+    });
+}
+
+qint64 ProtoRequestHttp::webSocketBufferedBytes() const
+{
+    if (!websocketUpgraded) {
+        return 0;
+    }
+    return io->bytesToWrite() + websocket_held_back_size;
+}
+
+bool ProtoRequestHttp::sendEarlyHints(const Cutelyst::Headers &headers)
+{
+    if (websocketUpgraded || (status & EngineRequest::FinalizedHeaders)) {
+        return false;
+    }
+
+    // HTTP/1.0 clients do not understand 1xx responses (RFC 9110 15.2)
+    if (protocol.compare("HTTP/1.1") != 0) {
+        return false;
+    }
+
+    return writeHeaders(Cutelyst::Response::EarlyHints, headers);
+}
+
+bool ProtoRequestHttp::webSocketSendMessage(quint8 opcode, const QByteArray &message)
+{
+    return webSocketQueueMessage({
+        .opcode  = opcode,
+        .encoded = false,
+        .payload = message,
+    });
+}
+
+bool ProtoRequestHttp::webSocketQueueMessage(const WebSocketMessage &message)
+{
+    const qint64 highWatermark = websocket_proto->m_writeHighWatermark;
+    if (!highWatermark || (!websocket_slow && io->bytesToWrite() < highWatermark)) {
+        return webSocketWriteMessage(message);
+    }
+
+    // Control frames may be sent between messages, they are never held back nor dropped
+    if (message.opcode & 0x08) {
+        if (message.opcode == ProtoRequestHttp::OpCodeClose) {
+            webSocketReleaseHeldBack();
+        }
+        return webSocketWriteMessage(message);
+    }
+
+    // Whole messages are held back so they can be dropped without corrupting the stream
+    websocket_slow = true;
+    switch (websocket_proto->m_slowConsumerPolicy) {
+    case ProtocolWebSocket::SlowConsumerPolicy::Close:
+        ++websocket_proto->m_slowConsumerClosed;
+        qCDebug(C_SERVER_HTTP) << "Closing slow websocket consumer" << webSocketBufferedBytes();
+        webSocketClose(Cutelyst::Response::CloseCodePolicyViolated, u"Slow consumer"_s);
+        headerConnection = ProtoRequestHttp::HeaderConnection::Close;
+        return false;
+    case ProtocolWebSocket::SlowConsumerPolicy::Coalesce:
+        websocket_proto->m_slowConsumerCoalesced += quint64(websocket_held_back.size());
+        webSocketReleaseHeldBack();
+        break;
+    case ProtocolWebSocket::SlowConsumerPolicy::DropOldest:
+        break;
+    }
+
+    websocket_held_back.append(message);
+    websocket_held_back_size += message.payload.size();
+    websocket_proto->m_heldBackBytes += message.payload.size();
+
+    // The newest message is always kept
+    while (websocket_held_back_size > highWatermark && websocket_held_back.size() > 1) {
+        const qsizetype size = websocket_held_back.takeFirst().payload.size();
+        websocket_held_back_size -= size;
+        websocket_proto->m_heldBackBytes -= size;
+        ++websocket_proto->m_slowConsumerDropped;
+    }
+
+    return true;
+}
+
+bool ProtoRequestHttp::webSocketWriteMessage(const WebSocketMessage &message)
+{
+    if (message.encoded) {
+        return doWrite(message.payload) == message.payload.size();
+    }
+
+    // Compressing only what reaches the socket keeps the deflate context of both peers in sync
+    if (websocket_deflate && !(message.opcode & 0x08)) {
+        QByteArray compressed;
+        if (websocket_deflate->compress(message.payload, compressed)) {
+            const QByteArray headers = ProtocolWebSocket::createWebsocketHeader(
+                quint8(message.opcode | ProtocolWebSocket::FlagCompressed),
+                quint64(compressed.size()));
+            return doWrite(headers) == headers.size() &&
+                   doWrite(compressed) == compressed.size();
+        }
+    }
+
+    const QByteArray headers =
+        ProtocolWebSocket::createWebsocketHeader(message.opcode, quint64(message.payload.size()));
+    return doWrite(headers) == headers.size() && doWrite(message.payload) == message.payload.size();
+}
+
+void ProtoRequestHttp::webSocketBytesWritten()
+{
+    if (!websocket_slow || io->bytesToWrite() > websocket_proto->m_writeLowWatermark) {
+        return;
+    }
+
+    const qint64 highWatermark = websocket_proto->m_writeHighWatermark;
+    while (!websocket_held_back.isEmpty() && io->bytesToWrite() < highWatermark) {
+        const WebSocketMessage message = websocket_held_back.takeFirst();
+        websocket_held_back_size -= message.payload.size();
+        websocket_proto->m_heldBackBytes -= message.payload.size();
+        webSocketWriteMessage(message);
+    }
+
+    if (websocket_held_back.isEmpty() && io->bytesToWrite() < highWatermark && context) {
+        websocket_slow = false;
+        Q_EMIT context->request()->webSocketWritable(context);
+    }
+}
+
+void ProtoRequestHttp::webSocketReleaseHeldBack()
+{
+    if (websocket_proto) {
+        websocket_proto->m_heldBackBytes -= websocket_held_back_size;
+    }
+    websocket_held_back.clear();
+    websocket_held_back_size = 0;
+}
+
+void ProtoRequestHttp::webSocketScheduleKeepAlive(TimePointSteady now)
+{
+    using namespace std::chrono;
+
+    seconds next = seconds::max();
+    if (websocket_awaiting_pong) {
+        next = websocket_proto->m_pongTimeout;
+    } else {
+        if (websocket_proto->m_pingInterval.count()) {
+            next = websocket_proto->m_pingInterval -
+                   duration_cast<seconds>(now - websocket_last_received);
+        }
+        if (websocket_proto->m_idleTimeout.count()) {
+            next = qMin(next,
+                        websocket_proto->m_idleTimeout -
+                            duration_cast<seconds>(now - websocket_last_message));
+        }
+    }
+
+    static_cast<ServerEngine *>(sock->engine)->timerWheel()->schedule(this, next);
+}
+
+void ProtoRequestHttp::webSocketStopKeepAlive()
+{
+    static_cast<ServerEngine *>(sock->engine)->timerWheel()->cancel(this);
+}
+
+void ProtoRequestHttp::timerWheelExpired()
+{
+    if (headerConnection != ProtoRequestHttp::HeaderConnection::Upgrade) {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (websocket_awaiting_pong) {
+        ++websocket_proto->m_pongTimeouts;
+        qCDebug(C_SERVER_HTTP) << "Closing websocket connection that didn't answer a ping";
+        webSocketClose(Cutelyst::Response::CloseCodeGoingAway, u"Ping timeout"_s);
+        headerConnection = ProtoRequestHttp::HeaderConnection::Close;
+        return;
+    }
+
+    const auto &idleTimeout = websocket_proto->m_idleTimeout;
+    if (idleTimeout.count() && now - websocket_last_message >= idleTimeout) {
+        ++websocket_proto->m_idleCloses;
+        qCDebug(C_SERVER_HTTP) << "Closing idle websocket connection";
+        webSocketClose(Cutelyst::Response::CloseCodeGoingAway, u"Idle timeout"_s);
+        headerConnection = ProtoRequestHttp::HeaderConnection::Close;
+        return;
+    }
+
+    // Only quiet peers are pinged, anything received recently already proves liveness
+    const auto &pingInterval = websocket_proto->m_pingInterval;
+    if (pingInterval.count() && now - websocket_last_received >= pingInterval) {
+        ++websocket_proto->m_keepAlivePings;
+        websocket_awaiting_pong = true;
+        webSocketSendPing({});
+        sock->flush();
+    }
+
+    webSocketScheduleKeepAlive(now);
+}
+
 void ProtoRequestHttp::socketDisconnected()
 {
+    if (isScheduled()) {
+        webSocketStopKeepAlive();
+    }
+
     if (websocketUpgraded) {
         if (websocket_finn_opcode != 0x88) {
             Q_EMIT context->request()->webSocketClosed(1005, QString{});
@@ -543,10 +780,31 @@ bool ProtoRequestHttp::webSocketHandshakeDo(const QByteArray &key,
         QCryptographicHash::hash(wsKey, QCryptographicHash::Sha1).toBase64();
     headers.setHeader("Sec-Websocket-Accept"_ba, wsAccept);
 
-    headerConnection      = ProtoRequestHttp::HeaderConnection::Upgrade;
-    websocketUpgraded     = true;
     const auto *httpProto = static_cast<ProtocolHttp *>(sock->proto);
-    sock->proto           = httpProto->m_websocketProto;
+    if (const auto offers = requestHeaders.header("Sec-Websocket-Extensions");
+        !offers.isEmpty()) {
+        QByteArray extensions;
+        websocket_deflate = httpProto->m_websocketProto->negotiateDeflate(offers, extensions);
+        if (websocket_deflate) {
+            headers.setHeader("Sec-Websocket-Extensions"_ba, extensions);
+        }
+    }
+
+    headerConnection  = ProtoRequestHttp::HeaderConnection::Upgrade;
+    websocketUpgraded = true;
+    sock->proto       = httpProto->m_websocketProto;
+    websocket_proto   = httpProto->m_websocketProto;
+
+    if (websocket_proto->m_writeHighWatermark) {
+        // Sockets are not reused, so this lasts as long as the connection
+        QObject::connect(io, &QIODevice::bytesWritten, io, [this] { webSocketBytesWritten(); });
+    }
+
+    if (websocket_proto->keepAliveEnabled()) {
+        websocket_last_received = std::chrono::steady_clock::now();
+        websocket_last_message  = websocket_last_received;
+        webSocketScheduleKeepAlive(websocket_last_received);
+    }
 
     return writeHeaders(Cutelyst::Response::SwitchingProtocols, headers);
 }
@@ -600,6 +858,9 @@ QByteArray http11StatusMessage(quint16 status)
     case Response::SwitchingProtocols:
         ret = QByteArrayLiteral("HTTP/1.1 101 Switching Protocols");
         break;
+    case Response::EarlyHints:
+        ret = QByteArrayLiteral("HTTP/1.1 103 Early Hints");
+        break;
     case Response::Created:
         ret = QByteArrayLiteral("HTTP/1.1 201 Created");
         break;
@@ -7,6 +7,8 @@
 
 #include "protocol.h"
 #include "socket.h"
+#include "timerwheel.h"
+#include "websocketdeflate.h"
 
 #include <Cutelyst/Context>
 
@@ -15,16 +17,16 @@
 namespace Cutelyst {
 class Server;
 class Socket;
+class ProtocolWebSocket;
 class ProtoRequestHttp final
     : public ProtocolData
     , public Cutelyst::EngineRequest
+    , public TimerWheel::Entry
 {
     Q_GADGET
 public:
     enum class WebSocketPhase {
         WebSocketPhaseHeaders,
-        WebSocketPhaseSize,
-        WebSocketPhaseMask,
         WebSocketPhasePayload,
     };
     Q_ENUM(WebSocketPhase)
@@ -69,6 +71,12 @@ public:
 
     bool webSocketClose(quint16 code, const QString &reason) override final;
 
+    bool webSocketSendFrame(const QByteArray &frame) override final;
+
+    qint64 webSocketBufferedBytes() const override final;
+
+    bool sendEarlyHints(const Cutelyst::Headers &headers) override final;
+
     inline void resetData() override final
     {
         ProtocolData::resetData();
@@ -89,6 +97,18 @@ public:
         last              = 0;
         beginLine         = 0;
 
+        delete websocket_deflate;
+        websocket_deflate    = nullptr;
+        websocket_compressed = false;
+
+        webSocketReleaseHeldBack();
+        websocket_slow = false;
+
+        if (isScheduled()) {
+            webSocketStopKeepAlive();
+        }
+        websocket_awaiting_pong = false;
+
         serverAddress = sock->serverAddress;
         remoteAddress = sock->remoteAddress;
         remotePort    = sock->remotePort;
@@ -99,6 +119,7 @@ public:
 
     QByteArray websocket_message;
     QByteArray websocket_payload;
+    WebSocketDeflate *websocket_deflate = nullptr;
     quint64 websocket_payload_size   = 0;
     quint32 websocket_need           = 0;
     quint32 websocket_mask           = 0;
@@ -109,11 +130,43 @@ public:
     quint8 websocket_continue_opcode = 0;
     quint8 websocket_finn_opcode     = 0;
     bool websocketUpgraded           = false;
+    bool websocket_compressed        = false;
+
+    struct WebSocketMessage {
+        quint8 opcode = 0;
+        // Already a complete frame, otherwise it is framed and compressed when written
+        bool encoded = false;
+        QByteArray payload;
+    };
+
+    // Messages not written to the socket while above the write high watermark, they are kept
+    // uncompressed so that dropping one doesn't desync the client inflater
+    QList<WebSocketMessage> websocket_held_back;
+    qint64 websocket_held_back_size          = 0;
+    const ProtocolWebSocket *websocket_proto = nullptr;
+    bool websocket_slow                      = false;
+
+    // Keepalive state, only tracked when pings or the idle timeout are enabled
+    TimePointSteady websocket_last_received;
+    TimePointSteady websocket_last_message;
+    bool websocket_awaiting_pong = false;
+
+    void webSocketScheduleKeepAlive(TimePointSteady now);
 
 protected:
     bool webSocketHandshakeDo(const QByteArray &key,
                               const QByteArray &origin,
                               const QByteArray &protocol) override final;
+
+    void timerWheelExpired() override final;
+
+private:
+    bool webSocketSendMessage(quint8 opcode, const QByteArray &message);
+    bool webSocketQueueMessage(const WebSocketMessage &message);
+    bool webSocketWriteMessage(const WebSocketMessage &message);
+    void webSocketBytesWritten();
+    void webSocketReleaseHeldBack();
+    void webSocketStopKeepAlive();
 };
 
 class ProtocolHttp2;
@@ -133,6 +186,8 @@ public:
 
     ProtocolData *createData(Socket *sock) const override final;
 
+    void counters(QVariantMap &counters) const;
+
 private:
     inline bool processRequest(Socket *sock, QIODevice *io) const;
     inline void parseMethod(const char *ptr, const char *end, Socket *sock) const;
@@ -8,6 +8,8 @@
 #include "server.h"
 #include "socket.h"
 
+#include <Cutelyst/Response>
+
 #include <QEventLoop>
 #include <QLoggingCategory>
 
@@ -96,6 +98,9 @@ constexpr int PREFACE_SIZE = 24;
 ProtocolHttp2::ProtocolHttp2(Server *server)
     : Protocol(server)
     , m_headerTableSize(qint32(server->http2HeaderTableSize()))
+    , m_maxConcurrentStreams(server->http2MaxConcurrentStreams())
+    , m_maxInflightRequests(server->http2MaxInflightRequests())
+    , m_maxResetStreams(server->http2MaxResetStreams())
 {
     m_bufferSize = qMin(m_bufferSize, 2147483647);
 
@@ -152,6 +157,8 @@ void ProtocolHttp2::parse(Socket *sock, QIODevice *io) const
                             sendSettings(io,
                                          {
                                              {SETTINGS_ENABLE_CONNECT_PROTOCOL, 0},
+                                             {SETTINGS_MAX_CONCURRENT_STREAMS,
+                                              m_maxConcurrentStreams},
                                              {SETTINGS_MAX_FRAME_SIZE, m_maxFrameSize},
                                              {SETTINGS_HEADER_TABLE_SIZE, m_headerTableSize},
                                          });
@@ -355,6 +362,12 @@ int ProtocolHttp2::parseData(ProtoRequestHttp2 *request, QIODevice *io, const H2
         } else if (stream->state == H2Stream::HalfClosed || stream->state == H2Stream::Closed) {
             return sendGoAway(io, request->maxStreamId, ErrorStreamClosed);
         }
+    } else if (request->refusedStreams.contains(fr.streamId)) {
+        // The client might have sent it before receiving our RST_STREAM
+        if (fr.flags & FlagDataEndStream) {
+            request->refusedStreams.remove(fr.streamId);
+        }
+        return ErrorNoError;
     } else {
         return sendGoAway(io, request->maxStreamId, ErrorStreamClosed);
     }
@@ -452,6 +465,8 @@ int ProtocolHttp2::parseHeaders(ProtoRequestHttp2 *request, QIODevice *io, const
         if (useStats) {
             stream->startOfRequest = std::chrono::steady_clock::now();
         }
+        // The header block still has to be decoded to keep the HPACK context in sync
+        stream->refused = quint32(request->streams.size()) >= m_maxConcurrentStreams;
         request->streams.insert(fr.streamId, stream);
     }
 
@@ -497,6 +512,21 @@ int ProtocolHttp2::parseHeaders(ProtoRequestHttp2 *request, QIODevice *io, const
         return sendGoAway(io, request->maxStreamId, quint32(ret));
     }
 
+    if (stream->refused) {
+        ++m_refusedStreams;
+        qCDebug(C_SERVER_H2) << "Refusing stream" << fr.streamId << "max concurrent streams"
+                             << m_maxConcurrentStreams << "reached";
+        if (!(fr.flags & FlagHeadersEndStream)) {
+            request->refusedStreams.insert(fr.streamId);
+        }
+        request->streams.remove(fr.streamId);
+        delete stream;
+
+        // REFUSED_STREAM is a stream error, the connection remains usable
+        sendRstStream(io, fr.streamId, ErrorRefusedStream);
+        return 0;
+    }
+
     //    qDebug() << "Headers" << padLength << streamDependency << weight << "stream headers size"
     //    << stream->headers /*<< QByteArray(ptr + pos, fr.len - pos - padLength).toHex()*/ << ret;
 
@@ -581,10 +611,39 @@ int ProtocolHttp2::parseRstStream(ProtoRequestHttp2 *request,
             return sendGoAway(io, request->maxStreamId, ErrorProtocolError);
         }
 
+    } else if (request->refusedStreams.remove(fr.streamId)) {
+        return 0;
     } else {
         return sendGoAway(io, request->maxStreamId, ErrorStreamClosed);
     }
 
+    // Opening and cancelling streams right away costs the client nothing
+    // while we may already be processing them (CVE-2023-44487)
+    if (m_maxResetStreams) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - request->resetWindowStart >= std::chrono::seconds{1}) {
+            request->resetWindowStart = now;
+            request->resetCount       = 0;
+        }
+
+        if (++request->resetCount > m_maxResetStreams) {
+            ++m_resetFloodGoAways;
+            qCWarning(C_SERVER_H2) << "Too many streams reset by"
+                                   << request->sock->remoteAddress.toString()
+                                   << "closing connection";
+            return sendGoAway(io, request->maxStreamId, ErrorEnhanceYourCalm);
+        }
+    }
+
+    if (!stream->dispatched) {
+        // The application never saw it, drop it right away
+        request->pendingStreams.removeOne(stream);
+        request->streams.remove(fr.streamId);
+        delete stream->body;
+        delete stream;
+        return 0;
+    }
+
     stream->state = H2Stream::Closed;
 
     //    quint32 errorCode = h2_be32(request->buffer + 9);
@@ -776,13 +835,28 @@ int ProtocolHttp2::sendFrame(QIODevice *io,
 
 void ProtocolHttp2::queueStream(Socket *socket, H2Stream *stream) const
 {
-    ++socket->processing;
+    if (m_maxInflightRequests && quint32(socket->processing) >= m_maxInflightRequests) {
+        // Dispatched by H2Stream::processingFinished()
+        ++m_queuedRequests;
+        stream->protoRequest->pendingStreams.enqueue(stream);
+        return;
+    }
+
+    stream->dispatched = true;
+    socket->requestStarted(stream);
     if (stream->body) {
         stream->body->seek(0);
     }
     Q_EMIT socket->engine->processRequestAsync(stream);
 }
 
+void ProtocolHttp2::counters(QVariantMap &counters) const
+{
+    counters.insert(u"http2_refused_streams"_s, m_refusedStreams.load());
+    counters.insert(u"http2_queued_requests"_s, m_queuedRequests.load());
+    counters.insert(u"http2_reset_flood_goaways"_s, m_resetFloodGoAways.load());
+}
+
 bool ProtocolHttp2::upgradeH2C(Socket *socket,
                                QIODevice *io,
                                const Cutelyst::EngineRequest &request)
@@ -819,6 +893,7 @@ bool ProtocolHttp2::upgradeH2C(Socket *socket,
 
             sendSettings(io,
                          {
+                             {SETTINGS_MAX_CONCURRENT_STREAMS, m_maxConcurrentStreams},
                              {SETTINGS_MAX_FRAME_SIZE, m_maxFrameSize},
                              {SETTINGS_HEADER_TABLE_SIZE, m_headerTableSize},
                          });
@@ -943,12 +1018,29 @@ bool H2Stream::writeHeaders(quint16 status, const Cutelyst::Headers &headers)
     return ret == 0;
 }
 
+bool H2Stream::sendEarlyHints(const Cutelyst::Headers &headers)
+{
+    if (state == H2Stream::Closed || (status & EngineRequest::FinalizedHeaders)) {
+        return false;
+    }
+
+    return writeHeaders(Cutelyst::Response::EarlyHints, headers);
+}
+
 void H2Stream::processingFinished()
 {
     state = Closed;
-    protoRequest->streams.remove(streamId);
-    protoRequest->sock->requestFinished();
+
+    auto request = protoRequest;
+    request->sock->requestCompleted(this, Protocol::Type::Http2);
+    request->streams.remove(streamId);
+    const bool connected = request->sock->requestFinished();
     delete this;
+
+    if (connected && !request->pendingStreams.isEmpty()) {
+        auto parser = dynamic_cast<ProtocolHttp2 *>(request->sock->proto);
+        parser->queueStream(request->sock, request->pendingStreams.dequeue());
+    }
 }
 
 void H2Stream::windowUpdated()
@@ -13,6 +13,11 @@
 #include <enginerequest.h>
 
 #include <QObject>
+#include <QQueue>
+#include <QSet>
+
+#include <atomic>
+#include <chrono>
 
 // namespace Cutelyst {
 // class Headers;
@@ -42,6 +47,8 @@ public:
 
     bool writeHeaders(quint16 status, const Cutelyst::Headers &headers) override final;
 
+    bool sendEarlyHints(const Cutelyst::Headers &headers) override final;
+
     void processingFinished() override final;
 
     void windowUpdated();
@@ -56,6 +63,8 @@ public:
     qint64 consumedData  = 0;
     quint8 state         = Idle;
     bool gotPath         = false;
+    bool refused         = false;
+    bool dispatched      = false;
 };
 
 class ProtoRequestHttp2 final : public ProtocolData
@@ -81,10 +90,16 @@ public:
             // be an event that tries to finalize the request
             // and it will encounter a null context pointer
             delete stream->context;
+            if (!stream->dispatched) {
+                // Still queued in pendingStreams, no Request took ownership of the body
+                delete stream->body;
+            }
             delete stream;
         }
 
         streams.clear();
+        pendingStreams.clear();
+        refusedStreams.clear();
 
         headersBuffer.clear();
         maxStreamId               = 0;
@@ -93,6 +108,8 @@ public:
         windowSize                = 65535;
         settingsInitialWindowSize = 65535;
         canPush                   = false;
+        resetCount                = 0;
+        resetWindowStart          = {};
     }
 
     quint32 stream_id = 0;
@@ -106,10 +123,16 @@ public:
     qint32 windowSize                = 65535;
     qint32 settingsInitialWindowSize = 65535;
     quint32 settingsMaxFrameSize     = 16384;
+    quint32 resetCount               = 0;
     quint8 processing                = 0;
     bool canPush                     = true;
+    std::chrono::steady_clock::time_point resetWindowStart;
 
     QHash<quint32, H2Stream *> streams;
+    // Complete streams waiting for a free in-flight slot
+    QQueue<H2Stream *> pendingStreams;
+    // Refused streams that might still have DATA frames in flight
+    QSet<quint32> refusedStreams;
 };
 
 class ProtocolHttp2 final : public Protocol
@@ -151,12 +174,21 @@ public:
 
     void queueStream(Cutelyst::Socket *socket, H2Stream *stream) const;
 
+    void counters(QVariantMap &counters) const;
+
     bool
         upgradeH2C(Cutelyst::Socket *socket, QIODevice *io, const Cutelyst::EngineRequest &request);
 
 public:
     quint32 m_maxFrameSize;
     qint32 m_headerTableSize;
+    quint32 m_maxConcurrentStreams;
+    quint32 m_maxInflightRequests;
+    quint32 m_maxResetStreams;
+
+    mutable std::atomic<quint64> m_refusedStreams    = 0;
+    mutable std::atomic<quint64> m_queuedRequests    = 0;
+    mutable std::atomic<quint64> m_resetFloodGoAways = 0;
 };
 
 } // namespace Cutelyst
@@ -0,0 +1,311 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "protocoluwsgi.h"
+
+#include "server.h"
+#include "serverengine.h"
+#include "socket.h"
+
+#include <Cutelyst/Context>
+
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(C_SERVER_UWSGI, "cutelyst.server.uwsgi", QtWarningMsg)
+
+using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
+
+QByteArray http11StatusMessage(quint16 status);
+
+namespace {
+
+// modifier1 (8 bits), datasize (16 bits little endian), modifier2 (8 bits)
+constexpr int UwsgiHeaderSize = 4;
+
+inline quint16 net_le16(const char *buf)
+{
+    return quint16(quint8(buf[0]) | (quint8(buf[1]) << 8));
+}
+
+} // namespace
+
+ProtocolUwsgi::ProtocolUwsgi(Server *server)
+    : Protocol(server)
+{
+}
+
+ProtocolUwsgi::~ProtocolUwsgi()
+{
+}
+
+Protocol::Type ProtocolUwsgi::type() const
+{
+    return Protocol::Type::Uwsgi;
+}
+
+void ProtocolUwsgi::addVar(ProtoRequestUwsgi *request,
+                           QByteArrayView key,
+                           char *val,
+                           quint16 vallen) const
+{
+    if (key.startsWith("HTTP_")) {
+        const auto value = QByteArray(val, vallen);
+        if (!request->headerHost && key == "HTTP_HOST") {
+            request->serverAddress = value;
+            request->headerHost    = true;
+            request->headers.pushHeader(QByteArrayLiteral("Host"), value);
+        } else {
+            const auto keyStr = key.sliced(5).toByteArray().replace('_', '-');
+            request->headers.pushHeader(keyStr, value);
+        }
+    } else if (key == "REQUEST_METHOD") {
+        request->method = QByteArray(val, vallen);
+    } else if (key == "REQUEST_URI") {
+        const char *pch = static_cast<const char *>(memchr(val, '?', vallen));
+        if (pch) {
+            int pos = int(pch - val);
+            request->setPath(val, pos);
+            request->query = QByteArray(pch + 1, vallen - pos - 1);
+        } else {
+            request->setPath(val, vallen);
+            request->query = QByteArray();
+        }
+    } else if (key == "SERVER_PROTOCOL") {
+        request->protocol = QByteArray(val, vallen);
+    } else if (key == "REMOTE_ADDR") {
+        request->remoteAddress.setAddress(QString::fromLatin1(val, vallen));
+    } else if (key == "REMOTE_PORT") {
+        request->remotePort = quint16(QByteArray(val, vallen).toUInt());
+    } else if (key == "CONTENT_TYPE") {
+        if (vallen) {
+            request->headers.setContentType(QByteArray{val, vallen});
+        }
+    } else if (key == "CONTENT_LENGTH") {
+        request->bodyLength = QByteArray(val, vallen).toLongLong();
+    } else if (key == "REQUEST_SCHEME") {
+        request->isSecure = QByteArrayView(val, vallen) == "https";
+    } else if (key == "HTTPS") {
+        request->isSecure = QByteArrayView(val, vallen).compare("on", Qt::CaseInsensitive) == 0;
+    }
+}
+
+bool ProtocolUwsgi::parseVars(ProtoRequestUwsgi *request, char *buf, quint32 len) const
+{
+    quint32 pos = 0;
+    while (pos < len) {
+        if (pos + 2 > len) {
+            return false;
+        }
+        const quint16 keylen = net_le16(buf + pos);
+        pos += 2;
+
+        if (pos + keylen + 2 > len) {
+            return false;
+        }
+        const QByteArrayView key(buf + pos, keylen);
+        pos += keylen;
+
+        const quint16 vallen = net_le16(buf + pos);
+        pos += 2;
+
+        if (pos + vallen > len) {
+            return false;
+        }
+        addVar(request, key, buf + pos, vallen);
+        pos += vallen;
+    }
+
+    return true;
+}
+
+bool ProtocolUwsgi::processPacket(Socket *sock, ProtoRequestUwsgi *protoRequest) const
+{
+    if (protoRequest->buf_size < UwsgiHeaderSize) {
+        return true;
+    }
+
+    // modifier1 selects the uWSGI plugin, all of them send the same vars block
+    const quint16 pktsize = net_le16(protoRequest->buffer + 1);
+    const int packetSize  = UwsgiHeaderSize + pktsize;
+    if (packetSize > m_bufferSize) {
+        qCWarning(C_SERVER_UWSGI) << "uwsgi packet of" << packetSize
+                                  << "bytes doesn't fit, consider increasing buffer size";
+        return false;
+    }
+
+    if (protoRequest->buf_size < packetSize) {
+        return true;
+    }
+
+    if (!parseVars(protoRequest, protoRequest->buffer + UwsgiHeaderSize, pktsize)) {
+        return false;
+    }
+
+    // Whatever came after the vars is the start of the body
+    const qint64 received = qMin(qint64(protoRequest->buf_size - packetSize),
+                                 protoRequest->bodyLength);
+    if (received && !writeBody(protoRequest, protoRequest->buffer + packetSize, received)) {
+        return false;
+    }
+    protoRequest->bodyLength -= received;
+    protoRequest->buf_size = 0;
+
+    if (protoRequest->bodyLength > 0) {
+        protoRequest->connState = ProtoRequestUwsgi::ContentBody;
+    } else {
+        processRequest(sock, protoRequest);
+    }
+    return true;
+}
+
+bool ProtocolUwsgi::writeBody(ProtoRequestUwsgi *request, const char *buf, qint64 len) const
+{
+    if (!request->body) {
+        request->body = createBody(request->bodyLength);
+        if (!request->body) {
+            return false;
+        }
+    }
+
+    return request->body->write(buf, len) == len;
+}
+
+void ProtocolUwsgi::processRequest(Socket *sock, ProtoRequestUwsgi *request) const
+{
+    request->dispatched = true;
+    if (request->body) {
+        request->body->seek(0);
+    }
+
+    sock->requestStarted(request);
+    sock->engine->processRequest(request);
+}
+
+void ProtocolUwsgi::parse(Socket *sock, QIODevice *io) const
+{
+    auto protoRequest = static_cast<ProtoRequestUwsgi *>(sock->protoData);
+
+    qint64 bytesAvailable = io->bytesAvailable();
+    while (bytesAvailable > 0) {
+        if (protoRequest->dispatched) {
+            // A connection carries a single request
+            io->skip(bytesAvailable);
+            return;
+        }
+
+        if (protoRequest->connState == ProtoRequestUwsgi::ContentBody) {
+            const qint64 len = io->read(protoRequest->buffer,
+                                        qMin(qint64(m_bufferSize), protoRequest->bodyLength));
+            if (len <= 0) {
+                sock->connectionClose();
+                return;
+            }
+            bytesAvailable -= len;
+
+            if (!writeBody(protoRequest, protoRequest->buffer, len)) {
+                sock->connectionClose();
+                return;
+            }
+
+            protoRequest->bodyLength -= len;
+            if (protoRequest->bodyLength == 0) {
+                processRequest(sock, protoRequest);
+            }
+            continue;
+        }
+
+        const qint64 len = io->read(protoRequest->buffer + protoRequest->buf_size,
+                                    m_bufferSize - protoRequest->buf_size);
+        if (len <= 0) {
+            qCWarning(C_SERVER_UWSGI) << "Failed to read from socket" << io->errorString();
+            break;
+        }
+        bytesAvailable -= len;
+
+        if (useStats && protoRequest->buf_size == 0) {
+            protoRequest->startOfRequest = std::chrono::steady_clock::now();
+        }
+        protoRequest->buf_size += int(len);
+
+        if (!processPacket(sock, protoRequest)) {
+            qCWarning(C_SERVER_UWSGI) << "Failed to parse packet from"
+                                      << sock->remoteAddress.toString() << sock->remotePort;
+            // On error disconnect immediately
+            io->close();
+            return;
+        }
+    }
+}
+
+ProtocolData *ProtocolUwsgi::createData(Socket *sock) const
+{
+    return new ProtoRequestUwsgi(sock, m_bufferSize);
+}
+
+ProtoRequestUwsgi::ProtoRequestUwsgi(Socket *sock, int bufferSize)
+    : ProtocolData(sock, bufferSize)
+{
+}
+
+ProtoRequestUwsgi::~ProtoRequestUwsgi()
+{
+    // Once dispatched the body belongs to the context
+    if (!context) {
+        delete body;
+    }
+}
+
+void ProtoRequestUwsgi::setupNewConnection(Socket *sock)
+{
+    serverAddress = sock->serverAddress;
+    remoteAddress = sock->remoteAddress;
+    remotePort    = sock->remotePort;
+}
+
+bool ProtoRequestUwsgi::writeHeaders(quint16 status, const Cutelyst::Headers &headers)
+{
+    QByteArray data = http11StatusMessage(status);
+
+    const auto headersData = headers.data();
+
+    bool hasDate = false;
+    for (const auto &[key, value] : headersData) {
+        if (!hasDate && key.compare("Date", Qt::CaseInsensitive) == 0) {
+            hasDate = true;
+        }
+
+        data.append("\r\n");
+        data.append(key);
+        data.append(": ");
+        data.append(value);
+    }
+
+    if (!hasDate) {
+        data.append(static_cast<ServerEngine *>(sock->engine)->lastDate());
+    }
+    data.append("\r\n\r\n", 4);
+
+    return io->write(data) == data.size();
+}
+
+qint64 ProtoRequestUwsgi::doWrite(const char *data, qint64 len)
+{
+    return io->write(data, len);
+}
+
+void ProtoRequestUwsgi::processingFinished()
+{
+    sock->requestCompleted(this, Protocol::Type::Uwsgi);
+
+    if (!sock->requestFinished()) {
+        // disconnected
+        return;
+    }
+
+    // The frontend reads the response until the connection is closed
+    sock->connectionClose();
+}
+
+#include "moc_protocoluwsgi.cpp"
@@ -0,0 +1,70 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef PROTOCOLUWSGI_H
+#define PROTOCOLUWSGI_H
+
+#include "protocol.h"
+#include "socket.h"
+
+#include <Cutelyst/Context>
+
+#include <QObject>
+
+namespace Cutelyst {
+
+class Server;
+class ProtoRequestUwsgi final
+    : public ProtocolData
+    , public Cutelyst::EngineRequest
+{
+    Q_GADGET
+public:
+    ProtoRequestUwsgi(Socket *sock, int bufferSize);
+    ~ProtoRequestUwsgi() override;
+
+    void setupNewConnection(Socket *sock) override final;
+
+    bool writeHeaders(quint16 status, const Cutelyst::Headers &headers) override final;
+
+    qint64 doWrite(const char *data, qint64 len) override final;
+
+    void processingFinished() override final;
+
+    // Request body bytes still to be read
+    qint64 bodyLength = 0;
+    bool dispatched   = false;
+};
+
+/**
+ * Implements the uwsgi protocol spoken by nginx's uwsgi_pass, each connection carries a
+ * single request made of a 4 bytes header followed by length prefixed CGI variables and
+ * the request body. The response is plain HTTP/1.1 delimited by closing the connection.
+ */
+class ProtocolUwsgi final : public Protocol
+{
+public:
+    explicit ProtocolUwsgi(Server *server);
+    ~ProtocolUwsgi() override;
+
+    Type type() const override;
+
+    void parse(Socket *sock, QIODevice *io) const override final;
+
+    ProtocolData *createData(Socket *sock) const override final;
+
+private:
+    inline void addVar(ProtoRequestUwsgi *request,
+                       QByteArrayView key,
+                       char *val,
+                       quint16 vallen) const;
+    inline bool parseVars(ProtoRequestUwsgi *request, char *buf, quint32 len) const;
+    inline bool processPacket(Socket *sock, ProtoRequestUwsgi *protoRequest) const;
+    inline bool writeBody(ProtoRequestUwsgi *request, const char *buf, qint64 len) const;
+    inline void processRequest(Socket *sock, ProtoRequestUwsgi *request) const;
+};
+
+} // namespace Cutelyst
+
+#endif // PROTOCOLUWSGI_H
@@ -18,11 +18,41 @@
 Q_LOGGING_CATEGORY(C_SERVER_WS, "cutelyst.server.websocket", QtWarningMsg)
 
 using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
 
 ProtocolWebSocket::ProtocolWebSocket(Server *server)
     : Protocol(server)
     , m_websockets_max_size(server->websocketMaxSize() * 1024)
+    , m_deflate(server->websocketCompression())
 {
+    m_deflateOptions.windowBits        = qBound(9, server->websocketCompressionWindowBits(), 15);
+    m_deflateOptions.memLevel          = qBound(1, server->websocketCompressionMemLevel(), 9);
+    m_deflateOptions.noContextTakeover = server->websocketCompressionNoContextTakeover();
+
+    if (m_deflate && !WebSocketDeflate::isAvailable()) {
+        qCWarning(C_SERVER_WS) << "WebSocket compression is not available, built without zlib";
+        m_deflate = false;
+    }
+
+    m_writeHighWatermark = qMax(0, server->websocketWriteHighWatermark()) * 1024;
+    m_writeLowWatermark  = qMax(0, server->websocketWriteLowWatermark()) * 1024;
+    if (m_writeLowWatermark == 0 || m_writeLowWatermark >= m_writeHighWatermark) {
+        m_writeLowWatermark = m_writeHighWatermark / 4;
+    }
+
+    const QString policy = server->websocketSlowConsumerPolicy();
+    if (policy == u"drop-oldest") {
+        m_slowConsumerPolicy = SlowConsumerPolicy::DropOldest;
+    } else if (policy == u"coalesce") {
+        m_slowConsumerPolicy = SlowConsumerPolicy::Coalesce;
+    } else if (policy != u"close") {
+        qCWarning(C_SERVER_WS) << "Unknown websocket slow consumer policy" << policy
+                               << "closing slow consumers instead";
+    }
+
+    m_pingInterval = std::chrono::seconds{qMax(0, server->websocketPingInterval())};
+    m_pongTimeout  = std::chrono::seconds{qMax(1, server->websocketPongTimeout())};
+    m_idleTimeout  = std::chrono::seconds{qMax(0, server->websocketIdleTimeout())};
 }
 
 ProtocolWebSocket::~ProtocolWebSocket()
@@ -88,49 +118,53 @@ QByteArray ProtocolWebSocket::createWebsocketCloseReply(const QString &msg, quin
 
 void ProtocolWebSocket::parse(Socket *sock, QIODevice *io) const
 {
-    qint64 bytesAvailable = io->bytesAvailable();
-    const auto *request   = static_cast<ProtoRequestHttp *>(sock->protoData);
+    auto request = static_cast<ProtoRequestHttp *>(sock->protoData);
 
     Q_FOREVER
     {
-        if (!bytesAvailable || !request->websocket_need ||
-            (bytesAvailable < request->websocket_need &&
-             request->websocket_phase != ProtoRequestHttp::WebSocketPhase::WebSocketPhasePayload)) {
-            // Need more data
+        if (!request->websocket_need) {
+            // Handshake not finished yet
             return;
         }
 
-        quint32 maxlen = qMin(request->websocket_need, static_cast<quint32>(m_postBufferSize));
-        qint64 len     = io->read(m_postBuffer, maxlen);
-        if (len == -1) {
-            qCWarning(C_SERVER_WS) << "Failed to read from socket" << io->errorString();
-            sock->connectionClose();
-            return;
-        }
-        bytesAvailable -= len;
+        if (request->websocket_phase == ProtoRequestHttp::WebSocketPhase::WebSocketPhaseHeaders) {
+            // The whole frame header is parsed at once, so peek the largest one
+            char header[MaxHeaderSize];
+            const qint64 len = io->peek(header, MaxHeaderSize);
+            if (len < 2 || len < websocket_header_size(header[1])) {
+                // Need more data
+                return;
+            }
 
-        switch (request->websocket_phase) {
-        case ProtoRequestHttp::WebSocketPhase::WebSocketPhaseHeaders:
-            if (!websocket_parse_header(sock, m_postBuffer, io)) {
+            if (io->read(header, websocket_header_size(header[1])) == -1) {
+                qCWarning(C_SERVER_WS) << "Failed to read from socket" << io->errorString();
+                sock->connectionClose();
                 return;
             }
-            break;
-        case ProtoRequestHttp::WebSocketPhase::WebSocketPhaseSize:
-            if (!websocket_parse_size(sock, m_postBuffer, m_websockets_max_size)) {
+
+            if (!websocket_parse_header(sock, header, io)) {
                 return;
             }
-            break;
-        case ProtoRequestHttp::WebSocketPhase::WebSocketPhaseMask:
-            websocket_parse_mask(sock, m_postBuffer, io);
-            break;
-        case ProtoRequestHttp::WebSocketPhase::WebSocketPhasePayload:
-            if (!websocket_parse_payload(sock, m_postBuffer, int(len), io)) {
+        } else {
+            // Read straight into the payload buffer allocated for the whole frame
+            const auto offset = qint64(request->websocket_payload_size - request->websocket_need);
+            char *data        = request->websocket_payload.data() + offset;
+            const qint64 len  = io->read(data, request->websocket_need);
+            if (len == -1) {
+                qCWarning(C_SERVER_WS) << "Failed to read from socket" << io->errorString();
+                sock->connectionClose();
+                return;
+            } else if (len == 0) {
+                // Need more data
+                return;
+            }
+
+            websocket_unmask(data, len, request->websocket_mask, quint64(offset));
+
+            request->websocket_need -= quint32(len);
+            if (!request->websocket_need && !websocket_parse_payload(sock, io)) {
                 return;
             }
-            break;
-        default:
-            Q_UNREACHABLE();
-            break;
         }
     }
 }
@@ -141,13 +175,36 @@ ProtocolData *ProtocolWebSocket::createData(Socket *sock) const
     return nullptr;
 }
 
+WebSocketDeflate *ProtocolWebSocket::negotiateDeflate(const QByteArray &offers,
+                                                      QByteArray &response) const
+{
+    if (!m_deflate) {
+        return nullptr;
+    }
+    return WebSocketDeflate::negotiate(offers, m_deflateOptions, response);
+}
+
+void ProtocolWebSocket::counters(QVariantMap &counters) const
+{
+    counters.insert(u"websocket_slow_consumer_dropped"_s, m_slowConsumerDropped.load());
+    counters.insert(u"websocket_slow_consumer_coalesced"_s, m_slowConsumerCoalesced.load());
+    counters.insert(u"websocket_slow_consumer_closed"_s, m_slowConsumerClosed.load());
+    counters.insert(u"websocket_held_back_bytes"_s, m_heldBackBytes.load());
+    counters.insert(u"websocket_keepalive_pings"_s, m_keepAlivePings.load());
+    counters.insert(u"websocket_pong_timeouts"_s, m_pongTimeouts.load());
+    counters.insert(u"websocket_idle_closes"_s, m_idleCloses.load());
+}
+
 bool ProtocolWebSocket::send_text(Cutelyst::Context *c, Socket *sock, bool singleFrame) const
 {
     Cutelyst::Request *request = c->request();
     auto protoRequest          = static_cast<ProtoRequestHttp *>(sock->protoData);
 
+    // Single frame messages are emitted straight from the payload buffer
     const int msg_size = protoRequest->websocket_message.size();
-    protoRequest->websocket_message.append(protoRequest->websocket_payload);
+    if (!singleFrame) {
+        protoRequest->websocket_message.append(protoRequest->websocket_payload);
+    }
 
     QByteArray payload = protoRequest->websocket_payload;
     if (protoRequest->websocket_start_of_frame != msg_size) {
@@ -169,7 +226,7 @@ bool ProtocolWebSocket::send_text(Cutelyst::Context *c, Socket *sock, bool singl
 
     if (protoRequest->websocket_finn_opcode & 0x80) {
         protoRequest->websocket_continue_opcode = 0;
-        if (singleFrame || protoRequest->websocket_payload == protoRequest->websocket_message) {
+        if (singleFrame || msg_size == 0) {
             Q_EMIT request->webSocketTextMessage(frame, protoRequest->context);
         } else {
             const QString msg = toUtf16(protoRequest->websocket_message);
@@ -191,22 +248,23 @@ void ProtocolWebSocket::send_binary(Cutelyst::Context *c, Socket *sock, bool sin
     Cutelyst::Request *request = c->request();
     auto protoRequest          = static_cast<ProtoRequestHttp *>(sock->protoData);
 
-    protoRequest->websocket_message.append(protoRequest->websocket_payload);
-
     const QByteArray frame = protoRequest->websocket_payload;
     Q_EMIT request->webSocketBinaryFrame(
         frame, protoRequest->websocket_finn_opcode & 0x80, protoRequest->context);
 
     if (protoRequest->websocket_finn_opcode & 0x80) {
         protoRequest->websocket_continue_opcode = 0;
-        if (singleFrame || protoRequest->websocket_payload == protoRequest->websocket_message) {
+        if (singleFrame || protoRequest->websocket_message.isEmpty()) {
             Q_EMIT request->webSocketBinaryMessage(frame, protoRequest->context);
         } else {
+            protoRequest->websocket_message.append(frame);
             Q_EMIT request->webSocketBinaryMessage(protoRequest->websocket_message,
                                                    protoRequest->context);
         }
         protoRequest->websocket_message = QByteArray();
         protoRequest->websocket_payload = QByteArray();
+    } else {
+        protoRequest->websocket_message.append(frame);
     }
 }
 
@@ -281,11 +339,17 @@ bool ProtocolWebSocket::websocket_parse_header(Socket *sock, const char *buf, QI
 
     quint8 opcode = byte1 & 0xf;
 
+    // RSV1 marks compressed messages and is only valid on their first frame
+    const bool canBeCompressed = protoRequest->websocket_deflate &&
+                                 (opcode == ProtoRequestHttp::OpCodeText ||
+                                  opcode == ProtoRequestHttp::OpCodeBinary);
+    const quint8 rsvMask       = canBeCompressed ? 0x30 : 0x70;
+
     bool websocket_has_mask = byte2 >> 7;
     if (!websocket_has_mask ||
         ((opcode == ProtoRequestHttp::OpCodePing || opcode == ProtoRequestHttp::OpCodeClose) &&
          protoRequest->websocket_payload_size > 125) ||
-        (byte1 & 0x70) ||
+        (byte1 & rsvMask) ||
         ((opcode >= ProtoRequestHttp::OpCodeReserved3 &&
           opcode <= ProtoRequestHttp::OpCodeReserved7) ||
          (opcode >= ProtoRequestHttp::OpCodeReservedB &&
@@ -297,7 +361,7 @@ bool ProtocolWebSocket::websocket_parse_header(Socket *sock, const char *buf, QI
         // RFC errors
         // client to server MUST have a mask
         // Control opcode cannot have payload bigger than 125
-        // RSV bytes MUST not be set
+        // RSV bytes MUST not be set, except RSV1 when permessage-deflate was negotiated
         // reserved opcodes must not be set 3-7
         // reserved opcodes must not be set B-F
         // Only Text/Bynary/Coninue opcodes can be fragmented
@@ -311,98 +375,72 @@ bool ProtocolWebSocket::websocket_parse_header(Socket *sock, const char *buf, QI
     if (opcode == ProtoRequestHttp::OpCodeText || opcode == ProtoRequestHttp::OpCodeBinary) {
         protoRequest->websocket_message        = QByteArray();
         protoRequest->websocket_start_of_frame = 0;
+        protoRequest->websocket_compressed     = byte1 & ProtocolWebSocket::FlagCompressed;
         if (!(byte1 & 0x80)) {
             // FINN byte not set, store opcode for continue
             protoRequest->websocket_continue_opcode = opcode;
         }
     }
 
+    // Extended payload length followed by the mask
+    const char *ptr = buf + 2;
     if (protoRequest->websocket_payload_size == 126) {
-        protoRequest->websocket_need  = 2;
-        protoRequest->websocket_phase = ProtoRequestHttp::WebSocketPhase::WebSocketPhaseSize;
+        protoRequest->websocket_payload_size = net_be16(ptr);
+        ptr += 2;
     } else if (protoRequest->websocket_payload_size == 127) {
-        protoRequest->websocket_need  = 8;
-        protoRequest->websocket_phase = ProtoRequestHttp::WebSocketPhase::WebSocketPhaseSize;
-    } else {
-        protoRequest->websocket_need  = 4;
-        protoRequest->websocket_phase = ProtoRequestHttp::WebSocketPhase::WebSocketPhaseMask;
+        protoRequest->websocket_payload_size = net_be64(ptr);
+        ptr += 8;
     }
 
-    return true;
-}
-
-bool ProtocolWebSocket::websocket_parse_size(Socket *sock,
-                                             const char *buf,
-                                             int websockets_max_message_size) const
-{
-    auto protoRequest = static_cast<ProtoRequestHttp *>(sock->protoData);
-    quint64 size;
-    if (protoRequest->websocket_payload_size == 126) {
-        size = net_be16(buf);
-    } else if (protoRequest->websocket_payload_size == 127) {
-        size = net_be64(buf);
-    } else {
-        qCCritical(C_SERVER_WS) << "BUG error in websocket parser:"
-                                << protoRequest->websocket_payload_size;
+    if (protoRequest->websocket_payload_size > static_cast<quint64>(m_websockets_max_size)) {
+        qCCritical(C_SERVER_WS) << "Payload size too big" << protoRequest->websocket_payload_size
+                                << "max allowed" << m_websockets_max_size;
         sock->connectionClose();
         return false;
     }
+    std::memcpy(&protoRequest->websocket_mask, ptr, sizeof(protoRequest->websocket_mask));
 
-    if (size > static_cast<quint64>(websockets_max_message_size)) {
-        qCCritical(C_SERVER_WS) << "Payload size too big" << size << "max allowed"
-                                << websockets_max_message_size;
-        sock->connectionClose();
-        return false;
+    // Allocated once for the whole frame, the socket data is read directly into it
+    protoRequest->websocket_payload.resize(qsizetype(protoRequest->websocket_payload_size));
+    if (protoRequest->websocket_payload_size == 0) {
+        return websocket_parse_payload(sock, io);
     }
-    protoRequest->websocket_payload_size = size;
-
-    protoRequest->websocket_need  = 4;
-    protoRequest->websocket_phase = ProtoRequestHttp::WebSocketPhase::WebSocketPhaseMask;
-
-    return true;
-}
-
-void ProtocolWebSocket::websocket_parse_mask(Socket *sock, char *buf, QIODevice *io) const
-{
-    auto ptr                     = reinterpret_cast<const quint32 *>(buf);
-    auto protoRequest            = static_cast<ProtoRequestHttp *>(sock->protoData);
-    protoRequest->websocket_mask = *ptr;
 
     protoRequest->websocket_phase = ProtoRequestHttp::WebSocketPhase::WebSocketPhasePayload;
     protoRequest->websocket_need  = quint32(protoRequest->websocket_payload_size);
 
-    protoRequest->websocket_payload = QByteArray();
-    if (protoRequest->websocket_payload_size == 0) {
-        websocket_parse_payload(sock, buf, 0, io);
-    } else {
-        protoRequest->websocket_payload.reserve(int(protoRequest->websocket_payload_size));
-    }
+    return true;
 }
 
-bool ProtocolWebSocket::websocket_parse_payload(Socket *sock,
-                                                char *buf,
-                                                int len,
-                                                QIODevice *io) const
+bool ProtocolWebSocket::websocket_parse_payload(Socket *sock, QIODevice *io) const
 {
     auto protoRequest = static_cast<ProtoRequestHttp *>(sock->protoData);
-    const auto *mask  = reinterpret_cast<quint8 *>(&protoRequest->websocket_mask);
-    for (int i = 0, maskIx = protoRequest->websocket_payload.size(); i < len; ++i, ++maskIx) {
-        buf[i] = buf[i] ^ mask[maskIx % 4];
-    }
-
-    protoRequest->websocket_payload.append(buf, len);
-    if (quint64(protoRequest->websocket_payload.size()) < protoRequest->websocket_payload_size) {
-        // need more data
-        protoRequest->websocket_need -= uint(len);
-        return true;
-    }
 
     protoRequest->websocket_need  = 2;
     protoRequest->websocket_phase = ProtoRequestHttp::WebSocketPhase::WebSocketPhaseHeaders;
 
+    if (protoRequest->websocket_compressed && !websocket_inflate_payload(sock, io)) {
+        return false;
+    }
+
     Cutelyst::Request *request = protoRequest->context->request();
+    const quint8 opcode        = protoRequest->websocket_finn_opcode & 0xf;
+
+    if (keepAliveEnabled()) {
+        // Any frame shows the peer is alive, only messages keep it from being idle
+        const auto now                        = std::chrono::steady_clock::now();
+        protoRequest->websocket_last_received = now;
+        if (opcode == ProtoRequestHttp::OpCodeText || opcode == ProtoRequestHttp::OpCodeBinary ||
+            opcode == ProtoRequestHttp::OpCodeContinue) {
+            protoRequest->websocket_last_message = now;
+        }
+        if (protoRequest->websocket_awaiting_pong) {
+            protoRequest->websocket_awaiting_pong = false;
+            protoRequest->webSocketScheduleKeepAlive(now);
+        }
+    }
 
-    switch (protoRequest->websocket_finn_opcode & 0xf) {
+    switch (opcode) {
     case ProtoRequestHttp::OpCodeContinue:
         switch (protoRequest->websocket_continue_opcode) {
         case ProtoRequestHttp::OpCodeText:
@@ -414,8 +452,7 @@ bool ProtocolWebSocket::websocket_parse_payload(Socket *sock,
             send_binary(protoRequest->context, sock, false);
             break;
         default:
-            qCCritical(C_SERVER_WS)
-                << "Invalid CONTINUE opcode:" << (protoRequest->websocket_finn_opcode & 0xf);
+            qCCritical(C_SERVER_WS) << "Invalid CONTINUE opcode:" << opcode;
             sock->connectionClose();
             return false;
         }
@@ -444,3 +481,32 @@ bool ProtocolWebSocket::websocket_parse_payload(Socket *sock,
 
     return true;
 }
+
+bool ProtocolWebSocket::websocket_inflate_payload(Socket *sock, QIODevice *io) const
+{
+    auto protoRequest = static_cast<ProtoRequestHttp *>(sock->protoData);
+
+    const quint8 opcode = protoRequest->websocket_finn_opcode & 0xf;
+    if (opcode != ProtoRequestHttp::OpCodeText && opcode != ProtoRequestHttp::OpCodeBinary &&
+        opcode != ProtoRequestHttp::OpCodeContinue) {
+        // Control frames are never compressed
+        return true;
+    }
+
+    QByteArray inflated;
+    const qint64 maxSize = m_websockets_max_size - protoRequest->websocket_message.size();
+    if (!protoRequest->websocket_deflate->decompress(protoRequest->websocket_payload,
+                                                     protoRequest->websocket_finn_opcode & 0x80,
+                                                     inflated,
+                                                     maxSize)) {
+        const quint16 closeCode = inflated.size() > maxSize
+                                      ? Cutelyst::Response::CloseCodeTooMuchData
+                                      : Cutelyst::Response::CloseCodeProtocolError;
+        io->write(ProtocolWebSocket::createWebsocketCloseReply({}, closeCode));
+        sock->connectionClose();
+        return false;
+    }
+    protoRequest->websocket_payload = inflated;
+
+    return true;
+}
@@ -6,6 +6,17 @@
 #define PROTOCOLWEBSOCKET_H
 
 #include "protocol.h"
+#include "websocketdeflate.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#    include <arm_neon.h>
+#endif
 
 namespace Cutelyst {
 class Context;
@@ -18,6 +29,9 @@ public:
 
     Type type() const override;
 
+    // RSV1 bit set on the first frame of permessage-deflate compressed messages
+    static constexpr quint8 FlagCompressed = 0x40;
+
     static QByteArray createWebsocketHeader(quint8 opcode, quint64 len);
     static QByteArray createWebsocketCloseReply(const QString &msg, quint16 closeCode);
 
@@ -25,19 +39,106 @@ public:
 
     ProtocolData *createData(Socket *sock) const override final;
 
+    WebSocketDeflate *negotiateDeflate(const QByteArray &offers, QByteArray &response) const;
+
+    void counters(QVariantMap &counters) const;
+
+    enum class SlowConsumerPolicy {
+        Close,
+        DropOldest,
+        Coalesce,
+    };
+
+    qint64 m_writeHighWatermark;
+    qint64 m_writeLowWatermark;
+    SlowConsumerPolicy m_slowConsumerPolicy = SlowConsumerPolicy::Close;
+
+    mutable std::atomic<quint64> m_slowConsumerDropped   = 0;
+    mutable std::atomic<quint64> m_slowConsumerCoalesced = 0;
+    mutable std::atomic<quint64> m_slowConsumerClosed    = 0;
+    mutable std::atomic<qint64> m_heldBackBytes          = 0;
+
+    std::chrono::seconds m_pingInterval;
+    std::chrono::seconds m_pongTimeout;
+    std::chrono::seconds m_idleTimeout;
+
+    mutable std::atomic<quint64> m_keepAlivePings = 0;
+    mutable std::atomic<quint64> m_pongTimeouts   = 0;
+    mutable std::atomic<quint64> m_idleCloses     = 0;
+
+    [[nodiscard]] inline bool keepAliveEnabled() const noexcept
+    {
+        return m_pingInterval.count() || m_idleTimeout.count();
+    }
+
 private:
+    // 2 bytes header, 8 bytes extended payload length and 4 bytes mask
+    static constexpr int MaxHeaderSize = 14;
+
+    // Size of the whole frame header given its second byte
+    static constexpr int websocket_header_size(char byte2)
+    {
+        const int len = byte2 & 0x7f;
+        return 2 + (len == 126 ? 2 : (len == 127 ? 8 : 0)) + (byte2 & 0x80 ? 4 : 0);
+    }
+
     bool send_text(Cutelyst::Context *c, Socket *sock, bool singleFrame) const;
     void send_binary(Cutelyst::Context *c, Socket *sock, bool singleFrame) const;
     void send_pong(QIODevice *io, const QByteArray &data) const;
     void send_closed(const Context *c, Socket *sock, QIODevice *io) const;
     bool websocket_parse_header(Socket *sock, const char *buf, QIODevice *io) const;
-    bool websocket_parse_size(Socket *sock, const char *buf, int websockets_max_message_size) const;
-    void websocket_parse_mask(Socket *sock, char *buf, QIODevice *io) const;
-    bool websocket_parse_payload(Socket *sock, char *buf, int len, QIODevice *io) const;
+    bool websocket_parse_payload(Socket *sock, QIODevice *io) const;
+    bool websocket_inflate_payload(Socket *sock, QIODevice *io) const;
 
+    WebSocketDeflate::Options m_deflateOptions;
     int m_websockets_max_size;
+    bool m_deflate;
 };
 
+/**
+ * XORs \a len bytes of \a data with the frame \a mask, \a offset is the position of
+ * \a data in the frame payload so a payload can be unmasked as it arrives.
+ *
+ * The mask is rotated and widened once so the bulk of the data is handled 16 bytes
+ * at a time with SSE2/NEON, or 8 bytes at a time otherwise.
+ */
+inline void websocket_unmask(char *data, qint64 len, quint32 mask, quint64 offset)
+{
+    quint8 bytes[4];
+    std::memcpy(bytes, &mask, sizeof(bytes));
+
+    quint8 rotated[8];
+    for (int i = 0; i < 8; ++i) {
+        rotated[i] = bytes[(offset + quint64(i)) % 4];
+    }
+    quint64 wide;
+    std::memcpy(&wide, rotated, sizeof(wide));
+
+    qint64 i = 0;
+#if defined(__SSE2__)
+    const __m128i wide128 = _mm_set1_epi64x(static_cast<long long>(wide));
+    for (; i + 16 <= len; i += 16) {
+        auto ptr = reinterpret_cast<__m128i *>(data + i);
+        _mm_storeu_si128(ptr, _mm_xor_si128(_mm_loadu_si128(ptr), wide128));
+    }
+#elif defined(__ARM_NEON)
+    const uint8x16_t wide128 = vreinterpretq_u8_u64(vdupq_n_u64(wide));
+    for (; i + 16 <= len; i += 16) {
+        auto ptr = reinterpret_cast<uint8_t *>(data + i);
+        vst1q_u8(ptr, veorq_u8(vld1q_u8(ptr), wide128));
+    }
+#endif
+    for (; i + 8 <= len; i += 8) {
+        quint64 chunk;
+        std::memcpy(&chunk, data + i, sizeof(chunk));
+        chunk ^= wide;
+        std::memcpy(data + i, &chunk, sizeof(chunk));
+    }
+    for (; i < len; ++i) {
+        data[i] = char(data[i] ^ rotated[i % 8]);
+    }
+}
+
 } // namespace Cutelyst
 
 #endif // PROTOCOLWEBSOCKET_H
@@ -0,0 +1,256 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "proxyprotocol.h"
+
+#include "protocol.h"
+#include "socket.h"
+
+#include <QLoggingCategory>
+
+#include <utility>
+
+#ifdef Q_OS_UNIX
+#    include <errno.h>
+#    include <sys/socket.h>
+#    include <unistd.h>
+#endif
+
+Q_LOGGING_CATEGORY(C_SERVER_PROXY, "cutelyst.server.proxyprotocol", QtWarningMsg)
+
+using namespace Cutelyst;
+
+namespace {
+
+constexpr char V2Signature[12] =
+    {'\r', '\n', '\r', '\n', '\0', '\r', '\n', 'Q', 'U', 'I', 'T', '\n'};
+constexpr int V2HeaderSize = 16;
+
+// "PROXY TCP6 " + 2 * 39 + 2 * 5 + 3 spaces + CRLF
+constexpr int V1MaxSize = 107;
+
+// Enough for a whole version 1 header or the addresses of a version 2 one
+constexpr int PeekSize = V1MaxSize + 1;
+
+// Used when the socket timeout is disabled
+constexpr std::chrono::seconds DefaultTimeout{10};
+
+constexpr quint8 V2CommandLocal = 0x0;
+constexpr quint8 V2CommandProxy = 0x1;
+constexpr quint8 V2TcpOverIPv4  = 0x11;
+constexpr quint8 V2TcpOverIPv6  = 0x21;
+
+ProxyProtocol::Status parseV1(const char *data, int len, ProxyProtocol::Header &header)
+{
+    const auto *crlf =
+        static_cast<const char *>(memchr(data, '\r', size_t(qMin(len, V1MaxSize))));
+    if (!crlf || crlf + 1 == data + len) {
+        return len >= V1MaxSize ? ProxyProtocol::Status::Invalid
+                                : ProxyProtocol::Status::Incomplete;
+    }
+    if (crlf[1] != '\n') {
+        return ProxyProtocol::Status::Invalid;
+    }
+
+    const auto fields = QByteArrayView(data, crlf - data).toByteArray().split(' ');
+    header.size       = int(crlf - data) + 2;
+    if (fields.size() >= 2 && fields.at(1) == "UNKNOWN") {
+        header.local = true;
+        return ProxyProtocol::Status::Done;
+    }
+
+    if (fields.size() != 6 || (fields.at(1) != "TCP4" && fields.at(1) != "TCP6")) {
+        return ProxyProtocol::Status::Invalid;
+    }
+
+    bool ok;
+    header.sourcePort = fields.at(4).toUShort(&ok);
+    if (!ok || !header.sourceAddress.setAddress(QString::fromLatin1(fields.at(2)))) {
+        return ProxyProtocol::Status::Invalid;
+    }
+    return ProxyProtocol::Status::Done;
+}
+
+ProxyProtocol::Status parseV2(const char *data, int len, ProxyProtocol::Header &header)
+{
+    if (len < V2HeaderSize) {
+        return ProxyProtocol::Status::Incomplete;
+    }
+
+    const auto verCmd = quint8(data[12]);
+    const auto family = quint8(data[13]);
+    const int addrLen = net_be16(data + 14);
+    if ((verCmd & 0xF0) != 0x20) {
+        return ProxyProtocol::Status::Invalid;
+    }
+    header.size = V2HeaderSize + addrLen;
+
+    const quint8 command = verCmd & 0x0F;
+    if (command == V2CommandLocal) {
+        header.local = true;
+        return ProxyProtocol::Status::Done;
+    } else if (command != V2CommandProxy) {
+        return ProxyProtocol::Status::Invalid;
+    }
+
+    // The address block is followed by optional TLVs that are skipped
+    const char *addr = data + V2HeaderSize;
+    if (family == V2TcpOverIPv4) {
+        if (addrLen < 12) {
+            return ProxyProtocol::Status::Invalid;
+        } else if (len < V2HeaderSize + 12) {
+            return ProxyProtocol::Status::Incomplete;
+        }
+        header.sourceAddress.setAddress(net_be32(addr));
+        header.sourcePort = net_be16(addr + 8);
+    } else if (family == V2TcpOverIPv6) {
+        if (addrLen < 36) {
+            return ProxyProtocol::Status::Invalid;
+        } else if (len < V2HeaderSize + 36) {
+            return ProxyProtocol::Status::Incomplete;
+        }
+        header.sourceAddress.setAddress(reinterpret_cast<const quint8 *>(addr));
+        header.sourcePort = net_be16(addr + 32);
+    } else {
+        // UDP, UNIX or unspecified, there is no TCP peer to report
+        header.local = true;
+    }
+    return ProxyProtocol::Status::Done;
+}
+
+} // namespace
+
+void ProxyProtocol::Header::applyTo(Socket *sock) const
+{
+    if (!local) {
+        sock->remoteAddress = sourceAddress;
+        sock->remotePort    = sourcePort;
+    }
+}
+
+ProxyProtocol::Status ProxyProtocol::parse(const char *data, int len, Header &header)
+{
+    if (len <= 0) {
+        return Status::Incomplete;
+    }
+
+    if (data[0] == 'P') {
+        if (memcmp(data, "PROXY ", size_t(qMin(len, 6))) != 0) {
+            return Status::Invalid;
+        }
+        return parseV1(data, len, header);
+    }
+
+    if (memcmp(data, V2Signature, size_t(qMin(len, int(sizeof(V2Signature))))) != 0) {
+        return Status::Invalid;
+    }
+    return parseV2(data, len, header);
+}
+
+void ProxyProtocol::read(qintptr handle,
+                         std::chrono::seconds timeout,
+                         QObject *context,
+                         Callback callback)
+{
+    // Deletes itself once done
+    new ProxyProtocol(handle, timeout, context, std::move(callback));
+}
+
+ProxyProtocol::ProxyProtocol(qintptr handle,
+                             std::chrono::seconds timeout,
+                             QObject *context,
+                             Callback cb)
+    : QObject(context)
+    , m_notifier(handle, QSocketNotifier::Read)
+    , m_callback(std::move(cb))
+    , m_handle(handle)
+{
+    connect(&m_notifier, &QSocketNotifier::activated, this, &ProxyProtocol::readHeader);
+
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, [this] { abort("timed out"); });
+    m_timer.start(timeout.count() > 0 ? timeout : DefaultTimeout);
+
+    // Load balancers send it right after connecting, usually in the same packet as the data
+    readHeader();
+}
+
+ProxyProtocol::~ProxyProtocol()
+{
+    m_notifier.setEnabled(false);
+#ifdef Q_OS_UNIX
+    if (m_handle != -1) {
+        ::close(int(m_handle));
+    }
+#endif
+}
+
+void ProxyProtocol::readHeader()
+{
+#ifdef Q_OS_UNIX
+    const int fd = int(m_handle);
+    char buf[PeekSize];
+
+    if (m_skip == -1) {
+        const auto consumed = int(m_buffer.size());
+        const auto len = ::recv(fd, buf, size_t(PeekSize - consumed), MSG_PEEK | MSG_DONTWAIT);
+        if (len <= 0) {
+            if (len == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                abort("connection closed");
+            }
+            return;
+        }
+
+        m_buffer.append(buf, len);
+        switch (parse(m_buffer.constData(), int(m_buffer.size()), m_header)) {
+        case Status::Incomplete:
+            // All of it belongs to the header, leaving it in the kernel would keep the
+            // notifier firing until the rest arrives
+            if (::recv(fd, buf, size_t(len), MSG_DONTWAIT) != len) {
+                abort("connection closed");
+            } else if (m_buffer.size() >= PeekSize) {
+                abort("invalid header");
+            }
+            return;
+        case Status::Invalid:
+            abort("invalid header");
+            return;
+        case Status::Done:
+            m_skip = m_header.size - consumed;
+            m_buffer.clear();
+            break;
+        }
+    }
+
+    while (m_skip > 0) {
+        const auto len = ::recv(fd, buf, size_t(qMin<int>(m_skip, sizeof(buf))), MSG_DONTWAIT);
+        if (len <= 0) {
+            if (len == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                abort("connection closed");
+            }
+            return;
+        }
+        m_skip -= int(len);
+    }
+
+    m_notifier.setEnabled(false);
+    m_timer.stop();
+    m_callback(std::exchange(m_handle, -1), m_header);
+    deleteLater();
+#else
+    abort("not supported on this platform");
+#endif
+}
+
+void ProxyProtocol::abort(const char *reason)
+{
+    qCDebug(C_SERVER_PROXY) << "Dropping connection without PROXY header:" << reason;
+
+    // The descriptor is closed when deleted
+    m_notifier.setEnabled(false);
+    m_timer.stop();
+    deleteLater();
+}
+
+#include "moc_proxyprotocol.cpp"
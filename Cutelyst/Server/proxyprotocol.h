@@ -0,0 +1,93 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef PROXYPROTOCOL_H
+#define PROXYPROTOCOL_H
+
+#include <chrono>
+#include <functional>
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QObject>
+#include <QSocketNotifier>
+#include <QTimer>
+
+namespace Cutelyst {
+
+class Socket;
+
+/**
+ * Reads the PROXY protocol header, version 1 (text) or 2 (binary), that load balancers
+ * like HAProxy send before any connection data to tell the address of the real client.
+ *
+ * The header is read from the accepted descriptor before a Socket is created for it, it's
+ * peeked from the kernel and only its own bytes are consumed, so TLS handshakes and the
+ * protocol parsers see the stream as the client sent it. Bytes of a header that is not
+ * complete yet are consumed into a buffer, so the descriptor is only readable again once
+ * more of it arrives.
+ */
+class ProxyProtocol final : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Status {
+        Incomplete,
+        Done,
+        Invalid,
+    };
+
+    struct Header {
+        QHostAddress sourceAddress;
+        quint16 sourcePort = 0;
+        // Total bytes of the header, including TLVs of version 2
+        int size = 0;
+        // LOCAL or UNKNOWN connections, like health checks, keep the peer address
+        bool local = false;
+
+        void applyTo(Socket *sock) const;
+    };
+
+    using Callback = std::function<void(qintptr handle, const Header &header)>;
+
+    /**
+     * Parses the header at the start of \a data, Incomplete is returned while more bytes
+     * are needed to know the source address.
+     */
+    static Status parse(const char *data, int len, Header &header);
+
+    /**
+     * Waits for the header on the just accepted \a handle and calls \a callback from
+     * \a context with it. The descriptor is closed if the header is invalid or doesn't
+     * arrive within \a timeout, 0 uses a 10 seconds deadline as a connection that never
+     * sends it would otherwise be kept forever.
+     */
+    static void read(qintptr handle,
+                     std::chrono::seconds timeout,
+                     QObject *context,
+                     Callback callback);
+
+    ~ProxyProtocol() override;
+
+private:
+    ProxyProtocol(qintptr handle, std::chrono::seconds timeout, QObject *context, Callback cb);
+
+    void readHeader();
+    void abort(const char *reason);
+
+    QSocketNotifier m_notifier;
+    QTimer m_timer;
+    Callback m_callback;
+    Header m_header;
+    // Owned until handed to the callback
+    qintptr m_handle;
+    // Bytes of an incomplete header that were already consumed
+    QByteArray m_buffer;
+    // Header bytes still to be consumed once it was parsed
+    int m_skip = -1;
+};
+
+} // namespace Cutelyst
+
+#endif // PROXYPROTOCOL_H
@@ -0,0 +1,301 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "scoreboard.h"
+
+#include "server.h"
+#include "unixfork.h"
+
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <QCoreApplication>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+constexpr auto MemoryInterval = std::chrono::seconds{1};
+
+bool isRunning(qint64 pid)
+{
+    // Released once the master reaps the worker, which might have exited before that
+    return pid && ::kill(pid_t(pid), 0) == 0;
+}
+} // namespace
+
+void ScoreboardThread::setAction(const QByteArray &name)
+{
+    const quint32 sequence = actionSequence.load(std::memory_order_relaxed);
+    actionSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    qstrncpy(action, name.constData(), ActionSize);
+
+    actionSequence.store(sequence + 2, std::memory_order_release);
+}
+
+QByteArray ScoreboardThread::currentAction() const
+{
+    char copy[ActionSize];
+    quint32 sequence;
+    do {
+        sequence = actionSequence.load(std::memory_order_acquire);
+        memcpy(copy, action, ActionSize);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence & 1) || actionSequence.load(std::memory_order_relaxed) != sequence);
+
+    return QByteArray(copy, qsizetype(qstrnlen(copy, ActionSize)));
+}
+
+Scoreboard::Scoreboard(int slots, int threads, Server *server)
+    : QObject(server)
+    , m_server(server)
+    , m_masterPid(QCoreApplication::applicationPid())
+    , m_slotCount(slots)
+    , m_threadCount(threads)
+{
+    const size_t workersSize = sizeof(ScoreboardWorker) * size_t(slots);
+    const size_t threadsSize = sizeof(ScoreboardThread) * size_t(slots * threads);
+    // Threads first, so they keep their alignment
+    m_size = threadsSize + workersSize;
+
+    void *memory =
+        mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        std::cerr << "Failed to allocate the scoreboard: " << strerror(errno) << '\n';
+        return;
+    }
+
+    m_threads = static_cast<ScoreboardThread *>(memory);
+    m_workers = reinterpret_cast<ScoreboardWorker *>(static_cast<char *>(memory) + threadsSize);
+    for (int i = 0; i < slots * threads; ++i) {
+        new (m_threads + i) ScoreboardThread;
+    }
+    for (int i = 0; i < slots; ++i) {
+        new (m_workers + i) ScoreboardWorker;
+    }
+}
+
+Scoreboard::~Scoreboard()
+{
+    if (m_threads) {
+        munmap(m_threads, m_size);
+    }
+}
+
+bool Scoreboard::listen(const QString &address)
+{
+    if (!m_threads) {
+        return false;
+    }
+
+    if (address.startsWith(u'/')) {
+        m_localServer = new QLocalServer(this);
+        QLocalServer::removeServer(address);
+        if (!m_localServer->listen(address)) {
+            std::cerr << "Failed to listen on stats socket " << qPrintable(address) << ": "
+                      << qPrintable(m_localServer->errorString()) << '\n';
+            return false;
+        }
+
+        connect(m_localServer, &QLocalServer::newConnection, this, [this] {
+            while (QLocalSocket *socket = m_localServer->nextPendingConnection()) {
+                serve(socket);
+                connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+                socket->disconnectFromServer();
+            }
+        });
+    } else {
+        const QString host = address.section(u':', 0, -2);
+        bool ok;
+        const quint16 port = address.section(u':', -1).toUShort(&ok);
+        QHostAddress hostAddress(QHostAddress::Any);
+        if (!host.isEmpty()) {
+            hostAddress.setAddress(host.startsWith(u'[') ? host.mid(1, host.size() - 2) : host);
+        }
+
+        m_tcpServer = new QTcpServer(this);
+        if (!ok || !m_tcpServer->listen(hostAddress, port)) {
+            std::cerr << "Failed to listen on stats socket " << qPrintable(address) << ": "
+                      << qPrintable(m_tcpServer->errorString()) << '\n';
+            return false;
+        }
+
+        connect(m_tcpServer, &QTcpServer::newConnection, this, [this] {
+            while (QTcpSocket *socket = m_tcpServer->nextPendingConnection()) {
+                serve(socket);
+                connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+                socket->disconnectFromHost();
+            }
+        });
+    }
+
+    std::cout << "Stats socket bound to " << qPrintable(address) << '\n';
+    return true;
+}
+
+void Scoreboard::postFork(int slot, int workerId)
+{
+    if (!m_threads) {
+        return;
+    }
+
+    if (!isMaster()) {
+        // Only the master serves the stats
+        delete m_tcpServer;
+        m_tcpServer = nullptr;
+        delete m_localServer;
+        m_localServer = nullptr;
+    }
+
+    m_slot   = slot;
+    m_worker = m_workers + slot;
+    for (int i = 0; i < m_threadCount; ++i) {
+        // A new worker starts counting from zero
+        new (thread(i)) ScoreboardThread;
+    }
+    m_worker->id      = workerId + 1;
+    m_worker->pid     = QCoreApplication::applicationPid();
+    m_worker->started = std::time(nullptr);
+
+    updateMemory();
+    m_memoryTimer = new QTimer(this);
+    m_memoryTimer->setInterval(MemoryInterval);
+    connect(m_memoryTimer, &QTimer::timeout, this, &Scoreboard::updateMemory);
+    m_memoryTimer->start();
+}
+
+void Scoreboard::releaseSlot(int slot)
+{
+    if (m_workers && slot >= 0 && slot < m_slotCount) {
+        m_workers[slot].pid.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool Scoreboard::isMaster() const
+{
+    return QCoreApplication::applicationPid() == m_masterPid;
+}
+
+ScoreboardThread *Scoreboard::thread(int workerCore) const
+{
+    if (!m_threads) {
+        return nullptr;
+    }
+    return m_threads + m_slot * m_threadCount + workerCore;
+}
+
+QJsonObject Scoreboard::toJson() const
+{
+    QJsonArray workers;
+    for (int i = 0; i < m_slotCount && m_threads; ++i) {
+        const ScoreboardWorker &worker = m_workers[i];
+        if (!isRunning(worker.pid)) {
+            continue;
+        }
+
+        QJsonArray threads;
+        qint64 requests    = 0;
+        qint64 inFlight    = 0;
+        qint64 connections = 0;
+        qint64 bytesIn     = 0;
+        qint64 bytesOut    = 0;
+        qint64 lastRequest = 0;
+        for (int core = 0; core < m_threadCount; ++core) {
+            const ScoreboardThread &slot = m_threads[i * m_threadCount + core];
+            const QJsonObject thread{
+                {u"id"_s, core},
+                {u"requests"_s, qint64(slot.requests.load(std::memory_order_relaxed))},
+                {u"in_flight"_s, slot.inFlight.load(std::memory_order_relaxed)},
+                {u"connections"_s, slot.connections.load(std::memory_order_relaxed)},
+                {u"bytes_in"_s, qint64(slot.bytesIn.load(std::memory_order_relaxed))},
+                {u"bytes_out"_s, qint64(slot.bytesOut.load(std::memory_order_relaxed))},
+                {u"last_request"_s, slot.lastRequest.load(std::memory_order_relaxed)},
+                {u"action"_s, QString::fromUtf8(slot.currentAction())},
+            };
+            requests += thread[u"requests"_s].toInteger();
+            inFlight += thread[u"in_flight"_s].toInteger();
+            connections += thread[u"connections"_s].toInteger();
+            bytesIn += thread[u"bytes_in"_s].toInteger();
+            bytesOut += thread[u"bytes_out"_s].toInteger();
+            lastRequest = qMax(lastRequest, thread[u"last_request"_s].toInteger());
+            threads.append(thread);
+        }
+
+        workers.append(QJsonObject{
+            {u"id"_s, worker.id.load(std::memory_order_relaxed)},
+            {u"pid"_s, worker.pid.load(std::memory_order_relaxed)},
+            {u"started"_s, worker.started.load(std::memory_order_relaxed)},
+            {u"rss"_s, worker.rss.load(std::memory_order_relaxed)},
+            {u"requests"_s, requests},
+            {u"in_flight"_s, inFlight},
+            {u"connections"_s, connections},
+            {u"bytes_in"_s, bytesIn},
+            {u"bytes_out"_s, bytesOut},
+            {u"last_request"_s, lastRequest},
+            {u"threads"_s, threads},
+        });
+    }
+
+    return {
+        {u"pid"_s, m_masterPid},
+        {u"workers"_s, workers},
+        {u"counters"_s, QJsonObject::fromVariantMap(m_server->counters())},
+    };
+}
+
+QByteArray Scoreboard::summary() const
+{
+    int workers        = 0;
+    quint64 requests   = 0;
+    qint64 inFlight    = 0;
+    qint64 connections = 0;
+    qint64 rss         = 0;
+    for (int i = 0; i < m_slotCount && m_threads; ++i) {
+        if (!isRunning(m_workers[i].pid)) {
+            continue;
+        }
+
+        ++workers;
+        rss += m_workers[i].rss.load(std::memory_order_relaxed);
+        for (int core = 0; core < m_threadCount; ++core) {
+            const ScoreboardThread &slot = m_threads[i * m_threadCount + core];
+            requests += slot.requests.load(std::memory_order_relaxed);
+            inFlight += slot.inFlight.load(std::memory_order_relaxed);
+            connections += slot.connections.load(std::memory_order_relaxed);
+        }
+    }
+
+    return QByteArray::number(workers) + " workers, " + QByteArray::number(requests) +
+           " requests, " + QByteArray::number(inFlight) + " in flight, " +
+           QByteArray::number(connections) + " connections, " +
+           QByteArray::number(rss / (1024 * 1024)) + " MB";
+}
+
+void Scoreboard::serve(QIODevice *socket)
+{
+    socket->write(QJsonDocument(toJson()).toJson(QJsonDocument::Compact) + '\n');
+}
+
+void Scoreboard::updateMemory()
+{
+    qint64 rss = 0;
+    qint64 as  = 0;
+    UnixFork::memoryUsage(&rss, &as);
+    m_worker->rss.store(rss, std::memory_order_relaxed);
+}
+
+#include "moc_scoreboard.cpp"
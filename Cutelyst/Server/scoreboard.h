@@ -0,0 +1,156 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <atomic>
+#include <ctime>
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QObject>
+
+class QTcpServer;
+class QLocalServer;
+class QTimer;
+
+namespace Cutelyst {
+
+class Server;
+
+/**
+ * Counters of an engine thread, it lives in memory shared with the master which reads
+ * them to report the server status. Only the engine thread writes them, so updates are
+ * relaxed loads and stores instead of read-modify-write operations.
+ */
+struct alignas(64) ScoreboardThread {
+    static constexpr int ActionSize = 128;
+
+    std::atomic<quint64> requests{0};
+    std::atomic<quint64> bytesIn{0};
+    std::atomic<quint64> bytesOut{0};
+    // Seconds since epoch the last request started at
+    std::atomic<qint64> lastRequest{0};
+    std::atomic<qint32> inFlight{0};
+    std::atomic<qint32> connections{0};
+    // Odd while action is being written
+    std::atomic<quint32> actionSequence{0};
+    char action[ActionSize]{};
+
+    inline void requestStarted()
+    {
+        add(inFlight, 1);
+        lastRequest.store(std::time(nullptr), std::memory_order_relaxed);
+    }
+
+    inline void requestFinished()
+    {
+        add(inFlight, -1);
+        add(requests, quint64(1));
+    }
+
+    inline void addBytesIn(qint64 len) { add(bytesIn, quint64(len)); }
+    inline void addBytesOut(qint64 len) { add(bytesOut, quint64(len)); }
+    inline void connectionOpened() { add(connections, 1); }
+    inline void connectionClosed() { add(connections, -1); }
+
+    /**
+     * Sets the name of the action dispatched last.
+     */
+    void setAction(const QByteArray &name);
+
+    /**
+     * Returns the name of the action dispatched last, it's safe to call from any process.
+     */
+    QByteArray currentAction() const;
+
+private:
+    template <typename T>
+    static inline void add(std::atomic<T> &counter, T value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value,
+                      std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Worker process of the scoreboard.
+ */
+struct ScoreboardWorker {
+    // 0 while the slot is free
+    std::atomic<qint64> pid{0};
+    // Counted from 1, a replacement has the id of the worker it replaces
+    std::atomic<int> id{0};
+    // Seconds since epoch the worker was started at
+    std::atomic<qint64> started{0};
+    std::atomic<qint64> rss{0};
+};
+
+/**
+ * Status of every worker process and engine thread, allocated by the master before it
+ * forks so they all share it. The master serves it as JSON on the stats socket.
+ *
+ * Each worker process has its own slot, handed out by the master, so that replacements
+ * don't overwrite the workers they replace while those still drain.
+ */
+class Scoreboard final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Scoreboard(int slots, int threads, Server *server);
+    ~Scoreboard() override;
+
+    /**
+     * Serves the scoreboard to each connection on \a address, either [address]:port or the
+     * path of a local socket. The JSON document is written and the connection closed.
+     */
+    bool listen(const QString &address);
+
+    /**
+     * Takes \a slot, counted from 0, for the worker \a workerId in the process that runs its
+     * engines, worker processes stop serving the stats socket of the master.
+     */
+    void postFork(int slot, int workerId);
+
+    /**
+     * Leaves \a slot out of the status once the master reaped the worker that had it.
+     */
+    void releaseSlot(int slot);
+
+    /**
+     * Returns true in the process that allocated the scoreboard.
+     */
+    bool isMaster() const;
+
+    /**
+     * Returns the slot of the engine thread \a workerCore of this worker.
+     */
+    ScoreboardThread *thread(int workerCore) const;
+
+    QJsonObject toJson() const;
+
+    /**
+     * Returns a one line summary, suitable for the systemd status.
+     */
+    QByteArray summary() const;
+
+private:
+    void serve(QIODevice *socket);
+    void updateMemory();
+
+    Server *m_server;
+    ScoreboardWorker *m_workers = nullptr;
+    ScoreboardThread *m_threads = nullptr;
+    ScoreboardWorker *m_worker  = nullptr;
+    QTcpServer *m_tcpServer     = nullptr;
+    QLocalServer *m_localServer = nullptr;
+    QTimer *m_memoryTimer       = nullptr;
+    size_t m_size;
+    qint64 m_masterPid;
+    int m_slotCount;
+    int m_threadCount;
+    int m_slot = 0;
+};
+
+} // namespace Cutelyst
@@ -2,17 +2,34 @@
  * SPDX-FileCopyrightText: (C) 2016-2022 Daniel Nicoletti <dantti12@gmail.com>
  * SPDX-License-Identifier: BSD-3-Clause
  */
+#include "accesslog.h"
+#include "loadmonitor.h"
 #include "localserver.h"
+#include "metrics.h"
 #include "protocol.h"
 #include "protocolfastcgi.h"
+#include "protocoluwsgi.h"
 #include "protocolhttp.h"
 #include "protocolhttp2.h"
 #include "server_p.h"
 #include "serverengine.h"
+#include "slowrequest.h"
 #include "socket.h"
 #include "tcpserverbalancer.h"
+#include "traceexporter.h"
+
+#include <Cutelyst/Action>
+#include <Cutelyst/Context>
+#include <Cutelyst/Request>
+#include <Cutelyst/Response>
+
+#ifdef HAS_OPENSSL
+#    include "tlssessioncache.h"
+#endif
 
 #ifdef Q_OS_UNIX
+#    include "harakiri.h"
+#    include "scoreboard.h"
 #    include "unixfork.h"
 #else
 #    include "windowsfork.h"
@@ -21,6 +38,9 @@
 #ifdef Q_OS_LINUX
 #    include "../EventLoopEPoll/eventdispatcher_epoll.h"
 #    include "systemdnotify.h"
+
+#    include <sys/socket.h>
+#    include <unistd.h>
 #endif
 
 #include <iostream>
@@ -76,6 +96,9 @@ Server::Server(QObject *parent)
         delete d->protoFCGI;
         d->protoFCGI = nullptr;
 
+        delete d->protoUwsgi;
+        d->protoUwsgi = nullptr;
+
         qDeleteAll(d->engines);
         d->engines.clear();
         d->mainEngine = nullptr;
@@ -253,6 +276,34 @@ void Server::parseCommandLine(const QStringList &arguments)
                                                qtTrId("cutelystd-opt-value-size"));
     parser.addOption(http2HeaderTableSizeOpt);
 
+    QCommandLineOption http2MaxConcurrentStreamsOpt(
+        u"http2-max-concurrent-streams"_s,
+        //: CLI option description
+        //% "Sets the maximum number of concurrent streams of a HTTP/2 connection."
+        qtTrId("cutelystd-opt-http2-max-concurrent-streams-desc"),
+        //: CLI option value name
+        //% "number"
+        qtTrId("cutelystd-opt-value-number"));
+    parser.addOption(http2MaxConcurrentStreamsOpt);
+
+    QCommandLineOption http2MaxInflightRequestsOpt(
+        u"http2-max-inflight-requests"_s,
+        //: CLI option description
+        //% "Sets the maximum number of requests of a HTTP/2 connection processed at the same "
+        //% "time, 0 means unlimited."
+        qtTrId("cutelystd-opt-http2-max-inflight-requests-desc"),
+        qtTrId("cutelystd-opt-value-number"));
+    parser.addOption(http2MaxInflightRequestsOpt);
+
+    QCommandLineOption http2MaxResetStreamsOpt(
+        u"http2-max-reset-streams"_s,
+        //: CLI option description
+        //% "Sets the maximum number of streams a HTTP/2 client can reset per second before the "
+        //% "connection is closed, 0 disables the check."
+        qtTrId("cutelystd-opt-http2-max-reset-streams-desc"),
+        qtTrId("cutelystd-opt-value-number"));
+    parser.addOption(http2MaxResetStreamsOpt);
+
     QCommandLineOption upgradeH2cOpt(u"upgrade-h2c"_s,
                                      //: CLI option description
                                      //% "Upgrades HTTP/1 to H2c (HTTP/2 Clear Text)."
@@ -265,6 +316,44 @@ void Server::parseCommandLine(const QStringList &arguments)
                                   qtTrId("cutelystd-opt-https-h2-desc"));
     parser.addOption(httpsH2Opt);
 
+    QCommandLineOption tlsSessionCacheOpt(
+        u"tls-session-cache"_s,
+        //: CLI option description
+        //% "Sets the number of TLS sessions cached in memory shared by all workers, 0 "
+        //% "disables it. Default value: 0."
+        qtTrId("cutelystd-opt-tls-session-cache-desc"),
+        qtTrId("cutelystd-opt-value-number"));
+    parser.addOption(tlsSessionCacheOpt);
+
+    QCommandLineOption tlsTicketKeyLifetimeOpt(
+        u"tls-ticket-key-lifetime"_s,
+        //: CLI option description
+        //% "Sets the seconds a TLS session ticket key is used before being rotated. "
+        //% "Default value: 3600."
+        qtTrId("cutelystd-opt-tls-ticket-key-lifetime-desc"),
+        //: CLI option value name
+        //% "seconds"
+        qtTrId("cutelystd-opt-value-seconds"));
+    parser.addOption(tlsTicketKeyLifetimeOpt);
+
+    QCommandLineOption ktlsOpt(u"ktls"_s,
+                               //: CLI option description
+                               //% "Hand the TLS keys to the kernel after the handshake (kTLS), "
+                               //% "needs the openssl TLS backend."
+                               qtTrId("cutelystd-opt-ktls-desc"));
+    parser.addOption(ktlsOpt);
+
+    QCommandLineOption tlsBackendOpt(
+        u"tls-backend"_s,
+        //: CLI option description
+        //% "Sets how HTTPS sockets are encrypted: qt (QSslSocket) or openssl. "
+        //% "Default value: openssl if --tls-session-cache or --ktls are set, qt otherwise."
+        qtTrId("cutelystd-opt-tls-backend-desc"),
+        //: CLI option value name
+        //% "backend"
+        qtTrId("cutelystd-opt-tls-backend-value"));
+    parser.addOption(tlsBackendOpt);
+
     QCommandLineOption httpsSocketOpt({u"https-socket"_s, u"hs1"_s},
                                       //: CLI option description
                                       //% "Bind to the specified TCP socket using HTTPS protocol."
@@ -281,6 +370,32 @@ void Server::parseCommandLine(const QStringList &arguments)
         qtTrId("cutelystd-opt-value-address"));
     parser.addOption(fastcgiSocketOpt);
 
+    QCommandLineOption fastcgiMaxRequestsOpt(
+        u"fastcgi-max-requests"_s,
+        //: CLI option description
+        //% "Sets the maximum number of requests multiplexed on a FastCGI connection, 1 "
+        //% "disables multiplexing. Default value: 64."
+        qtTrId("cutelystd-opt-fastcgi-max-requests-desc"),
+        qtTrId("cutelystd-opt-value-number"));
+    parser.addOption(fastcgiMaxRequestsOpt);
+
+    QCommandLineOption uwsgiSocketOpt(
+        u"uwsgi-socket"_s,
+        //: CLI option description
+        //% "Bind to the specified UNIX/TCP socket using uwsgi protocol."
+        qtTrId("cutelystd-opt-uwsgi-socket-desc"),
+        qtTrId("cutelystd-opt-value-address"));
+    parser.addOption(uwsgiSocketOpt);
+
+    QCommandLineOption proxyProtocolOpt(
+        u"proxy-protocol"_s,
+        //: CLI option description
+        //% "Expect the PROXY protocol header on connections to the specified socket, the "
+        //% "address must match the one given to a socket option."
+        qtTrId("cutelystd-opt-proxy-protocol-desc"),
+        qtTrId("cutelystd-opt-value-address"));
+    parser.addOption(proxyProtocolOpt);
+
     QCommandLineOption socketAccessOpt(
         u"socket-access"_s,
         //: CLI option description
@@ -338,6 +453,158 @@ void Server::parseCommandLine(const QStringList &arguments)
         qtTrId("cutelystd-opt-value-file"));
     parser.addOption(touchReloadOpt);
 
+    QCommandLineOption rollingReloadOpt(
+        u"rolling-reload"_s,
+        //: CLI option description
+        //% "Reload workers this many at a time, each old worker is stopped once its "
+        //% "replacement is ready. Master process has to be enabled."
+        qtTrId("cutelystd-opt-rolling-reload-desc"),
+        qtTrId("cutelystd-opt-value-number"));
+    parser.addOption(rollingReloadOpt);
+
+    QCommandLineOption workerReloadMercyOpt(
+        u"worker-reload-mercy"_s,
+        //: CLI option description
+        //% "Time a worker told to exit has to finish its requests before it is killed. "
+        //% "Default value: 0, the harakiri timeout when set, 60 seconds otherwise."
+        qtTrId("cutelystd-opt-worker-reload-mercy-desc"),
+        qtTrId("cutelystd-opt-value-seconds"));
+    parser.addOption(workerReloadMercyOpt);
+
+    QCommandLineOption cheaperOpt(
+        u"cheaper"_s,
+        //: CLI option description
+        //% "Minimum number of worker processes, more are spawned up to the number of "
+        //% "processes when the load requires. Master process has to be enabled."
+        qtTrId("cutelystd-opt-cheaper-desc"),
+        qtTrId("cutelystd-opt-value-number"));
+    parser.addOption(cheaperOpt);
+
+    QCommandLineOption cheaperStepOpt(
+        u"cheaper-step"_s,
+        //: CLI option description
+        //% "Number of workers spawned or stopped at once by the cheaper mode. Default value: 1."
+        qtTrId("cutelystd-opt-cheaper-step-desc"),
+        qtTrId("cutelystd-opt-value-number"));
+    parser.addOption(cheaperStepOpt);
+
+    QCommandLineOption cheaperCooldownOpt(
+        u"cheaper-cooldown"_s,
+        //: CLI option description
+        //% "Minimum number of seconds between two decisions of the cheaper mode. "
+        //% "Default value: 10."
+        qtTrId("cutelystd-opt-cheaper-cooldown-desc"),
+        qtTrId("cutelystd-opt-value-seconds"));
+    parser.addOption(cheaperCooldownOpt);
+
+    QCommandLineOption maxRequestsOpt(
+        u"max-requests"_s,
+        //: CLI option description
+        //% "Recycle a worker after it served this many requests, it is replaced before it "
+        //% "stops. Default value: 0, disabled."
+        qtTrId("cutelystd-opt-max-requests-desc"),
+        qtTrId("cutelystd-opt-value-number"));
+    parser.addOption(maxRequestsOpt);
+
+    QCommandLineOption reloadOnRssOpt(
+        u"reload-on-rss"_s,
+        //: CLI option description
+        //% "Recycle a worker once its resident memory is larger than this. "
+        //% "Default value: 0, disabled."
+        qtTrId("cutelystd-opt-reload-on-rss-desc"),
+        //: CLI option value name
+        //% "megabytes"
+        qtTrId("cutelystd-opt-value-megabytes"));
+    parser.addOption(reloadOnRssOpt);
+
+    QCommandLineOption reloadOnAsOpt(
+        u"reload-on-as"_s,
+        //: CLI option description
+        //% "Recycle a worker once its address space is larger than this. "
+        //% "Default value: 0, disabled."
+        qtTrId("cutelystd-opt-reload-on-as-desc"),
+        qtTrId("cutelystd-opt-value-megabytes"));
+    parser.addOption(reloadOnAsOpt);
+
+    QCommandLineOption maxWorkerLifetimeOpt(
+        u"max-worker-lifetime"_s,
+        //: CLI option description
+        //% "Recycle a worker after it has been running for this long. "
+        //% "Default value: 0, disabled."
+        qtTrId("cutelystd-opt-max-worker-lifetime-desc"),
+        qtTrId("cutelystd-opt-value-seconds"));
+    parser.addOption(maxWorkerLifetimeOpt);
+
+    QCommandLineOption harakiriOpt(
+        u"harakiri"_s,
+        //: CLI option description
+        //% "Log requests that keep their thread busy for longer than this, with a "
+        //% "backtrace of the thread, and recycle their worker. Default value: 0, disabled."
+        qtTrId("cutelystd-opt-harakiri-desc"),
+        qtTrId("cutelystd-opt-value-seconds"));
+    parser.addOption(harakiriOpt);
+
+    QCommandLineOption logSlowOpt(
+        u"log-slow"_s,
+        //: CLI option description
+        //% "Log requests that keep their thread busy for longer than this, with the time "
+        //% "spent dispatching, rendering views and writing the body. "
+        //% "Default value: 0, disabled."
+        qtTrId("cutelystd-opt-log-slow-desc"),
+        //: CLI option value name
+        //% "milliseconds"
+        qtTrId("cutelystd-opt-value-milliseconds"));
+    parser.addOption(logSlowOpt);
+
+    QCommandLineOption statsOpt(
+        u"stats"_s,
+        //: CLI option description
+        //% "Serve the status of the workers as JSON on this TCP address or local socket "
+        //% "path from the master process."
+        qtTrId("cutelystd-opt-stats-desc"),
+        qtTrId("cutelystd-opt-value-address"));
+    parser.addOption(statsOpt);
+
+    QCommandLineOption metricsOpt(
+        u"metrics"_s,
+        //: CLI option description
+        //% "Answer requests to this path with request latency histograms in the "
+        //% "OpenMetrics format."
+        qtTrId("cutelystd-opt-metrics-desc"),
+        //: CLI option value name
+        //% "path"
+        qtTrId("cutelystd-opt-value-path"));
+    parser.addOption(metricsOpt);
+
+    QCommandLineOption traceExportOpt(
+        u"trace-export"_s,
+        //: CLI option description
+        //% "Append the spans of traced requests to this file in the OTLP/JSON format."
+        qtTrId("cutelystd-opt-trace-export-desc"),
+        qtTrId("cutelystd-opt-value-file"));
+    parser.addOption(traceExportOpt);
+
+    QCommandLineOption accessLogOpt(
+        u"access-log"_s,
+        //: CLI option description
+        //% "Append a line for each request to this file, written in batches by a "
+        //% "background thread of each worker. Reopened on SIGUSR1."
+        qtTrId("cutelystd-opt-access-log-desc"),
+        qtTrId("cutelystd-opt-value-file"));
+    parser.addOption(accessLogOpt);
+
+    QCommandLineOption accessLogFormatOpt(
+        u"access-log-format"_s,
+        //: CLI option description
+        //% "Format of the access log lines with nginx like variables such as "
+        //% "$remote_addr, $request, $status and $request_time. Default value: the "
+        //% "combined log format."
+        qtTrId("cutelystd-opt-access-log-format-desc"),
+        //: CLI option value name
+        //% "format"
+        qtTrId("cutelystd-opt-value-format"));
+    parser.addOption(accessLogFormatOpt);
+
     QCommandLineOption tcpNoDelay(u"tcp-nodelay"_s,
                                   //: CLI option description
                                   //% "Enable TCP NODELAY on each request."
@@ -376,6 +643,93 @@ void Server::parseCommandLine(const QStringList &arguments)
                                  qtTrId("cutelystd-opt-websocket-max-size-value"));
     parser.addOption(wsMaxSize);
 
+    QCommandLineOption wsCompressionOpt(
+        u"websocket-compression"_s,
+        //: CLI option description
+        //% "Enables the permessage-deflate websocket extension."
+        qtTrId("cutelystd-opt-websocket-compression-desc"));
+    parser.addOption(wsCompressionOpt);
+
+    QCommandLineOption wsCompressionWindowBitsOpt(
+        u"websocket-compression-window-bits"_s,
+        //: CLI option description
+        //% "Maximum LZ77 window size between 9 and 15 used by websocket compression. "
+        //% "Default value: 15."
+        qtTrId("cutelystd-opt-websocket-compression-window-bits-desc"),
+        qtTrId("cutelystd-opt-value-number"));
+    parser.addOption(wsCompressionWindowBitsOpt);
+
+    QCommandLineOption wsCompressionMemLevelOpt(
+        u"websocket-compression-mem-level"_s,
+        //: CLI option description
+        //% "Memory level between 1 and 9 used by websocket compression. Default value: 8."
+        qtTrId("cutelystd-opt-websocket-compression-mem-level-desc"),
+        qtTrId("cutelystd-opt-value-number"));
+    parser.addOption(wsCompressionMemLevelOpt);
+
+    QCommandLineOption wsCompressionNoContextTakeoverOpt(
+        u"websocket-compression-no-context-takeover"_s,
+        //: CLI option description
+        //% "Compresses each websocket message independently."
+        qtTrId("cutelystd-opt-websocket-compression-no-context-takeover-desc"));
+    parser.addOption(wsCompressionNoContextTakeoverOpt);
+
+    QCommandLineOption wsWriteHighWatermarkOpt(
+        u"websocket-write-high-watermark"_s,
+        //: CLI option description
+        //% "Outgoing data in kibibytes buffered for a websocket connection above which the "
+        //% "slow consumer policy is applied. Default value: 0 (unlimited)."
+        qtTrId("cutelystd-opt-websocket-write-high-watermark-desc"),
+        qtTrId("cutelystd-opt-websocket-max-size-value"));
+    parser.addOption(wsWriteHighWatermarkOpt);
+
+    QCommandLineOption wsWriteLowWatermarkOpt(
+        u"websocket-write-low-watermark"_s,
+        //: CLI option description
+        //% "Outgoing data in kibibytes a slow websocket consumer must drain to before it is "
+        //% "writable again. Default value: a quarter of the high watermark."
+        qtTrId("cutelystd-opt-websocket-write-low-watermark-desc"),
+        qtTrId("cutelystd-opt-websocket-max-size-value"));
+    parser.addOption(wsWriteLowWatermarkOpt);
+
+    QCommandLineOption wsSlowConsumerPolicyOpt(
+        u"websocket-slow-consumer-policy"_s,
+        //: CLI option description
+        //% "What to do with messages sent to a websocket connection above the high "
+        //% "watermark: close, drop-oldest or coalesce. Default value: close."
+        qtTrId("cutelystd-opt-websocket-slow-consumer-policy-desc"),
+        //: CLI option value name
+        //% "policy"
+        qtTrId("cutelystd-opt-websocket-slow-consumer-policy-value"));
+    parser.addOption(wsSlowConsumerPolicyOpt);
+
+    QCommandLineOption wsPingIntervalOpt(
+        u"websocket-ping-interval"_s,
+        //: CLI option description
+        //% "Interval in seconds to ping websocket connections that have been quiet. "
+        //% "Default value: 0 (disabled)."
+        qtTrId("cutelystd-opt-websocket-ping-interval-desc"),
+        qtTrId("cutelystd-opt-socket-timeout-value"));
+    parser.addOption(wsPingIntervalOpt);
+
+    QCommandLineOption wsPongTimeoutOpt(
+        u"websocket-pong-timeout"_s,
+        //: CLI option description
+        //% "Seconds to wait for an answer to a websocket ping before closing the "
+        //% "connection. Default value: 10."
+        qtTrId("cutelystd-opt-websocket-pong-timeout-desc"),
+        qtTrId("cutelystd-opt-socket-timeout-value"));
+    parser.addOption(wsPongTimeoutOpt);
+
+    QCommandLineOption wsIdleTimeoutOpt(
+        u"websocket-idle-timeout"_s,
+        //: CLI option description
+        //% "Seconds without websocket messages from the peer before the connection is "
+        //% "closed. Default value: 0 (disabled)."
+        qtTrId("cutelystd-opt-websocket-idle-timeout-desc"),
+        qtTrId("cutelystd-opt-socket-timeout-value"));
+    parser.addOption(wsIdleTimeoutOpt);
+
     QCommandLineOption pidfileOpt(u"pidfile"_s,
                                   //: CLI option description
                                   //% "Create pidfile (before privilege drop)."
@@ -627,6 +981,155 @@ void Server::parseCommandLine(const QStringList &arguments)
         setHttpsH2(true);
     }
 
+    if (parser.isSet(rollingReloadOpt)) {
+        bool ok;
+        auto value = parser.value(rollingReloadOpt).toInt(&ok);
+        setRollingReload(value);
+        if (!ok || value < 0) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(workerReloadMercyOpt)) {
+        bool ok;
+        auto value = parser.value(workerReloadMercyOpt).toInt(&ok);
+        setWorkerReloadMercy(value);
+        if (!ok || value < 0) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(cheaperOpt)) {
+        bool ok;
+        auto value = parser.value(cheaperOpt).toInt(&ok);
+        setCheaper(value);
+        if (!ok || value < 0) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(cheaperStepOpt)) {
+        bool ok;
+        auto value = parser.value(cheaperStepOpt).toInt(&ok);
+        setCheaperStep(value);
+        if (!ok || value < 1) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(cheaperCooldownOpt)) {
+        bool ok;
+        auto value = parser.value(cheaperCooldownOpt).toInt(&ok);
+        setCheaperCooldown(value);
+        if (!ok || value < 0) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(maxRequestsOpt)) {
+        bool ok;
+        auto value = parser.value(maxRequestsOpt).toInt(&ok);
+        setMaxRequests(value);
+        if (!ok || value < 0) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(reloadOnRssOpt)) {
+        bool ok;
+        auto value = parser.value(reloadOnRssOpt).toInt(&ok);
+        setReloadOnRss(value);
+        if (!ok || value < 0) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(reloadOnAsOpt)) {
+        bool ok;
+        auto value = parser.value(reloadOnAsOpt).toInt(&ok);
+        setReloadOnAs(value);
+        if (!ok || value < 0) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(maxWorkerLifetimeOpt)) {
+        bool ok;
+        auto value = parser.value(maxWorkerLifetimeOpt).toInt(&ok);
+        setMaxWorkerLifetime(value);
+        if (!ok || value < 0) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(harakiriOpt)) {
+        bool ok;
+        auto value = parser.value(harakiriOpt).toInt(&ok);
+        setHarakiri(value);
+        if (!ok || value < 0) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(logSlowOpt)) {
+        bool ok;
+        auto value = parser.value(logSlowOpt).toInt(&ok);
+        setLogSlow(value);
+        if (!ok || value < 0) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(statsOpt)) {
+        setStats(parser.value(statsOpt));
+    }
+
+    if (parser.isSet(metricsOpt)) {
+        setMetrics(parser.value(metricsOpt));
+    }
+
+    if (parser.isSet(traceExportOpt)) {
+        setTraceExport(parser.value(traceExportOpt));
+    }
+
+    if (parser.isSet(accessLogOpt)) {
+        setAccessLog(parser.value(accessLogOpt));
+    }
+
+    if (parser.isSet(accessLogFormatOpt)) {
+        setAccessLogFormat(parser.value(accessLogFormatOpt));
+    }
+
+    if (parser.isSet(tlsSessionCacheOpt)) {
+        bool ok;
+        auto value = parser.value(tlsSessionCacheOpt).toInt(&ok);
+        setTlsSessionCache(value);
+        if (!ok || value < 0) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(tlsTicketKeyLifetimeOpt)) {
+        bool ok;
+        auto value = parser.value(tlsTicketKeyLifetimeOpt).toInt(&ok);
+        setTlsTicketKeyLifetime(value);
+        if (!ok || value < 1) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(ktlsOpt)) {
+        setKtls(true);
+    }
+
+    if (parser.isSet(tlsBackendOpt)) {
+        const QString backend = parser.value(tlsBackendOpt);
+        setTlsBackend(backend);
+        if (backend != u"qt"_s && backend != u"openssl"_s) {
+            parser.showHelp(1);
+        }
+    }
+
     if (parser.isSet(socketSndbufOpt)) {
         bool ok;
         auto size = parser.value(socketSndbufOpt).toInt(&ok);
@@ -654,6 +1157,85 @@ void Server::parseCommandLine(const QStringList &arguments)
         }
     }
 
+    if (parser.isSet(wsCompressionOpt)) {
+        setWebsocketCompression(true);
+    }
+
+    if (parser.isSet(wsCompressionWindowBitsOpt)) {
+        bool ok;
+        auto value = parser.value(wsCompressionWindowBitsOpt).toInt(&ok);
+        setWebsocketCompressionWindowBits(value);
+        if (!ok || value < 9 || value > 15) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(wsCompressionMemLevelOpt)) {
+        bool ok;
+        auto value = parser.value(wsCompressionMemLevelOpt).toInt(&ok);
+        setWebsocketCompressionMemLevel(value);
+        if (!ok || value < 1 || value > 9) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(wsCompressionNoContextTakeoverOpt)) {
+        setWebsocketCompressionNoContextTakeover(true);
+    }
+
+    if (parser.isSet(wsWriteHighWatermarkOpt)) {
+        bool ok;
+        auto size = parser.value(wsWriteHighWatermarkOpt).toInt(&ok);
+        setWebsocketWriteHighWatermark(size);
+        if (!ok || size < 0) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(wsWriteLowWatermarkOpt)) {
+        bool ok;
+        auto size = parser.value(wsWriteLowWatermarkOpt).toInt(&ok);
+        setWebsocketWriteLowWatermark(size);
+        if (!ok || size < 0) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(wsSlowConsumerPolicyOpt)) {
+        const QString policy = parser.value(wsSlowConsumerPolicyOpt);
+        setWebsocketSlowConsumerPolicy(policy);
+        if (policy != u"close"_s && policy != u"drop-oldest"_s && policy != u"coalesce"_s) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(wsPingIntervalOpt)) {
+        bool ok;
+        auto value = parser.value(wsPingIntervalOpt).toInt(&ok);
+        setWebsocketPingInterval(value);
+        if (!ok || value < 0) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(wsPongTimeoutOpt)) {
+        bool ok;
+        auto value = parser.value(wsPongTimeoutOpt).toInt(&ok);
+        setWebsocketPongTimeout(value);
+        if (!ok || value < 1) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(wsIdleTimeoutOpt)) {
+        bool ok;
+        auto value = parser.value(wsIdleTimeoutOpt).toInt(&ok);
+        setWebsocketIdleTimeout(value);
+        if (!ok || value < 0) {
+            parser.showHelp(1);
+        }
+    }
+
     if (parser.isSet(http2HeaderTableSizeOpt)) {
         bool ok;
         auto size = parser.value(http2HeaderTableSizeOpt).toUInt(&ok);
@@ -663,6 +1245,33 @@ void Server::parseCommandLine(const QStringList &arguments)
         }
     }
 
+    if (parser.isSet(http2MaxConcurrentStreamsOpt)) {
+        bool ok;
+        auto value = parser.value(http2MaxConcurrentStreamsOpt).toUInt(&ok);
+        setHttp2MaxConcurrentStreams(value);
+        if (!ok || value < 1) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(http2MaxInflightRequestsOpt)) {
+        bool ok;
+        auto value = parser.value(http2MaxInflightRequestsOpt).toUInt(&ok);
+        setHttp2MaxInflightRequests(value);
+        if (!ok) {
+            parser.showHelp(1);
+        }
+    }
+
+    if (parser.isSet(http2MaxResetStreamsOpt)) {
+        bool ok;
+        auto value = parser.value(http2MaxResetStreamsOpt).toUInt(&ok);
+        setHttp2MaxResetStreams(value);
+        if (!ok) {
+            parser.showHelp(1);
+        }
+    }
+
     if (parser.isSet(frontendProxy)) {
         setUsingFrontendProxy(true);
     }
@@ -675,6 +1284,19 @@ void Server::parseCommandLine(const QStringList &arguments)
 
     setFastcgiSocket(fastcgiSocket() + parser.values(fastcgiSocketOpt));
 
+    if (parser.isSet(fastcgiMaxRequestsOpt)) {
+        bool ok;
+        auto value = parser.value(fastcgiMaxRequestsOpt).toUInt(&ok);
+        setFastcgiMaxRequests(value);
+        if (!ok || value < 1) {
+            parser.showHelp(1);
+        }
+    }
+
+    setUwsgiSocket(uwsgiSocket() + parser.values(uwsgiSocketOpt));
+
+    setProxyProtocol(proxyProtocol() + parser.values(proxyProtocolOpt));
+
     setStaticMap(staticMap() + parser.values(staticMapOpt));
 
     setStaticMap2(staticMap2() + parser.values(staticMap2Opt));
@@ -709,7 +1331,18 @@ int Server::exec(Cutelyst::Application *app)
         d->processes = 1;
     }
     delete d->genericFork;
-    d->genericFork = new UnixFork(d->processes, qMax(d->threads, 1), !d->userEventLoop, this);
+    auto unixFork = new UnixFork(d->processes, qMax(d->threads, 1), !d->userEventLoop, this);
+    unixFork->setRollingReload(d->rollingReload);
+    unixFork->setReloadMercy(std::chrono::seconds{d->workerReloadMercy});
+    unixFork->setRecycle(d->maxRequests,
+                         d->reloadOnRss,
+                         d->reloadOnAs,
+                         std::chrono::seconds{d->maxWorkerLifetime});
+    unixFork->setHarakiri(std::chrono::seconds{d->harakiri});
+    if (d->master) {
+        unixFork->setCheaper(d->cheaper, d->cheaperStep, std::chrono::seconds{d->cheaperCooldown});
+    }
+    d->genericFork = unixFork;
 #else
     if (d->processes == -1) {
         d->processes = 1;
@@ -725,6 +1358,12 @@ int Server::exec(Cutelyst::Application *app)
         d->genericFork, &AbstractFork::forked, d, &ServerPrivate::postFork, Qt::DirectConnection);
     connect(
         d->genericFork, &AbstractFork::shutdown, d, &ServerPrivate::shutdown, Qt::DirectConnection);
+    connect(d->genericFork, &AbstractFork::reopenLogs, d, [d] {
+        if (d->accessLog) {
+            d->accessLog->reopen();
+        }
+    });
+    connect(this, &Server::ready, d->genericFork, &AbstractFork::workerReady);
 
     if (d->master && d->lazy) {
         if (d->autoReload && !d->application.isEmpty()) {
@@ -747,8 +1386,25 @@ int Server::exec(Cutelyst::Application *app)
             sd->sendReady("1");
         });
         connect(d, &ServerPrivate::postForked, sd, [sd] { sd->setWatchdog(false); });
+        if (!d->stats.isEmpty()) {
+            // Only the master sums up the scoreboard
+            auto status = new QTimer(sd);
+            status->setInterval(std::chrono::seconds{5});
+            connect(status, &QTimer::timeout, sd, [sd, d] {
+                sd->sendStatus(d->scoreboard->summary());
+            });
+            connect(d, &ServerPrivate::postForked, status, [status, d] {
+                if (!d->scoreboard->isMaster()) {
+                    status->stop();
+                }
+            });
+            status->start();
+        }
         qInfo(CUTELYST_SERVER) << "systemd notify detected";
     }
+
+    // From systemd or from the master that exec'd this binary on an upgrade
+    d->inheritedSockets = systemdNotify::listenFds();
 #endif
 
     // TCP needs root privileges, but SO_REUSEPORT must have an effective user ID that
@@ -809,6 +1465,14 @@ int Server::exec(Cutelyst::Application *app)
         }
     }
 
+#ifdef Q_OS_LINUX
+    for (int fd : std::exchange(d->inheritedSockets, {})) {
+        std::cerr << "Inherited socket fd " << fd << " does not match any configured socket"
+                  << '\n';
+        ::close(fd);
+    }
+#endif
+
     if (d->servers.empty()) {
         std::cout << "Please specify a socket to listen to" << '\n';
         //% "No socket specified"
@@ -818,6 +1482,18 @@ int Server::exec(Cutelyst::Application *app)
 
     d->writePidFile(d->pidfile2);
 
+#ifdef Q_OS_LINUX
+    std::vector<int> listenSockets;
+    for (QObject *server : d->servers) {
+        if (auto tcpServer = qobject_cast<TcpServerBalancer *>(server)) {
+            listenSockets.push_back(int(tcpServer->socketDescriptor()));
+        } else if (auto localServer = qobject_cast<LocalServer *>(server)) {
+            listenSockets.push_back(int(localServer->socket()));
+        }
+    }
+    static_cast<UnixFork *>(d->genericFork)->setListenSockets(listenSockets);
+#endif
+
     if (!d->chdir.isEmpty()) {
         std::cout << "Changing directory to: " << d->chdir.toLatin1().constData() << '\n';
         if (!QDir::setCurrent(d->chdir)) {
@@ -827,12 +1503,64 @@ int Server::exec(Cutelyst::Application *app)
         }
     }
 
-    d->app = app;
-
-    if (!d->lazy) {
-        if (!d->setupApplication()) {
-            //% "Failed to setup Application"
-            Q_EMIT errorOccured(qtTrId("cutelystd-err-fail-setup-app"));
+#ifdef Q_OS_UNIX
+    delete d->scoreboard;
+    d->scoreboard = nullptr;
+    if (!d->stats.isEmpty()) {
+        // Allocated before forking, so every worker shares it with the master
+        auto unixFork = static_cast<UnixFork *>(d->genericFork);
+        d->scoreboard = new Scoreboard(unixFork->slotCount(), qMax(d->threads, 1), this);
+        if (!d->scoreboard->listen(d->stats)) {
+            //% "Failed to listen on stats socket %1"
+            Q_EMIT errorOccured(qtTrId("cutelystd-err-listen-stats").arg(d->stats));
+            return 1;
+        }
+        connect(unixFork, &UnixFork::slotReleased, d->scoreboard, &Scoreboard::releaseSlot);
+    }
+#endif
+
+    delete d->metrics;
+    d->metrics = nullptr;
+    if (!d->metricsPath.isEmpty()) {
+#ifdef Q_OS_UNIX
+        const int slots = static_cast<UnixFork *>(d->genericFork)->slotCount();
+#else
+        const int slots = qMax(d->processes, 1);
+#endif
+        d->metrics = new Metrics(slots, qMax(d->threads, 1));
+#ifdef Q_OS_UNIX
+        // Counters of exited workers are kept, Prometheus would take a drop for a reset
+        connect(static_cast<UnixFork *>(d->genericFork), &UnixFork::slotReleased, d, [d](int slot) {
+            if (d->metrics) {
+                d->metrics->retireSlot(slot);
+            }
+        });
+#endif
+    }
+
+    delete d->accessLog;
+    d->accessLog = nullptr;
+    if (!d->accessLogPath.isEmpty()) {
+        std::vector<AccessLogField> fields;
+        QString error;
+        const QString format = d->accessLogFormat.isEmpty()
+                                   ? QString::fromLatin1(AccessLog::DefaultFormat)
+                                   : d->accessLogFormat;
+        if (!AccessLog::parseFormat(format, fields, &error)) {
+            //% "Unknown access log format variable %1"
+            Q_EMIT errorOccured(qtTrId("cutelystd-err-access-log-format").arg(error));
+            return 1;
+        }
+        // Started by each worker, threads don't survive fork()
+        d->accessLog = new AccessLog(d->accessLogPath, fields);
+    }
+
+    d->app = app;
+
+    if (!d->lazy) {
+        if (!d->setupApplication()) {
+            //% "Failed to setup Application"
+            Q_EMIT errorOccured(qtTrId("cutelystd-err-fail-setup-app"));
             return 1;
         }
     }
@@ -889,6 +1617,13 @@ ServerPrivate::~ServerPrivate()
     delete protoHTTP;
     delete protoHTTP2;
     delete protoFCGI;
+    delete protoUwsgi;
+#ifdef HAS_OPENSSL
+    delete tlsSessionCache;
+#endif
+    delete metrics;
+    delete accessLog;
+    delete slowRequests;
 }
 
 bool ServerPrivate::listenTcpSockets()
@@ -896,11 +1631,19 @@ bool ServerPrivate::listenTcpSockets()
     lastListenError.clear();
 
     if (httpSockets.isEmpty() && httpsSockets.isEmpty() && http2Sockets.isEmpty() &&
-        fastcgiSockets.isEmpty()) {
+        fastcgiSockets.isEmpty() && uwsgiSockets.isEmpty()) {
         // no sockets to listen to
         return false;
     }
 
+    Q_Q(const Server);
+    const QString backend = q->tlsBackend();
+    if (!httpsSockets.isEmpty() && backend != u"openssl"_s && (tlsSessionCacheSize > 0 || ktls)) {
+        lastListenError = QStringLiteral("tls_session_cache and ktls need the openssl tls_backend");
+        qCWarning(CUTELYST_SERVER) << lastListenError;
+        return false;
+    }
+
     // HTTP
     bool httpOk = std::ranges::all_of(httpSockets, [this](const auto &socket) {
         return listenTcp(socket, getHttpProto(), false);
@@ -909,6 +1652,15 @@ bool ServerPrivate::listenTcpSockets()
         return false;
     }
 
+#ifdef HAS_OPENSSL
+    // Created before forking so all workers share it
+    if (!httpsSockets.isEmpty() && backend == u"openssl"_s && tlsSessionCacheSize > 0 &&
+        !tlsSessionCache) {
+        tlsSessionCache = TlsSessionCache::create(
+            tlsSessionCacheSize, std::chrono::seconds{tlsTicketKeyLifetime});
+    }
+#endif
+
     // HTTPS
     bool httpsOk = std::ranges::all_of(httpsSockets, [this](const auto &socket) {
         return listenTcp(socket, getHttpProto(), true);
@@ -926,9 +1678,17 @@ bool ServerPrivate::listenTcpSockets()
     }
 
     // FastCGI
-    bool allOk = std::ranges::all_of(fastcgiSockets, [this](const QString &socket) {
+    bool fastcgiOk = std::ranges::all_of(fastcgiSockets, [this](const QString &socket) {
         return listenTcp(socket, getFastCgiProto(), false);
     });
+    if (!fastcgiOk) {
+        return false;
+    }
+
+    // uwsgi
+    bool allOk = std::ranges::all_of(uwsgiSockets, [this](const QString &socket) {
+        return listenTcp(socket, getUwsgiProto(), false);
+    });
 
     return allOk;
 }
@@ -943,6 +1703,12 @@ bool ServerPrivate::listenTcp(const QString &line, Protocol *protocol, bool secu
 
     auto server = new TcpServerBalancer(q);
     server->setBalancer(threadBalancer);
+    server->setProxyProtocol(expectsProxyProtocol(line));
+    if (secure && httpsH2) {
+        server->setHttp2Protocol(getHttp2Proto());
+    }
+    server->setTlsSessionCache(tlsSessionCache);
+    server->setInheritedSockets(&inheritedSockets);
     const bool ret = server->listen(line, protocol, secure);
 
     if (!ret || !server->socketDescriptor()) {
@@ -973,11 +1739,24 @@ bool ServerPrivate::listenLocalSockets()
     QStringList http    = httpSockets;
     QStringList http2   = http2Sockets;
     QStringList fastcgi = fastcgiSockets;
+    QStringList uwsgi   = uwsgiSockets;
 
 #ifdef Q_OS_LINUX
     Q_Q(Server);
 
-    std::vector<int> fds = systemdNotify::listenFds();
+    // TCP ones are taken by listenTcpSockets()
+    std::vector<int> fds;
+    std::erase_if(inheritedSockets, [&fds](int fd) {
+        sockaddr_storage addr{};
+        socklen_t addrLen = sizeof(addr);
+        if (::getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &addrLen) == 0 &&
+            addr.ss_family == AF_UNIX) {
+            fds.push_back(fd);
+            return true;
+        }
+        return false;
+    });
+
     for (int fd : fds) {
         auto server = new LocalServer(q, this);
         if (server->listen(fd)) {
@@ -991,12 +1770,16 @@ bool ServerPrivate::listenLocalSockets()
                 protocol = getHttp2Proto();
             } else if (fastcgi.removeOne(fullName) || fastcgi.removeOne(name)) {
                 protocol = getFastCgiProto();
+            } else if (uwsgi.removeOne(fullName) || uwsgi.removeOne(name)) {
+                protocol = getUwsgiProto();
             } else {
                 std::cerr << "systemd activated socket does not match any configured socket"
                           << '\n';
                 return false;
             }
             server->setProtocol(protocol);
+            server->setProxyProtocol(expectsProxyProtocol(fullName) ||
+                                     expectsProxyProtocol(name));
             server->pauseAccepting();
 
             auto qEnum = Protocol::staticMetaObject.enumerator(0);
@@ -1030,6 +1813,11 @@ bool ServerPrivate::listenLocalSockets()
         ret |= listenLocal(socket, getFastCgiProto());
     }
 
+    const auto uwsgiConst = uwsgi;
+    for (const auto &socket : uwsgiConst) {
+        ret |= listenLocal(socket, getUwsgiProto());
+    }
+
     return ret;
 }
 
@@ -1041,6 +1829,7 @@ bool ServerPrivate::listenLocal(const QString &line, Protocol *protocol)
     if (line.startsWith(u'/')) {
         auto server = new LocalServer(q, this);
         server->setProtocol(protocol);
+        server->setProxyProtocol(expectsProxyProtocol(line));
         if (!socketAccess.isEmpty()) {
             QLocalServer::SocketOptions options;
             if (socketAccess.contains(u'u')) {
@@ -1084,6 +1873,21 @@ bool ServerPrivate::listenLocal(const QString &line, Protocol *protocol)
     return ret;
 }
 
+bool ServerPrivate::expectsProxyProtocol(const QString &line) const
+{
+    // HTTPS sockets carry the certificate and key after the address
+    const QString address = line.section(u',', 0, 0);
+    const bool ret        = std::ranges::any_of(proxyProtocolSockets, [&](const QString &socket) {
+        return socket.section(u',', 0, 0) == address;
+    });
+#ifndef Q_OS_UNIX
+    if (ret) {
+        qCWarning(CUTELYST_SERVER) << "PROXY protocol is not supported on this platform";
+    }
+#endif
+    return ret;
+}
+
 void Server::setApplication(const QString &application)
 {
     Q_D(Server);
@@ -1199,6 +2003,45 @@ quint32 Server::http2HeaderTableSize() const
     return d->http2HeaderTableSize;
 }
 
+void Server::setHttp2MaxConcurrentStreams(quint32 maxStreams)
+{
+    Q_D(Server);
+    d->http2MaxConcurrentStreams = maxStreams;
+    Q_EMIT changed();
+}
+
+quint32 Server::http2MaxConcurrentStreams() const
+{
+    Q_D(const Server);
+    return d->http2MaxConcurrentStreams;
+}
+
+void Server::setHttp2MaxInflightRequests(quint32 maxRequests)
+{
+    Q_D(Server);
+    d->http2MaxInflightRequests = maxRequests;
+    Q_EMIT changed();
+}
+
+quint32 Server::http2MaxInflightRequests() const
+{
+    Q_D(const Server);
+    return d->http2MaxInflightRequests;
+}
+
+void Server::setHttp2MaxResetStreams(quint32 maxResets)
+{
+    Q_D(Server);
+    d->http2MaxResetStreams = maxResets;
+    Q_EMIT changed();
+}
+
+quint32 Server::http2MaxResetStreams() const
+{
+    Q_D(const Server);
+    return d->http2MaxResetStreams;
+}
+
 void Server::setUpgradeH2c(bool enable)
 {
     Q_D(Server);
@@ -1225,6 +2068,68 @@ bool Server::httpsH2() const
     return d->httpsH2;
 }
 
+void Server::setTlsSessionCache(int entries)
+{
+    Q_D(Server);
+    d->tlsSessionCacheSize = entries;
+    Q_EMIT changed();
+}
+
+int Server::tlsSessionCache() const
+{
+    Q_D(const Server);
+    return d->tlsSessionCacheSize;
+}
+
+void Server::setTlsTicketKeyLifetime(int seconds)
+{
+    Q_D(Server);
+    d->tlsTicketKeyLifetime = seconds;
+    Q_EMIT changed();
+}
+
+int Server::tlsTicketKeyLifetime() const
+{
+    Q_D(const Server);
+    return d->tlsTicketKeyLifetime;
+}
+
+void Server::setKtls(bool enable)
+{
+    Q_D(Server);
+    d->ktls = enable;
+    Q_EMIT changed();
+}
+
+bool Server::ktls() const
+{
+    Q_D(const Server);
+    return d->ktls;
+}
+
+void Server::setTlsBackend(const QString &backend)
+{
+    Q_D(Server);
+    d->tlsBackend = backend;
+    Q_EMIT changed();
+}
+
+QString Server::tlsBackend() const
+{
+    Q_D(const Server);
+    if (!d->tlsBackend.isEmpty()) {
+        return d->tlsBackend;
+    }
+
+#if defined(HAS_OPENSSL) && defined(Q_OS_UNIX)
+    // The shared session cache and kTLS are only implemented by the openssl backend
+    if (d->tlsSessionCacheSize > 0 || d->ktls) {
+        return u"openssl"_s;
+    }
+#endif
+    return u"qt"_s;
+}
+
 void Server::setHttpsSocket(const QStringList &httpsSocket)
 {
     Q_D(Server);
@@ -1251,6 +2156,45 @@ QStringList Server::fastcgiSocket() const
     return d->fastcgiSockets;
 }
 
+void Server::setFastcgiMaxRequests(quint32 maxRequests)
+{
+    Q_D(Server);
+    d->fastcgiMaxRequests = maxRequests;
+    Q_EMIT changed();
+}
+
+quint32 Server::fastcgiMaxRequests() const
+{
+    Q_D(const Server);
+    return d->fastcgiMaxRequests;
+}
+
+void Server::setUwsgiSocket(const QStringList &uwsgiSocket)
+{
+    Q_D(Server);
+    d->uwsgiSockets = uwsgiSocket;
+    Q_EMIT changed();
+}
+
+QStringList Server::uwsgiSocket() const
+{
+    Q_D(const Server);
+    return d->uwsgiSockets;
+}
+
+void Server::setProxyProtocol(const QStringList &sockets)
+{
+    Q_D(Server);
+    d->proxyProtocolSockets = sockets;
+    Q_EMIT changed();
+}
+
+QStringList Server::proxyProtocol() const
+{
+    Q_D(const Server);
+    return d->proxyProtocolSockets;
+}
+
 void Server::setSocketAccess(const QString &socketAccess)
 {
     Q_D(Server);
@@ -1411,6 +2355,214 @@ QStringList Server::touchReload() const
     return d->touchReload;
 }
 
+void Server::setRollingReload(int workers)
+{
+    Q_D(Server);
+    d->rollingReload = workers;
+    Q_EMIT changed();
+}
+
+int Server::rollingReload() const
+{
+    Q_D(const Server);
+    return d->rollingReload;
+}
+
+void Server::setWorkerReloadMercy(int seconds)
+{
+    Q_D(Server);
+    d->workerReloadMercy = seconds;
+    Q_EMIT changed();
+}
+
+int Server::workerReloadMercy() const
+{
+    Q_D(const Server);
+    return d->workerReloadMercy;
+}
+
+void Server::setCheaper(int workers)
+{
+    Q_D(Server);
+    d->cheaper = workers;
+    Q_EMIT changed();
+}
+
+int Server::cheaper() const
+{
+    Q_D(const Server);
+    return d->cheaper;
+}
+
+void Server::setCheaperStep(int workers)
+{
+    Q_D(Server);
+    d->cheaperStep = workers;
+    Q_EMIT changed();
+}
+
+int Server::cheaperStep() const
+{
+    Q_D(const Server);
+    return d->cheaperStep;
+}
+
+void Server::setCheaperCooldown(int seconds)
+{
+    Q_D(Server);
+    d->cheaperCooldown = seconds;
+    Q_EMIT changed();
+}
+
+int Server::cheaperCooldown() const
+{
+    Q_D(const Server);
+    return d->cheaperCooldown;
+}
+
+void Server::setMaxRequests(int requests)
+{
+    Q_D(Server);
+    d->maxRequests = requests;
+    Q_EMIT changed();
+}
+
+int Server::maxRequests() const
+{
+    Q_D(const Server);
+    return d->maxRequests;
+}
+
+void Server::setReloadOnRss(int megabytes)
+{
+    Q_D(Server);
+    d->reloadOnRss = megabytes;
+    Q_EMIT changed();
+}
+
+int Server::reloadOnRss() const
+{
+    Q_D(const Server);
+    return d->reloadOnRss;
+}
+
+void Server::setReloadOnAs(int megabytes)
+{
+    Q_D(Server);
+    d->reloadOnAs = megabytes;
+    Q_EMIT changed();
+}
+
+int Server::reloadOnAs() const
+{
+    Q_D(const Server);
+    return d->reloadOnAs;
+}
+
+void Server::setMaxWorkerLifetime(int seconds)
+{
+    Q_D(Server);
+    d->maxWorkerLifetime = seconds;
+    Q_EMIT changed();
+}
+
+int Server::maxWorkerLifetime() const
+{
+    Q_D(const Server);
+    return d->maxWorkerLifetime;
+}
+
+void Server::setHarakiri(int seconds)
+{
+    Q_D(Server);
+    d->harakiri = seconds;
+    Q_EMIT changed();
+}
+
+int Server::harakiri() const
+{
+    Q_D(const Server);
+    return d->harakiri;
+}
+
+void Server::setLogSlow(int milliseconds)
+{
+    Q_D(Server);
+    d->logSlow = milliseconds;
+    Q_EMIT changed();
+}
+
+int Server::logSlow() const
+{
+    Q_D(const Server);
+    return d->logSlow;
+}
+
+void Server::setStats(const QString &address)
+{
+    Q_D(Server);
+    d->stats = address;
+    Q_EMIT changed();
+}
+
+QString Server::stats() const
+{
+    Q_D(const Server);
+    return d->stats;
+}
+
+void Server::setMetrics(const QString &path)
+{
+    Q_D(Server);
+    d->metricsPath = path;
+    Q_EMIT changed();
+}
+
+QString Server::metrics() const
+{
+    Q_D(const Server);
+    return d->metricsPath;
+}
+
+void Server::setTraceExport(const QString &file)
+{
+    Q_D(Server);
+    d->traceExport = file;
+    Q_EMIT changed();
+}
+
+QString Server::traceExport() const
+{
+    Q_D(const Server);
+    return d->traceExport;
+}
+
+void Server::setAccessLog(const QString &file)
+{
+    Q_D(Server);
+    d->accessLogPath = file;
+    Q_EMIT changed();
+}
+
+QString Server::accessLog() const
+{
+    Q_D(const Server);
+    return d->accessLogPath;
+}
+
+void Server::setAccessLogFormat(const QString &format)
+{
+    Q_D(Server);
+    d->accessLogFormat = format;
+    Q_EMIT changed();
+}
+
+QString Server::accessLogFormat() const
+{
+    Q_D(const Server);
+    return d->accessLogFormat;
+}
+
 void Server::setListenQueue(int size)
 {
     Q_D(Server);
@@ -1536,6 +2688,136 @@ int Server::websocketMaxSize() const
     return d->websocketMaxSize / 1024;
 }
 
+void Server::setWebsocketCompression(bool enable)
+{
+    Q_D(Server);
+    d->websocketCompression = enable;
+    Q_EMIT changed();
+}
+
+bool Server::websocketCompression() const
+{
+    Q_D(const Server);
+    return d->websocketCompression;
+}
+
+void Server::setWebsocketCompressionWindowBits(int windowBits)
+{
+    Q_D(Server);
+    d->websocketCompressionWindowBits = windowBits;
+    Q_EMIT changed();
+}
+
+int Server::websocketCompressionWindowBits() const
+{
+    Q_D(const Server);
+    return d->websocketCompressionWindowBits;
+}
+
+void Server::setWebsocketCompressionMemLevel(int memLevel)
+{
+    Q_D(Server);
+    d->websocketCompressionMemLevel = memLevel;
+    Q_EMIT changed();
+}
+
+int Server::websocketCompressionMemLevel() const
+{
+    Q_D(const Server);
+    return d->websocketCompressionMemLevel;
+}
+
+void Server::setWebsocketCompressionNoContextTakeover(bool enable)
+{
+    Q_D(Server);
+    d->websocketCompressionNoContextTakeover = enable;
+    Q_EMIT changed();
+}
+
+bool Server::websocketCompressionNoContextTakeover() const
+{
+    Q_D(const Server);
+    return d->websocketCompressionNoContextTakeover;
+}
+
+void Server::setWebsocketWriteHighWatermark(int value)
+{
+    Q_D(Server);
+    d->websocketWriteHighWatermark = value * 1024;
+    Q_EMIT changed();
+}
+
+int Server::websocketWriteHighWatermark() const
+{
+    Q_D(const Server);
+    return d->websocketWriteHighWatermark / 1024;
+}
+
+void Server::setWebsocketWriteLowWatermark(int value)
+{
+    Q_D(Server);
+    d->websocketWriteLowWatermark = value * 1024;
+    Q_EMIT changed();
+}
+
+int Server::websocketWriteLowWatermark() const
+{
+    Q_D(const Server);
+    return d->websocketWriteLowWatermark / 1024;
+}
+
+void Server::setWebsocketSlowConsumerPolicy(const QString &policy)
+{
+    Q_D(Server);
+    d->websocketSlowConsumerPolicy = policy;
+    Q_EMIT changed();
+}
+
+QString Server::websocketSlowConsumerPolicy() const
+{
+    Q_D(const Server);
+    return d->websocketSlowConsumerPolicy;
+}
+
+void Server::setWebsocketPingInterval(int seconds)
+{
+    Q_D(Server);
+    d->websocketPingInterval = seconds;
+    Q_EMIT changed();
+}
+
+int Server::websocketPingInterval() const
+{
+    Q_D(const Server);
+    return d->websocketPingInterval;
+}
+
+void Server::setWebsocketPongTimeout(int seconds)
+{
+    Q_D(Server);
+    d->websocketPongTimeout = seconds;
+    Q_EMIT changed();
+}
+
+int Server::websocketPongTimeout() const
+{
+    Q_D(const Server);
+    return d->websocketPongTimeout;
+}
+
+void Server::setWebsocketIdleTimeout(int seconds)
+{
+    Q_D(Server);
+    d->websocketIdleTimeout = seconds;
+    Q_EMIT changed();
+}
+
+int Server::websocketIdleTimeout() const
+{
+    Q_D(const Server);
+    return d->websocketIdleTimeout;
+}
+
 void Server::setPidfile(const QString &file)
 {
     Q_D(Server);
@@ -1701,6 +2983,36 @@ QVariantMap Server::config() const noexcept
     return d->config;
 }
 
+QVariantMap Server::counters() const
+{
+    Q_D(const Server);
+    QVariantMap ret;
+    if (d->protoHTTP) {
+        static_cast<ProtocolHttp *>(d->protoHTTP)->counters(ret);
+    }
+    if (d->protoHTTP2) {
+        d->protoHTTP2->counters(ret);
+    }
+    if (d->protoFCGI) {
+        static_cast<ProtocolFastCGI *>(d->protoFCGI)->counters(ret);
+    }
+#ifdef HAS_OPENSSL
+    if (d->tlsSessionCache) {
+        d->tlsSessionCache->counters(ret);
+    }
+#endif
+    if (d->genericFork) {
+        d->genericFork->counters(ret);
+    }
+    if (d->traceExporter) {
+        d->traceExporter->counters(ret);
+    }
+    if (d->accessLog) {
+        d->accessLog->counters(ret);
+    }
+    return ret;
+}
+
 bool ServerPrivate::setupApplication()
 {
     Cutelyst::Application *localApp = app;
@@ -1813,6 +3125,11 @@ void ServerPrivate::engineShutdown(ServerEngine *engine)
 void ServerPrivate::checkEngineShutdown()
 {
     if (engines.empty()) {
+        if (accessLog) {
+            // Nothing is logged anymore, writes what is still queued
+            accessLog->stop();
+        }
+
         if (userEventLoop) {
             Q_Q(Server);
             Q_EMIT q->stopped();
@@ -1843,6 +3160,92 @@ bool ServerPrivate::postFork(int workerId)
         }
     }
 
+#ifdef Q_OS_UNIX
+    // Replacements have the id of the worker they replace, which still drains meanwhile
+    const int workerSlot = static_cast<UnixFork *>(genericFork)->slot();
+#else
+    const int workerSlot = workerId;
+#endif
+
+#ifdef Q_OS_UNIX
+    if (scoreboard) {
+        scoreboard->postFork(workerSlot, workerId);
+        for (ServerEngine *engine : engines) {
+            ScoreboardThread *slot = scoreboard->thread(engine->workerCore());
+            engine->setScoreboard(slot);
+            // Only renames the slot when another action runs
+            connect(engine->app(),
+                    &Application::beforeDispatch,
+                    engine,
+                    [slot, last = static_cast<Action *>(nullptr)](Context *c) mutable {
+                        if (c->action() != last) {
+                            last = c->action();
+                            slot->setAction(last ? last->reverse().toUtf8() : QByteArray{});
+                        }
+                    });
+        }
+    }
+#endif
+
+    if (metrics) {
+        metrics->postFork(workerSlot);
+        for (ServerEngine *engine : engines) {
+            engine->setMetrics(metrics->recorder(engine->workerCore()));
+            // Scrapes are answered before the application dispatches them
+            connect(engine->app(),
+                    &Application::beforePrepareAction,
+                    engine,
+                    [this](Context *c, bool *skipMethod) {
+                        if (c->request()->path() != metricsPath) {
+                            return;
+                        }
+
+                        Q_Q(Server);
+                        Response *response = c->response();
+                        response->setContentType(Metrics::ContentType);
+                        response->setBody(metrics->render(q->counters()));
+                        *skipMethod = true;
+                    });
+        }
+    }
+
+    if (!traceExport.isEmpty()) {
+        // Each worker writes its own batches to the file
+        delete traceExporter;
+        traceExporter = new TraceExporter(traceExport, q);
+        if (!traceExporter->open()) {
+            return false;
+        }
+
+        for (ServerEngine *engine : engines) {
+            connect(engine->app(),
+                    &Application::requestTraced,
+                    engine,
+                    [exporter = traceExporter](Context *c, const Stats *stats) {
+                        exporter->add(c, stats);
+                    });
+        }
+    }
+
+    if (logSlow > 0) {
+        delete slowRequests;
+        slowRequests = new SlowRequestLog(std::chrono::milliseconds{logSlow});
+        for (ServerEngine *engine : engines) {
+            engine->setSlowRequests(slowRequests);
+        }
+    }
+
+    if (accessLog) {
+        // Each worker has its own writer thread appending to the file
+        if (!accessLog->start(int(engines.size()))) {
+            return false;
+        }
+
+        for (ServerEngine *engine : engines) {
+            engine->setAccessLog(accessLog->buffer(engine->workerCore()));
+        }
+    }
+
     if (engines.size() > 1) {
         qCDebug(CUTELYST_SERVER) << "Starting threads";
     }
@@ -1861,6 +3264,48 @@ bool ServerPrivate::postFork(int workerId)
         }
     }
 
+    WorkerLoad *load = nullptr;
+#ifdef Q_OS_UNIX
+    auto unixFork = static_cast<UnixFork *>(genericFork);
+    if (unixFork->countRequests()) {
+        for (ServerEngine *engine : engines) {
+            // Emitted for every request, from the engine thread
+            connect(engine->app(), &Application::beforePrepareAction, engine, [unixFork] {
+                unixFork->requestStarted();
+            });
+        }
+    }
+
+    if (auto table = unixFork->harakiriSlots()) {
+        for (ServerEngine *engine : engines) {
+            QMetaObject::invokeMethod(
+                engine,
+                [engine, table] {
+                    auto tracker =
+                        new HarakiriTracker(table + engine->workerCore(), engine->app(), engine);
+                    tracker->start();
+                },
+                Qt::QueuedConnection);
+        }
+    }
+
+    load = unixFork->workerLoad();
+#endif
+
+    if (load || metrics) {
+        for (ServerEngine *engine : engines) {
+            MetricsRecorder *recorder = metrics ? metrics->recorder(engine->workerCore()) : nullptr;
+            // Created in the engine thread, whose event loop it measures
+            QMetaObject::invokeMethod(
+                engine,
+                [engine, load, recorder] {
+                    auto monitor = new LoadMonitor(load, recorder, engine);
+                    monitor->start();
+                },
+                Qt::QueuedConnection);
+        }
+    }
+
     Q_EMIT postForked(workerId);
 
     QTimer::singleShot(std::chrono::seconds{1}, this, [=]() {
@@ -2070,5 +3515,14 @@ Protocol *ServerPrivate::getFastCgiProto()
     return protoFCGI;
 }
 
+Protocol *ServerPrivate::getUwsgiProto()
+{
+    Q_Q(Server);
+    if (!protoUwsgi) {
+        protoUwsgi = new ProtocolUwsgi(q);
+    }
+    return protoUwsgi;
+}
+
 #include "moc_server.cpp"
 #include "moc_server_p.cpp"
@@ -160,6 +160,39 @@ public:
     void setProcesses(const QString &process);
     [[nodiscard]] QString processes() const;
 
+    /**
+     * Defines the minimum number of worker processes, enabling adaptive scaling. The master
+     * starts this many workers and spawns more, up to processes, when they get busy, the
+     * listen queue fills up or their event loops lag behind; once the load goes away it stops
+     * the extra workers. Default value: \c 0, always runs processes workers.
+     * \since Cutelyst 5.1.0
+     * \note UNIX only
+     * @accessors cheaper(), setCheaper()
+     */
+    Q_PROPERTY(int cheaper READ cheaper WRITE setCheaper NOTIFY changed)
+    void setCheaper(int workers);
+    [[nodiscard]] int cheaper() const;
+
+    /**
+     * Defines how many workers are spawned or stopped at once by adaptive scaling.
+     * Default value: \c 1.
+     * \since Cutelyst 5.1.0
+     * @accessors cheaperStep(), setCheaperStep()
+     */
+    Q_PROPERTY(int cheaper_step READ cheaperStep WRITE setCheaperStep NOTIFY changed)
+    void setCheaperStep(int workers);
+    [[nodiscard]] int cheaperStep() const;
+
+    /**
+     * Defines the minimum number of seconds between two adaptive scaling decisions,
+     * so new workers get to take load before the next one. Default value: \c 10.
+     * \since Cutelyst 5.1.0
+     * @accessors cheaperCooldown(), setCheaperCooldown()
+     */
+    Q_PROPERTY(int cheaper_cooldown READ cheaperCooldown WRITE setCheaperCooldown NOTIFY changed)
+    void setCheaperCooldown(int seconds);
+    [[nodiscard]] int cheaperCooldown() const;
+
     /**
      * Defines directory to change into before application loading.
      * @accessors chdir(), setChdir()
@@ -193,6 +226,42 @@ public:
     void setHttp2HeaderTableSize(quint32 headerTableSize);
     [[nodiscard]] quint32 http2HeaderTableSize() const;
 
+    /**
+     * Defines the maximum number of concurrent streams a HTTP/2 client can open on a single
+     * connection, it's advertised as SETTINGS_MAX_CONCURRENT_STREAMS and streams above it
+     * are refused with REFUSED_STREAM. Default value: 100.
+     * \since Cutelyst 5.1.0
+     * @accessors http2MaxConcurrentStreams(), setHttp2MaxConcurrentStreams()
+     */
+    Q_PROPERTY(quint32 http2_max_concurrent_streams READ http2MaxConcurrentStreams WRITE
+                   setHttp2MaxConcurrentStreams NOTIFY changed)
+    void setHttp2MaxConcurrentStreams(quint32 maxStreams);
+    [[nodiscard]] quint32 http2MaxConcurrentStreams() const;
+
+    /**
+     * Defines the maximum number of requests of a single HTTP/2 connection that are
+     * processed at the same time, complete requests above this limit are queued until
+     * a running one finishes. Set to \c 0 to not limit. Default value: 16.
+     * \since Cutelyst 5.1.0
+     * @accessors http2MaxInflightRequests(), setHttp2MaxInflightRequests()
+     */
+    Q_PROPERTY(quint32 http2_max_inflight_requests READ http2MaxInflightRequests WRITE
+                   setHttp2MaxInflightRequests NOTIFY changed)
+    void setHttp2MaxInflightRequests(quint32 maxRequests);
+    [[nodiscard]] quint32 http2MaxInflightRequests() const;
+
+    /**
+     * Defines the maximum number of RST_STREAM frames a HTTP/2 client can send per second
+     * for streams that did not finish yet, above this limit the connection is closed
+     * with a GOAWAY ENHANCE_YOUR_CALM error. Set to \c 0 to disable. Default value: 100.
+     * \since Cutelyst 5.1.0
+     * @accessors http2MaxResetStreams(), setHttp2MaxResetStreams()
+     */
+    Q_PROPERTY(quint32 http2_max_reset_streams READ http2MaxResetStreams WRITE
+                   setHttp2MaxResetStreams NOTIFY changed)
+    void setHttp2MaxResetStreams(quint32 maxResets);
+    [[nodiscard]] quint32 http2MaxResetStreams() const;
+
     /**
      * Defines if an HTTP/1 connection can be upgraded to H2C (HTTP 2 Clear Text).
      * Defaults to \c false.
@@ -211,6 +280,60 @@ public:
     void setHttpsH2(bool enable);
     [[nodiscard]] bool httpsH2() const;
 
+    /**
+     * Defines the number of TLS sessions kept in a cache shared by all worker processes
+     * and threads, along with the session ticket keys, so clients can resume their
+     * sessions on any worker. It's used by the \c openssl tls_backend, which becomes the
+     * default when it's set, setting it to \c 0 disables it. Default value: 0.
+     * \since Cutelyst 5.1.0
+     * @accessors tlsSessionCache(), setTlsSessionCache()
+     */
+    Q_PROPERTY(int tls_session_cache READ tlsSessionCache WRITE setTlsSessionCache NOTIFY changed)
+    void setTlsSessionCache(int entries);
+    [[nodiscard]] int tlsSessionCache() const;
+
+    /**
+     * Defines in seconds how long a TLS session ticket key is used to issue tickets,
+     * tickets of the previous key are still accepted. It's also the lifetime of the
+     * cached sessions. Default value: 3600.
+     * \since Cutelyst 5.1.0
+     * @accessors tlsTicketKeyLifetime(), setTlsTicketKeyLifetime()
+     */
+    Q_PROPERTY(int tls_ticket_key_lifetime READ tlsTicketKeyLifetime WRITE setTlsTicketKeyLifetime
+                   NOTIFY changed)
+    void setTlsTicketKeyLifetime(int seconds);
+    [[nodiscard]] int tlsTicketKeyLifetime() const;
+
+    /**
+     * Defines if the keys negotiated by HTTPS connections are handed to the kernel (kTLS)
+     * after the handshake, records are then encrypted by the kernel and written without
+     * extra copies. Connections fall back to userspace encryption when the kernel \c tls
+     * module or the negotiated cipher don't support it. Like tls_session_cache it's used
+     * by the \c openssl tls_backend, which becomes the default when it's enabled.
+     * Defaults to \c false.
+     * \since Cutelyst 5.1.0
+     * @accessors ktls(), setKtls()
+     */
+    Q_PROPERTY(bool ktls READ ktls WRITE setKtls NOTIFY changed)
+    void setKtls(bool enable);
+    [[nodiscard]] bool ktls() const;
+
+    /**
+     * Defines how HTTPS sockets are encrypted:
+     * \li \c qt uses QSslSocket
+     * \li \c openssl uses OpenSSL directly on the socket descriptor, with less buffering
+     * and copies, it's the one that uses tls_session_cache and ktls. Only available on
+     * UNIX when Cutelyst was built with OpenSSL.
+     *
+     * Default value: \c openssl when tls_session_cache or ktls are set, \c qt otherwise.
+     * Setting them with the \c qt backend fails to listen on the HTTPS sockets.
+     * \since Cutelyst 5.1.0
+     * @accessors tlsBackend(), setTlsBackend()
+     */
+    Q_PROPERTY(QString tls_backend READ tlsBackend WRITE setTlsBackend NOTIFY changed)
+    void setTlsBackend(const QString &backend);
+    [[nodiscard]] QString tlsBackend() const;
+
     /**
      * Defines how an HTTPS socket should be binded.
      * @accessors httpsSocket(), setHttpsSocket()
@@ -227,6 +350,40 @@ public:
     void setFastcgiSocket(const QStringList &fastcgiSocket);
     [[nodiscard]] QStringList fastcgiSocket() const;
 
+    /**
+     * Defines the maximum number of requests a FastCGI frontend can multiplex on a
+     * single connection, requests above it are rejected with \c FCGI_OVERLOADED.
+     * Set to \c 1 to disable multiplexing. Default value: 64.
+     * \since Cutelyst 5.1.0
+     * @accessors fastcgiMaxRequests(), setFastcgiMaxRequests()
+     */
+    Q_PROPERTY(quint32 fastcgi_max_requests READ fastcgiMaxRequests WRITE setFastcgiMaxRequests
+                   NOTIFY changed)
+    void setFastcgiMaxRequests(quint32 maxRequests);
+    [[nodiscard]] quint32 fastcgiMaxRequests() const;
+
+    /**
+     * Defines how an uwsgi socket should be binded, the binary protocol used by
+     * nginx's \c uwsgi_pass.
+     * \since Cutelyst 5.1.0
+     * @accessors uwsgiSocket(), setUwsgiSocket()
+     */
+    Q_PROPERTY(QStringList uwsgi_socket READ uwsgiSocket WRITE setUwsgiSocket NOTIFY changed)
+    void setUwsgiSocket(const QStringList &uwsgiSocket);
+    [[nodiscard]] QStringList uwsgiSocket() const;
+
+    /**
+     * Defines the sockets, using the same address given to any of the socket options,
+     * that are behind a load balancer sending the PROXY protocol header, version 1 or 2.
+     * The header is read once per connection before TLS or any protocol data and its
+     * source becomes the request address, connections without a valid one are closed.
+     * \since Cutelyst 5.1.0
+     * @accessors proxyProtocol(), setProxyProtocol()
+     */
+    Q_PROPERTY(QStringList proxy_protocol READ proxyProtocol WRITE setProxyProtocol NOTIFY changed)
+    void setProxyProtocol(const QStringList &sockets);
+    [[nodiscard]] QStringList proxyProtocol() const;
+
     /**
      * Defines the file permissions of a local socket, u = user, g = group, o = others.
      * @accessors socketAccess(), setSocketAccess()
@@ -359,6 +516,187 @@ public:
     void setTouchReload(const QStringList &files);
     [[nodiscard]] QStringList touchReload() const;
 
+    /**
+     * Defines how many workers are replaced at a time when the master process reloads them,
+     * on SIGHUP or touch_reload. Old workers keep serving requests until their replacement
+     * is accepting connections, after that they finish the requests in progress and exit.
+     * Default value: \c 0, which restarts all workers at once.
+     * \since Cutelyst 5.1.0
+     * @accessors rollingReload(), setRollingReload()
+     */
+    Q_PROPERTY(int rolling_reload READ rollingReload WRITE setRollingReload NOTIFY changed)
+    void setRollingReload(int workers);
+    [[nodiscard]] int rollingReload() const;
+
+    /**
+     * Defines the number of seconds a worker told to exit, when it is reloaded, recycled or
+     * cheaped, has to finish its requests in progress before the master process kills it.
+     * Default value: \c 0, uses the harakiri timeout when set, 60 seconds otherwise.
+     * \since Cutelyst 5.1.0
+     * \note UNIX only
+     * @accessors workerReloadMercy(), setWorkerReloadMercy()
+     */
+    Q_PROPERTY(
+        int worker_reload_mercy READ workerReloadMercy WRITE setWorkerReloadMercy NOTIFY changed)
+    void setWorkerReloadMercy(int seconds);
+    [[nodiscard]] int workerReloadMercy() const;
+
+    /**
+     * Defines the number of requests after which a worker is recycled: the master spawns a
+     * replacement and once it is accepting connections the old worker finishes the requests
+     * in progress and exits. Each worker gets a limit up to 10% lower so they don't all get
+     * recycled at once. Default value: \c 0, never recycles workers.
+     * \since Cutelyst 5.1.0
+     * \note UNIX only
+     * @accessors maxRequests(), setMaxRequests()
+     */
+    Q_PROPERTY(int max_requests READ maxRequests WRITE setMaxRequests NOTIFY changed)
+    void setMaxRequests(int requests);
+    [[nodiscard]] int maxRequests() const;
+
+    /**
+     * Defines the resident memory size in megabytes above which a worker is recycled, it is
+     * checked every second. Default value: \c 0, disabled.
+     * \since Cutelyst 5.1.0
+     * \note UNIX only
+     * @accessors reloadOnRss(), setReloadOnRss()
+     */
+    Q_PROPERTY(int reload_on_rss READ reloadOnRss WRITE setReloadOnRss NOTIFY changed)
+    void setReloadOnRss(int megabytes);
+    [[nodiscard]] int reloadOnRss() const;
+
+    /**
+     * Defines the address space size in megabytes above which a worker is recycled, it is
+     * checked every second. Default value: \c 0, disabled.
+     * \since Cutelyst 5.1.0
+     * \note Linux only
+     * @accessors reloadOnAs(), setReloadOnAs()
+     */
+    Q_PROPERTY(int reload_on_as READ reloadOnAs WRITE setReloadOnAs NOTIFY changed)
+    void setReloadOnAs(int megabytes);
+    [[nodiscard]] int reloadOnAs() const;
+
+    /**
+     * Defines the number of seconds after which a worker is recycled, each worker gets a
+     * lifetime up to 10% shorter. Default value: \c 0, disabled.
+     * \since Cutelyst 5.1.0
+     * \note UNIX only
+     * @accessors maxWorkerLifetime(), setMaxWorkerLifetime()
+     */
+    Q_PROPERTY(
+        int max_worker_lifetime READ maxWorkerLifetime WRITE setMaxWorkerLifetime NOTIFY changed)
+    void setMaxWorkerLifetime(int seconds);
+    [[nodiscard]] int maxWorkerLifetime() const;
+
+    /**
+     * Defines the number of seconds after which a request that keeps its thread from
+     * returning to the event loop is considered stuck. The request, its action and, on
+     * Linux, a backtrace of the stuck thread are logged and the worker is recycled, its
+     * replacement is started right away and the stuck worker is killed once it is ready.
+     * The master process watches the worker processes, without worker processes a thread
+     * of the server process watches the engine threads and only logs the stuck requests.
+     * The number of stuck requests is the \c harakiri entry of counters().
+     * Default value: \c 0, disabled.
+     * \since Cutelyst 5.1.0
+     * \note UNIX only
+     * @accessors harakiri(), setHarakiri()
+     */
+    Q_PROPERTY(int harakiri READ harakiri WRITE setHarakiri NOTIFY changed)
+    void setHarakiri(int seconds);
+    [[nodiscard]] int harakiri() const;
+
+    /**
+     * Defines the number of milliseconds after which a request that kept its thread busy is
+     * logged, in the \c cutelyst.server.slow category, with the actions it executed and if
+     * the time went to \c Application::handleRequest(), to rendering views or to writing
+     * the body. The time async requests waited for events is not counted. The actions that
+     * ran and their durations are listed when Stats are collected for tracing or
+     * Server-Timing, otherwise only a few clock reads are added per request.
+     * Default value: \c 0, disabled.
+     * \since Cutelyst 5.1.0
+     * @accessors logSlow(), setLogSlow()
+     */
+    Q_PROPERTY(int log_slow READ logSlow WRITE setLogSlow NOTIFY changed)
+    void setLogSlow(int milliseconds);
+    [[nodiscard]] int logSlow() const;
+
+    /**
+     * Defines the address the master process serves the scoreboard on, either
+     * <tt>[address]:port</tt> or the path of a local socket. Each connection gets a JSON
+     * document with the requests, connections, bytes, current action and memory of every
+     * worker process and engine thread, followed by counters(), and is closed. Under
+     * systemd the status line also sums it up.
+     * Default value: empty, disabled.
+     * \since Cutelyst 5.1.0
+     * \note UNIX only
+     * @accessors stats(), setStats()
+     */
+    Q_PROPERTY(QString stats READ stats WRITE setStats NOTIFY changed)
+    void setStats(const QString &address);
+    [[nodiscard]] QString stats() const;
+
+    /**
+     * Defines the request path the workers answer with request latency histograms in the
+     * OpenMetrics text format, like <tt>/metrics</tt>. Requests are counted by action,
+     * status class and protocol by each engine thread, the histograms of every worker are
+     * merged when the path is requested and followed by counters(). The event loop lag of
+     * each engine thread is exported as the <tt>cutelyst_event_loop_lag_seconds</tt> histogram.
+     * Default value: empty, disabled.
+     * \since Cutelyst 5.1.0
+     * @accessors metrics(), setMetrics()
+     */
+    Q_PROPERTY(QString metrics READ metrics WRITE setMetrics NOTIFY changed)
+    void setMetrics(const QString &path);
+    [[nodiscard]] QString metrics() const;
+
+    /**
+     * Defines the file the spans of traced requests are appended to, one OTLP/JSON export
+     * request per line as read by the OpenTelemetry collector file receiver. Each worker
+     * process writes a batch once a second. Requests are traced with the
+     * \c trace_sample_rate option of the \c %Cutelyst configuration section, see Application.
+     * Default value: empty, disabled.
+     * \since Cutelyst 5.1.0
+     * @accessors traceExport(), setTraceExport()
+     */
+    Q_PROPERTY(QString trace_export READ traceExport WRITE setTraceExport NOTIFY changed)
+    void setTraceExport(const QString &file);
+    [[nodiscard]] QString traceExport() const;
+
+    /**
+     * Defines the file a line is appended to for each request. Engine threads only format
+     * the lines into a buffer of their own, a background thread of each worker writes
+     * them in batches, lines are dropped and counted when it can't keep up. The file is
+     * reopened on \c SIGUSR1, the master process forwards it to the workers so that it
+     * can be used by logrotate.
+     * Default value: empty, disabled.
+     * \since Cutelyst 5.1.0
+     * @accessors accessLog(), setAccessLog()
+     */
+    Q_PROPERTY(QString access_log READ accessLog WRITE setAccessLog NOTIFY changed)
+    void setAccessLog(const QString &file);
+    [[nodiscard]] QString accessLog() const;
+
+    /**
+     * Defines the format of the access log lines, with the nginx variables
+     * \c $remote_addr, \c $remote_port, \c $remote_user, \c $time_local,
+     * \c $time_iso8601, \c $msec, \c $request, \c $request_method, \c $request_uri,
+     * \c $uri, \c $args, \c $query_string, \c $server_protocol, \c $status,
+     * \c $body_bytes_sent, \c $request_length, \c $request_time,
+     * \c $upstream_response_time, \c $host, \c $pid, \c $http_<em>name</em> for request
+     * headers and \c $sent_http_<em>name</em> for response headers. \c $request_time is
+     * counted from the first byte of the request and \c $upstream_response_time from
+     * when it was handed to the application.
+     * Default value: empty, the combined log format
+     * <tt>$remote_addr - $remote_user [$time_local] "$request" $status $body_bytes_sent
+     * "$http_referer" "$http_user_agent"</tt>.
+     * \since Cutelyst 5.1.0
+     * @accessors accessLogFormat(), setAccessLogFormat()
+     */
+    Q_PROPERTY(
+        QString access_log_format READ accessLogFormat WRITE setAccessLogFormat NOTIFY changed)
+    void setAccessLogFormat(const QString &format);
+    [[nodiscard]] QString accessLogFormat() const;
+
     /**
      * Defines the socket listen queue size.
      * This setting currently works only on Linux for TCP sockets.
@@ -444,6 +782,133 @@ public:
     void setWebsocketMaxSize(int value);
     [[nodiscard]] int websocketMaxSize() const;
 
+    /**
+     * Enables the WebSocket permessage-deflate extension (RFC 7692), which is used when
+     * the client offers it on the handshake. Requires the server to be built with zlib.
+     * Default value: \c false.
+     * \since Cutelyst 5.1.0
+     * @accessors %websocketCompression(), setWebsocketCompression()
+     */
+    Q_PROPERTY(bool websocket_compression READ websocketCompression WRITE setWebsocketCompression
+                   NOTIFY changed)
+    void setWebsocketCompression(bool enable);
+    [[nodiscard]] bool websocketCompression() const;
+
+    /**
+     * Sets the maximum LZ77 window size, as a base-two logarithm between 9 and 15, used to
+     * compress and to decompress WebSocket messages when the client allows limiting it.
+     * Together with websocket_compression_mem_level it bounds the memory used per connection,
+     * deflate takes (1 << (window_bits + 2)) + (1 << (mem_level + 9)) bytes and inflate
+     * (1 << window_bits) plus about 7 KiB. Default value: \c 15.
+     * \since Cutelyst 5.1.0
+     * @accessors %websocketCompressionWindowBits(), setWebsocketCompressionWindowBits()
+     */
+    Q_PROPERTY(int websocket_compression_window_bits READ websocketCompressionWindowBits WRITE
+                   setWebsocketCompressionWindowBits NOTIFY changed)
+    void setWebsocketCompressionWindowBits(int windowBits);
+    [[nodiscard]] int websocketCompressionWindowBits() const;
+
+    /**
+     * Sets the zlib memory level between 1 and 9 used to compress WebSocket messages,
+     * lower values use less memory at the cost of compression ratio. Default value: \c 8.
+     * \since Cutelyst 5.1.0
+     * @accessors %websocketCompressionMemLevel(), setWebsocketCompressionMemLevel()
+     */
+    Q_PROPERTY(int websocket_compression_mem_level READ websocketCompressionMemLevel WRITE
+                   setWebsocketCompressionMemLevel NOTIFY changed)
+    void setWebsocketCompressionMemLevel(int memLevel);
+    [[nodiscard]] int websocketCompressionMemLevel() const;
+
+    /**
+     * Compresses each WebSocket message independently (server_no_context_takeover),
+     * this lowers the compression ratio of similar messages but the compression state
+     * doesn't depend on previous messages. Default value: \c false.
+     * \since Cutelyst 5.1.0
+     * @accessors %websocketCompressionNoContextTakeover(),
+     * setWebsocketCompressionNoContextTakeover()
+     */
+    Q_PROPERTY(bool websocket_compression_no_context_takeover READ
+                   websocketCompressionNoContextTakeover WRITE
+                       setWebsocketCompressionNoContextTakeover NOTIFY changed)
+    void setWebsocketCompressionNoContextTakeover(bool enable);
+    [[nodiscard]] bool websocketCompressionNoContextTakeover() const;
+
+    /**
+     * Sets the amount of outgoing data (in KiB) buffered for a WebSocket connection above
+     * which it is considered a slow consumer and websocket_slow_consumer_policy is applied
+     * to new messages. Default value: \c 0, which disables the limit.
+     * \since Cutelyst 5.1.0
+     * @accessors %websocketWriteHighWatermark(), setWebsocketWriteHighWatermark()
+     */
+    Q_PROPERTY(int websocket_write_high_watermark READ websocketWriteHighWatermark WRITE
+                   setWebsocketWriteHighWatermark NOTIFY changed)
+    void setWebsocketWriteHighWatermark(int value);
+    [[nodiscard]] int websocketWriteHighWatermark() const;
+
+    /**
+     * Sets the amount of outgoing data (in KiB) a slow WebSocket consumer must drain to
+     * before messages held back are written and Request::webSocketWritable() is emitted.
+     * Default value: \c 0, which uses a quarter of websocket_write_high_watermark.
+     * \since Cutelyst 5.1.0
+     * @accessors %websocketWriteLowWatermark(), setWebsocketWriteLowWatermark()
+     */
+    Q_PROPERTY(int websocket_write_low_watermark READ websocketWriteLowWatermark WRITE
+                   setWebsocketWriteLowWatermark NOTIFY changed)
+    void setWebsocketWriteLowWatermark(int value);
+    [[nodiscard]] int websocketWriteLowWatermark() const;
+
+    /**
+     * Defines what happens to messages sent to a WebSocket connection above
+     * websocket_write_high_watermark:
+     * \li \c close closes the connection with code 1008 (Policy Violation)
+     * \li \c drop-oldest holds messages back, discarding the oldest ones once they take
+     * more than websocket_write_high_watermark
+     * \li \c coalesce holds back only the most recent message
+     *
+     * Default value: \c close.
+     * \since Cutelyst 5.1.0
+     * @accessors %websocketSlowConsumerPolicy(), setWebsocketSlowConsumerPolicy()
+     */
+    Q_PROPERTY(QString websocket_slow_consumer_policy READ websocketSlowConsumerPolicy WRITE
+                   setWebsocketSlowConsumerPolicy NOTIFY changed)
+    void setWebsocketSlowConsumerPolicy(const QString &policy);
+    [[nodiscard]] QString websocketSlowConsumerPolicy() const;
+
+    /**
+     * Defines the interval in seconds at which the server sends a ping to WebSocket
+     * connections that haven't sent anything since the last one. Default value: \c 0,
+     * which disables server side pings.
+     * \since Cutelyst 5.1.0
+     * @accessors %websocketPingInterval(), setWebsocketPingInterval()
+     */
+    Q_PROPERTY(int websocket_ping_interval READ websocketPingInterval WRITE
+                   setWebsocketPingInterval NOTIFY changed)
+    void setWebsocketPingInterval(int seconds);
+    [[nodiscard]] int websocketPingInterval() const;
+
+    /**
+     * Defines how many seconds the server waits for a frame after sending a ping
+     * before it considers the peer dead and closes the connection. Default value: \c 10.
+     * \since Cutelyst 5.1.0
+     * @accessors %websocketPongTimeout(), setWebsocketPongTimeout()
+     */
+    Q_PROPERTY(int websocket_pong_timeout READ websocketPongTimeout WRITE
+                   setWebsocketPongTimeout NOTIFY changed)
+    void setWebsocketPongTimeout(int seconds);
+    [[nodiscard]] int websocketPongTimeout() const;
+
+    /**
+     * Defines after how many seconds without a text or binary message from the peer a
+     * WebSocket connection is closed, pings and pongs do not count as activity.
+     * Default value: \c 0, which disables the idle timeout.
+     * \since Cutelyst 5.1.0
+     * @accessors %websocketIdleTimeout(), setWebsocketIdleTimeout()
+     */
+    Q_PROPERTY(int websocket_idle_timeout READ websocketIdleTimeout WRITE
+                   setWebsocketIdleTimeout NOTIFY changed)
+    void setWebsocketIdleTimeout(int seconds);
+    [[nodiscard]] int websocketIdleTimeout() const;
+
     /**
      * Defines the pid file to be written before privileges drop.
      * @accessors pidfile(), setPidfile()
@@ -548,6 +1013,13 @@ public:
      */
     [[nodiscard]] QVariantMap config() const noexcept;
 
+    /**
+     * Returns the counters collected by the protocols of this process, like the number of
+     * HTTP/2 streams that were refused because of http2_max_concurrent_streams.
+     * \since Cutelyst 5.1.0
+     */
+    [[nodiscard]] QVariantMap counters() const;
+
 Q_SIGNALS:
     /**
      * It is emitted once the server is ready.
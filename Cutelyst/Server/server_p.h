@@ -17,8 +17,14 @@ class AbstractFork;
 
 namespace Cutelyst {
 
+class AccessLog;
+class Metrics;
 class Protocol;
 class ProtocolHttp2;
+class Scoreboard;
+class SlowRequestLog;
+class TlsSessionCache;
+class TraceExporter;
 class ServerPrivate : public QObject
 {
     Q_OBJECT
@@ -37,6 +43,7 @@ public:
     bool listenTcp(const QString &line, Protocol *protocol, bool secure);
     bool listenLocalSockets();
     bool listenLocal(const QString &line, Protocol *protocol);
+    bool expectsProxyProtocol(const QString &line) const;
     bool setupApplication();
     void engineShutdown(ServerEngine *engine);
     void checkEngineShutdown();
@@ -53,9 +60,12 @@ public:
     Protocol *getHttpProto();
     ProtocolHttp2 *getHttp2Proto();
     Protocol *getFastCgiProto();
+    Protocol *getUwsgiProto();
 
     Server *q_ptr;
     std::vector<QObject *> servers;
+    // Listening sockets from socket activation or a binary upgrade not taken yet
+    std::vector<int> inheritedSockets;
     std::vector<ServerEngine *> engines;
     Cutelyst::Application *app = nullptr;
     ServerEngine *mainEngine   = nullptr;
@@ -64,9 +74,15 @@ public:
     QVariantMap config;
     QStringList httpSockets;
     QStringList http2Sockets;
-    quint32 http2HeaderTableSize = 4096;
+    quint32 http2HeaderTableSize      = 4096;
+    quint32 http2MaxConcurrentStreams = 100;
+    quint32 http2MaxInflightRequests  = 16;
+    quint32 http2MaxResetStreams      = 100;
     QStringList httpsSockets;
     QStringList fastcgiSockets;
+    quint32 fastcgiMaxRequests = 64;
+    QStringList uwsgiSockets;
+    QStringList proxyProtocolSockets;
     QStringList staticMaps;
     QStringList staticMaps2;
     QStringList touchReload;
@@ -84,6 +100,11 @@ public:
     QString gid;
     QString chownSocket;
     QString umask;
+    QString stats;
+    QString metricsPath;
+    QString traceExport;
+    QString accessLogPath;
+    QString accessLogFormat;
     bool noInitgroups           = false;
     int cpuAffinity             = 0;
     bool reusePort              = false;
@@ -92,6 +113,7 @@ public:
     Protocol *protoHTTP         = nullptr;
     ProtocolHttp2 *protoHTTP2   = nullptr;
     Protocol *protoFCGI         = nullptr;
+    Protocol *protoUwsgi        = nullptr;
     AbstractFork *genericFork   = nullptr;
     QString lastListenError;
     int bufferSize          = 4096;
@@ -103,6 +125,17 @@ public:
     int socketTimeout       = 4;
     int websocketMaxSize    = 1024 * 1024;
     int listenQueue         = 100;
+    int rollingReload       = 0;
+    int workerReloadMercy   = 0;
+    int cheaper             = 0;
+    int cheaperStep         = 1;
+    int cheaperCooldown     = 10;
+    int maxRequests         = 0;
+    int reloadOnRss         = 0;
+    int reloadOnAs          = 0;
+    int maxWorkerLifetime   = 0;
+    int harakiri            = 0;
+    int logSlow             = 0;
     bool lazy               = false;
     bool master             = false;
     bool autoReload         = false;
@@ -115,6 +148,31 @@ public:
     bool usingFrontendProxy = false;
     bool loadingConfig      = false;
 
+    int websocketCompressionWindowBits         = 15;
+    int websocketCompressionMemLevel           = 8;
+    bool websocketCompression                  = false;
+    bool websocketCompressionNoContextTakeover = false;
+
+    QString websocketSlowConsumerPolicy = QStringLiteral("close");
+    int websocketWriteHighWatermark     = 0;
+    int websocketWriteLowWatermark      = 0;
+
+    int websocketPingInterval = 0;
+    int websocketPongTimeout  = 10;
+    int websocketIdleTimeout  = 0;
+
+    // Shared by the forked workers
+    TlsSessionCache *tlsSessionCache = nullptr;
+    Scoreboard *scoreboard           = nullptr;
+    Metrics *metrics                 = nullptr;
+    TraceExporter *traceExporter     = nullptr;
+    AccessLog *accessLog             = nullptr;
+    SlowRequestLog *slowRequests     = nullptr;
+    int tlsSessionCacheSize          = 0;
+    int tlsTicketKeyLifetime         = 3600;
+    bool ktls                        = false;
+    QString tlsBackend;
+
 Q_SIGNALS:
     void postForked(int workerId);
     void killChildProcess();
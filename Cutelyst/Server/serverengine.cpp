@@ -8,6 +8,7 @@
 #include "localserver.h"
 #include "protocol.h"
 #include "protocolfastcgi.h"
+#include "protocoluwsgi.h"
 #include "protocolhttp.h"
 #include "protocolhttp2.h"
 #include "protocolwebsocket.h"
@@ -17,6 +18,7 @@
 #include "tcpserver.h"
 #include "tcpserverbalancer.h"
 #include "tcpsslserver.h"
+#include "timerwheel.h"
 
 #ifdef Q_OS_UNIX
 #    include "unixfork.h"
@@ -77,6 +79,7 @@ ServerEngine::ServerEngine(Application *localApp,
 ServerEngine::~ServerEngine()
 {
     delete m_protoFcgi;
+    delete m_protoUwsgi;
     delete m_protoHttp;
     delete m_protoHttp2;
 }
@@ -107,6 +110,8 @@ void ServerEngine::setServers(const std::vector<QObject *> &servers)
                     cloneServer->setProtocol(getProtoHttp2());
                 } else if (cloneServer->protocol()->type() == Protocol::Type::FastCGI1) {
                     cloneServer->setProtocol(getProtoFastCgi());
+                } else if (cloneServer->protocol()->type() == Protocol::Type::Uwsgi) {
+                    cloneServer->setProtocol(getProtoUwsgi());
                 }
 
 #ifndef QT_NO_SSL
@@ -138,6 +143,8 @@ void ServerEngine::setServers(const std::vector<QObject *> &servers)
                     cloneServer->setProtocol(getProtoHttp2());
                 } else if (cloneServer->protocol()->type() == Protocol::Type::FastCGI1) {
                     cloneServer->setProtocol(getProtoFastCgi());
+                } else if (cloneServer->protocol()->type() == Protocol::Type::Uwsgi) {
+                    cloneServer->setProtocol(getProtoUwsgi());
                 }
             }
         }
@@ -197,6 +204,14 @@ Protocol *ServerEngine::getProtoFastCgi()
     return m_protoFcgi;
 }
 
+Protocol *ServerEngine::getProtoUwsgi()
+{
+    if (!m_protoUwsgi) {
+        m_protoUwsgi = new ProtocolUwsgi(m_server);
+    }
+    return m_protoUwsgi;
+}
+
 bool ServerEngine::init()
 {
     if (Q_LIKELY(initApplication())) {
@@ -218,4 +233,12 @@ void ServerEngine::handleSocketShutdown(Socket *socket)
     }
 }
 
+TimerWheel *ServerEngine::timerWheel()
+{
+    if (!m_timerWheel) {
+        m_timerWheel = new TimerWheel(this);
+    }
+    return m_timerWheel;
+}
+
 #include "moc_serverengine.cpp"
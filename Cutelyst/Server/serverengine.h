@@ -19,8 +19,14 @@ class Protocol;
 class ProtocolFastCGI;
 class ProtocolHttp;
 class ProtocolHttp2;
+class ProtocolUwsgi;
 class Server;
 class Socket;
+class TimerWheel;
+struct ScoreboardThread;
+class MetricsRecorder;
+class AccessLogBuffer;
+class SlowRequestLog;
 class ServerEngine final : public Cutelyst::Engine
 {
     Q_OBJECT
@@ -52,6 +58,39 @@ public:
 
     void handleSocketShutdown(Socket *sock);
 
+    /**
+     * Returns the timer wheel used for per connection timeouts of this engine,
+     * it's created on first use.
+     */
+    TimerWheel *timerWheel();
+
+    /**
+     * Sets the scoreboard slot the connections of this engine update, it must be set
+     * before the engine thread starts.
+     */
+    inline void setScoreboard(ScoreboardThread *scoreboard) { m_scoreboard = scoreboard; }
+
+    /**
+     * Sets where the requests of this engine are recorded, it must be set before the
+     * engine thread starts.
+     */
+    inline void setMetrics(MetricsRecorder *metrics) { m_metrics = metrics; }
+
+    /**
+     * Sets where the requests of this engine are logged, it must be set before the
+     * engine thread starts.
+     */
+    inline void setAccessLog(AccessLogBuffer *accessLog) { m_accessLog = accessLog; }
+
+    /**
+     * Sets what checks for slow requests of this engine, it must be set before the
+     * engine thread starts.
+     */
+    inline void setSlowRequests(const SlowRequestLog *slowRequests)
+    {
+        m_slowRequests = slowRequests;
+    }
+
 Q_SIGNALS:
     void started();
     void shutdown();
@@ -93,6 +132,7 @@ private:
     Protocol *getProtoHttp();
     ProtocolHttp2 *getProtoHttp2();
     Protocol *getProtoFastCgi();
+    Protocol *getProtoUwsgi();
 
     QByteArray m_lastDate;
     QElapsedTimer m_lastDateTimer;
@@ -101,8 +141,15 @@ private:
     ProtocolHttp *m_protoHttp    = nullptr;
     ProtocolHttp2 *m_protoHttp2  = nullptr;
     ProtocolFastCGI *m_protoFcgi = nullptr;
+    ProtocolUwsgi *m_protoUwsgi  = nullptr;
     int m_runningServers         = 0;
     int m_serversTimeout         = 0;
+
+    TimerWheel *m_timerWheel             = nullptr;
+    ScoreboardThread *m_scoreboard       = nullptr;
+    MetricsRecorder *m_metrics           = nullptr;
+    AccessLogBuffer *m_accessLog         = nullptr;
+    const SlowRequestLog *m_slowRequests = nullptr;
 };
 
 } // namespace Cutelyst
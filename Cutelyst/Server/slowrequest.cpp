@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "slowrequest.h"
+
+#include "Cutelyst/enginerequest.h"
+
+#include <Cutelyst/Context>
+#include <Cutelyst/Request>
+#include <Cutelyst/Stats>
+
+#include <QLoggingCategory>
+
+Q_LOGGING_CATEGORY(C_SERVER_SLOW, "cutelyst.server.slow", QtWarningMsg)
+
+using namespace Cutelyst;
+
+namespace {
+QByteArray milliseconds(qint64 nsecs)
+{
+    return QByteArray::number(double(nsecs) / 1e6, 'f', 3) + "ms";
+}
+} // namespace
+
+SlowRequestLog::SlowRequestLog(std::chrono::milliseconds threshold)
+    : m_thresholdNsecs(std::chrono::nanoseconds{threshold}.count())
+{
+}
+
+void SlowRequestLog::check(EngineRequest *request) const
+{
+    Context *c = request->context;
+    if (!c || request->endOfProcessing == TimePointSteady{}) {
+        return;
+    }
+
+    auto nsecs = [](std::chrono::steady_clock::duration duration) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    };
+
+    const qint64 processing = nsecs(request->startOfProcessing - request->startOfRequest);
+    const qint64 writing    = nsecs(std::chrono::steady_clock::now() - request->endOfProcessing);
+    // Async requests wait for events between their actions, only the time they ran counts
+    const qint64 dispatch = request->status & EngineRequest::Async
+                                ? request->executionTime.count()
+                                : nsecs(request->endOfProcessing - request->startOfProcessing);
+    if (dispatch + writing < m_thresholdNsecs) {
+        return;
+    }
+
+    const qint64 view   = request->viewTime.count();
+    const qint64 handle = qMax<qint64>(dispatch - view, 0);
+
+    const char *spentIn = "handleRequest";
+    if (view > handle && view >= writing) {
+        spentIn = "view rendering";
+    } else if (writing > handle && writing > view) {
+        spentIn = "body writing";
+    }
+
+    const Request *req = c->request();
+    QByteArray actions;
+    if (const Stats *stats = c->stats()) {
+        // Only there when tracing or Server-Timing collect them
+        actions = ": " + stats->serverTiming();
+    }
+    qCWarning(C_SERVER_SLOW).noquote().nospace()
+        << "Slow request " << req->method() << ' ' << req->path() << " kept its thread busy for "
+        << milliseconds(dispatch + writing) << ", mostly in " << spentIn << " (handleRequest "
+        << milliseconds(handle) << ", view rendering " << milliseconds(view) << ", body writing "
+        << milliseconds(writing) << ", waited " << milliseconds(processing) << " before dispatch)"
+        << actions;
+}
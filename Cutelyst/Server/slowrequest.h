@@ -0,0 +1,36 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <chrono>
+
+#include <QtGlobal>
+
+namespace Cutelyst {
+
+class EngineRequest;
+
+/**
+ * Logs the requests that kept their engine thread busy for longer than a threshold, and if
+ * the time went to dispatching them, to the views or to writing the body. The timings are
+ * taken by the engine request once EngineRequest::startOfProcessing is set, the actions
+ * executed are only listed when the application collects Stats for tracing or
+ * Server-Timing.
+ */
+class SlowRequestLog
+{
+public:
+    explicit SlowRequestLog(std::chrono::milliseconds threshold);
+
+    /**
+     * Checks \a request once its response is finished, before its context is deleted.
+     */
+    void check(EngineRequest *request) const;
+
+private:
+    qint64 m_thresholdNsecs;
+};
+
+} // namespace Cutelyst
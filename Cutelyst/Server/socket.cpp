@@ -14,12 +14,22 @@ using namespace Cutelyst;
 
 Socket::Socket(bool secure, Cutelyst::Engine *_engine)
     : engine(_engine)
+    , scoreboard(static_cast<ServerEngine *>(_engine)->m_scoreboard)
+    , metrics(static_cast<ServerEngine *>(_engine)->m_metrics)
+    , accessLog(static_cast<ServerEngine *>(_engine)->m_accessLog)
+    , slowRequests(static_cast<ServerEngine *>(_engine)->m_slowRequests)
     , isSecure(secure)
 {
+    if (scoreboard) {
+        scoreboard->connectionOpened();
+    }
 }
 
 Socket::~Socket()
 {
+    if (scoreboard) {
+        scoreboard->connectionClosed();
+    }
     delete protoData;
 }
 
@@ -43,7 +53,7 @@ void TcpSocket::connectionClose()
 bool TcpSocket::requestFinished()
 {
     bool disconnected = state() != ConnectedState;
-    if (!--processing && disconnected) {
+    if (!requestEnded() && disconnected) {
         Q_EMIT finished();
     }
     return !disconnected;
@@ -63,6 +73,20 @@ void TcpSocket::socketDisconnected()
     }
 }
 
+qint64 TcpSocket::readData(char *data, qint64 maxSize)
+{
+    const qint64 len = QTcpSocket::readData(data, maxSize);
+    countRead(len);
+    return len;
+}
+
+qint64 TcpSocket::writeData(const char *data, qint64 maxSize)
+{
+    const qint64 len = QTcpSocket::writeData(data, maxSize);
+    countWritten(len);
+    return len;
+}
+
 LocalSocket::LocalSocket(Cutelyst::Engine *engine, QObject *parent)
     : QLocalSocket(parent)
     , Socket(false, engine)
@@ -83,7 +107,7 @@ void LocalSocket::connectionClose()
 bool LocalSocket::requestFinished()
 {
     bool disconnected = state() != ConnectedState;
-    if (!--processing && disconnected) {
+    if (!requestEnded() && disconnected) {
         Q_EMIT finished();
     }
     return !disconnected;
@@ -103,6 +127,20 @@ void LocalSocket::socketDisconnected()
     }
 }
 
+qint64 LocalSocket::readData(char *data, qint64 maxSize)
+{
+    const qint64 len = QLocalSocket::readData(data, maxSize);
+    countRead(len);
+    return len;
+}
+
+qint64 LocalSocket::writeData(const char *data, qint64 maxSize)
+{
+    const qint64 len = QLocalSocket::writeData(data, maxSize);
+    countWritten(len);
+    return len;
+}
+
 #ifndef QT_NO_SSL
 
 SslSocket::SslSocket(Cutelyst::Engine *engine, QObject *parent)
@@ -125,7 +163,7 @@ void SslSocket::connectionClose()
 bool SslSocket::requestFinished()
 {
     bool disconnected = state() != ConnectedState;
-    if (!--processing && disconnected) {
+    if (!requestEnded() && disconnected) {
         Q_EMIT finished();
     }
     return !disconnected;
@@ -145,6 +183,20 @@ void SslSocket::socketDisconnected()
     }
 }
 
+qint64 SslSocket::readData(char *data, qint64 maxSize)
+{
+    const qint64 len = QSslSocket::readData(data, maxSize);
+    countRead(len);
+    return len;
+}
+
+qint64 SslSocket::writeData(const char *data, qint64 maxSize)
+{
+    const qint64 len = QSslSocket::writeData(data, maxSize);
+    countWritten(len);
+    return len;
+}
+
 #endif // QT_NO_SSL
 
 #include "moc_socket.cpp"
@@ -6,8 +6,12 @@
 #define SOCKET_H
 
 #include "Cutelyst/enginerequest.h"
+#include "accesslog.h"
+#include "metrics.h"
 #include "protocol.h"
+#include "scoreboard.h"
 #include "serverengine.h"
+#include "slowrequest.h"
 
 #include <Cutelyst/Headers>
 
@@ -46,15 +50,76 @@ public:
         protoData->resetData();
     }
 
+    // Called for each request handed to the engine, requestFinished() pairs it
+    inline void requestStarted(EngineRequest *request)
+    {
+        ++processing;
+        if (scoreboard) {
+            scoreboard->requestStarted();
+        }
+        if (metrics || accessLog || slowRequests) {
+            const auto now = std::chrono::steady_clock::now();
+            if (request->startOfRequest == TimePointSteady{}) {
+                request->startOfRequest = now;
+            }
+            request->startOfProcessing = now;
+            request->endOfProcessing   = {};
+            request->executionTime     = {};
+            request->viewTime          = {};
+        }
+    }
+
+    // Called once the response of request is finished, before its context is deleted
+    inline void requestCompleted(EngineRequest *request, Protocol::Type protocol)
+    {
+        if (metrics) {
+            metrics->record(request, protocol);
+        }
+        if (accessLog) {
+            accessLog->log(request);
+        }
+        if (slowRequests) {
+            slowRequests->check(request);
+        }
+    }
+
     QByteArray serverAddress;
     QHostAddress remoteAddress;
     quint16 remotePort = 0;
     Engine *engine;
-    Protocol *proto         = nullptr;
-    ProtocolData *protoData = nullptr;
-    qint8 processing        = 0;
+    Protocol *proto                    = nullptr;
+    ProtocolData *protoData            = nullptr;
+    ScoreboardThread *scoreboard       = nullptr;
+    MetricsRecorder *metrics           = nullptr;
+    AccessLogBuffer *accessLog         = nullptr;
+    const SlowRequestLog *slowRequests = nullptr;
+    int processing                     = 0;
     bool isSecure;
     bool timeout = false;
+
+protected:
+    // Returns the number of requests still being processed
+    inline int requestEnded()
+    {
+        if (scoreboard) {
+            scoreboard->requestFinished();
+        }
+        return --processing;
+    }
+
+    inline void countRead(qint64 len)
+    {
+        if (scoreboard && len > 0) {
+            scoreboard->addBytesIn(len);
+        }
+    }
+
+    inline void countWritten(qint64 len)
+    {
+        if (scoreboard && len > 0) {
+            scoreboard->addBytesOut(len);
+        }
+    }
 };
 
 class TcpSocket final
@@ -75,6 +140,10 @@ Q_SIGNALS:
     // triggered the disconnect event like websocket close, and deleting
     // it's context from this event will crash
     void finished();
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
 };
 
 #ifndef QT_NO_SSL
@@ -95,6 +164,10 @@ public:
 Q_SIGNALS:
     // See TcpSocket note
     void finished();
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
 };
 
 #endif // QT_NO_SSL
@@ -115,6 +188,10 @@ public:
 Q_SIGNALS:
     // See TcpSocket note
     void finished();
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
 };
 
 } // namespace Cutelyst
@@ -46,6 +46,19 @@ TcpServer::TcpServer(const QByteArray &serverAddress,
 }
 
 void TcpServer::incomingConnection(qintptr handle)
+{
+    if (m_proxyProtocol) {
+        auto accept = [this](qintptr handle, const ProxyProtocol::Header &header) {
+            acceptConnection(handle, &header);
+        };
+        const std::chrono::seconds timeout{m_server->socketTimeout()};
+        ProxyProtocol::read(handle, timeout, this, accept);
+    } else {
+        acceptConnection(handle, nullptr);
+    }
+}
+
+void TcpServer::acceptConnection(qintptr handle, const ProxyProtocol::Header *proxy)
 {
     auto sock           = new TcpSocket(m_engine, this);
     sock->serverAddress = m_serverAddress;
@@ -68,6 +81,9 @@ void TcpServer::incomingConnection(qintptr handle)
 
         sock->remoteAddress = sock->peerAddress();
         sock->remotePort    = sock->peerPort();
+        if (proxy) {
+            proxy->applyTo(sock);
+        }
         sock->protoData->setupNewConnection(sock);
 
         for (const auto &opt : m_socketOptions) {
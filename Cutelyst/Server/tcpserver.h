@@ -5,6 +5,8 @@
 #ifndef TCPSERVER_H
 #define TCPSERVER_H
 
+#include "proxyprotocol.h"
+
 #include <QTcpServer>
 
 namespace Cutelyst {
@@ -23,7 +25,7 @@ public:
                        QObject *parent = nullptr);
 
     Q_INVOKABLE
-    virtual void incomingConnection(qintptr handle) override;
+    void incomingConnection(qintptr handle) override;
 
     virtual void shutdown();
     virtual void timeoutConnections();
@@ -37,6 +39,9 @@ Q_SIGNALS:
 protected:
     friend class TcpServerBalancer;
 
+    // Creates the socket once the PROXY header, if expected, was read
+    virtual void acceptConnection(qintptr handle, const ProxyProtocol::Header *proxy);
+
     QByteArray m_serverAddress;
     ServerEngine *m_engine;
     Server *m_server;
@@ -44,6 +49,8 @@ protected:
     std::vector<std::pair<QAbstractSocket::SocketOption, QVariant>> m_socketOptions;
     Protocol *m_protocol;
     int m_processing = 0;
+
+    bool m_proxyProtocol = false;
 };
 
 } // namespace Cutelyst
@@ -19,6 +19,11 @@
 #include "tcpserverbalancer.h"
 #include "tcpsslserver.h"
 
+#if defined(HAS_OPENSSL) && defined(Q_OS_UNIX)
+#    include "tcptlsserver.h"
+#    include "tlscontext.h"
+#endif
+
 #include <iostream>
 #include <mutex>
 
@@ -37,6 +42,7 @@
 Q_LOGGING_CATEGORY(C_SERVER_BALANCER, "cutelyst.server.tcpbalancer", QtWarningMsg)
 
 using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
 
 #ifdef Q_OS_LINUX
 namespace {
@@ -45,7 +51,8 @@ int listenReuse(const QHostAddress &address,
                 quint16 port,
                 bool reusePort,
                 bool startListening);
-}
+int takeInheritedSocket(std::vector<int> *sockets, const QHostAddress &address, quint16 port);
+} // namespace
 #endif
 
 #ifdef Q_OS_WIN
@@ -188,6 +195,9 @@ TcpServerBalancer::~TcpServerBalancer()
 #ifndef QT_NO_SSL
     delete m_sslConfiguration;
 #endif // QT_NO_SSL
+#if defined(HAS_OPENSSL) && defined(Q_OS_UNIX)
+    delete m_tlsContext;
+#endif
 }
 
 bool TcpServerBalancer::listen(const QString &line, Protocol *protocol, bool secure)
@@ -223,8 +233,38 @@ bool TcpServerBalancer::listen(const QString &line, Protocol *protocol, bool sec
         port = 80;
     }
 
+    if (secure && m_server->tlsBackend() == u"openssl"_s) {
+#if defined(HAS_OPENSSL) && defined(Q_OS_UNIX)
+        if (commaPos == -1) {
+            std::cerr << "No SSL certificate specified" << '\n';
+            return false;
+        }
+
+        // OpenSSL detects the key algorithm by itself
+        const QString sslString = line.mid(commaPos + 1);
+        QString error;
+        m_tlsContext = TlsContext::create(
+            sslString.section(u',', 0, 0), sslString.section(u',', 1, 1), &error);
+        if (!m_tlsContext) {
+            std::cerr << qPrintable(error) << '\n';
+            return false;
+        }
+
+        m_tlsContext->setKtls(m_server->ktls());
+        if (m_tlsSessionCache) {
+            m_tlsContext->setSessionCache(m_tlsSessionCache);
+        }
+        if (m_server->httpsH2()) {
+            m_tlsContext->setAlpnProtocols({"h2"_ba, "http/1.1"_ba});
+        }
+#else
+        std::cerr << "The openssl TLS backend is not available" << '\n';
+        return false;
+#endif
+    }
+
 #ifndef QT_NO_SSL
-    if (secure) {
+    if (secure && !m_tlsContext) {
         if (commaPos == -1) {
             std::cerr << "No SSL certificate specified" << '\n';
             return false;
@@ -289,8 +329,11 @@ bool TcpServerBalancer::listen(const QString &line, Protocol *protocol, bool sec
     m_bindError.clear();
 
 #ifdef Q_OS_LINUX
-    int socket = listenReuse(
-        address, m_server->listenQueue(), port, m_server->reusePort(), !m_server->reusePort());
+    int socket = takeInheritedSocket(m_inheritedSockets, address, port);
+    if (socket == -1) {
+        socket = listenReuse(
+            address, m_server->listenQueue(), port, m_server->reusePort(), !m_server->reusePort());
+    }
     if (socket > 0) {
         if (setSocketDescriptor(socket)) {
             pauseAccepting();
@@ -603,6 +646,40 @@ int listenReuse(const QHostAddress &address,
 
     return socket;
 }
+
+int takeInheritedSocket(std::vector<int> *sockets, const QHostAddress &address, quint16 port)
+{
+    if (!sockets) {
+        return -1;
+    }
+
+    for (auto it = sockets->begin(); it != sockets->end(); ++it) {
+        sockaddr_storage addr{};
+        socklen_t addrLen = sizeof(addr);
+        if (::getsockname(*it, reinterpret_cast<sockaddr *>(&addr), &addrLen) == -1) {
+            continue;
+        }
+
+        quint16 inheritedPort;
+        if (addr.ss_family == AF_INET6) {
+            inheritedPort = ntohs(reinterpret_cast<const sockaddr_in6 *>(&addr)->sin6_port);
+        } else if (addr.ss_family == AF_INET) {
+            inheritedPort = ntohs(reinterpret_cast<const sockaddr_in *>(&addr)->sin_port);
+        } else {
+            continue;
+        }
+
+        // Tolerant, so Any matches the dual stack socket bound to ::
+        const QHostAddress inherited(reinterpret_cast<const sockaddr *>(&addr));
+        if (inheritedPort == port && inherited.isEqual(address)) {
+            const int socket = *it;
+            sockets->erase(it);
+            return socket;
+        }
+    }
+
+    return -1;
+}
 #endif // Q_OS_LINUX
 } // namespace
 
@@ -611,6 +688,26 @@ void TcpServerBalancer::setBalancer(bool enable)
     m_balancer = enable;
 }
 
+void TcpServerBalancer::setProxyProtocol(bool enable)
+{
+    m_proxyProtocol = enable;
+}
+
+void TcpServerBalancer::setHttp2Protocol(Protocol *protocol)
+{
+    m_http2Protocol = protocol;
+}
+
+void TcpServerBalancer::setTlsSessionCache(TlsSessionCache *cache)
+{
+    m_tlsSessionCache = cache;
+}
+
+void TcpServerBalancer::setInheritedSockets(std::vector<int> *sockets)
+{
+    m_inheritedSockets = sockets;
+}
+
 void TcpServerBalancer::incomingConnection(qintptr handle)
 {
     TcpServer *serverIdle = m_servers.at(m_currentServer++ % m_servers.size());
@@ -620,16 +717,27 @@ void TcpServerBalancer::incomingConnection(qintptr handle)
 
 TcpServer *TcpServerBalancer::createServer(ServerEngine *engine)
 {
-    TcpServer *server;
-    if (m_sslConfiguration) {
+    TcpServer *server = nullptr;
+#if defined(HAS_OPENSSL) && defined(Q_OS_UNIX)
+    if (m_tlsContext) {
+        auto tlsServer = new TcpTlsServer(m_serverName, m_protocol, m_server, engine);
+        tlsServer->setTlsContext(m_tlsContext);
+        tlsServer->setHttp2Protocol(m_http2Protocol);
+        server = tlsServer;
+    }
+#endif
 #ifndef QT_NO_SSL
+    if (m_sslConfiguration) {
         auto sslServer = new TcpSslServer(m_serverName, m_protocol, m_server, engine);
         sslServer->setSslConfiguration(*m_sslConfiguration);
+        sslServer->setHttp2Protocol(m_http2Protocol);
         server = sslServer;
+    }
 #endif // QT_NO_SSL
-    } else {
+    if (!server) {
         server = new TcpServer(m_serverName, m_protocol, m_server, engine);
     }
+    server->m_proxyProtocol = m_proxyProtocol;
     connect(engine, &ServerEngine::shutdown, server, &TcpServer::shutdown);
 
     if (m_balancer) {
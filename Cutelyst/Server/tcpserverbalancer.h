@@ -16,6 +16,8 @@ class Server;
 class TcpServer;
 class ServerEngine;
 class Protocol;
+class TlsContext;
+class TlsSessionCache;
 class TcpServerBalancer final : public QTcpServer
 {
     Q_OBJECT
@@ -26,6 +28,12 @@ public:
     bool listen(const QString &address, Protocol *protocol, bool secure);
 
     void setBalancer(bool enable);
+    void setProxyProtocol(bool enable);
+    // Protocol switched to when HTTPS clients negotiate h2
+    void setHttp2Protocol(Protocol *protocol);
+    void setTlsSessionCache(TlsSessionCache *cache);
+    // Listening sockets from socket activation or a binary upgrade, a match is taken out
+    void setInheritedSockets(std::vector<int> *sockets);
     QByteArray serverName() const { return m_serverName; }
     QString bindError() const { return m_bindError; }
 
@@ -40,9 +48,14 @@ private:
     std::vector<TcpServer *> m_servers;
     Server *m_server;
     Protocol *m_protocol                  = nullptr;
+    Protocol *m_http2Protocol             = nullptr;
     QSslConfiguration *m_sslConfiguration = nullptr;
+    TlsContext *m_tlsContext              = nullptr;
+    TlsSessionCache *m_tlsSessionCache    = nullptr;
+    std::vector<int> *m_inheritedSockets  = nullptr;
     int m_currentServer                   = 0;
     bool m_balancer                       = false;
+    bool m_proxyProtocol                  = false;
     QString m_bindError;
 };
 
@@ -22,7 +22,7 @@ TcpSslServer::TcpSslServer(const QByteArray &serverAddress,
 {
 }
 
-void TcpSslServer::incomingConnection(qintptr handle)
+void TcpSslServer::acceptConnection(qintptr handle, const ProxyProtocol::Header *proxy)
 {
     auto sock       = new SslSocket(m_engine, this);
     sock->protoData = m_protocol->createData(sock);
@@ -46,6 +46,9 @@ void TcpSslServer::incomingConnection(qintptr handle)
         sock->serverAddress = m_serverAddress;
         sock->remoteAddress = sock->peerAddress();
         sock->remotePort    = sock->peerPort();
+        if (proxy) {
+            proxy->applyTo(sock);
+        }
         sock->protoData->setupNewConnection(sock);
 
         for (const auto &opt : m_socketOptions) {
@@ -60,8 +63,10 @@ void TcpSslServer::incomingConnection(qintptr handle)
         if (m_http2Protocol) {
             connect(sock, &SslSocket::encrypted, this, [this, sock]() {
                 if (sock->sslConfiguration().nextNegotiatedProtocol() == "h2") {
+                    delete sock->protoData;
                     sock->proto     = m_http2Protocol;
                     sock->protoData = sock->proto->createData(sock);
+                    sock->protoData->setupNewConnection(sock);
                 }
             });
         }
@@ -28,8 +28,6 @@ public:
                           Server *server,
                           QObject *parent = nullptr);
 
-    virtual void incomingConnection(qintptr handle) override;
-
     virtual void shutdown() override;
     virtual void timeoutConnections() override;
 
@@ -37,6 +35,9 @@ public:
 
     void setHttp2Protocol(Protocol *protocol);
 
+protected:
+    void acceptConnection(qintptr handle, const ProxyProtocol::Header *proxy) override;
+
 private:
     Protocol *m_http2Protocol = nullptr;
     QSslConfiguration m_sslConfiguration;
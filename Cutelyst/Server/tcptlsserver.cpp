@@ -0,0 +1,125 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "tcptlsserver.h"
+
+#include "protocol.h"
+#include "server.h"
+#include "tlssocket.h"
+
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(C_SERVER_TCP)
+
+using namespace Cutelyst;
+
+TcpTlsServer::TcpTlsServer(const QByteArray &serverAddress,
+                           Protocol *protocol,
+                           Server *server,
+                           QObject *parent)
+    : TcpServer(serverAddress, protocol, server, parent)
+{
+}
+
+void TcpTlsServer::acceptConnection(qintptr handle, const ProxyProtocol::Header *proxy)
+{
+    auto sock           = new TlsSocket(m_context, m_engine, this);
+    sock->serverAddress = m_serverAddress;
+    sock->protoData     = m_protocol->createData(sock);
+
+    connect(sock, &QIODevice::readyRead, this, [sock] {
+        sock->timeout = false;
+        sock->proto->parse(sock, sock);
+    });
+    connect(sock, &TlsSocket::finished, this, [this, sock] {
+        sock->deleteLater();
+        if (--m_processing == 0) {
+            m_engine->stopSocketTimeout();
+        }
+    });
+
+    if (Q_LIKELY(sock->setSocketDescriptor(handle))) {
+        sock->proto = m_protocol;
+
+        if (proxy) {
+            proxy->applyTo(sock);
+        }
+        sock->protoData->setupNewConnection(sock);
+
+        for (const auto &opt : m_socketOptions) {
+            sock->setSocketOption(opt.first, opt.second);
+        }
+
+        if (++m_processing) {
+            m_engine->startSocketTimeout();
+        }
+
+        if (m_http2Protocol) {
+            connect(sock, &TlsSocket::encrypted, this, [this, sock] {
+                if (sock->negotiatedProtocol() == "h2") {
+                    delete sock->protoData;
+                    sock->proto     = m_http2Protocol;
+                    sock->protoData = sock->proto->createData(sock);
+                    sock->protoData->setupNewConnection(sock);
+                }
+            });
+        }
+    } else {
+        delete sock;
+    }
+}
+
+void TcpTlsServer::shutdown()
+{
+    close();
+
+    if (m_processing == 0) {
+        m_engine->serverShutdown();
+    } else {
+        const auto childrenL = children();
+        for (auto child : childrenL) {
+            auto socket = qobject_cast<TlsSocket *>(child);
+            if (socket) {
+                connect(socket, &TlsSocket::finished, this, [this]() {
+                    if (m_processing == 0) {
+                        m_engine->serverShutdown();
+                    }
+                });
+                m_engine->handleSocketShutdown(socket);
+            }
+        }
+    }
+}
+
+void TcpTlsServer::timeoutConnections()
+{
+    if (m_processing) {
+        const auto childrenL = children();
+        for (auto child : childrenL) {
+            auto socket = qobject_cast<TlsSocket *>(child);
+            // Also closes clients that never finish the handshake
+            if (socket && !socket->processing && socket->isConnected()) {
+                if (socket->timeout) {
+                    qCInfo(C_SERVER_TCP) << "timing out connection"
+                                         << socket->remoteAddress.toString() << socket->remotePort;
+                    socket->connectionClose();
+                } else {
+                    socket->timeout = true;
+                }
+            }
+        }
+    }
+}
+
+void TcpTlsServer::setTlsContext(TlsContext *context)
+{
+    m_context = context;
+}
+
+void TcpTlsServer::setHttp2Protocol(Protocol *protocol)
+{
+    m_http2Protocol = protocol;
+}
+
+#include "moc_tcptlsserver.cpp"
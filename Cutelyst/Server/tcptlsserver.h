@@ -0,0 +1,43 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef TCPTLSSERVER_H
+#define TCPTLSSERVER_H
+
+#include "tcpserver.h"
+
+namespace Cutelyst {
+
+class TlsContext;
+
+/**
+ * HTTPS server accepting TlsSocket connections, the OpenSSL counterpart of TcpSslServer.
+ */
+class TcpTlsServer final : public TcpServer
+{
+    Q_OBJECT
+public:
+    explicit TcpTlsServer(const QByteArray &serverAddress,
+                          Protocol *protocol,
+                          Server *server,
+                          QObject *parent = nullptr);
+
+    virtual void shutdown() override;
+    virtual void timeoutConnections() override;
+
+    void setTlsContext(TlsContext *context);
+
+    void setHttp2Protocol(Protocol *protocol);
+
+protected:
+    void acceptConnection(qintptr handle, const ProxyProtocol::Header *proxy) override;
+
+private:
+    Protocol *m_http2Protocol = nullptr;
+    TlsContext *m_context     = nullptr;
+};
+
+} // namespace Cutelyst
+
+#endif // TCPTLSSERVER_H
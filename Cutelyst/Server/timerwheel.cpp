@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "timerwheel.h"
+
+using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
+
+TimerWheel::Entry::~Entry()
+{
+    if (m_wheel) {
+        m_wheel->cancel(this);
+    }
+}
+
+TimerWheel::TimerWheel(QObject *parent, quint32 buckets)
+    : QObject(parent)
+    , m_buckets(qMax(1U, buckets) + 1, nullptr)
+{
+    m_timer.setObjectName(u"Cutelyst::TimerWheel"_s);
+    m_timer.setInterval(std::chrono::seconds{1});
+    connect(&m_timer, &QTimer::timeout, this, &TimerWheel::tick);
+}
+
+TimerWheel::~TimerWheel()
+{
+    for (Entry *head : m_buckets) {
+        while (head) {
+            Entry *next   = head->m_next;
+            head->m_wheel = nullptr;
+            head->m_prev  = nullptr;
+            head->m_next  = nullptr;
+            head          = next;
+        }
+    }
+}
+
+void TimerWheel::schedule(Entry *entry, std::chrono::seconds timeout)
+{
+    if (entry->m_wheel) {
+        cancel(entry);
+    }
+
+    // An entry is only looked at once the cursor moves, so it takes at least one tick
+    const auto ticks   = quint64(qMax<std::chrono::seconds::rep>(1, timeout.count()));
+    const auto buckets = quint64(wheelSize());
+    entry->m_rounds    = quint32((ticks - 1) / buckets);
+    entry->m_wheel     = this;
+    link(entry, quint32((m_cursor + ticks) % buckets));
+
+    if (++m_size == 1) {
+        m_timer.start();
+    }
+}
+
+void TimerWheel::cancel(Entry *entry)
+{
+    if (entry->m_wheel != this) {
+        return;
+    }
+
+    unlink(entry);
+    entry->m_wheel = nullptr;
+
+    if (--m_size == 0) {
+        m_timer.stop();
+    }
+}
+
+void TimerWheel::tick()
+{
+    m_cursor = (m_cursor + 1) % wheelSize();
+
+    // Expired entries are moved to their own list first as their callbacks may schedule,
+    // cancel or even delete other entries, including ones in this bucket
+    const quint32 expired = wheelSize();
+    Entry *entry          = m_buckets[m_cursor];
+    while (entry) {
+        Entry *next = entry->m_next;
+        if (entry->m_rounds) {
+            --entry->m_rounds;
+        } else {
+            unlink(entry);
+            link(entry, expired);
+        }
+        entry = next;
+    }
+
+    while (Entry *expiredEntry = m_buckets[expired]) {
+        cancel(expiredEntry);
+        expiredEntry->timerWheelExpired();
+    }
+}
+
+void TimerWheel::link(Entry *entry, quint32 bucket)
+{
+    entry->m_bucket = bucket;
+    entry->m_prev   = nullptr;
+    entry->m_next   = m_buckets[bucket];
+    if (entry->m_next) {
+        entry->m_next->m_prev = entry;
+    }
+    m_buckets[bucket] = entry;
+}
+
+void TimerWheel::unlink(Entry *entry)
+{
+    if (entry->m_prev) {
+        entry->m_prev->m_next = entry->m_next;
+    } else {
+        m_buckets[entry->m_bucket] = entry->m_next;
+    }
+    if (entry->m_next) {
+        entry->m_next->m_prev = entry->m_prev;
+    }
+    entry->m_prev = nullptr;
+    entry->m_next = nullptr;
+}
+
+#include "moc_timerwheel.cpp"
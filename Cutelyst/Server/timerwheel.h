@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include <QObject>
+#include <QTimer>
+
+namespace Cutelyst {
+
+/**
+ * A hashed timer wheel with one second resolution, it allows an engine thread to keep
+ * a timeout on a large number of connections with a single QTimer.
+ *
+ * Scheduling and cancelling are O(1), each tick only walks the entries in one bucket,
+ * timeouts longer than the wheel wait for the required number of rounds.
+ * The QTimer only runs while there are entries scheduled.
+ */
+class TimerWheel final : public QObject
+{
+    Q_OBJECT
+public:
+    class Entry
+    {
+    public:
+        Entry() = default;
+        virtual ~Entry();
+
+        Entry(const Entry &)            = delete;
+        Entry &operator=(const Entry &) = delete;
+
+        [[nodiscard]] inline bool isScheduled() const noexcept { return m_wheel; }
+
+    protected:
+        friend class TimerWheel;
+
+        /**
+         * Called from the wheel once the timeout expired, the entry is no longer
+         * scheduled so it can schedule itself again.
+         */
+        virtual void timerWheelExpired() = 0;
+
+    private:
+        TimerWheel *m_wheel = nullptr;
+        Entry *m_prev       = nullptr;
+        Entry *m_next       = nullptr;
+        quint32 m_rounds    = 0;
+        quint32 m_bucket    = 0;
+    };
+
+    explicit TimerWheel(QObject *parent = nullptr, quint32 buckets = 512);
+    ~TimerWheel() override;
+
+    /**
+     * Schedules \a entry to expire after \a timeout, rounded up to the next tick,
+     * an entry already scheduled is moved.
+     */
+    void schedule(Entry *entry, std::chrono::seconds timeout);
+
+    void cancel(Entry *entry);
+
+    [[nodiscard]] inline qsizetype size() const noexcept { return m_size; }
+
+private:
+    void tick();
+    void link(Entry *entry, quint32 bucket);
+    void unlink(Entry *entry);
+
+    // The last bucket holds the entries expired in the current tick
+    [[nodiscard]] inline quint32 wheelSize() const noexcept
+    {
+        return quint32(m_buckets.size() - 1);
+    }
+
+    std::vector<Entry *> m_buckets;
+    QTimer m_timer;
+    qsizetype m_size = 0;
+    quint32 m_cursor = 0;
+};
+
+} // namespace Cutelyst
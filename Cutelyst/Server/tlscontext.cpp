@@ -0,0 +1,146 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "tlscontext.h"
+
+#include "tlssessioncache.h"
+
+#include <QFile>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+
+QString lastError()
+{
+    char buf[256];
+    ERR_error_string_n(ERR_get_error(), buf, sizeof(buf));
+    ERR_clear_error();
+    return QString::fromLatin1(buf);
+}
+
+int alpnSelect(SSL *ssl,
+               const unsigned char **out,
+               unsigned char *outlen,
+               const unsigned char *in,
+               unsigned int inlen,
+               void *arg)
+{
+    Q_UNUSED(ssl)
+    const auto alpn = static_cast<const QByteArray *>(arg);
+    // Only reads from out, the const cast is an API quirk
+    if (SSL_select_next_proto(const_cast<unsigned char **>(out),
+                              outlen,
+                              reinterpret_cast<const unsigned char *>(alpn->constData()),
+                              unsigned(alpn->size()),
+                              in,
+                              inlen) == OPENSSL_NPN_NEGOTIATED) {
+        return SSL_TLSEXT_ERR_OK;
+    }
+    return SSL_TLSEXT_ERR_NOACK;
+}
+
+} // namespace
+
+TlsContext *
+    TlsContext::create(const QString &certificate, const QString &privateKey, QString *error)
+{
+    SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+    if (!ctx) {
+        *error = lastError();
+        return nullptr;
+    }
+
+    const QByteArray certPath = QFile::encodeName(certificate);
+    const QByteArray keyPath  = QFile::encodeName(privateKey);
+    if (SSL_CTX_use_certificate_chain_file(ctx, certPath.constData()) != 1) {
+        *error = u"Failed to load certificate %1: %2"_s.arg(certificate, lastError());
+        SSL_CTX_free(ctx);
+        return nullptr;
+    }
+
+    if (SSL_CTX_use_PrivateKey_file(ctx, keyPath.constData(), SSL_FILETYPE_PEM) != 1 ||
+        SSL_CTX_check_private_key(ctx) != 1) {
+        *error = u"Failed to load private key %1: %2"_s.arg(privateKey, lastError());
+        SSL_CTX_free(ctx);
+        return nullptr;
+    }
+
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    // Non-blocking sockets would otherwise have to read in order to write mid-connection
+    SSL_CTX_set_options(ctx, SSL_OP_CIPHER_SERVER_PREFERENCE | SSL_OP_NO_RENEGOTIATION);
+    // Partial writes are retried later from a buffer that may have been reallocated
+    SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+    return new TlsContext(ctx);
+}
+
+TlsContext::TlsContext(SSL_CTX *ctx)
+    : m_ctx(ctx)
+{
+}
+
+TlsContext::~TlsContext()
+{
+    SSL_CTX_free(m_ctx);
+}
+
+void TlsContext::setSessionCache(TlsSessionCache *cache)
+{
+    cache->install(m_ctx);
+}
+
+void TlsContext::setKtls(bool enable)
+{
+    m_ktls = enable;
+    if (enable) {
+        // The default cipher lists start with AEAD ciphers the kernel supports, server
+        // preference keeps clients from picking CBC ones that would disable it
+        SSL_CTX_set_options(m_ctx, SSL_OP_ENABLE_KTLS);
+    } else {
+        SSL_CTX_clear_options(m_ctx, SSL_OP_ENABLE_KTLS);
+    }
+}
+
+bool TlsContext::ktls() const
+{
+    return m_ktls;
+}
+
+void TlsContext::setAlpnProtocols(const QByteArrayList &protocols)
+{
+    // Wire format, each name prefixed by its length
+    m_alpn.clear();
+    for (const QByteArray &protocol : protocols) {
+        m_alpn.append(char(protocol.size()));
+        m_alpn.append(protocol);
+    }
+
+    if (m_alpn.isEmpty()) {
+        SSL_CTX_set_alpn_select_cb(m_ctx, nullptr, nullptr);
+    } else {
+        SSL_CTX_set_alpn_select_cb(m_ctx, alpnSelect, &m_alpn);
+    }
+}
+
+SSL_CTX *TlsContext::handle() const
+{
+    return m_ctx;
+}
+
+TlsContext::KtlsState TlsContext::ktlsState(SSL *ssl)
+{
+    KtlsState ret = KtlsNone;
+    if (BIO_get_ktls_send(SSL_get_wbio(ssl))) {
+        ret |= KtlsSend;
+    }
+    if (BIO_get_ktls_recv(SSL_get_rbio(ssl))) {
+        ret |= KtlsReceive;
+    }
+    return ret;
+}
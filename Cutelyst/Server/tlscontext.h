@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef TLSCONTEXT_H
+#define TLSCONTEXT_H
+
+#include <QByteArrayList>
+#include <QFlags>
+#include <QString>
+
+#include <openssl/types.h>
+
+namespace Cutelyst {
+
+class TlsSessionCache;
+
+/**
+ * OpenSSL server context of an HTTPS socket, shared by all connections accepted on it,
+ * unlike QSslSocket that builds one per connection.
+ */
+class TlsContext
+{
+public:
+    enum KtlsFlag {
+        KtlsNone    = 0x0,
+        KtlsSend    = 0x1,
+        KtlsReceive = 0x2,
+    };
+    Q_DECLARE_FLAGS(KtlsState, KtlsFlag)
+
+    /**
+     * Creates a context for the PEM encoded \a certificate chain and \a privateKey files,
+     * returns nullptr and sets \a error if they can't be used.
+     */
+    static TlsContext *
+        create(const QString &certificate, const QString &privateKey, QString *error);
+    ~TlsContext();
+
+    void setSessionCache(TlsSessionCache *cache);
+
+    /**
+     * Hands the negotiated keys to the kernel once the handshake is done, so records are
+     * encrypted by the kernel and plain writes go straight to the socket. Connections
+     * keep the userspace encryption if the kernel or the cipher doesn't support it.
+     */
+    void setKtls(bool enable);
+    bool ktls() const;
+
+    /**
+     * Sets the ALPN \a protocols offered to clients in order of preference, the first
+     * one also supported by the client is selected. Without it ALPN isn't negotiated.
+     */
+    void setAlpnProtocols(const QByteArrayList &protocols);
+
+    SSL_CTX *handle() const;
+
+    /**
+     * Returns the directions of the connection of \a ssl encrypted by the kernel.
+     */
+    static KtlsState ktlsState(SSL *ssl);
+
+private:
+    explicit TlsContext(SSL_CTX *ctx);
+
+    SSL_CTX *m_ctx;
+    QByteArray m_alpn;
+    bool m_ktls = false;
+};
+
+} // namespace Cutelyst
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(Cutelyst::TlsContext::KtlsState)
+
+#endif // TLSCONTEXT_H
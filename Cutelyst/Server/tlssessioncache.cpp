@@ -0,0 +1,472 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "tlssessioncache.h"
+
+#include <QLoggingCategory>
+
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <thread>
+
+#ifndef Q_OS_UNIX
+#    include <mutex>
+#endif
+
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/ssl.h>
+
+#ifdef Q_OS_UNIX
+#    include <errno.h>
+#    include <pthread.h>
+#    include <sys/mman.h>
+#endif
+
+// Robust mutexes are released by the kernel when their owner dies
+#if defined(Q_OS_LINUX) || defined(Q_OS_FREEBSD)
+#    define HAS_ROBUST_MUTEX
+#endif
+
+Q_LOGGING_CATEGORY(C_SERVER_TLS, "cutelyst.server.tls", QtWarningMsg)
+
+using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+
+// Server sessions without client certificates take a few hundred bytes
+constexpr int MaxSessionSize = 2048;
+
+#if defined(Q_OS_UNIX) && !defined(HAS_ROBUST_MUTEX)
+constexpr int SpinLimit = 4096;
+#endif
+
+qint64 steadySeconds()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Lives in the shared mapping and is never destroyed, it goes away with the mapping
+class SharedMutex
+{
+public:
+    SharedMutex()
+    {
+#ifdef Q_OS_UNIX
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+#    ifdef HAS_ROBUST_MUTEX
+        pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+#    endif
+        pthread_mutex_init(&m_mutex, &attr);
+        pthread_mutexattr_destroy(&attr);
+#endif
+    }
+
+private:
+    friend class SharedLock;
+
+#ifdef Q_OS_UNIX
+    pthread_mutex_t m_mutex;
+#else
+    std::mutex m_mutex;
+#endif
+};
+
+// Locks are only held to copy a slot. If the worker holding one dies, e.g. killed by
+// harakiri, the next one to lock it recovers it and is told the data may be half written
+class SharedLock
+{
+public:
+    explicit SharedLock(SharedMutex &mutex)
+        : m_mutex(mutex)
+        , m_locked(lock())
+    {
+    }
+
+    ~SharedLock()
+    {
+        if (m_locked) {
+#ifdef Q_OS_UNIX
+            pthread_mutex_unlock(&m_mutex.m_mutex);
+#else
+            m_mutex.m_mutex.unlock();
+#endif
+        }
+    }
+
+    explicit operator bool() const { return m_locked; }
+
+    // The previous owner died while holding the lock
+    bool recovered() const { return m_recovered; }
+
+private:
+    bool lock();
+
+    SharedMutex &m_mutex;
+    bool m_recovered = false;
+    const bool m_locked;
+};
+
+bool SharedLock::lock()
+{
+#if defined(HAS_ROBUST_MUTEX)
+    const int ret = pthread_mutex_lock(&m_mutex.m_mutex);
+    if (ret == EOWNERDEAD) {
+        m_recovered = true;
+        pthread_mutex_consistent(&m_mutex.m_mutex);
+        return true;
+    }
+    return ret == 0;
+#elif defined(Q_OS_UNIX)
+    // Without robust mutexes a lock left by a dead worker only turns its slot into misses
+    for (int i = 0; i < SpinLimit; ++i) {
+        if (pthread_mutex_trylock(&m_mutex.m_mutex) == 0) {
+            return true;
+        }
+        std::this_thread::yield();
+    }
+    return false;
+#else
+    m_mutex.m_mutex.lock();
+    return true;
+#endif
+}
+
+} // namespace
+
+struct TlsSessionCache::Shared {
+    struct TicketKey {
+        unsigned char name[16];
+        unsigned char aesKey[32];
+        unsigned char hmacKey[32];
+    };
+
+    struct Entry {
+        SharedMutex lock;
+        // Wall clock, as sessions carry their creation time
+        qint64 expires;
+        quint16 derSize;
+        quint8 idSize;
+        unsigned char id[SSL_MAX_SSL_SESSION_ID_LENGTH];
+        unsigned char der[MaxSessionSize];
+    };
+
+    std::atomic<quint64> fullHandshakes{0};
+    std::atomic<quint64> resumedHandshakes{0};
+
+    SharedMutex keysLock;
+    qint64 keysRotatedAt = 0;
+    qint64 keyLifetime   = 0;
+    // Current and previous
+    TicketKey keys[2];
+
+    int entries = 0;
+
+    // The slots follow this struct in the same mapping
+    Entry *slots() { return reinterpret_cast<Entry *>(this + 1); }
+
+    Entry *slotFor(const unsigned char *id, unsigned int len)
+    {
+        if (entries == 0 || len == 0) {
+            return nullptr;
+        }
+
+        // Session ids are random, their first bytes are as good as a hash
+        quint32 hash = 0;
+        memcpy(&hash, id, qMin<size_t>(len, sizeof(hash)));
+        return slots() + (hash % quint32(entries));
+    }
+};
+
+namespace {
+
+using Shared = TlsSessionCache::Shared;
+
+int exDataIndex()
+{
+    static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+Shared *sharedFromSsl(const SSL *ssl)
+{
+    return static_cast<Shared *>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), exDataIndex()));
+}
+
+bool generateKey(Shared::TicketKey &key)
+{
+    return RAND_bytes(key.name, sizeof(key.name)) == 1 &&
+           RAND_bytes(key.aesKey, sizeof(key.aesKey)) == 1 &&
+           RAND_bytes(key.hmacKey, sizeof(key.hmacKey)) == 1;
+}
+
+// Copies the keys, rotating them first when the current one is too old
+bool ticketKeys(Shared *shared, Shared::TicketKey *keys)
+{
+    SharedLock lock(shared->keysLock);
+    if (!lock) {
+        return false;
+    }
+
+    const qint64 now = steadySeconds();
+    if (now - shared->keysRotatedAt >= shared->keyLifetime) {
+        Shared::TicketKey key;
+        if (!generateKey(key)) {
+            return false;
+        }
+        shared->keys[1]       = shared->keys[0];
+        shared->keys[0]       = key;
+        shared->keysRotatedAt = now;
+    }
+
+    memcpy(keys, shared->keys, sizeof(shared->keys));
+    return true;
+}
+
+bool setMacKey(EVP_MAC_CTX *macCtx, Shared::TicketKey &key)
+{
+    char digest[] = "SHA256";
+    const OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.hmacKey, sizeof(key.hmacKey)),
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+        OSSL_PARAM_construct_end(),
+    };
+    return EVP_MAC_CTX_set_params(macCtx, params) == 1;
+}
+
+int ticketKeyCallback(SSL *ssl,
+                      unsigned char *keyName,
+                      unsigned char *iv,
+                      EVP_CIPHER_CTX *cipherCtx,
+                      EVP_MAC_CTX *macCtx,
+                      int enc)
+{
+    Shared *shared = sharedFromSsl(ssl);
+    Shared::TicketKey keys[2];
+    if (!shared || !ticketKeys(shared, keys)) {
+        // No ticket is issued or the ticket is ignored, both fall back to a full handshake
+        return 0;
+    }
+
+    const EVP_CIPHER *cipher = EVP_aes_256_cbc();
+    if (enc) {
+        Shared::TicketKey &key = keys[0];
+        if (RAND_bytes(iv, EVP_CIPHER_get_iv_length(cipher)) != 1) {
+            return -1;
+        }
+        memcpy(keyName, key.name, sizeof(key.name));
+        if (EVP_EncryptInit_ex(cipherCtx, cipher, nullptr, key.aesKey, iv) != 1 ||
+            !setMacKey(macCtx, key)) {
+            return -1;
+        }
+        return 1;
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        Shared::TicketKey &key = keys[i];
+        if (memcmp(keyName, key.name, sizeof(key.name)) == 0) {
+            if (EVP_DecryptInit_ex(cipherCtx, cipher, nullptr, key.aesKey, iv) != 1 ||
+                !setMacKey(macCtx, key)) {
+                return -1;
+            }
+            // Tickets of the previous key are renewed with the current one
+            return i == 0 ? 1 : 2;
+        }
+    }
+    return 0;
+}
+
+int newSession(SSL *ssl, SSL_SESSION *session)
+{
+    Shared *shared = sharedFromSsl(ssl);
+    if (!shared) {
+        return 0;
+    }
+
+    unsigned int idSize;
+    const unsigned char *id = SSL_SESSION_get_id(session, &idSize);
+    const int derSize       = i2d_SSL_SESSION(session, nullptr);
+    Shared::Entry *entry    = shared->slotFor(id, idSize);
+    if (!entry || derSize <= 0 || derSize > MaxSessionSize) {
+        return 0;
+    }
+
+    SharedLock lock(entry->lock);
+    if (lock) {
+        unsigned char *der = entry->der;
+        i2d_SSL_SESSION(session, &der);
+        entry->derSize = quint16(derSize);
+        entry->idSize  = quint8(idSize);
+        memcpy(entry->id, id, idSize);
+        entry->expires = qint64(time(nullptr)) + SSL_SESSION_get_timeout(session);
+    }
+
+    // It was serialized, OpenSSL keeps the only reference
+    return 0;
+}
+
+SSL_SESSION *getSession(SSL *ssl, const unsigned char *id, int idSize, int *copy)
+{
+    *copy          = 0;
+    Shared *shared = sharedFromSsl(ssl);
+    if (!shared || idSize <= 0 || idSize > SSL_MAX_SSL_SESSION_ID_LENGTH) {
+        return nullptr;
+    }
+
+    Shared::Entry *entry = shared->slotFor(id, unsigned(idSize));
+    if (!entry) {
+        return nullptr;
+    }
+
+    unsigned char der[MaxSessionSize];
+    int derSize;
+    {
+        SharedLock lock(entry->lock);
+        if (lock.recovered()) {
+            // The worker that died might have been writing it
+            entry->idSize = 0;
+        }
+        if (!lock || entry->idSize != idSize || memcmp(entry->id, id, size_t(idSize)) != 0 ||
+            entry->expires < qint64(time(nullptr))) {
+            return nullptr;
+        }
+        derSize = entry->derSize;
+        memcpy(der, entry->der, size_t(derSize));
+    }
+
+    const unsigned char *data = der;
+    return d2i_SSL_SESSION(nullptr, &data, derSize);
+}
+
+void removeSession(SSL_CTX *ctx, SSL_SESSION *session)
+{
+    auto shared = static_cast<Shared *>(SSL_CTX_get_ex_data(ctx, exDataIndex()));
+    if (!shared) {
+        return;
+    }
+
+    unsigned int idSize;
+    const unsigned char *id = SSL_SESSION_get_id(session, &idSize);
+    Shared::Entry *entry    = shared->slotFor(id, idSize);
+    if (!entry) {
+        return;
+    }
+
+    SharedLock lock(entry->lock);
+    if (lock && entry->idSize == idSize && memcmp(entry->id, id, idSize) == 0) {
+        entry->idSize = 0;
+    }
+}
+
+void infoCallback(const SSL *ssl, int where, int ret)
+{
+    Q_UNUSED(ret)
+    if (where & SSL_CB_HANDSHAKE_DONE) {
+        Shared *shared = sharedFromSsl(ssl);
+        if (!shared) {
+            return;
+        }
+
+        if (SSL_session_reused(ssl)) {
+            shared->resumedHandshakes.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            shared->fullHandshakes.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+} // namespace
+
+TlsSessionCache *TlsSessionCache::create(int entries, std::chrono::seconds ticketKeyLifetime)
+{
+    const size_t size = sizeof(Shared) + size_t(qMax(entries, 0)) * sizeof(Shared::Entry);
+
+#ifdef Q_OS_UNIX
+    // Anonymous shared memory is inherited by the forked workers
+    void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        qCCritical(C_SERVER_TLS) << "Failed to map TLS session cache:" << strerror(errno);
+        return nullptr;
+    }
+#else
+    // Without forking there is a single process to share with
+    void *mem = ::operator new(size, std::nothrow);
+    if (!mem) {
+        return nullptr;
+    }
+    memset(mem, 0, size);
+#endif
+
+    auto shared           = new (mem) Shared;
+    shared->entries       = qMax(entries, 0);
+    shared->keyLifetime   = qMax<qint64>(ticketKeyLifetime.count(), 1);
+    shared->keysRotatedAt = steadySeconds();
+    for (int i = 0; i < shared->entries; ++i) {
+        new (shared->slots() + i) Shared::Entry;
+    }
+
+    auto cache = new TlsSessionCache(shared, size);
+    if (!generateKey(shared->keys[0]) || !generateKey(shared->keys[1])) {
+        qCCritical(C_SERVER_TLS) << "Failed to generate TLS session ticket keys";
+        delete cache;
+        return nullptr;
+    }
+    return cache;
+}
+
+TlsSessionCache::TlsSessionCache(Shared *shared, size_t size)
+    : m_shared(shared)
+    , m_size(size)
+{
+}
+
+TlsSessionCache::~TlsSessionCache()
+{
+#ifdef Q_OS_UNIX
+    munmap(m_shared, m_size);
+#else
+    ::operator delete(m_shared);
+#endif
+}
+
+void TlsSessionCache::install(SSL_CTX *ctx)
+{
+    SSL_CTX_set_ex_data(ctx, exDataIndex(), m_shared);
+
+    // Sessions must be accepted by the contexts of all workers
+    static const unsigned char sessionIdContext[] = "cutelyst";
+    SSL_CTX_set_session_id_context(ctx, sessionIdContext, sizeof(sessionIdContext) - 1);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_set_timeout(ctx, long(m_shared->keyLifetime));
+
+    SSL_CTX_sess_set_new_cb(ctx, newSession);
+    SSL_CTX_sess_set_get_cb(ctx, getSession);
+    SSL_CTX_sess_set_remove_cb(ctx, removeSession);
+    SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, ticketKeyCallback);
+    SSL_CTX_set_info_callback(ctx, infoCallback);
+}
+
+quint64 TlsSessionCache::fullHandshakes() const
+{
+    return m_shared->fullHandshakes.load(std::memory_order_relaxed);
+}
+
+quint64 TlsSessionCache::resumedHandshakes() const
+{
+    return m_shared->resumedHandshakes.load(std::memory_order_relaxed);
+}
+
+void TlsSessionCache::counters(QVariantMap &counters) const
+{
+    counters.insert(u"tls_full_handshakes"_s, fullHandshakes());
+    counters.insert(u"tls_resumed_handshakes"_s, resumedHandshakes());
+}
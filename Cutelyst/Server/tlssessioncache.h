@@ -0,0 +1,59 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef TLSSESSIONCACHE_H
+#define TLSSESSIONCACHE_H
+
+#include <chrono>
+
+#include <QVariantMap>
+
+#include <openssl/types.h>
+
+namespace Cutelyst {
+
+/**
+ * Server side TLS session cache and session ticket keys living in shared memory.
+ *
+ * The master process creates it before forking so every worker maps the same memory,
+ * a client resuming its session on a different worker, or thread, than the one that
+ * did the full handshake is then still resumed.
+ *
+ * Sessions are kept in a fixed number of slots indexed by the session id, a new session
+ * simply replaces the one in its slot. Ticket keys are rotated by whichever worker first
+ * notices the current key is older than the lifetime, tickets encrypted with the previous
+ * key are still accepted and renewed.
+ */
+class TlsSessionCache
+{
+public:
+    /**
+     * Maps the shared memory for \a entries sessions, returns nullptr if it fails.
+     */
+    static TlsSessionCache *create(int entries, std::chrono::seconds ticketKeyLifetime);
+    ~TlsSessionCache();
+
+    /**
+     * Makes \a ctx store and lookup its sessions and encrypt its tickets here, it also
+     * counts the handshakes done by \a ctx.
+     */
+    void install(SSL_CTX *ctx);
+
+    quint64 fullHandshakes() const;
+    quint64 resumedHandshakes() const;
+
+    void counters(QVariantMap &counters) const;
+
+    struct Shared;
+
+private:
+    TlsSessionCache(Shared *shared, size_t size);
+
+    Shared *m_shared;
+    size_t m_size;
+};
+
+} // namespace Cutelyst
+
+#endif // TLSSESSIONCACHE_H
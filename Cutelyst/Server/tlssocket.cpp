@@ -0,0 +1,487 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "tlssocket.h"
+
+#include <QLoggingCategory>
+#include <QSocketNotifier>
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <limits>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+Q_LOGGING_CATEGORY(C_SERVER_TLS_SOCK, "cutelyst.server.tls.socket", QtWarningMsg)
+
+using namespace Cutelyst;
+
+namespace {
+
+// Room for a whole record, so no plain text is left behind in OpenSSL between reads
+constexpr int ReadChunkSize = 16 * 1024;
+// Decrypted per pass, so a client sending fast doesn't keep the event loop on one socket
+constexpr qsizetype MaxReadPerPass = 4 * ReadChunkSize;
+
+int chunkSize(qint64 size)
+{
+    return int(qMin(size, qint64(std::numeric_limits<int>::max())));
+}
+
+// OpenSSL writes to the socket with plain write(), which raises SIGPIPE once the peer is
+// gone. It is blocked in this thread while OpenSSL may write and a SIGPIPE it raised is
+// discarded, instead of ignoring the signal for the whole process.
+class SigPipeBlocker
+{
+public:
+    SigPipeBlocker()
+    {
+        sigemptyset(&m_sigPipe);
+        sigaddset(&m_sigPipe, SIGPIPE);
+        m_wasPending = isPending();
+        pthread_sigmask(SIG_BLOCK, &m_sigPipe, &m_oldMask);
+    }
+
+    ~SigPipeBlocker()
+    {
+        if (!m_wasPending && isPending()) {
+            const int savedErrno = errno;
+            const timespec noWait{};
+            while (sigtimedwait(&m_sigPipe, nullptr, &noWait) == -1 && errno == EINTR) {
+            }
+            errno = savedErrno;
+        }
+        pthread_sigmask(SIG_SETMASK, &m_oldMask, nullptr);
+    }
+
+private:
+    bool isPending() const
+    {
+        sigset_t pending;
+        return sigpending(&pending) == 0 && sigismember(&pending, SIGPIPE) == 1;
+    }
+
+    sigset_t m_sigPipe;
+    sigset_t m_oldMask;
+    bool m_wasPending;
+};
+
+} // namespace
+
+TlsSocket::TlsSocket(TlsContext *context, Cutelyst::Engine *engine, QObject *parent)
+    : QIODevice(parent)
+    , Socket(true, engine)
+    , m_ssl(SSL_new(context->handle()))
+{
+    connect(this,
+            &TlsSocket::disconnected,
+            this,
+            &TlsSocket::socketDisconnected,
+            Qt::DirectConnection);
+}
+
+TlsSocket::~TlsSocket()
+{
+    if (m_handle != -1) {
+        ::close(m_handle);
+    }
+    SSL_free(m_ssl);
+}
+
+bool TlsSocket::setSocketDescriptor(qintptr handle)
+{
+    m_handle = int(handle);
+
+    sockaddr_storage addr{};
+    socklen_t addrLen = sizeof(addr);
+    if (!m_ssl || ::getpeername(m_handle, reinterpret_cast<sockaddr *>(&addr), &addrLen) == -1 ||
+        ::fcntl(m_handle, F_SETFL, ::fcntl(m_handle, F_GETFL) | O_NONBLOCK) == -1 ||
+        SSL_set_fd(m_ssl, m_handle) != 1) {
+        ERR_clear_error();
+        return false;
+    }
+
+    remoteAddress = QHostAddress(reinterpret_cast<const sockaddr *>(&addr));
+    if (addr.ss_family == AF_INET6) {
+        remotePort = ntohs(reinterpret_cast<const sockaddr_in6 *>(&addr)->sin6_port);
+    } else {
+        remotePort = ntohs(reinterpret_cast<const sockaddr_in *>(&addr)->sin_port);
+    }
+
+    SSL_set_accept_state(m_ssl);
+
+    m_readNotifier = new QSocketNotifier(m_handle, QSocketNotifier::Read, this);
+    connect(m_readNotifier, &QSocketNotifier::activated, this, &TlsSocket::socketReadable);
+    m_writeNotifier = new QSocketNotifier(m_handle, QSocketNotifier::Write, this);
+    m_writeNotifier->setEnabled(false);
+    connect(m_writeNotifier, &QSocketNotifier::activated, this, &TlsSocket::socketWritable);
+
+    m_state = State::Handshaking;
+    return open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+}
+
+void TlsSocket::setSocketOption(QAbstractSocket::SocketOption option, const QVariant &value)
+{
+    int level = SOL_SOCKET;
+    int name;
+    switch (option) {
+    case QAbstractSocket::LowDelayOption:
+        level = IPPROTO_TCP;
+        name  = TCP_NODELAY;
+        break;
+    case QAbstractSocket::KeepAliveOption:
+        name = SO_KEEPALIVE;
+        break;
+    case QAbstractSocket::SendBufferSizeSocketOption:
+        name = SO_SNDBUF;
+        break;
+    case QAbstractSocket::ReceiveBufferSizeSocketOption:
+        name = SO_RCVBUF;
+        break;
+    default:
+        qCWarning(C_SERVER_TLS_SOCK) << "Unsupported socket option" << option;
+        return;
+    }
+
+    const int v = value.toInt();
+    if (::setsockopt(m_handle, level, name, &v, sizeof(v)) == -1) {
+        qCWarning(C_SERVER_TLS_SOCK) << "Failed to set socket option" << option << errno;
+    }
+}
+
+bool TlsSocket::isConnected() const
+{
+    return m_state != State::Unconnected;
+}
+
+QByteArray TlsSocket::negotiatedProtocol() const
+{
+    const unsigned char *data;
+    unsigned int len;
+    SSL_get0_alpn_selected(m_ssl, &data, &len);
+    return QByteArray(reinterpret_cast<const char *>(data), len);
+}
+
+TlsContext::KtlsState TlsSocket::ktlsState() const
+{
+    return TlsContext::ktlsState(m_ssl);
+}
+
+void TlsSocket::connectionClose()
+{
+    if (m_state == State::Unconnected || m_state == State::Closing) {
+        return;
+    }
+
+    if (m_state == State::Connected) {
+        writeBuffered();
+        if (bytesToWrite()) {
+            // Closed by socketWritable() once everything was sent
+            m_state = State::Closing;
+            m_readNotifier->setEnabled(m_writeWantsRead);
+            return;
+        }
+    }
+    closeSocket(m_state == State::Connected);
+}
+
+bool TlsSocket::requestFinished()
+{
+    const bool disconnected = m_state == State::Unconnected;
+    if (!requestEnded() && disconnected) {
+        Q_EMIT finished();
+    }
+    // A closing socket emits disconnected() once its data is written
+    return m_state == State::Connected;
+}
+
+bool TlsSocket::flush()
+{
+    return writeBuffered() > 0;
+}
+
+void TlsSocket::socketDisconnected()
+{
+    if (!processing) {
+        Q_EMIT finished();
+    } else {
+        protoData->socketDisconnected();
+    }
+}
+
+void TlsSocket::close()
+{
+    if (m_state == State::Connected) {
+        // Whatever OpenSSL takes now is still sent before close_notify
+        writeBuffered();
+    }
+    closeSocket(m_state == State::Connected);
+}
+
+bool TlsSocket::isSequential() const
+{
+    return true;
+}
+
+qint64 TlsSocket::bytesAvailable() const
+{
+    return m_readBuffer.size() - m_readPos + QIODevice::bytesAvailable();
+}
+
+qint64 TlsSocket::bytesToWrite() const
+{
+    return m_writeBuffer.size() - m_writePos;
+}
+
+qint64 TlsSocket::readData(char *data, qint64 maxSize)
+{
+    const qint64 len = qMin(maxSize, qint64(m_readBuffer.size() - m_readPos));
+    memcpy(data, m_readBuffer.constData() + m_readPos, size_t(len));
+    m_readPos += len;
+    if (m_readPos == m_readBuffer.size()) {
+        // Keeps the capacity for the next records
+        m_readBuffer.resize(0);
+        m_readPos = 0;
+    }
+    countRead(len);
+    return len;
+}
+
+qint64 TlsSocket::writeData(const char *data, qint64 maxSize)
+{
+    if (m_state != State::Connected) {
+        return -1;
+    }
+
+    qint64 written = 0;
+    if (!bytesToWrite()) {
+        // Nothing queued, so the data can go straight to OpenSSL
+        SigPipeBlocker blocker;
+        while (written < maxSize) {
+            const int len = SSL_write(m_ssl, data + written, chunkSize(maxSize - written));
+            if (len > 0) {
+                written += len;
+                continue;
+            }
+
+            const int error = SSL_get_error(m_ssl, len);
+            if (error == SSL_ERROR_WANT_WRITE) {
+                m_writeNotifier->setEnabled(true);
+            } else if (error == SSL_ERROR_WANT_READ) {
+                m_writeWantsRead = true;
+            } else {
+                qCDebug(C_SERVER_TLS_SOCK) << "Failed to write" << remoteAddress << error;
+                abortLater();
+                return -1;
+            }
+            break;
+        }
+    }
+
+    // OpenSSL wants the rest retried with the same bytes, possibly from another address
+    m_writeBuffer.append(data + written, maxSize - written);
+    countWritten(maxSize);
+    return maxSize;
+}
+
+void TlsSocket::socketReadable()
+{
+    if (m_state == State::Handshaking && !handshake()) {
+        return;
+    }
+
+    if (m_state == State::Connected) {
+        readRecords();
+    }
+
+    if (m_writeWantsRead) {
+        socketWritable();
+    } else if (m_state == State::Closing) {
+        // Nothing else is read from a closing socket
+        m_readNotifier->setEnabled(false);
+    }
+}
+
+void TlsSocket::socketWritable()
+{
+    m_writeNotifier->setEnabled(false);
+
+    if (m_state == State::Handshaking) {
+        handshake();
+        return;
+    }
+
+    if (m_readWantsWrite) {
+        m_readWantsWrite = false;
+        readRecords();
+    }
+
+    const qint64 written = writeBuffered();
+    if (written) {
+        Q_EMIT bytesWritten(written);
+    }
+
+    if (m_state == State::Closing && !bytesToWrite()) {
+        closeSocket(true);
+    }
+}
+
+bool TlsSocket::handshake()
+{
+    SigPipeBlocker blocker;
+    const int ret = SSL_do_handshake(m_ssl);
+    if (ret == 1) {
+        m_state = State::Connected;
+        Q_EMIT encrypted();
+        return true;
+    }
+
+    const int error = SSL_get_error(m_ssl, ret);
+    if (error == SSL_ERROR_WANT_WRITE) {
+        m_writeNotifier->setEnabled(true);
+    } else if (error != SSL_ERROR_WANT_READ) {
+        qCDebug(C_SERVER_TLS_SOCK) << "Handshake failed" << remoteAddress
+                                   << ERR_reason_error_string(ERR_peek_error());
+        closeSocket(false);
+    }
+    return false;
+}
+
+void TlsSocket::readRecords()
+{
+    if (m_readPos) {
+        m_readBuffer.remove(0, m_readPos);
+        m_readPos = 0;
+    }
+
+    // Reading may answer key updates
+    SigPipeBlocker blocker;
+    qsizetype received = 0;
+    int error          = SSL_ERROR_NONE;
+    while (received < MaxReadPerPass) {
+        const qsizetype size = m_readBuffer.size();
+        m_readBuffer.resize(size + ReadChunkSize);
+        const int len = SSL_read(m_ssl, m_readBuffer.data() + size, ReadChunkSize);
+        m_readBuffer.resize(size + qMax(len, 0));
+        if (len > 0) {
+            received += len;
+            continue;
+        }
+
+        error = SSL_get_error(m_ssl, len);
+        if (error == SSL_ERROR_WANT_WRITE) {
+            m_readWantsWrite = true;
+            m_writeNotifier->setEnabled(true);
+        }
+        break;
+    }
+
+    if (received) {
+        Q_EMIT readyRead();
+    }
+
+    if (error == SSL_ERROR_NONE) {
+        // Stopped at MaxReadPerPass, the read notifier fires again for data still in the
+        // kernel but not for records OpenSSL already took from it
+        if (SSL_has_pending(m_ssl) && !m_readQueued) {
+            m_readQueued = true;
+            QMetaObject::invokeMethod(
+                this,
+                [this] {
+                    m_readQueued = false;
+                    if (m_state == State::Connected) {
+                        readRecords();
+                    }
+                },
+                Qt::QueuedConnection);
+        }
+    } else if (error != SSL_ERROR_WANT_READ && error != SSL_ERROR_WANT_WRITE) {
+        // The peer sent close_notify, which is answered, or the connection broke
+        if (error != SSL_ERROR_ZERO_RETURN) {
+            qCDebug(C_SERVER_TLS_SOCK) << "Failed to read" << remoteAddress << error;
+        }
+        closeSocket(error == SSL_ERROR_ZERO_RETURN);
+    }
+}
+
+qint64 TlsSocket::writeBuffered()
+{
+    m_writeWantsRead = false;
+    if (!bytesToWrite()) {
+        return 0;
+    }
+
+    SigPipeBlocker blocker;
+    qint64 written = 0;
+    while (m_state != State::Unconnected && bytesToWrite()) {
+        const int len =
+            SSL_write(m_ssl, m_writeBuffer.constData() + m_writePos, chunkSize(bytesToWrite()));
+        if (len > 0) {
+            m_writePos += len;
+            written += len;
+            continue;
+        }
+
+        const int error = SSL_get_error(m_ssl, len);
+        if (error == SSL_ERROR_WANT_WRITE) {
+            m_writeNotifier->setEnabled(true);
+        } else if (error == SSL_ERROR_WANT_READ) {
+            m_writeWantsRead = true;
+            m_readNotifier->setEnabled(true);
+        } else {
+            qCDebug(C_SERVER_TLS_SOCK) << "Failed to write" << remoteAddress << error;
+            abortLater();
+        }
+        return written;
+    }
+
+    m_writeBuffer.resize(0);
+    m_writePos = 0;
+    return written;
+}
+
+void TlsSocket::abortLater()
+{
+    // The caller might still be using the connection
+    m_state = State::Closing;
+    m_readNotifier->setEnabled(false);
+    m_writeNotifier->setEnabled(false);
+    QMetaObject::invokeMethod(this, [this] { closeSocket(false); }, Qt::QueuedConnection);
+}
+
+void TlsSocket::closeSocket(bool notifyPeer)
+{
+    if (m_state == State::Unconnected) {
+        return;
+    }
+
+    if (notifyPeer) {
+        // Sessions of connections closed without close_notify can't be resumed
+        SigPipeBlocker blocker;
+        SSL_shutdown(m_ssl);
+    }
+    ERR_clear_error();
+
+    m_state = State::Unconnected;
+    m_readNotifier->setEnabled(false);
+    m_writeNotifier->setEnabled(false);
+    ::close(m_handle);
+    m_handle = -1;
+    m_writeBuffer.clear();
+    m_writePos = 0;
+
+    QIODevice::close();
+    Q_EMIT disconnected();
+}
+
+#include "moc_tlssocket.cpp"
@@ -0,0 +1,98 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef TLSSOCKET_H
+#define TLSSOCKET_H
+
+#include "socket.h"
+#include "tlscontext.h"
+
+#include <QAbstractSocket>
+#include <QIODevice>
+
+class QSocketNotifier;
+
+namespace Cutelyst {
+
+/**
+ * HTTPS connection encrypted with OpenSSL directly on the socket descriptor.
+ *
+ * Unlike QSslSocket records are read and written by SSL_read()/SSL_write() on the
+ * non-blocking descriptor, decrypted data is kept in a single buffer and writes only
+ * get buffered when the socket can't take them.
+ */
+class TlsSocket final
+    : public QIODevice
+    , public Socket
+{
+    Q_OBJECT
+public:
+    explicit TlsSocket(TlsContext *context, Cutelyst::Engine *engine, QObject *parent = nullptr);
+    ~TlsSocket() override;
+
+    // Takes ownership of the connected descriptor and waits for the client hello
+    bool setSocketDescriptor(qintptr handle);
+    void setSocketOption(QAbstractSocket::SocketOption option, const QVariant &value);
+
+    bool isConnected() const;
+    QByteArray negotiatedProtocol() const;
+    TlsContext::KtlsState ktlsState() const;
+
+    void connectionClose() override final;
+    bool requestFinished() override final;
+    bool flush() override final;
+    void socketDisconnected();
+
+    // Like QAbstractSocket it closes the connection, sending close_notify when connected
+    void close() override;
+    bool isSequential() const override;
+    qint64 bytesAvailable() const override;
+    qint64 bytesToWrite() const override;
+
+Q_SIGNALS:
+    void encrypted();
+    void disconnected();
+    // See TcpSocket note
+    void finished();
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    enum class State {
+        Unconnected,
+        Handshaking,
+        Connected,
+        // Closes once the buffered data is written, or right after an error
+        Closing,
+    };
+
+    void socketReadable();
+    void socketWritable();
+    bool handshake();
+    void readRecords();
+    qint64 writeBuffered();
+    void abortLater();
+    void closeSocket(bool notifyPeer);
+
+    SSL *m_ssl;
+    QSocketNotifier *m_readNotifier  = nullptr;
+    QSocketNotifier *m_writeNotifier = nullptr;
+    QByteArray m_readBuffer;
+    QByteArray m_writeBuffer;
+    qsizetype m_readPos  = 0;
+    qsizetype m_writePos = 0;
+    int m_handle         = -1;
+    State m_state        = State::Unconnected;
+    // TLS may need to read to write and the other way around, during key updates
+    bool m_writeWantsRead = false;
+    bool m_readWantsWrite = false;
+    // A pass stopped with decrypted data left in OpenSSL
+    bool m_readQueued = false;
+};
+
+} // namespace Cutelyst
+
+#endif // TLSSOCKET_H
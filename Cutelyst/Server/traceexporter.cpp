@@ -0,0 +1,168 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "traceexporter.h"
+
+#include <Cutelyst/Action>
+#include <Cutelyst/Application>
+#include <Cutelyst/Context>
+#include <Cutelyst/Request>
+#include <Cutelyst/Response>
+#include <Cutelyst/Stats>
+
+#include <iostream>
+#include <utility>
+
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+
+using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+constexpr auto FlushInterval = std::chrono::seconds{1};
+// Traces written at once when the queue fills up before the next flush
+constexpr int BatchSize = 256;
+// Traces kept while the file can't keep up
+constexpr int MaxPending = 4 * BatchSize;
+
+QJsonObject attribute(const QString &key, const QJsonObject &value)
+{
+    return {
+        {u"key"_s, key},
+        {u"value"_s, value},
+    };
+}
+
+QJsonObject stringValue(const QString &value)
+{
+    return {{u"stringValue"_s, value}};
+}
+
+QJsonObject intValue(qint64 value)
+{
+    // int64 values are strings in OTLP/JSON
+    return {{u"intValue"_s, QString::number(value)}};
+}
+} // namespace
+
+TraceExporter::TraceExporter(const QString &path, QObject *parent)
+    : QObject(parent)
+    , m_file(path)
+    , m_timer(new QTimer(this))
+{
+    m_timer->setInterval(FlushInterval);
+    connect(m_timer, &QTimer::timeout, this, &TraceExporter::flush);
+}
+
+TraceExporter::~TraceExporter()
+{
+    flush();
+}
+
+bool TraceExporter::open()
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered)) {
+        std::cerr << "Failed to open trace export file " << qPrintable(m_file.fileName())
+                  << ": " << qPrintable(m_file.errorString()) << '\n';
+        return false;
+    }
+
+    m_timer->start();
+    return true;
+}
+
+void TraceExporter::add(Context *c, const Stats *stats)
+{
+    const Request *request = c->request();
+    const Action *action   = c->action();
+    const QString route    = action ? u'/' + action->reverse() : request->path();
+
+    QJsonArray spans = stats->toOtlpSpans(QString::fromLatin1(request->method()) + u' ' + route);
+
+    QJsonObject root = spans.first().toObject();
+    root.insert(u"attributes"_s,
+                QJsonArray{
+                    attribute(u"http.request.method"_s,
+                              stringValue(QString::fromLatin1(request->method()))),
+                    attribute(u"url.path"_s, stringValue(request->path())),
+                    attribute(u"http.route"_s, stringValue(route)),
+                    attribute(u"http.response.status_code"_s, intValue(c->response()->status())),
+                });
+    spans.replace(0, root);
+
+    QMutexLocker locker(&m_mutex);
+    if (m_pendingTraces == MaxPending) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    for (const auto &span : std::as_const(spans)) {
+        m_pending.append(span);
+    }
+
+    if (++m_pendingTraces >= BatchSize && !m_flushQueued) {
+        m_flushQueued = true;
+        QMetaObject::invokeMethod(this, &TraceExporter::flush, Qt::QueuedConnection);
+    }
+}
+
+void TraceExporter::flush()
+{
+    QJsonArray spans;
+    int traces;
+    {
+        QMutexLocker locker(&m_mutex);
+        spans         = std::exchange(m_pending, {});
+        traces        = std::exchange(m_pendingTraces, 0);
+        m_flushQueued = false;
+    }
+
+    if (!traces || !m_file.isOpen()) {
+        return;
+    }
+
+    const QJsonObject resource{
+        {u"attributes"_s,
+         QJsonArray{
+             attribute(u"service.name"_s, stringValue(QCoreApplication::applicationName())),
+             attribute(u"process.pid"_s, intValue(QCoreApplication::applicationPid())),
+         }},
+    };
+    const QJsonObject scope{
+        {u"name"_s, u"cutelyst"_s},
+        {u"version"_s, QString::fromLatin1(Application::cutelystVersion())},
+    };
+    const QJsonObject exportRequest{
+        {u"resourceSpans"_s,
+         QJsonArray{QJsonObject{
+             {u"resource"_s, resource},
+             {u"scopeSpans"_s,
+              QJsonArray{QJsonObject{
+                  {u"scope"_s, scope},
+                  {u"spans"_s, spans},
+              }}},
+         }}},
+    };
+
+    // A single write per batch, so that lines of other workers are not interleaved
+    const QByteArray line = QJsonDocument(exportRequest).toJson(QJsonDocument::Compact) + '\n';
+    if (m_file.write(line) != line.size()) {
+        std::cerr << "Failed to write trace export file " << qPrintable(m_file.fileName())
+                  << ": " << qPrintable(m_file.errorString()) << '\n';
+        m_dropped.fetch_add(quint64(traces), std::memory_order_relaxed);
+        return;
+    }
+    m_exported.fetch_add(quint64(traces), std::memory_order_relaxed);
+}
+
+void TraceExporter::counters(QVariantMap &counters) const
+{
+    counters.insert(u"traces_exported"_s, m_exported.load(std::memory_order_relaxed));
+    counters.insert(u"traces_dropped"_s, m_dropped.load(std::memory_order_relaxed));
+}
+
+#include "moc_traceexporter.cpp"
@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <atomic>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QMutex>
+#include <QObject>
+#include <QVariantMap>
+
+class QTimer;
+
+namespace Cutelyst {
+
+class Context;
+class Stats;
+
+/**
+ * Writes the spans of traced requests to a file, one OTLP/JSON ExportTraceServiceRequest
+ * per line as read by the OpenTelemetry collector file receiver.
+ *
+ * Engine threads only queue the spans, they are written in batches from the thread of the
+ * exporter, once a second or as soon as a batch is full.
+ */
+class TraceExporter final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TraceExporter(const QString &path, QObject *parent = nullptr);
+    ~TraceExporter() override;
+
+    /**
+     * Opens the file to append to, returns false if it can't be written.
+     */
+    bool open();
+
+    /**
+     * Queues the spans of the request \a c, it's safe to call from any thread.
+     * Requests are dropped while the queue is full.
+     */
+    void add(Context *c, const Stats *stats);
+
+    /**
+     * Writes the queued spans.
+     */
+    void flush();
+
+    void counters(QVariantMap &counters) const;
+
+private:
+    QFile m_file;
+    QTimer *m_timer;
+    QMutex m_mutex;
+    QJsonArray m_pending;
+    int m_pendingTraces = 0;
+    bool m_flushQueued  = false;
+    std::atomic<quint64> m_exported{0};
+    std::atomic<quint64> m_dropped{0};
+};
+
+} // namespace Cutelyst
@@ -4,6 +4,8 @@
  */
 #include "unixfork.h"
 
+#include "harakiri.h"
+#include "loadmonitor.h"
 #include "server.h"
 
 #if defined(HAS_EventLoopEPoll)
@@ -15,13 +17,23 @@
 #    include <sys/param.h>
 #endif
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cerrno>
 #include <csignal>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
 #include <grp.h>
 #include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <pwd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -31,9 +43,12 @@
 #include <QAbstractEventDispatcher>
 #include <QCoreApplication>
 #include <QFile>
+#include <QFileInfo>
 #include <QLoggingCategory>
 #include <QMutex>
+#include <QRandomGenerator>
 #include <QSocketNotifier>
+#include <QStandardPaths>
 #include <QThread>
 #include <QTimer>
 
@@ -42,12 +57,117 @@ Q_LOGGING_CATEGORY(C_SERVER_UNIX, "cutelyst.server.unix", QtWarningMsg)
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-result"
 
+extern char **environ;
+
 using namespace Qt::StringLiterals;
 
 namespace {
 int signalsFd[2];
+
+// How long a rolling reload waits for a new worker to be ready
+constexpr auto ReloadReadyTimeout = std::chrono::seconds{60};
+
+// How long workers told to exit may drain when neither the mercy nor harakiri are set
+constexpr auto DefaultReloadMercy = std::chrono::seconds{60};
+
+// Same as SD_LISTEN_FDS_START, the upgraded binary picks the sockets up from there
+constexpr int ListenFdsStart = 3;
+
+// Load thresholds of the cheaper mode, above any high one workers are spawned and
+// below all low ones they are stopped
+constexpr double BusyHigh     = 0.75;
+constexpr double BusyLow      = 0.25;
+constexpr qint64 LagHighUsecs = 100'000;
+constexpr qint64 LagLowUsecs  = 10'000;
+constexpr auto LoadInterval   = std::chrono::seconds{1};
+
+// Limits that make a worker ask to be replaced, the master replaces one at a time after
+// a random delay so workers that reach them together aren't all replaced at once
+enum RecycleLimit : int {
+    RecycleRequests,
+    RecycleRss,
+    RecycleAs,
+    RecycleLifetime,
+};
+constexpr std::pair<const char *, const char *> RecycleLimits[] = {
+    {"max_requests", ""},
+    {"reload_on_rss", " MB"},
+    {"reload_on_as", " MB"},
+    {"max_worker_lifetime", " s"},
+};
+constexpr auto RecycleCheckInterval = std::chrono::seconds{1};
+constexpr auto RecycleDelayMin      = std::chrono::milliseconds{500};
+constexpr auto RecycleDelayMax      = std::chrono::milliseconds{5000};
+// Per worker the request and lifetime limits are lowered by up to this ratio
+constexpr double RecycleJitter = 0.1;
+
+constexpr auto HarakiriInterval = std::chrono::seconds{1};
+
+// Written by workers to the master on the ready pipe
+struct WorkerMessage {
+    pid_t pid;
+    // A RecycleLimit, or -1 once the worker is ready
+    int recycle;
+};
+constexpr int WorkerIsReady = -1;
+
+// Path of the binary to exec on a binary upgrade, which is the file that replaced the
+// running one, so /proc/self/exe is only used for its path
+QByteArray executablePath()
+{
+#ifdef Q_OS_LINUX
+    QString path = QFile::symLinkTarget(u"/proc/self/exe"_s);
+    if (path.endsWith(u" (deleted)")) {
+        path.chop(10);
+    }
+    if (!path.isEmpty()) {
+        return QFile::encodeName(path);
+    }
+#endif
+
+    // The working directory may have changed since argv[0] was resolved by the shell
+    const QString argv0 = QCoreApplication::arguments().value(0);
+    if (argv0.contains(u'/')) {
+        return QFile::encodeName(QFileInfo(argv0).absoluteFilePath());
+    }
+    return QFile::encodeName(QStandardPaths::findExecutable(argv0));
+}
+
+// snprintf() isn't async-signal-safe, so the forked child writes its pid with this
+void writeDecimal(char *buffer, int value)
+{
+    char digits[12];
+    int len = 0;
+    do {
+        digits[len++] = char('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    while (len) {
+        *buffer++ = digits[--len];
+    }
+    *buffer = '\0';
+}
 } // namespace
 
+// Lives in memory shared with the workers, so any of them can report it
+struct UnixForkStats {
+    std::atomic<quint64> reloads{0};
+    std::atomic<qint64> lastReloadDuration{0};
+    std::atomic<int> workers{0};
+    std::atomic<int> readyWorkers{0};
+    std::atomic<int> reloadMinReadyWorkers{0};
+    std::atomic<bool> reloading{false};
+    std::atomic<quint64> workersSpawned{0};
+    std::atomic<quint64> workersStopped{0};
+    std::atomic<int> loadBusyPercent{0};
+    std::atomic<int> loadBacklog{0};
+    std::atomic<qint64> loadLagUsecs{0};
+    // Indexed by RecycleLimit
+    std::array<std::atomic<quint64>, std::size(RecycleLimits)> recycles{};
+    std::atomic<quint64> harakiri{0};
+};
+
 UnixFork::UnixFork(int process, int threads, bool setupSignals, QObject *parent)
     : AbstractFork(parent)
     , m_threads(threads)
@@ -56,6 +176,50 @@ UnixFork::UnixFork(int process, int threads, bool setupSignals, QObject *parent)
     if (setupSignals) {
         setupUnixSignalHandlers();
     }
+
+    if (m_processes > 0) {
+        void *stats = mmap(nullptr,
+                           sizeof(UnixForkStats),
+                           PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_ANONYMOUS,
+                           -1,
+                           0);
+        if (stats != MAP_FAILED) {
+            m_stats = new (stats) UnixForkStats;
+        }
+
+        m_slotCount = m_processes * 2;
+
+        void *loads = mmap(nullptr,
+                           sizeof(Cutelyst::WorkerLoad) * size_t(m_slotCount),
+                           PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_ANONYMOUS,
+                           -1,
+                           0);
+        if (loads != MAP_FAILED) {
+            m_loads = static_cast<Cutelyst::WorkerLoad *>(loads);
+            for (int i = 0; i < m_slotCount; ++i) {
+                new (m_loads + i) Cutelyst::WorkerLoad;
+            }
+            m_lastBusy.resize(size_t(m_slotCount));
+        }
+
+        // Workers write a WorkerMessage once ready or when they reach a recycle limit
+        if (pipe(m_readyFd) == 0) {
+            fcntl(m_readyFd[0], F_SETFL, O_NONBLOCK);
+            fcntl(m_readyFd[0], F_SETFD, FD_CLOEXEC);
+            fcntl(m_readyFd[1], F_SETFD, FD_CLOEXEC);
+        } else {
+            qCWarning(C_SERVER_UNIX) << "Failed to create the worker ready pipe" << errno;
+        }
+    }
+
+    // Set by the master that exec'd this binary, it exits once our workers are ready
+    const qint64 upgradeParent = qEnvironmentVariableIntValue("CUTELYST_UPGRADE_PID");
+    if (upgradeParent > 0 && upgradeParent == getppid()) {
+        m_upgradeParent = upgradeParent;
+    }
+    qunsetenv("CUTELYST_UPGRADE_PID");
 }
 
 UnixFork::~UnixFork()
@@ -63,6 +227,20 @@ UnixFork::~UnixFork()
     if (m_child) {
         _exit(0);
     }
+
+    if (m_stats) {
+        munmap(m_stats, sizeof(UnixForkStats));
+    }
+
+    if (m_loads) {
+        munmap(m_loads, sizeof(Cutelyst::WorkerLoad) * size_t(m_slotCount));
+    }
+
+    if (m_harakiriSlots) {
+        // Stopped before the slots it reads go away
+        delete m_harakiriMonitor;
+        munmap(m_harakiriSlots, sizeof(Cutelyst::HarakiriSlot) * size_t(m_slotCount * m_threads));
+    }
 }
 
 bool UnixFork::continueMaster(int *exit)
@@ -90,6 +268,14 @@ int UnixFork::exec(bool lazy, bool master)
         if (m_processes > 0) {
             ret = internalExec();
         } else {
+            if (m_harakiriSlots) {
+                // There is no master to watch the requests
+                Cutelyst::HarakiriMonitor::installBacktraceHandler();
+                m_harakiriMonitor =
+                    new Cutelyst::HarakiriMonitor(m_harakiriSlots, m_threads, m_harakiri, this);
+                m_harakiriMonitor->start();
+            }
+
             Q_EMIT forked(0);
             ret = qApp->exec();
         }
@@ -100,16 +286,189 @@ int UnixFork::exec(bool lazy, bool master)
 
 void UnixFork::restart()
 {
+    if (m_rollingReload > 0) {
+        rollingRestart();
+        return;
+    }
+
+    const auto killAt = reloadMercyDeadline();
     for (const auto &[key, value] : m_childs.asKeyValueRange()) {
         value.restart = 1; // Mark as requiring restart
+        value.killAt  = killAt;
         terminateChild(key);
     }
 
     setupCheckChildTimer();
 }
 
+void UnixFork::workerReady()
+{
+    if (m_child && m_readyFd[1] != -1) {
+        const WorkerMessage message{getpid(), WorkerIsReady};
+        write(m_readyFd[1], &message, sizeof(message));
+    }
+}
+
+void UnixFork::counters(QVariantMap &counters) const
+{
+    if (m_harakiriMonitor) {
+        counters.insert(u"harakiri"_s, m_harakiriMonitor->reported());
+    }
+
+    if (!m_stats) {
+        return;
+    }
+
+    if (m_harakiriSlots) {
+        counters.insert(u"harakiri"_s, m_stats->harakiri.load());
+    }
+
+    counters.insert(u"workers"_s, m_stats->workers.load());
+    counters.insert(u"workers_ready"_s, m_stats->readyWorkers.load());
+    counters.insert(u"reloads"_s, m_stats->reloads.load());
+    counters.insert(u"reload_in_progress"_s, m_stats->reloading.load());
+    counters.insert(u"reload_last_duration_ms"_s, m_stats->lastReloadDuration.load());
+    counters.insert(u"reload_min_workers_ready"_s, m_stats->reloadMinReadyWorkers.load());
+
+    if (m_cheaper) {
+        counters.insert(u"workers_min"_s, m_cheaper);
+        counters.insert(u"workers_max"_s, m_processes);
+        counters.insert(u"workers_spawned"_s, m_stats->workersSpawned.load());
+        counters.insert(u"workers_stopped"_s, m_stats->workersStopped.load());
+        counters.insert(u"load_busy_percent"_s, m_stats->loadBusyPercent.load());
+        counters.insert(u"load_backlog"_s, m_stats->loadBacklog.load());
+        counters.insert(u"load_lag_ms"_s, m_stats->loadLagUsecs.load() / 1000);
+    }
+
+    if (m_maxRequests || m_reloadOnRss || m_reloadOnAs || m_maxLifetime.count()) {
+        for (size_t i = 0; i < std::size(RecycleLimits); ++i) {
+            counters.insert(u"recycles_"_s + QLatin1String(RecycleLimits[i].first),
+                            m_stats->recycles[i].load());
+        }
+    }
+}
+
+void UnixFork::setRollingReload(int workers)
+{
+    m_rollingReload = workers;
+}
+
+void UnixFork::setReloadMercy(std::chrono::seconds mercy)
+{
+    m_reloadMercy = mercy;
+}
+
+void UnixFork::setListenSockets(const std::vector<int> &sockets)
+{
+    m_listenSockets = sockets;
+}
+
+void UnixFork::setCheaper(int minWorkers, int step, std::chrono::seconds cooldown)
+{
+    // Only meaningful below the number of processes
+    const bool enable = minWorkers > 0 && minWorkers < m_processes && m_loads && m_stats;
+    m_cheaper         = enable ? minWorkers : 0;
+    m_cheaperStep     = qMax(step, 1);
+    m_cheaperCooldown = cooldown;
+}
+
+int UnixFork::slotCount() const
+{
+    return m_slotCount;
+}
+
+int UnixFork::slot() const
+{
+    return m_slot;
+}
+
+Cutelyst::WorkerLoad *UnixFork::workerLoad() const
+{
+    if (m_child && m_cheaper && m_loads) {
+        return m_loads + m_slot;
+    }
+    return nullptr;
+}
+
+void UnixFork::setRecycle(int maxRequests, int rss, int as, std::chrono::seconds lifetime)
+{
+    // Workers are replaced by the master, which they tell through the ready pipe
+    if (m_processes <= 0 || !m_stats || m_readyFd[1] == -1) {
+        return;
+    }
+
+    m_maxRequests = qMax(maxRequests, 0);
+    m_reloadOnRss = qMax(rss, 0);
+    m_reloadOnAs  = qMax(as, 0);
+    m_maxLifetime = qMax(lifetime, std::chrono::seconds{0});
+}
+
+bool UnixFork::countRequests() const
+{
+    return m_child && m_requestsLimit > 0;
+}
+
+void UnixFork::requestStarted()
+{
+    const quint64 requests = m_requests.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (requests == m_requestsLimit) {
+        recycle(RecycleRequests, qint64(requests), qint64(m_requestsLimit));
+    }
+}
+
+void UnixFork::setHarakiri(std::chrono::seconds timeout)
+{
+    if (timeout.count() <= 0 || m_harakiriSlots) {
+        return;
+    }
+
+    // One per thread of each worker slot, without worker processes there is a single one
+    void *table = mmap(nullptr,
+                       sizeof(Cutelyst::HarakiriSlot) * size_t(m_slotCount * m_threads),
+                       PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_ANONYMOUS,
+                       -1,
+                       0);
+    if (table == MAP_FAILED) {
+        qCWarning(C_SERVER_UNIX) << "Failed to map the harakiri slots" << errno;
+        return;
+    }
+
+    m_harakiriSlots = static_cast<Cutelyst::HarakiriSlot *>(table);
+    for (int i = 0; i < m_slotCount * m_threads; ++i) {
+        new (m_harakiriSlots + i) Cutelyst::HarakiriSlot;
+    }
+    m_harakiri = timeout;
+}
+
+Cutelyst::HarakiriSlot *UnixFork::harakiriSlots() const
+{
+    if (m_child) {
+        return m_harakiriSlots ? m_harakiriSlots + m_slot * m_threads : nullptr;
+    }
+
+    // Only set without worker processes
+    return m_harakiriMonitor ? m_harakiriSlots : nullptr;
+}
+
 int UnixFork::internalExec()
 {
+    if (m_cheaper) {
+        m_loadTimer = new QTimer(this);
+        m_loadTimer->setInterval(LoadInterval);
+        connect(m_loadTimer, &QTimer::timeout, this, &UnixFork::checkLoad);
+        m_loadTimer->start();
+        m_loadElapsed.start();
+        m_lastScale.start();
+    }
+
+    if (m_harakiriSlots) {
+        m_harakiriTimer = new QTimer(this);
+        m_harakiriTimer->setInterval(HarakiriInterval);
+        connect(m_harakiriTimer, &QTimer::timeout, this, &UnixFork::checkHarakiri);
+        m_harakiriTimer->start();
+    }
+
     int ret;
     bool respawn = false;
     do {
@@ -141,9 +500,12 @@ bool UnixFork::createProcess(bool respawn)
             return true; // Clean recreate worker list
         });
     } else {
-        for (int i = 0; i < m_processes; ++i) {
+        // The cheaper mode spawns the others once the load requires them
+        const int initial = m_cheaper ? m_cheaper : m_processes;
+        for (int i = 0; i < initial; ++i) {
             Worker worker;
             worker.id   = i + 1;
+            worker.slot = i;
             worker.null = false;
             createChild(worker, respawn);
         }
@@ -255,11 +617,39 @@ void UnixFork::setupCheckChildTimer()
     }
 }
 
-void UnixFork::postFork(int workerId)
+void UnixFork::setupReadyNotifier()
+{
+    delete m_readyNotifier;
+    m_readyNotifier = nullptr;
+
+    if (m_readyFd[0] != -1) {
+        m_readyNotifier = new QSocketNotifier(m_readyFd[0], QSocketNotifier::Read, this);
+        connect(
+            m_readyNotifier, &QSocketNotifier::activated, this, &UnixFork::handleWorkerMessages);
+    }
+}
+
+void UnixFork::postFork(int workerId, int slot)
 {
     // Child must not have parent timers
     delete m_checkChildRestart;
+    delete m_reloadDeadline;
+    m_reloadDeadline = nullptr;
+    delete m_loadTimer;
+    m_loadTimer = nullptr;
+    delete m_recycleDelay;
+    m_recycleDelay = nullptr;
+    m_recycleQueue.clear();
+    delete m_harakiriTimer;
+    m_harakiriTimer = nullptr;
+
+    if (m_harakiriSlots) {
+        Cutelyst::HarakiriMonitor::installBacktraceHandler();
+    }
 
+    m_workerId = workerId;
+    m_slot     = slot;
+    startRecycleChecks();
     Q_EMIT forked(workerId - 1);
 }
 
@@ -433,11 +823,635 @@ int UnixFork::idealThreadCount()
 #endif
 }
 
+void UnixFork::handleWorkerMessages()
+{
+    WorkerMessage message;
+    while (read(m_readyFd[0], &message, sizeof(message)) == sizeof(message)) {
+        const pid_t pid = message.pid;
+        auto it         = m_childs.find(pid);
+        if (it == m_childs.end()) {
+            continue;
+        }
+
+        if (message.recycle != WorkerIsReady) {
+            if (!it->null && !m_recycleQueue.contains(pid) && message.recycle >= 0 &&
+                message.recycle < int(std::size(RecycleLimits))) {
+                std::cout << "SERVER worker " << it->id << " (pid: " << pid << ") reached "
+                          << RecycleLimits[message.recycle].first << ", queued for recycling"
+                          << '\n';
+                ++m_stats->recycles[size_t(message.recycle)];
+                m_recycleQueue.push_back(pid);
+            }
+            continue;
+        }
+
+        it->ready = true;
+        if (it->replaces) {
+            const qint64 old = std::exchange(it->replaces, 0);
+            --m_reloadStarting;
+            std::cout << "SERVER worker " << it->id << " (pid: " << pid
+                      << ") is ready, retiring pid " << old << '\n';
+            retireWorker(old);
+        }
+    }
+
+    updateStats();
+    if (m_reloadElapsed.isValid()) {
+        reloadNext();
+    }
+    scheduleRecycle();
+
+    if (m_upgradeParent) {
+        stopUpgradeParent();
+    }
+}
+
+void UnixFork::rollingRestart()
+{
+    if (m_reloadElapsed.isValid()) {
+        std::cout << "Rolling reload already in progress" << '\n';
+        return;
+    }
+
+    m_reloadQueue.clear();
+    for (const auto &[key, value] : m_childs.asKeyValueRange()) {
+        if (!value.null) {
+            m_reloadQueue.push_back(key);
+        }
+    }
+
+    if (m_reloadQueue.isEmpty()) {
+        return;
+    }
+
+    std::cout << "Rolling reload of " << m_reloadQueue.size() << " workers, " << m_rollingReload
+              << " at a time" << '\n';
+    m_reloadAborted = false;
+    m_reloadElapsed.start();
+    if (m_stats) {
+        m_stats->reloading             = true;
+        m_stats->reloadMinReadyWorkers = m_stats->readyWorkers.load();
+    }
+
+    reloadNext();
+}
+
+void UnixFork::reloadNext()
+{
+    bool spawn = false;
+    while (!m_reloadAborted && m_reloadStarting < m_rollingReload && !m_reloadQueue.isEmpty()) {
+        const int slot = freeSlot();
+        if (slot == -1) {
+            // Retired workers still drain, continued once one of them exits
+            break;
+        }
+
+        const qint64 pid = m_reloadQueue.takeFirst();
+        const auto it    = m_childs.constFind(pid);
+        if (it == m_childs.constEnd() || it->null) {
+            // Died meanwhile and got respawned already
+            continue;
+        }
+
+        // The old worker keeps serving until this one is ready
+        Worker worker;
+        worker.id       = it->id;
+        worker.slot     = slot;
+        worker.null     = false;
+        worker.replaces = pid;
+        m_recreateWorker.push_back(worker);
+        ++m_reloadStarting;
+        spawn = true;
+    }
+
+    if (spawn) {
+        startReplaceDeadline();
+
+        // Workers are forked once the event loop returns to internalExec()
+        qApp->quit();
+    } else if (m_reloadStarting == 0 && (m_reloadAborted || m_reloadQueue.isEmpty())) {
+        finishReload();
+    }
+}
+
+void UnixFork::startReplaceDeadline()
+{
+    if (!m_reloadDeadline) {
+        m_reloadDeadline = new QTimer(this);
+        m_reloadDeadline->setSingleShot(true);
+        m_reloadDeadline->setInterval(ReloadReadyTimeout);
+        connect(m_reloadDeadline, &QTimer::timeout, this, [this] {
+            std::cout << "Replacement workers not ready in time, aborting..." << '\n';
+            if (m_reloadElapsed.isValid()) {
+                m_reloadAborted = true;
+            }
+            for (const auto &[key, value] : m_childs.asKeyValueRange()) {
+                if (value.replaces) {
+                    terminateChild(key);
+                }
+            }
+        });
+    }
+    m_reloadDeadline->start();
+}
+
+void UnixFork::retireWorker(qint64 pid)
+{
+    auto it = m_childs.find(pid);
+    if (it == m_childs.end()) {
+        return;
+    }
+
+    // Not respawned when it exits, and killed if it doesn't drain in time
+    it->null    = true;
+    it->ready   = false;
+    it->restart = 1;
+    it->killAt  = reloadMercyDeadline();
+    if (it->harakiri) {
+        // Its stuck threads would only hold the slot until the mercy is over
+        std::cout << "Killing SERVER worker " << it->id << " (pid: " << pid
+                  << ") stuck after HARAKIRI" << '\n';
+        killChild(pid);
+    } else {
+        terminateChild(pid);
+    }
+    setupCheckChildTimer();
+}
+
+std::chrono::steady_clock::time_point UnixFork::reloadMercyDeadline() const
+{
+    // Requests that harakiri would let run aren't cut short by a reload either
+    std::chrono::seconds mercy = m_reloadMercy;
+    if (mercy.count() == 0) {
+        mercy = m_harakiri.count() ? m_harakiri : DefaultReloadMercy;
+    }
+    return std::chrono::steady_clock::now() + mercy;
+}
+
+void UnixFork::finishReload()
+{
+    const qint64 elapsed = m_reloadElapsed.elapsed();
+    m_reloadElapsed.invalidate();
+    m_reloadQueue.clear();
+    if (m_reloadDeadline) {
+        m_reloadDeadline->stop();
+    }
+
+    if (m_stats) {
+        m_stats->reloading          = false;
+        m_stats->lastReloadDuration = elapsed;
+        ++m_stats->reloads;
+    }
+
+    std::cout << "Rolling reload " << (m_reloadAborted ? "aborted" : "finished") << " after "
+              << elapsed << " ms" << '\n';
+
+    scheduleRecycle();
+}
+
+void UnixFork::updateStats()
+{
+    if (!m_stats) {
+        return;
+    }
+
+    int ready   = 0;
+    int workers = 0;
+    for (const Worker &worker : std::as_const(m_childs)) {
+        if (worker.ready) {
+            ++ready;
+        }
+        if (!worker.null) {
+            ++workers;
+        }
+    }
+
+    m_stats->workers      = workers;
+    m_stats->readyWorkers = ready;
+    if (m_stats->reloading && ready < m_stats->reloadMinReadyWorkers) {
+        m_stats->reloadMinReadyWorkers = ready;
+    }
+}
+
+void UnixFork::checkLoad()
+{
+    const qint64 elapsed = m_loadElapsed.nsecsElapsed();
+    m_loadElapsed.start();
+
+    qint64 busy  = 0;
+    qint64 lag   = 0;
+    int measured = 0;
+    int workers  = int(m_recreateWorker.size());
+    for (const Worker &worker : std::as_const(m_childs)) {
+        if (worker.null || worker.slot < 0) {
+            continue;
+        }
+        ++workers;
+
+        Cutelyst::WorkerLoad &load = m_loads[worker.slot];
+        const qint64 total         = load.busyNsecs.load(std::memory_order_relaxed);
+        if (worker.ready) {
+            busy += total - m_lastBusy[size_t(worker.slot)];
+            ++measured;
+        }
+        m_lastBusy[size_t(worker.slot)] = total;
+        lag = qMax(lag, load.maxLagUsecs.exchange(0, std::memory_order_relaxed));
+    }
+
+    const int backlog = listenBacklog();
+    const double busyRatio =
+        measured ? double(busy) / (double(elapsed) * qMax(m_threads, 1) * measured) : 0;
+    m_stats->loadBusyPercent = int(busyRatio * 100);
+    m_stats->loadBacklog     = backlog;
+    m_stats->loadLagUsecs    = lag;
+
+    // Workers being started or stopped haven't shown their effect on the load yet
+    if (m_terminating || m_reloadElapsed.isValid() || !m_recreateWorker.isEmpty() ||
+        m_lastScale.elapsed() < std::chrono::milliseconds{m_cheaperCooldown}.count()) {
+        return;
+    }
+
+    if ((busyRatio > BusyHigh || backlog > 0 || lag > LagHighUsecs) && workers < m_processes) {
+        int spawn = 0;
+        while (spawn < qMin(m_cheaperStep, m_processes - workers)) {
+            Worker worker;
+            // Retired workers still draining can hold all free slots
+            worker.slot = freeSlot();
+            if (worker.slot == -1) {
+                break;
+            }
+            worker.id   = freeWorkerId();
+            worker.null = false;
+            m_recreateWorker.push_back(worker);
+            ++spawn;
+        }
+        if (spawn == 0) {
+            return;
+        }
+
+        std::cout << "Load is high (busy: " << int(busyRatio * 100) << "%, backlog: " << backlog
+                  << ", lag: " << lag / 1000 << " ms), spawning " << spawn << " workers" << '\n';
+        m_stats->workersSpawned += quint64(spawn);
+        m_lastScale.start();
+
+        // Workers are forked once the event loop returns to internalExec()
+        qApp->quit();
+    } else if (busyRatio < BusyLow && backlog == 0 && lag < LagLowUsecs && workers > m_cheaper) {
+        // Highest ids first, the lowest ones are the initial workers
+        QList<std::pair<int, qint64>> candidates;
+        for (const auto &[key, value] : m_childs.asKeyValueRange()) {
+            if (!value.null && value.ready) {
+                candidates.push_back({value.id, key});
+            }
+        }
+        std::ranges::sort(candidates, std::greater{});
+
+        const int stop = qMin(m_cheaperStep, qMin(workers - m_cheaper, int(candidates.size())));
+        if (stop > 0) {
+            std::cout << "Load is low (busy: " << int(busyRatio * 100) << "%), stopping " << stop
+                      << " workers" << '\n';
+            for (int i = 0; i < stop; ++i) {
+                retireWorker(candidates[i].second);
+            }
+            m_stats->workersStopped += quint64(stop);
+            updateStats();
+            m_lastScale.start();
+        }
+    }
+}
+
+int UnixFork::listenBacklog() const
+{
+    int backlog = 0;
+#ifdef Q_OS_LINUX
+    for (int fd : m_listenSockets) {
+        tcp_info info{};
+        socklen_t len = sizeof(info);
+        // On listening sockets unacked is the number of connections waiting for accept()
+        if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len) == 0 &&
+            info.tcpi_state == TCP_LISTEN) {
+            backlog += int(info.tcpi_unacked);
+        }
+    }
+#endif
+    return backlog;
+}
+
+int UnixFork::freeWorkerId() const
+{
+    int id          = 1;
+    const auto used = [&id](const Worker &worker) { return !worker.null && worker.id == id; };
+    while (std::any_of(m_childs.cbegin(), m_childs.cend(), used) ||
+           std::ranges::any_of(m_recreateWorker, used)) {
+        ++id;
+    }
+    return id;
+}
+
+int UnixFork::freeSlot() const
+{
+    for (int slot = 0; slot < m_slotCount; ++slot) {
+        const auto used = [slot](const Worker &worker) { return worker.slot == slot; };
+        if (std::none_of(m_childs.cbegin(), m_childs.cend(), used) &&
+            std::ranges::none_of(m_recreateWorker, used)) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+void UnixFork::startRecycleChecks()
+{
+    const auto jitter = [](qint64 value) {
+        // The system generator, workers forked from the same state would share a sequence
+        return value - qint64(QRandomGenerator::system()->bounded(double(value) * RecycleJitter));
+    };
+
+    if (m_maxRequests) {
+        m_requestsLimit = quint64(qMax(jitter(m_maxRequests), qint64(1)));
+    }
+
+    if (m_maxLifetime.count()) {
+        const qint64 lifetime = jitter(std::chrono::milliseconds{m_maxLifetime}.count());
+        QTimer::singleShot(std::chrono::milliseconds{lifetime}, this, [this, lifetime] {
+            recycle(RecycleLifetime, lifetime / 1000, m_maxLifetime.count());
+        });
+    }
+
+    if (m_reloadOnRss || m_reloadOnAs) {
+        auto timer = new QTimer(this);
+        timer->setInterval(RecycleCheckInterval);
+        connect(timer, &QTimer::timeout, this, &UnixFork::checkMemory);
+        timer->start();
+    }
+}
+
+void UnixFork::checkMemory()
+{
+    if (m_recycling) {
+        return;
+    }
+
+    qint64 rss = 0;
+    qint64 as  = 0;
+    memoryUsage(&rss, &as);
+
+    constexpr qint64 MB = 1024 * 1024;
+    if (m_reloadOnRss && rss >= m_reloadOnRss * MB) {
+        recycle(RecycleRss, rss / MB, m_reloadOnRss);
+    } else if (m_reloadOnAs && as >= m_reloadOnAs * MB) {
+        recycle(RecycleAs, as / MB, m_reloadOnAs);
+    }
+}
+
+void UnixFork::memoryUsage(qint64 *rss, qint64 *as)
+{
+#ifdef Q_OS_LINUX
+    // Address space and resident set sizes, in pages
+    QFile file(u"/proc/self/statm"_s);
+    if (file.open(QFile::ReadOnly | QFile::Text)) {
+        const QByteArrayList fields = file.readLine().split(' ');
+        if (fields.size() > 1) {
+            const qint64 pageSize = sysconf(_SC_PAGESIZE);
+            *as                   = fields[0].toLongLong() * pageSize;
+            *rss                  = fields[1].toLongLong() * pageSize;
+        }
+    }
+#else
+    // Only the peak resident set size is available
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#    ifdef Q_OS_DARWIN
+        *rss = usage.ru_maxrss;
+#    else
+        *rss = qint64(usage.ru_maxrss) * 1024;
+#    endif
+    }
+#endif
+}
+
+void UnixFork::recycle(int limit, qint64 value, qint64 max)
+{
+    // Called from engine threads too, the master is told only once
+    if (m_recycling.exchange(true)) {
+        return;
+    }
+
+    const auto &[name, unit] = RecycleLimits[limit];
+    std::cout << "SERVER worker " << m_workerId << " (pid: " << getpid() << ") reached " << name
+              << " (" << value << unit << ", limit " << max << unit
+              << "), asking the master to recycle it" << '\n';
+
+    // The master replaces it, meanwhile it keeps serving requests
+    const WorkerMessage message{getpid(), limit};
+    write(m_readyFd[1], &message, sizeof(message));
+}
+
+void UnixFork::scheduleRecycle()
+{
+    // One worker at a time, rolling reloads replace them all anyway
+    if (m_recycleQueue.isEmpty() || m_terminating || m_reloadStarting > 0 ||
+        m_reloadElapsed.isValid() || (m_recycleDelay && m_recycleDelay->isActive())) {
+        return;
+    }
+
+    if (!m_recycleDelay) {
+        m_recycleDelay = new QTimer(this);
+        m_recycleDelay->setSingleShot(true);
+        connect(m_recycleDelay, &QTimer::timeout, this, &UnixFork::recycleNext);
+    }
+
+    const qint64 delay = QRandomGenerator::global()->bounded(qint64(RecycleDelayMin.count()),
+                                                             qint64(RecycleDelayMax.count()));
+    m_recycleDelay->start(std::chrono::milliseconds{delay});
+}
+
+void UnixFork::recycleNext()
+{
+    if (m_terminating || m_reloadStarting > 0 || m_reloadElapsed.isValid()) {
+        return;
+    }
+
+    const int slot = freeSlot();
+    if (slot == -1) {
+        // Retired workers still drain, scheduled again once one of them exits
+        return;
+    }
+
+    while (!m_recycleQueue.isEmpty()) {
+        const qint64 pid = m_recycleQueue.takeFirst();
+        const auto it    = m_childs.constFind(pid);
+        if (it == m_childs.constEnd() || it->null) {
+            // Exited or was stopped meanwhile
+            continue;
+        }
+
+        // Same as a rolling reload of a single worker
+        Worker worker;
+        worker.id       = it->id;
+        worker.slot     = slot;
+        worker.null     = false;
+        worker.replaces = pid;
+        worker.recycle  = true;
+        m_recreateWorker.push_back(worker);
+        ++m_reloadStarting;
+        startReplaceDeadline();
+
+        // Workers are forked once the event loop returns to internalExec()
+        qApp->quit();
+        return;
+    }
+}
+
+void UnixFork::checkHarakiri()
+{
+    bool recycle = false;
+    for (int i = 0; i < m_slotCount * m_threads; ++i) {
+        const qint64 pid = Cutelyst::HarakiriMonitor::check(m_harakiriSlots + i, m_harakiri);
+        const auto it    = m_childs.find(pid);
+        if (!pid || it == m_childs.end() || ::kill(pid_t(pid), 0) != 0) {
+            // Left behind by a worker that exited
+            continue;
+        }
+
+        if (m_stats) {
+            ++m_stats->harakiri;
+        }
+
+        it->harakiri = true;
+        if (it->null) {
+            // Already retired, there is nothing to wait for
+            killChild(pid);
+            continue;
+        }
+
+        if (m_recycleQueue.contains(pid) ||
+            std::any_of(m_childs.cbegin(), m_childs.cend(), [pid](const Worker &worker) {
+                return worker.replaces == pid;
+            })) {
+            // Being replaced already
+            continue;
+        }
+
+        // Stuck threads don't drain, it's killed once its replacement is ready
+        std::cout << "Recycling SERVER worker " << it->id << " (pid: " << pid << ") after HARAKIRI"
+                  << '\n';
+        m_recycleQueue.prepend(pid);
+        recycle = true;
+    }
+
+    if (recycle) {
+        recycleNext();
+    }
+}
+
+void UnixFork::stopUpgradeParent()
+{
+    for (const Worker &worker : std::as_const(m_childs)) {
+        if (!worker.null && !worker.ready) {
+            return;
+        }
+    }
+
+    // The old generation finishes its requests in progress and exits
+    std::cout << "Workers ready, stopping old master (pid: " << m_upgradeParent << ")" << '\n';
+    kill(pid_t(m_upgradeParent), SIGQUIT);
+    m_upgradeParent = 0;
+}
+
+void UnixFork::handleSigUsr1()
+{
+    if (!m_child) {
+        // Workers reopen their own files
+        for (const auto &[pid, worker] : m_childs.asKeyValueRange()) {
+            ::kill(pid_t(pid), SIGUSR1);
+        }
+    }
+
+    Q_EMIT reopenLogs();
+}
+
+void UnixFork::handleSigUsr2()
+{
+    if (m_child || m_terminating) {
+        return;
+    }
+
+    if (m_upgradePid) {
+        std::cout << "Binary upgrade already in progress (pid: " << m_upgradePid << ")" << '\n';
+        return;
+    }
+
+    // Everything is allocated before fork(), the child only moves descriptors and execs
+    const QByteArray path = executablePath();
+    if (path.isEmpty()) {
+        std::cerr << "Failed to find the binary to upgrade to" << '\n';
+        return;
+    }
+
+    QByteArrayList args;
+    const auto arguments = QCoreApplication::arguments();
+    for (const QString &argument : arguments) {
+        args.push_back(QFile::encodeName(argument));
+    }
+    std::vector<char *> argv;
+    for (QByteArray &arg : args) {
+        argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+
+    QByteArrayList env;
+    for (char **var = environ; *var; ++var) {
+        const QByteArray entry(*var);
+        if (!entry.startsWith("LISTEN_") && !entry.startsWith("CUTELYST_UPGRADE_PID=")) {
+            env.push_back(entry);
+        }
+    }
+    env.push_back("LISTEN_FDS=" + QByteArray::number(qsizetype(m_listenSockets.size())));
+    env.push_back("CUTELYST_UPGRADE_PID=" + QByteArray::number(QCoreApplication::applicationPid()));
+    // Filled in by the child, its pid is only known after fork()
+    env.push_back("LISTEN_PID=" + QByteArray(21, '\0'));
+    std::vector<char *> envp;
+    for (QByteArray &entry : env) {
+        envp.push_back(entry.data());
+    }
+    envp.push_back(nullptr);
+    char *listenPid = envp[envp.size() - 2] + strlen("LISTEN_PID=");
+
+    std::vector<int> moved(m_listenSockets.size());
+
+    const pid_t pid = fork();
+    if (pid == 0) {
+        const int count = int(m_listenSockets.size());
+        // Moved past the target range first so dup2() can't close one still to be moved
+        for (int i = 0; i < count; ++i) {
+            moved[i] = fcntl(m_listenSockets[i], F_DUPFD, ListenFdsStart + count);
+        }
+        for (int i = 0; i < count; ++i) {
+            dup2(moved[i], ListenFdsStart + i);
+            close(moved[i]);
+        }
+
+        writeDecimal(listenPid, int(getpid()));
+        environ = envp.data();
+        execv(path.constData(), argv.data());
+        _exit(127);
+    } else if (pid < 0) {
+        std::cerr << "Failed to fork for binary upgrade: " << strerror(errno) << '\n';
+        return;
+    }
+
+    m_upgradePid = pid;
+    std::cout << "Binary upgrade, spawned new master (pid: " << pid << ") with "
+              << m_listenSockets.size() << " listening sockets" << '\n';
+}
+
 void UnixFork::handleSigHup()
 {
-    // do Qt stuff
-    //    qDebug() << Q_FUNC_INFO << QCoreApplication::applicationPid();
-    //    m_proc->kill();
+    if (!m_child && !m_terminating) {
+        std::cout << "SIGHUP received, reloading workers..." << '\n';
+        restart();
+    }
 }
 
 void UnixFork::handleSigTerm()
@@ -490,11 +1504,20 @@ void UnixFork::handleSigChld()
         // SIGTERM is used when CHEAPED (ie post fork failed)
         int exitStatus = WEXITSTATUS(status);
 
+        if (p == m_upgradePid) {
+            // Once the upgrade succeeds this master exits first, so this is a failure
+            std::cout << "Binary upgrade failed, new master (pid: " << p << ") exited with "
+                      << exitStatus << ", keeping this one" << '\n';
+            m_upgradePid = 0;
+            continue;
+        }
+
         Worker worker;
         auto it = m_childs.constFind(p);
         if (it != m_childs.constEnd()) {
             worker = it.value();
             m_childs.erase(it);
+            Q_EMIT slotReleased(worker.slot);
         } else {
             std::cout << "DAMN ! *UNKNOWN* worker (pid: " << p << ") died, killed by signal "
                       << exitStatus << " :( ignoring .." << '\n';
@@ -506,6 +1529,33 @@ void UnixFork::handleSigChld()
             worker.null = true;
         }
 
+        if (worker.replaces && !m_terminating) {
+            worker.null = true;
+            --m_reloadStarting;
+            if (worker.recycle) {
+                // The old worker asked only once, so it's tried again later
+                std::cout << "SERVER worker " << worker.id << " (pid: " << p
+                          << ") failed to start, pid " << worker.replaces
+                          << " stays queued for recycling" << '\n';
+                if (!m_recycleQueue.contains(worker.replaces)) {
+                    m_recycleQueue.push_back(worker.replaces);
+                }
+            } else {
+                // Never got ready, the old worker stays and the reload stops
+                std::cout << "SERVER worker " << worker.id << " (pid: " << p
+                          << ") failed to start, keeping pid " << worker.replaces << '\n';
+                m_reloadAborted = true;
+            }
+        } else {
+            for (const Worker &replacement : std::as_const(m_childs)) {
+                if (replacement.replaces == p) {
+                    // Its replacement is already starting
+                    worker.null = true;
+                    break;
+                }
+            }
+        }
+
         if (!worker.null && !m_terminating) {
             if (worker.restart == 0) {
                 std::cout << "DAMN ! worker " << worker.id << " (pid: " << p
@@ -513,20 +1563,36 @@ void UnixFork::handleSigChld()
                           << '\n';
             }
             worker.restart = 0;
+            worker.ready   = false;
             ++worker.respawn;
             QTimer::singleShot(std::chrono::seconds{1}, this, &UnixFork::decreaseWorkerRespawn);
             m_recreateWorker.push_back(worker);
             qApp->quit();
         } else if (!m_child && m_childs.isEmpty()) {
+            if (m_upgradePid && m_terminating) {
+                // Destructors would remove the local socket files the new master listens on
+                std::cout << "Workers drained, handed over to new master (pid: " << m_upgradePid
+                          << ")" << std::endl;
+                _exit(0);
+            }
             qApp->quit();
         }
     }
 
+    updateStats();
+    if (m_reloadElapsed.isValid()) {
+        reloadNext();
+    }
+    scheduleRecycle();
+
     if (m_checkChildRestart) {
+        const auto now    = std::chrono::steady_clock::now();
         bool allRestarted = true;
         for (const auto &[key, value] : m_childs.asKeyValueRange()) {
             if (value.restart) {
-                if (++value.restart > 10) {
+                if (now >= value.killAt) {
+                    std::cout << "SERVER worker " << value.id << " (pid: " << key
+                              << ") didn't exit in time, killing it" << '\n';
                     killChild(key);
                 }
                 allRestarted = false;
@@ -656,6 +1722,37 @@ int UnixFork::setupUnixSignalHandlers()
         return SIGCHLD;
     }
 
+    // Reopens the log files, like after logrotate moved them
+    memset(&action, 0, sizeof(struct sigaction));
+    action.sa_handler = UnixFork::signalHandler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags |= SA_RESTART;
+    if (sigaction(SIGUSR1, &action, nullptr) > 0) {
+        return SIGUSR1;
+    }
+
+    // Reloads the workers, without them keep the default of terminating
+    if (m_processes > 0) {
+        memset(&action, 0, sizeof(struct sigaction));
+        action.sa_handler = UnixFork::signalHandler;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags |= SA_RESTART;
+        if (sigaction(SIGHUP, &action, nullptr) > 0) {
+            return SIGHUP;
+        }
+
+        // Binary upgrade, the receiving side needs systemd style socket activation
+#ifdef Q_OS_LINUX
+        memset(&action, 0, sizeof(struct sigaction));
+        action.sa_handler = UnixFork::signalHandler;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags |= SA_RESTART;
+        if (sigaction(SIGUSR2, &action, nullptr) > 0) {
+            return SIGUSR2;
+        }
+#endif
+    }
+
     return 0;
 }
 
@@ -686,6 +1783,15 @@ void UnixFork::setupSocketPair(bool closeSignalsFD, bool createPair)
         case SIGQUIT:
             handleSigInt();
             break;
+        case SIGHUP:
+            handleSigHup();
+            break;
+        case SIGUSR1:
+            handleSigUsr1();
+            break;
+        case SIGUSR2:
+            handleSigUsr2();
+            break;
         default:
             break;
         }
@@ -700,6 +1806,21 @@ bool UnixFork::createChild(const Worker &worker, bool respawn)
 
     delete m_signalNotifier;
     m_signalNotifier = nullptr;
+    delete m_readyNotifier;
+    m_readyNotifier = nullptr;
+
+    Q_ASSERT(worker.slot >= 0 && worker.slot < m_slotCount);
+    if (m_loads) {
+        // Left over by the worker that had the slot before
+        new (m_loads + worker.slot) Cutelyst::WorkerLoad;
+        m_lastBusy[size_t(worker.slot)] = 0;
+    }
+    if (m_harakiriSlots) {
+        // A killed worker can leave a request behind, reported again with its stale pid
+        for (int i = 0; i < m_threads; ++i) {
+            new (m_harakiriSlots + worker.slot * m_threads + i) Cutelyst::HarakiriSlot;
+        }
+    }
 
     qint64 childPID = fork();
 
@@ -720,15 +1841,25 @@ bool UnixFork::createChild(const Worker &worker, bool respawn)
 
             setupSocketPair(true, true);
 
+            if (m_readyFd[0] != -1) {
+                close(m_readyFd[0]);
+                m_readyFd[0] = -1;
+            }
+
             m_child = true;
-            postFork(worker.id);
+            postFork(worker.id, worker.slot);
 
             int ret = qApp->exec();
             _exit(ret);
         } else {
             setupSocketPair(false, false);
+            setupReadyNotifier();
 
-            if (respawn) {
+            if (worker.replaces) {
+                std::cout << "spawned SERVER worker " << worker.id << " (pid: " << childPID
+                          << ", cores: " << m_threads << ") to replace pid " << worker.replaces
+                          << '\n';
+            } else if (respawn) {
                 std::cout << "Respawned SERVER worker " << worker.id << " (new pid: " << childPID
                           << ", cores: " << m_threads << ")" << '\n';
             } else {
@@ -7,20 +7,42 @@
 
 #include "abstractfork.h"
 
+#include <QElapsedTimer>
 #include <QHash>
 #include <QObject>
 #include <QVector>
 
+#include <atomic>
+#include <chrono>
+#include <vector>
+
 struct Worker {
     bool null = true;
     int id;
+    // Where it reports to the master, the master hands them out so that a replacement
+    // doesn't share the slot of the worker it replaces while that one drains
+    int slot    = -1;
     int restart = 0;
     int respawn = 0;
+    // Pid of the worker retired once this one is ready, on rolling reloads
+    qint64 replaces = 0;
+    // Replaces a worker being recycled instead of one of a rolling reload
+    bool recycle = false;
+    // A request got stuck past the harakiri timeout, so it's killed instead of draining
+    bool harakiri = false;
+    bool ready    = false;
+    // When a worker told to exit is killed if it is still draining its requests
+    std::chrono::steady_clock::time_point killAt;
 };
 
+struct UnixForkStats;
+
 namespace Cutelyst {
 class Server;
-}
+struct WorkerLoad;
+struct HarakiriSlot;
+class HarakiriMonitor;
+} // namespace Cutelyst
 
 class QTimer;
 class QSocketNotifier;
@@ -37,6 +59,82 @@ public:
 
     virtual void restart() override;
 
+    virtual void workerReady() override;
+    virtual void counters(QVariantMap &counters) const override;
+
+    /**
+     * Makes restart() replace \a workers at a time, each old worker is only stopped
+     * once its replacement is ready. 0 restarts all of them at once.
+     */
+    void setRollingReload(int workers);
+
+    /**
+     * Gives workers told to exit on reloads, recycling or cheaping \a mercy to finish their
+     * requests in progress, they are killed after that. 0 uses the harakiri timeout when it
+     * is set, 60 seconds otherwise.
+     */
+    void setReloadMercy(std::chrono::seconds mercy);
+
+    /**
+     * Listening sockets handed to the new binary on SIGUSR2 binary upgrades, it gets
+     * them as systemd activated sockets.
+     */
+    void setListenSockets(const std::vector<int> &sockets);
+
+    /**
+     * Starts with \a minWorkers and spawns or stops \a step workers at a time, up to the
+     * number of processes, according to the load reported by the workers. Decisions are at
+     * least \a cooldown apart.
+     */
+    void setCheaper(int minWorkers, int step, std::chrono::seconds cooldown);
+
+    /**
+     * Returns how many worker processes can run at once, each with its own slot in the memory
+     * shared with the master. Twice the number of processes, as replacements start while the
+     * workers they replace still drain.
+     */
+    int slotCount() const;
+
+    /**
+     * Returns the slot of this worker process, counted from 0, no other worker running at the
+     * same time has it. Without worker processes it's 0.
+     */
+    int slot() const;
+
+    /**
+     * Returns where a worker process reports its load, nullptr when it's not needed.
+     */
+    Cutelyst::WorkerLoad *workerLoad() const;
+
+    /**
+     * Makes workers ask the master to replace them once they served \a maxRequests
+     * requests, use more than \a rss or \a as megabytes of resident or virtual memory, or
+     * lived longer than \a lifetime. A zero value disables the limit.
+     */
+    void setRecycle(int maxRequests, int rss, int as, std::chrono::seconds lifetime);
+
+    /**
+     * Returns true if the worker has to be told about each request it starts.
+     */
+    bool countRequests() const;
+
+    /**
+     * Counts a request started by this worker, it's safe to call from any thread.
+     */
+    void requestStarted();
+
+    /**
+     * Reports requests running for longer than \a timeout, the master recycles the worker
+     * running them. Without worker processes a thread of this process reports them.
+     */
+    void setHarakiri(std::chrono::seconds timeout);
+
+    /**
+     * Returns where the engine threads of this worker write their current request, one
+     * slot per thread, nullptr when it's not needed.
+     */
+    Cutelyst::HarakiriSlot *harakiriSlots() const;
+
     int internalExec();
 
     bool createProcess(bool respawn);
@@ -57,25 +155,97 @@ public:
     static int idealProcessCount();
     static int idealThreadCount();
 
+    /**
+     * Sets \a rss and \a as to the resident set and address space sizes of this process in
+     * bytes, where the system doesn't report the current values \a rss is the peak one.
+     */
+    static void memoryUsage(qint64 *rss, qint64 *as);
+
     void handleSigHup();
+    void handleSigUsr1();
+    void handleSigUsr2();
     void handleSigTerm();
     void handleSigInt();
     void handleSigChld();
 
     static void setSched(Cutelyst::Server *server, int workerId, int workerCore);
 
+Q_SIGNALS:
+    /**
+     * Emitted by the master once the worker process that had \a slot exited, before a
+     * respawned worker takes the same slot.
+     */
+    void slotReleased(int slot);
+
 private:
     int setupUnixSignalHandlers();
     void setupSocketPair(bool closeSignalsFD, bool createPair);
     bool createChild(const Worker &worker, bool respawn);
     static void signalHandler(int signal);
     void setupCheckChildTimer();
-    void postFork(int workerId);
+    void setupReadyNotifier();
+    void postFork(int workerId, int slot);
+    void handleWorkerMessages();
+    void rollingRestart();
+    void reloadNext();
+    void startReplaceDeadline();
+    void retireWorker(qint64 pid);
+    std::chrono::steady_clock::time_point reloadMercyDeadline() const;
+    void finishReload();
+    void updateStats();
+    void stopUpgradeParent();
+    void checkLoad();
+    int listenBacklog() const;
+    int freeWorkerId() const;
+    int freeSlot() const;
+    void startRecycleChecks();
+    void checkMemory();
+    void recycle(int limit, qint64 value, qint64 max);
+    void scheduleRecycle();
+    void recycleNext();
+    void checkHarakiri();
 
     QHash<qint64, Worker> m_childs;
     QVector<Worker> m_recreateWorker;
     QSocketNotifier *m_signalNotifier = nullptr;
+    QSocketNotifier *m_readyNotifier  = nullptr;
     QTimer *m_checkChildRestart       = nullptr;
+    QTimer *m_reloadDeadline          = nullptr;
+    QTimer *m_loadTimer               = nullptr;
+    QTimer *m_recycleDelay            = nullptr;
+    QTimer *m_harakiriTimer           = nullptr;
+    UnixForkStats *m_stats            = nullptr;
+    Cutelyst::WorkerLoad *m_loads     = nullptr;
+    QList<qint64> m_reloadQueue;
+    QList<qint64> m_recycleQueue;
+    QElapsedTimer m_reloadElapsed;
+    std::vector<int> m_listenSockets;
+    std::vector<qint64> m_lastBusy;
+    Cutelyst::HarakiriSlot *m_harakiriSlots      = nullptr;
+    Cutelyst::HarakiriMonitor *m_harakiriMonitor = nullptr;
+    quint64 m_requestsLimit                      = 0;
+    QElapsedTimer m_loadElapsed;
+    QElapsedTimer m_lastScale;
+    std::chrono::seconds m_cheaperCooldown{0};
+    std::chrono::seconds m_maxLifetime{0};
+    std::chrono::seconds m_harakiri{0};
+    std::chrono::seconds m_reloadMercy{0};
+    std::atomic<quint64> m_requests{0};
+    std::atomic<bool> m_recycling{false};
+    qint64 m_upgradePid    = 0;
+    qint64 m_upgradeParent = 0;
+    int m_readyFd[2]       = {-1, -1};
+    int m_rollingReload    = 0;
+    int m_reloadStarting   = 0;
+    bool m_reloadAborted   = false;
+    int m_cheaper          = 0;
+    int m_cheaperStep      = 1;
+    int m_slotCount        = 1;
+    int m_slot             = 0;
+    int m_maxRequests      = 0;
+    int m_reloadOnRss      = 0;
+    int m_reloadOnAs       = 0;
+    int m_workerId         = 0;
     int m_threads;
     int m_processes;
     bool m_child       = false;
@@ -0,0 +1,297 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "websocketdeflate.h"
+
+#include <QList>
+#include <QLoggingCategory>
+
+#ifdef HAS_ZLIB
+#    include <zlib.h>
+#endif
+
+Q_LOGGING_CATEGORY(C_SERVER_WS_DEFLATE, "cutelyst.server.websocket.deflate", QtWarningMsg)
+
+using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+#ifdef HAS_ZLIB
+constexpr qsizetype ChunkSize = 16384;
+
+// RFC 7692 7.2.1, the sync flush marker removed from every message
+constexpr char MessageTail[] = {'\x00', '\x00', '\xff', '\xff'};
+#endif
+
+int parseWindowBits(const QByteArray &value)
+{
+    bool ok;
+    const int bits = value.toInt(&ok);
+    if (!ok || bits < 8 || bits > 15) {
+        return -1;
+    }
+    return bits;
+}
+} // namespace
+
+WebSocketDeflate::WebSocketDeflate(int serverWindowBits,
+                                   int clientWindowBits,
+                                   int memLevel,
+                                   bool serverNoContextTakeover,
+                                   bool clientNoContextTakeover)
+    : m_serverWindowBits(serverWindowBits)
+    , m_clientWindowBits(clientWindowBits)
+    , m_memLevel(memLevel)
+    , m_serverNoContextTakeover(serverNoContextTakeover)
+    , m_clientNoContextTakeover(clientNoContextTakeover)
+{
+}
+
+WebSocketDeflate::~WebSocketDeflate()
+{
+#ifdef HAS_ZLIB
+    if (m_deflate) {
+        deflateEnd(m_deflate);
+        delete m_deflate;
+    }
+    if (m_inflate) {
+        inflateEnd(m_inflate);
+        delete m_inflate;
+    }
+#endif
+}
+
+bool WebSocketDeflate::isAvailable()
+{
+#ifdef HAS_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+WebSocketDeflate *WebSocketDeflate::negotiate(const QByteArray &offers,
+                                              const Options &options,
+                                              QByteArray &response)
+{
+    if (!isAvailable()) {
+        return nullptr;
+    }
+
+    const QList<QByteArray> offerList = offers.split(',');
+    for (const QByteArray &offer : offerList) {
+        const QList<QByteArray> params = offer.split(';');
+        if (params.constFirst().trimmed().compare("permessage-deflate", Qt::CaseInsensitive) !=
+            0) {
+            continue;
+        }
+
+        int serverWindowBits         = options.windowBits;
+        int clientWindowBits         = 15;
+        bool serverNoContextTakeover = options.noContextTakeover;
+        bool clientNoContextTakeover = false;
+        bool clientWindowBitsOffered = false;
+        bool valid                   = true;
+        QList<QByteArray> seen;
+
+        for (qsizetype i = 1; i < params.size() && valid; ++i) {
+            const QByteArray param = params.at(i).trimmed();
+            const qsizetype eq     = param.indexOf('=');
+            const QByteArray name  = param.left(eq).trimmed().toLower();
+            QByteArray value       = eq == -1 ? QByteArray{} : param.mid(eq + 1).trimmed();
+            if (value.size() > 1 && value.startsWith('"') && value.endsWith('"')) {
+                value = value.mid(1, value.size() - 2);
+            }
+
+            // An offer must not repeat a parameter (RFC 7692 7.1)
+            if (seen.contains(name)) {
+                valid = false;
+                break;
+            }
+            seen.append(name);
+
+            if (name == "server_no_context_takeover" && eq == -1) {
+                serverNoContextTakeover = true;
+            } else if (name == "client_no_context_takeover" && eq == -1) {
+                clientNoContextTakeover = true;
+            } else if (name == "server_max_window_bits") {
+                // zlib can't produce raw deflate data with a 256 bytes window
+                const int bits = parseWindowBits(value);
+                if (bits < 9) {
+                    valid = false;
+                } else {
+                    serverWindowBits = qMin(serverWindowBits, bits);
+                }
+            } else if (name == "client_max_window_bits") {
+                clientWindowBitsOffered = true;
+                if (eq != -1) {
+                    const int bits = parseWindowBits(value);
+                    if (bits == -1) {
+                        valid = false;
+                    } else {
+                        clientWindowBits = bits;
+                    }
+                }
+            } else {
+                valid = false;
+            }
+        }
+
+        if (!valid) {
+            qCDebug(C_SERVER_WS_DEFLATE) << "Declining permessage-deflate offer" << offer;
+            continue;
+        }
+
+        // The client window can only be limited if it told us it supports that
+        if (clientWindowBitsOffered) {
+            clientWindowBits = qMin(clientWindowBits, options.windowBits);
+        }
+
+        response = "permessage-deflate"_ba;
+        if (serverNoContextTakeover) {
+            response.append("; server_no_context_takeover");
+        }
+        if (clientNoContextTakeover) {
+            response.append("; client_no_context_takeover");
+        }
+        if (serverWindowBits < 15) {
+            response.append("; server_max_window_bits=" + QByteArray::number(serverWindowBits));
+        }
+        if (clientWindowBitsOffered && clientWindowBits < 15) {
+            response.append("; client_max_window_bits=" + QByteArray::number(clientWindowBits));
+        }
+
+        return new WebSocketDeflate(serverWindowBits,
+                                    clientWindowBits,
+                                    options.memLevel,
+                                    serverNoContextTakeover,
+                                    clientNoContextTakeover);
+    }
+
+    return nullptr;
+}
+
+bool WebSocketDeflate::compress(QByteArrayView message, QByteArray &out)
+{
+#ifdef HAS_ZLIB
+    if (!m_deflate) {
+        m_deflate = new z_stream{};
+        if (deflateInit2(m_deflate,
+                         Z_DEFAULT_COMPRESSION,
+                         Z_DEFLATED,
+                         -m_serverWindowBits,
+                         m_memLevel,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+            qCWarning(C_SERVER_WS_DEFLATE) << "Failed to init deflate" << m_deflate->msg;
+            delete m_deflate;
+            m_deflate = nullptr;
+            return false;
+        }
+    }
+
+    out.clear();
+    m_deflate->next_in  = reinterpret_cast<Bytef *>(const_cast<char *>(message.data()));
+    m_deflate->avail_in = uInt(message.size());
+    const auto bound = qsizetype(deflateBound(m_deflate, uLong(message.size())));
+    do {
+        const qsizetype used = out.size();
+        out.resize(used + qMax(ChunkSize, bound));
+        m_deflate->next_out  = reinterpret_cast<Bytef *>(out.data() + used);
+        m_deflate->avail_out = uInt(out.size() - used);
+
+        const int ret = deflate(m_deflate, Z_SYNC_FLUSH);
+        if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            qCWarning(C_SERVER_WS_DEFLATE) << "Failed to deflate message" << ret;
+            return false;
+        }
+        out.resize(out.size() - m_deflate->avail_out);
+    } while (m_deflate->avail_out == 0);
+
+    if (out.endsWith(QByteArrayView{MessageTail, sizeof(MessageTail)})) {
+        out.chop(sizeof(MessageTail));
+    }
+
+    if (m_serverNoContextTakeover) {
+        deflateReset(m_deflate);
+    }
+    return true;
+#else
+    Q_UNUSED(message)
+    Q_UNUSED(out)
+    return false;
+#endif
+}
+
+bool WebSocketDeflate::decompress(QByteArrayView data, bool fin, QByteArray &out, qint64 maxSize)
+{
+#ifdef HAS_ZLIB
+    if (!m_inflate) {
+        m_inflate = new z_stream{};
+        if (inflateInit2(m_inflate, -m_clientWindowBits) != Z_OK) {
+            qCWarning(C_SERVER_WS_DEFLATE) << "Failed to init inflate" << m_inflate->msg;
+            delete m_inflate;
+            m_inflate = nullptr;
+            return false;
+        }
+    }
+
+    if (!inflateData(data, out, maxSize)) {
+        return false;
+    }
+
+    if (fin) {
+        if (!inflateData(QByteArrayView{MessageTail, sizeof(MessageTail)}, out, maxSize)) {
+            return false;
+        }
+
+        if (m_clientNoContextTakeover) {
+            inflateReset(m_inflate);
+        }
+    }
+    return true;
+#else
+    Q_UNUSED(data)
+    Q_UNUSED(fin)
+    Q_UNUSED(out)
+    Q_UNUSED(maxSize)
+    return false;
+#endif
+}
+
+bool WebSocketDeflate::inflateData(QByteArrayView data, QByteArray &out, qint64 maxSize)
+{
+#ifdef HAS_ZLIB
+    m_inflate->next_in  = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    m_inflate->avail_in = uInt(data.size());
+    do {
+        const qsizetype used = out.size();
+        out.resize(used + ChunkSize);
+        m_inflate->next_out  = reinterpret_cast<Bytef *>(out.data() + used);
+        m_inflate->avail_out = uInt(ChunkSize);
+
+        const int ret = inflate(m_inflate, Z_SYNC_FLUSH);
+        out.resize(out.size() - m_inflate->avail_out);
+        if (out.size() > maxSize) {
+            qCDebug(C_SERVER_WS_DEFLATE) << "Inflated message too big" << out.size() << maxSize;
+            return false;
+        }
+
+        if (ret == Z_STREAM_END) {
+            // The client ended the deflate stream with BFINAL, the next message starts a new one
+            inflateReset(m_inflate);
+            break;
+        } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            qCDebug(C_SERVER_WS_DEFLATE) << "Failed to inflate message" << ret;
+            return false;
+        }
+    } while (m_inflate->avail_out == 0);
+
+    return true;
+#else
+    Q_UNUSED(data)
+    Q_UNUSED(out)
+    Q_UNUSED(maxSize)
+    return false;
+#endif
+}
@@ -0,0 +1,83 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#ifndef WEBSOCKETDEFLATE_H
+#define WEBSOCKETDEFLATE_H
+
+#include <QByteArray>
+
+struct z_stream_s;
+
+namespace Cutelyst {
+
+/**
+ * Per connection state of the permessage-deflate WebSocket extension (RFC 7692).
+ *
+ * zlib streams are only allocated once the first message is compressed or
+ * inflated, their size is bounded by the negotiated window bits and memory level:
+ * deflate uses (1 << (windowBits + 2)) + (1 << (memLevel + 9)) bytes and
+ * inflate (1 << windowBits) plus about 7 KiB.
+ */
+class WebSocketDeflate
+{
+public:
+    struct Options {
+        int windowBits         = 15;
+        int memLevel           = 8;
+        bool noContextTakeover = false;
+    };
+
+    WebSocketDeflate(int serverWindowBits,
+                     int clientWindowBits,
+                     int memLevel,
+                     bool serverNoContextTakeover,
+                     bool clientNoContextTakeover);
+    ~WebSocketDeflate();
+
+    WebSocketDeflate(const WebSocketDeflate &)            = delete;
+    WebSocketDeflate &operator=(const WebSocketDeflate &) = delete;
+
+    /**
+     * Returns true if zlib support was built in.
+     */
+    static bool isAvailable();
+
+    /**
+     * Picks the first acceptable permessage-deflate offer of a Sec-WebSocket-Extensions
+     * request header, \a response is set to the value of the reply header.
+     *
+     * Returns nullptr if none of the \a offers can be accepted.
+     */
+    static WebSocketDeflate *
+        negotiate(const QByteArray &offers, const Options &options, QByteArray &response);
+
+    /**
+     * Compresses a whole \a message into \a out without the trailing
+     * 0x00 0x00 0xff 0xff bytes, ready to be sent with RSV1 set.
+     */
+    bool compress(QByteArrayView message, QByteArray &out);
+
+    /**
+     * Inflates the payload of a frame of a compressed message appending it to \a out,
+     * \a fin must be set for the last frame so the message tail is restored.
+     *
+     * Returns false if the data is invalid or if \a out would grow above \a maxSize.
+     */
+    bool decompress(QByteArrayView data, bool fin, QByteArray &out, qint64 maxSize);
+
+private:
+    bool inflateData(QByteArrayView data, QByteArray &out, qint64 maxSize);
+
+    z_stream_s *m_deflate = nullptr;
+    z_stream_s *m_inflate = nullptr;
+    int m_serverWindowBits;
+    int m_clientWindowBits;
+    int m_memLevel;
+    bool m_serverNoContextTakeover;
+    bool m_clientNoContextTakeover;
+};
+
+} // namespace Cutelyst
+
+#endif // WEBSOCKETDEFLATE_H
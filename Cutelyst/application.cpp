@@ -252,9 +252,11 @@ bool Application::setup(Engine *engine)
     }
     d->init = true;
 
-    d->useStats = CUTELYST_STATS().isDebugEnabled();
-    d->engine   = engine;
-    d->config   = engine->config(u"Cutelyst"_s);
+    d->useStats        = CUTELYST_STATS().isDebugEnabled();
+    d->engine          = engine;
+    d->config          = engine->config(u"Cutelyst"_s);
+    d->traceSampleRate = std::clamp(d->config.value(u"trace_sample_rate"_s).toDouble(), 0.0, 1.0);
+    d->serverTiming    = d->config.value(u"server_timing"_s).toBool();
 
     d->setupHome();
 
@@ -374,7 +376,14 @@ void Application::handleRequest(EngineRequest *request)
     priv->request       = new Request(request);
     priv->locale        = d->defaultLocale;
 
-    if (d->useStats) {
+    if (Q_UNLIKELY(d->traceSampleRate > 0)) {
+        const QByteArray traceParent = request->headers.header("traceparent");
+        if (Stats::shouldSample(traceParent, d->traceSampleRate)) {
+            priv->stats = new Stats(request, true, traceParent);
+        } else if (d->useStats || d->statsEnabled) {
+            priv->stats = new Stats(request, false, traceParent);
+        }
+    } else if (d->useStats || d->statsEnabled) {
         priv->stats = new Stats(request);
     }
 
@@ -645,6 +654,12 @@ void Application::setDefaultLocale(const QLocale &locale)
     d->defaultLocale = locale;
 }
 
+void Application::setStatsEnabled(bool enabled)
+{
+    Q_D(Application);
+    d->statsEnabled = enabled;
+}
+
 void Cutelyst::ApplicationPrivate::setupHome()
 {
     // Hook the current directory in config if "home" is not set
@@ -32,6 +32,7 @@ class Engine;
 class EngineRequest;
 class Plugin;
 class Headers;
+class Stats;
 class ApplicationPrivate;
 
 /**
@@ -60,6 +61,19 @@ class ApplicationPrivate;
  * default), it will be populated as directory \c "root" below \c "home".
  * @endconfigblock
  *
+ * @configblock{trace_sample_rate,double,0}
+ * Fraction of the requests, from \c 0 to \c 1, that are traced. The timings of each
+ * action, from \c Begin to the view rendering, are recorded as nested spans and
+ * requestTraced() is emitted once the request is finalized. Requests with a W3C
+ * \c traceparent header follow its sampled flag instead, continuing the trace of the
+ * caller. With \c 0 (the default) tracing is disabled.
+ * @endconfigblock
+ *
+ * @configblock{server_timing,bool,false}
+ * Adds the spans of traced requests to a \c Server-Timing response header, the header is
+ * not added to responses that already sent their headers.
+ * @endconfigblock
+ *
  * \logcat{core}
  */
 class CUTELYST_EXPORT Application : public QObject
@@ -403,6 +417,14 @@ public:
      */
     void setDefaultLocale(const QLocale &locale);
 
+    /**
+     * Makes every request collect Stats, even when it's not traced nor logged, so that
+     * engines can tell where its time was spent from Context::stats() until the context
+     * is deleted. It must be set before requests are handled.
+     * \since Cutelyst 5.1.0
+     */
+    void setStatsEnabled(bool enabled);
+
 protected:
     /**
      * Do your application initialization here, if your
@@ -512,6 +534,14 @@ Q_SIGNALS:
      */
     void afterDispatch(Cutelyst::Context *c);
 
+    /**
+     * This signal is emitted when a request sampled by the \c trace_sample_rate option
+     * is finalized, \a stats holds its spans. It's emitted from the thread of the request
+     * so connected slots should only queue the spans to be exported.
+     * \since Cutelyst 5.1.0
+     */
+    void requestTraced(Cutelyst::Context *c, const Cutelyst::Stats *stats);
+
     /**
      * This signal is emitted right after application has been setup
      * and before application forks and postFork() is called.
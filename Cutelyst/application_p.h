@@ -38,7 +38,10 @@ public:
     Headers headers;
     QVariantMap config;
     Engine *engine;
+    double traceSampleRate = 0;
     bool useStats;
+    bool statsEnabled = false;
+    bool serverTiming = false;
     bool init = false;
     QHash<QLocale, QVector<QTranslator *>> translators;
     QLocale defaultLocale{QLocale::English, QLocale::LatinScript, QLocale::UnitedStates};
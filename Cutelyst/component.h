@@ -140,6 +140,7 @@ protected:
 
 protected:
     friend class Controller;
+    friend class ContextPrivate;
     ComponentPrivate
         *d_ptr; //!< we cannot inherit from QObjectPrivate and therefore need our own d_ptr
 };
@@ -4,7 +4,9 @@
  */
 #include "action.h"
 #include "application.h"
+#include "application_p.h"
 #include "common.h"
+#include "component_p.h"
 #include "config.h"
 #include "context_p.h"
 #include "controller.h"
@@ -13,6 +15,7 @@
 #include "request.h"
 #include "response.h"
 #include "stats.h"
+#include "view.h"
 
 #include <QBuffer>
 #include <QCoreApplication>
@@ -43,6 +46,7 @@ Context::Context(Application *app)
 
 Context::~Context()
 {
+    delete d_ptr->stats;
     delete d_ptr->request;
     delete d_ptr->response;
     delete d_ptr;
@@ -95,6 +99,12 @@ Application *Context::app() const noexcept
     return d->app;
 }
 
+Stats *Context::stats() const noexcept
+{
+    Q_D(const Context);
+    return d->stats;
+}
+
 Response *Context::response() const noexcept
 {
     Q_D(const Context);
@@ -439,20 +449,27 @@ bool Context::execute(Component *code)
     bool ret;
     d->stack.push(code);
 
+    const bool timed = d->timesExecute(code);
+    const auto start = timed ? std::chrono::steady_clock::now() : TimePointSteady{};
+
     if (d->stats) {
-        const QString statsInfo = d->statsStartExecute(code);
+        const int span = d->statsStartExecute(code);
 
         ret = code->execute(this);
 
         // The request might finalize execution before returning
         // so it's wise to check for d->stats again
-        if (d->stats && !statsInfo.isEmpty()) {
-            d->statsFinishExecute(statsInfo);
+        if (d->stats && span != -1) {
+            d->statsFinishExecute(span);
         }
     } else {
         ret = code->execute(this);
     }
 
+    if (timed) {
+        d->timedFinishExecute(code, start);
+    }
+
     d->stack.pop();
 
     return ret;
@@ -501,6 +518,17 @@ void Context::finalize()
     }
 
     if (d->stats) {
+        d->stats->finish();
+        if (d->stats->isSampled()) {
+            if (d->app->d_ptr->serverTiming &&
+                !(d->engineRequest->status & EngineRequest::FinalizedHeaders)) {
+                d->response->headers().pushHeader("Server-Timing"_ba, d->stats->serverTiming());
+            }
+            Q_EMIT d->app->requestTraced(this, d->stats);
+        }
+    }
+
+    if (d->stats && d->app->d_ptr->useStats) {
         qCDebug(CUTELYST_STATS,
                 "Response Code: %d; Content-Type: %s; Content-Length: %s",
                 d->response->status(),
@@ -523,40 +551,66 @@ void Context::finalize()
             u"Request took: %1s (%2/s)\n%3"_s.arg(QString::number(duration.count(), 'f'),
                                                   average,
                                                   QString::fromLatin1(d->stats->report())));
-        delete d->stats;
-        d->stats = nullptr;
     }
 
+    // Kept until the context is deleted, so that engines can read it once the body is written
     d->engineRequest->finalize();
 }
 
-QString ContextPrivate::statsStartExecute(Component *code)
+int ContextPrivate::statsStartExecute(Component *code)
 {
-    QString actionName;
-    // Skip internal actions
-    if (code->name().startsWith(u'_')) {
-        return actionName;
-    }
+    quint32 spanName = code->d_ptr->spanName.load(std::memory_order_relaxed);
+    if (!spanName) {
+        // Skip internal actions
+        if (code->name().startsWith(u'_')) {
+            return -1;
+        }
 
-    actionName = code->reverse();
+        QString name         = code->reverse();
+        Stats::SpanKind kind = Stats::SpanKind::Component;
+        if (qobject_cast<Action *>(code)) {
+            name.prepend(u'/');
+            if (code->name() == u"Begin") {
+                kind = Stats::SpanKind::Begin;
+            } else if (code->name() == u"Auto") {
+                kind = Stats::SpanKind::Auto;
+            } else if (code->name() == u"End") {
+                kind = Stats::SpanKind::End;
+            } else {
+                kind = Stats::SpanKind::Action;
+            }
+        } else if (qobject_cast<View *>(code)) {
+            kind = Stats::SpanKind::View;
+        }
 
-    if (qobject_cast<Action *>(code)) {
-        actionName.prepend(u'/');
+        spanName = Stats::intern(name, kind);
+        code->d_ptr->spanName.store(spanName, std::memory_order_relaxed);
     }
 
-    if (stack.size() > 2) {
-        actionName = u"-> " + actionName;
-        actionName = actionName.rightJustified(actionName.size() + stack.size() - 2, u' ');
-    }
+    return stats->beginSpan(spanName);
+}
 
-    stats->profileStart(actionName);
+void ContextPrivate::statsFinishExecute(int span)
+{
+    stats->endSpan(span);
+}
 
-    return actionName;
+bool ContextPrivate::timesExecute(Component *code) const
+{
+    return engineRequest->startOfProcessing != TimePointSteady{} &&
+           (stack.size() == 1 || code->d_ptr->isView);
 }
 
-void ContextPrivate::statsFinishExecute(const QString &statsInfo)
+void ContextPrivate::timedFinishExecute(Component *code, TimePointSteady start)
 {
-    stats->profileEnd(statsInfo);
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    if (stack.size() == 1) {
+        engineRequest->executionTime += elapsed;
+    }
+    if (code->d_ptr->isView) {
+        engineRequest->viewTime += elapsed;
+    }
 }
 
 void Context::stash(const QVariantHash &unite)
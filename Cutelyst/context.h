@@ -142,6 +142,15 @@ public:
      */
     [[nodiscard]] Application *app() const noexcept;
 
+    /**
+     * Returns the timings of this request, or \c nullptr when the \c cutelyst.stats logging
+     * category is disabled, the request isn't traced and Application::setStatsEnabled()
+     * is not set. Use Stats::traceParent() to propagate the trace to the services called
+     * by this request.
+     * \since Cutelyst 5.1.0
+     */
+    [[nodiscard]] Stats *stats() const noexcept;
+
     /**
      * Returns the current Cutelyst::Response object, see there for details.
      */
@@ -633,6 +642,7 @@ protected:
     friend class Engine;
     friend class Controller;
     friend class Async;
+    friend class WebSocketHubThread;
     ContextPrivate *d_ptr;
 
 private:
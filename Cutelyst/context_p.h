@@ -33,8 +33,12 @@ public:
     {
     }
 
-    QString statsStartExecute(Component *code);
-    void statsFinishExecute(const QString &statsInfo);
+    int statsStartExecute(Component *code);
+    void statsFinishExecute(int span);
+    // Engines that set EngineRequest::startOfProcessing get the time spent executing the
+    // outermost components and the views, without Stats
+    bool timesExecute(Component *code) const;
+    void timedFinishExecute(Component *code, TimePointSteady start);
 
     QStringList error;
     QVariantHash stash;
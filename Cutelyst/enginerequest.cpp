@@ -88,6 +88,9 @@ void EngineRequest::finalize()
     }
 
     status |= EngineRequest::Finalized;
+    if (startOfProcessing != TimePointSteady{}) {
+        endOfProcessing = std::chrono::steady_clock::now();
+    }
     processingFinished();
 }
 
@@ -185,6 +188,23 @@ bool EngineRequest::webSocketClose(quint16 code, const QString &reason)
     return false;
 }
 
+bool EngineRequest::webSocketSendFrame(const QByteArray &frame)
+{
+    Q_UNUSED(frame)
+    return false;
+}
+
+qint64 EngineRequest::webSocketBufferedBytes() const
+{
+    return 0;
+}
+
+bool EngineRequest::sendEarlyHints(const Headers &headers)
+{
+    Q_UNUSED(headers)
+    return false;
+}
+
 void EngineRequest::processingFinished()
 {
 }
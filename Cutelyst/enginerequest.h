@@ -96,6 +96,31 @@ public:
 
     virtual bool webSocketClose(quint16 code, const QString &reason);
 
+    /**
+     * Engines must reimplement this to write an already encoded WebSocket \a frame,
+     * used by WebSocketHub to send the same frame to many connections.
+     *
+     * Default implementation returns false.
+     */
+    virtual bool webSocketSendFrame(const QByteArray &frame);
+
+    /**
+     * Engines should reimplement this to return the amount of WebSocket data
+     * not yet written to the client.
+     *
+     * Default implementation returns 0.
+     */
+    virtual qint64 webSocketBufferedBytes() const;
+
+    /**
+     * Engines must reimplement this to send a 103 Early Hints informational
+     * response containing \a headers, it must not finalize the headers so that
+     * the final response can still be sent.
+     *
+     * Default implementation returns false.
+     */
+    virtual bool sendEarlyHints(const Headers &headers);
+
 protected:
     /**
      * Reimplement this to do the RAW writing to the client
@@ -175,6 +200,20 @@ public:
     /** The timepoint of the start of request */
     TimePointSteady startOfRequest;
 
+    /** The timepoint the request was handed to the application, only set by the server
+     *  when it needs it */
+    TimePointSteady startOfProcessing;
+
+    /** The timepoint the response was finalized, only set with startOfProcessing */
+    TimePointSteady endOfProcessing;
+
+    /** Time spent executing the outermost components, which for async requests excludes
+     *  the time they waited for events, only counted with startOfProcessing */
+    std::chrono::nanoseconds executionTime{0};
+
+    /** Time spent executing views, only counted with startOfProcessing */
+    std::chrono::nanoseconds viewTime{0};
+
     /** The remote/client port */
     quint16 remotePort = 0;
 
@@ -532,6 +532,16 @@ Q_SIGNALS:
      */
     void webSocketPong(const QByteArray &payload, Cutelyst::Context *c);
 
+    /*!
+     * Emitted when a websocket connection that had more outgoing data buffered than the
+     * server write high watermark drained it below the low watermark, messages sent while
+     * it was above are subject to the server slow consumer policy.
+     *
+     * \sa Response::webSocketBufferedBytes()
+     * \since Cutelyst 5.1.0
+     */
+    void webSocketWritable(Cutelyst::Context *c);
+
     /*!
      * Emitted when the websocket receives a close frame, including a close code and a reason,
      * it's also emitted when the connection closes without the client sending the close frame.
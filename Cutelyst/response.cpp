@@ -350,12 +350,28 @@ bool Response::webSocketPing(const QByteArray &payload)
     return d->engineRequest->webSocketSendPing(payload);
 }
 
+qint64 Response::webSocketBufferedBytes() const
+{
+    Q_D(const Response);
+    return d->engineRequest->webSocketBufferedBytes();
+}
+
 bool Response::webSocketClose(quint16 code, const QString &reason)
 {
     Q_D(Response);
     return d->engineRequest->webSocketClose(code, reason);
 }
 
+bool Response::sendEarlyHints(const Headers &headers)
+{
+    Q_D(Response);
+    if (d->engineRequest->status & EngineRequest::FinalizedHeaders) {
+        qCWarning(CUTELYST_RESPONSE) << "Can not send early hints after headers are finalized";
+        return false;
+    }
+    return d->engineRequest->sendEarlyHints(headers);
+}
+
 void ResponsePrivate::setBodyData(const QByteArray &body)
 {
     if (!(engineRequest->status & EngineRequest::IOWrite)) {
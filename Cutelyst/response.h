@@ -34,6 +34,7 @@ public:
     enum HttpStatus {
         Continue                     = 100,
         SwitchingProtocols           = 101,
+        EarlyHints                   = 103,
         OK                           = 200,
         Created                      = 201,
         Accepted                     = 202,
@@ -397,6 +398,35 @@ public:
      */
     bool webSocketClose(quint16 code = Response::CloseCodeNormal, const QString &reason = {});
 
+    /**
+     * Returns the number of bytes of WebSocket messages that were sent but not yet written
+     * to the network, including messages held back from a slow consumer.
+     *
+     * \sa Request::webSocketWritable()
+     * \since Cutelyst 5.1.0
+     */
+    [[nodiscard]] qint64 webSocketBufferedBytes() const;
+
+    /**
+     * Sends a 103 Early Hints informational response with \a headers before the final
+     * response, usually \c Link headers with \c rel=preload so that the user agent can
+     * start fetching resources while the page is still being rendered.
+     *
+     * This can be called multiple times but only before the final headers are sent.
+     * Returns \c true if the hints were written, \c false if the headers were already
+     * finalized or the engine/protocol does not support informational responses,
+     * like HTTP/1.0 clients or FastCGI.
+     *
+     * \code{.cpp}
+     * Headers hints;
+     * hints.pushHeader("Link"_ba, "</style.css>; rel=preload; as=style"_ba);
+     * c->res()->sendEarlyHints(hints);
+     * \endcode
+     *
+     * \since Cutelyst 5.1.0
+     */
+    bool sendEarlyHints(const Headers &headers);
+
 protected:
     /**
      * Constructs a %Response object, for engine request \a conn with \a defaultHeaders.
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: (C) 2015-2025 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-FileCopyrightText: (C) 2015-2026 Daniel Nicoletti <dantti12@gmail.com>
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #include "stats.h"
@@ -11,16 +11,145 @@
 #include "stats_p.h"
 #include "utils.h"
 
+#include <optional>
+
+#include <QtCore/QHash>
+#include <QtCore/QJsonObject>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QReadWriteLock>
 #include <QtCore/QStringList>
 
 using namespace Cutelyst;
 using namespace Qt::StringLiterals;
 
-Stats::Stats(EngineRequest *request)
+namespace {
+// OTLP Span.SpanKind values
+constexpr int OtlpKindInternal = 1;
+constexpr int OtlpKindServer   = 2;
+
+const char *const SpanKindNames[] = {
+    "component",
+    "begin",
+    "auto",
+    "action",
+    "end",
+    "view",
+};
+
+struct SpanName {
+    QString name;
+    // Quoted for the Server-Timing description
+    QByteArray description;
+    Stats::SpanKind kind;
+};
+
+struct SpanNames {
+    QReadWriteLock lock;
+    QHash<QString, quint32> ids;
+    // The span id is the index plus one
+    std::vector<SpanName> names;
+};
+Q_GLOBAL_STATIC(SpanNames, spanNames)
+
+struct TraceParent {
+    quint64 traceIdHigh;
+    quint64 traceIdLow;
+    quint64 parentId;
+    bool sampled;
+};
+
+QRandomGenerator64 &randomGenerator()
+{
+    // Seeded from the system on each thread, so that forked workers don't share a sequence
+    thread_local QRandomGenerator64 generator(QRandomGenerator::system()->generate());
+    return generator;
+}
+
+quint64 randomId()
+{
+    quint64 ret;
+    do {
+        ret = randomGenerator().generate64();
+    } while (ret == 0);
+    return ret;
+}
+
+QByteArray toHex(quint64 value)
+{
+    return QByteArray::number(value, 16).rightJustified(16, '0');
+}
+
+bool fromHex(QByteArrayView text, quint64 *value)
+{
+    quint64 ret = 0;
+    for (char ch : text) {
+        ret <<= 4;
+        if (ch >= '0' && ch <= '9') {
+            ret |= quint64(ch - '0');
+        } else if (ch >= 'a' && ch <= 'f') {
+            ret |= quint64(ch - 'a' + 10);
+        } else {
+            return false;
+        }
+    }
+    *value = ret;
+    return true;
+}
+
+// version-traceid-parentid-flags, later versions might append more fields
+std::optional<TraceParent> parseTraceParent(QByteArrayView value)
+{
+    if (value.size() < 55 || value[2] != '-' || value[35] != '-' || value[52] != '-' ||
+        (value.size() > 55 && (value.startsWith("00") || value[55] != '-'))) {
+        return {};
+    }
+
+    TraceParent ret;
+    quint64 version;
+    quint64 flags;
+    if (!fromHex(value.first(2), &version) || version == 0xff ||
+        !fromHex(value.sliced(3, 16), &ret.traceIdHigh) ||
+        !fromHex(value.sliced(19, 16), &ret.traceIdLow) ||
+        !fromHex(value.sliced(36, 16), &ret.parentId) || !fromHex(value.sliced(53, 2), &flags)) {
+        return {};
+    }
+
+    if ((ret.traceIdHigh == 0 && ret.traceIdLow == 0) || ret.parentId == 0) {
+        return {};
+    }
+
+    ret.sampled = flags & 0x01;
+    return ret;
+}
+} // namespace
+
+Stats::Stats(EngineRequest *request, bool sampled, const QByteArray &traceParent)
     : d_ptr(new StatsPrivate)
 {
     Q_D(Stats);
     d->engineRequest = request;
+    d->sampled       = sampled;
+    d->start         = request->startOfRequest;
+    if (d->start == TimePointSteady{}) {
+        d->start = std::chrono::steady_clock::now();
+    }
+
+    const auto unixNow = std::chrono::system_clock::now().time_since_epoch();
+    d->startUnixNs =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(unixNow).count() - d->elapsed();
+    d->spanId = randomId();
+
+    if (auto parent = parseTraceParent(traceParent)) {
+        d->traceIdHigh  = parent->traceIdHigh;
+        d->traceIdLow   = parent->traceIdLow;
+        d->parentSpanId = parent->parentId;
+    } else {
+        d->traceIdHigh = randomId();
+        d->traceIdLow  = randomId();
+    }
+
+    d->spans.reserve(16);
+    d->open.reserve(8);
 }
 
 Stats::~Stats()
@@ -28,24 +157,260 @@ Stats::~Stats()
     delete d_ptr;
 }
 
-void Stats::profileStart(const QString &action)
+bool Stats::shouldSample(QByteArrayView traceParent, double sampleRate)
+{
+    if (auto parent = parseTraceParent(traceParent)) {
+        // The caller already decided for the whole trace
+        return parent->sampled;
+    }
+    return sampleRate >= 1.0 || randomGenerator().generateDouble() < sampleRate;
+}
+
+quint32 Stats::intern(const QString &name, SpanKind kind)
+{
+    SpanNames *names = spanNames();
+    {
+        QReadLocker locker(&names->lock);
+        auto it = names->ids.constFind(name);
+        if (it != names->ids.constEnd()) {
+            return it.value();
+        }
+    }
+
+    QWriteLocker locker(&names->lock);
+    auto it = names->ids.constFind(name);
+    if (it != names->ids.constEnd()) {
+        return it.value();
+    }
+
+    QByteArray description = name.trimmed().toUtf8();
+    description.replace('\\', "\\\\");
+    description.replace('"', "\\\"");
+
+    names->names.push_back({name, '"' + description + '"', kind});
+    const auto id = quint32(names->names.size());
+    names->ids.insert(name, id);
+    return id;
+}
+
+QString Stats::name(quint32 id)
+{
+    SpanNames *names = spanNames();
+    QReadLocker locker(&names->lock);
+    if (id == 0 || id > names->names.size()) {
+        return {};
+    }
+    return names->names[id - 1].name;
+}
+
+int Stats::beginSpan(quint32 id)
+{
+    Q_D(Stats);
+    // Contexts outlive their response, like for websockets, don't grow forever
+    if (d->duration != -1) {
+        return -1;
+    }
+
+    const auto span = int(d->spans.size());
+    d->spans.push_back({
+        .name   = id,
+        .parent = d->open.empty() ? -1 : d->open.back(),
+        .begin  = d->elapsed(),
+    });
+    d->open.push_back(span);
+    return span;
+}
+
+void Stats::endSpan(int span)
 {
     Q_D(Stats);
-    StatsAction stat;
-    stat.action = action;
-    stat.begin  = std::chrono::steady_clock::now();
-    d->actions.push_back(stat);
+    if (span < 0 || size_t(span) >= d->spans.size() || d->spans[size_t(span)].end != -1) {
+        return;
+    }
+
+    const qint64 now = d->elapsed();
+    while (!d->open.empty() && d->open.back() >= span) {
+        d->spans[size_t(d->open.back())].end = now;
+        d->open.pop_back();
+    }
+}
+
+void Stats::profileStart(const QString &action)
+{
+    beginSpan(intern(action));
 }
 
 void Stats::profileEnd(const QString &action)
 {
     Q_D(Stats);
-    auto it = std::ranges::find_if(d->actions,
-                                   [action](const auto &stat) { return stat.action == action; });
+    const quint32 id = intern(action);
+    // The innermost span of that name, only open spans are searched
+    for (auto it = d->open.rbegin(); it != d->open.rend(); ++it) {
+        if (d->spans[size_t(*it)].name == id) {
+            endSpan(*it);
+            return;
+        }
+    }
+}
+
+void Stats::finish()
+{
+    Q_D(Stats);
+    if (d->duration != -1) {
+        return;
+    }
+
+    d->duration = d->elapsed();
+    for (int span : d->open) {
+        d->spans[size_t(span)].end = d->duration;
+    }
+    d->open.clear();
+}
+
+qint64 Stats::duration() const noexcept
+{
+    Q_D(const Stats);
+    return d->duration;
+}
+
+qint64 Stats::duration(SpanKind kind) const
+{
+    Q_D(const Stats);
+    const qint64 now = d->duration == -1 ? d->elapsed() : d->duration;
+
+    SpanNames *names = spanNames();
+    QReadLocker locker(&names->lock);
+    auto kindOf = [names](const StatsSpan &span) { return names->names[span.name - 1].kind; };
+
+    qint64 ret = 0;
+    for (const StatsSpan &span : d->spans) {
+        if (kindOf(span) != kind) {
+            continue;
+        }
+
+        bool nested = false;
+        int parent  = span.parent;
+        while (parent != -1 && !nested) {
+            const StatsSpan &parentSpan = d->spans[size_t(parent)];
+            nested                      = kindOf(parentSpan) == kind;
+            parent                      = parentSpan.parent;
+        }
+        if (!nested) {
+            ret += (span.end == -1 ? now : span.end) - span.begin;
+        }
+    }
+    return ret;
+}
+
+qint64 Stats::executionDuration() const noexcept
+{
+    Q_D(const Stats);
+    const qint64 now = d->duration == -1 ? d->elapsed() : d->duration;
+
+    qint64 ret = 0;
+    for (const StatsSpan &span : d->spans) {
+        if (span.parent == -1) {
+            ret += (span.end == -1 ? now : span.end) - span.begin;
+        }
+    }
+    return ret;
+}
+
+bool Stats::isSampled() const noexcept
+{
+    Q_D(const Stats);
+    return d->sampled;
+}
+
+QByteArray Stats::traceId() const
+{
+    Q_D(const Stats);
+    return toHex(d->traceIdHigh) + toHex(d->traceIdLow);
+}
 
-    if (it != d->actions.end()) {
-        it->end = std::chrono::steady_clock::now();
+QByteArray Stats::traceParent() const
+{
+    Q_D(const Stats);
+    return "00-" + traceId() + '-' + toHex(d->spanId) + (d->sampled ? "-01" : "-00");
+}
+
+QByteArray Stats::serverTiming() const
+{
+    Q_D(const Stats);
+
+    auto milliseconds = [](qint64 nsecs) {
+        return QByteArray::number(double(nsecs) / 1e6, 'f', 3);
+    };
+    const qint64 now = d->duration == -1 ? d->elapsed() : d->duration;
+
+    QByteArray ret;
+    ret.reserve(int(d->spans.size()) * 48 + 24);
+
+    SpanNames *names = spanNames();
+    QReadLocker locker(&names->lock);
+    for (const StatsSpan &span : d->spans) {
+        const SpanName &name = names->names[span.name - 1];
+        ret.append(SpanKindNames[int(name.kind)]);
+        ret.append(";desc=" + name.description + ";dur=");
+        ret.append(milliseconds((span.end == -1 ? now : span.end) - span.begin) + ", ");
     }
+    ret.append("total;dur=" + milliseconds(now));
+
+    return ret;
+}
+
+QJsonArray Stats::toOtlpSpans(const QString &requestName) const
+{
+    Q_D(const Stats);
+
+    const QString traceIdHex = QString::fromLatin1(traceId());
+    const QString rootId     = QString::fromLatin1(toHex(d->spanId));
+    const qint64 now         = d->duration == -1 ? d->elapsed() : d->duration;
+
+    auto unixNano = [d](qint64 nsecs) { return QString::number(d->startUnixNs + nsecs); };
+
+    QJsonObject root{
+        {u"traceId"_s, traceIdHex},
+        {u"spanId"_s, rootId},
+        {u"name"_s, requestName},
+        {u"kind"_s, OtlpKindServer},
+        {u"startTimeUnixNano"_s, unixNano(0)},
+        {u"endTimeUnixNano"_s, unixNano(now)},
+    };
+    if (d->parentSpanId) {
+        root.insert(u"parentSpanId"_s, QString::fromLatin1(toHex(d->parentSpanId)));
+    }
+
+    QJsonArray ret{root};
+
+    // Children only need ids once exported, parents always come first
+    std::vector<QString> spanIds;
+    spanIds.reserve(d->spans.size());
+
+    SpanNames *names = spanNames();
+    QReadLocker locker(&names->lock);
+    for (const StatsSpan &span : d->spans) {
+        const SpanName &name = names->names[span.name - 1];
+        spanIds.push_back(QString::fromLatin1(toHex(randomId())));
+
+        const QJsonObject kind{
+            {u"key"_s, u"cutelyst.span.kind"_s},
+            {u"value"_s,
+             QJsonObject{{u"stringValue"_s, QString::fromLatin1(SpanKindNames[int(name.kind)])}}},
+        };
+        ret.append(QJsonObject{
+            {u"traceId"_s, traceIdHex},
+            {u"spanId"_s, spanIds.back()},
+            {u"parentSpanId"_s, span.parent == -1 ? rootId : spanIds[size_t(span.parent)]},
+            {u"name"_s, name.name.trimmed()},
+            {u"kind"_s, OtlpKindInternal},
+            {u"startTimeUnixNano"_s, unixNano(span.begin)},
+            {u"endTimeUnixNano"_s, unixNano(span.end == -1 ? now : span.end)},
+            {u"attributes"_s, QJsonArray{kind}},
+        });
+    }
+
+    return ret;
 }
 
 QByteArray Stats::report()
@@ -53,16 +418,29 @@ QByteArray Stats::report()
     Q_D(const Stats);
 
     QByteArray ret;
-    if (d->actions.empty()) {
+    if (d->spans.empty()) {
         return ret;
     }
 
+    const qint64 now = d->elapsed();
+
     QVector<QStringList> table;
-    for (const auto &stat : d->actions) {
+    table.reserve(qsizetype(d->spans.size()));
+    for (const StatsSpan &span : d->spans) {
+        int depth = 0;
+        for (int parent = span.parent; parent != -1; parent = d->spans[size_t(parent)].parent) {
+            ++depth;
+        }
+
+        QString action = name(span.name);
+        if (depth) {
+            action = u"-> " + action;
+            action = action.rightJustified(action.size() + depth - 1, u' ');
+        }
+
         const std::chrono::duration<double> duration =
-            (stat.end.has_value() ? stat.end.value() : std::chrono::steady_clock::now()) -
-            stat.begin;
-        table.append({stat.action, QString::number(duration.count(), 'f') + u's'});
+            std::chrono::nanoseconds{(span.end == -1 ? now : span.end) - span.begin};
+        table.append({action, QString::number(duration.count(), 'f') + u's'});
     }
 
     ret = Utils::buildTable(table,
@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: (C) 2015-2022 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-FileCopyrightText: (C) 2015-2026 Daniel Nicoletti <dantti12@gmail.com>
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #ifndef STATS_H
@@ -7,24 +7,86 @@
 
 #include <Cutelyst/cutelyst_export.h>
 
-#include <QObject>
+#include <QtCore/QJsonArray>
+#include <QtCore/QObject>
 
 namespace Cutelyst {
 
 class EngineRequest;
 class StatsPrivate;
-class Stats
+/**
+ * \ingroup core
+ * \class Stats stats.h Cutelyst/Stats
+ * \brief Timings of the code executed by a request.
+ *
+ * Each executed component is a span with nanosecond timestamps, nested in the span that was
+ * open when it started. Span names are interned once so that recording a span doesn't copy
+ * or compare strings.
+ *
+ * A request has stats when the \c cutelyst.stats logging category is enabled, when it is
+ * traced, see the \c trace_sample_rate option of Application, or when
+ * Application::setStatsEnabled() is set.
+ */
+class CUTELYST_EXPORT Stats
 {
     Q_GADGET
     Q_DECLARE_PRIVATE(Stats) // cppcheck-suppress unusedPrivateFunction
     Q_DISABLE_COPY(Stats)
 public:
     /**
-     * Constructs a new stats object with the given parent.
+     * Kind of code measured by a span.
+     */
+    enum class SpanKind : quint8 {
+        Component,
+        Begin,
+        Auto,
+        Action,
+        End,
+        View,
+    };
+    Q_ENUM(SpanKind)
+
+    /**
+     * Constructs a new stats object for \a request.
+     *
+     * If \a traceParent is a valid W3C \c traceparent header the spans continue its trace,
+     * otherwise a new trace id is generated. \a sampled tells if the request was sampled
+     * to be exported.
      */
-    explicit Stats(EngineRequest *request);
+    explicit Stats(EngineRequest *request,
+                   bool sampled                  = false,
+                   const QByteArray &traceParent = {});
     virtual ~Stats();
 
+    /**
+     * Returns true if a request should be sampled, when \a traceParent is a valid W3C
+     * \c traceparent header its sampled flag is followed, otherwise requests are sampled
+     * with the probability \a sampleRate.
+     */
+    static bool shouldSample(QByteArrayView traceParent, double sampleRate);
+
+    /**
+     * Returns the id of the span \a name, the same id is returned for the same \a name
+     * on any thread. The \a kind of the first call for a name is kept.
+     */
+    static quint32 intern(const QString &name, SpanKind kind = SpanKind::Component);
+
+    /**
+     * Returns the name of the interned span \a id.
+     */
+    static QString name(quint32 id);
+
+    /**
+     * Starts a span with the interned name \a id, nested in the current one.
+     * Returns the span to pass to endSpan(), or -1 once the request is finished.
+     */
+    int beginSpan(quint32 id);
+
+    /**
+     * Ends \a span and any span started inside it that is still open.
+     */
+    void endSpan(int span);
+
     /**
      * Called before an action is executed to start counting it's time
      */
@@ -35,6 +97,56 @@ public:
      */
     virtual void profileEnd(const QString &action);
 
+    /**
+     * Marks the request as finished, spans still open are ended.
+     */
+    void finish();
+
+    /**
+     * Returns the nanoseconds from the start of the request to finish(), or -1 while
+     * it's not finished.
+     */
+    [[nodiscard]] qint64 duration() const noexcept;
+
+    /**
+     * Returns the nanoseconds spent in spans of \a kind, a span nested in another one of
+     * the same kind is not counted twice.
+     */
+    [[nodiscard]] qint64 duration(SpanKind kind) const;
+
+    /**
+     * Returns the nanoseconds spent executing components, the sum of the top level spans.
+     */
+    [[nodiscard]] qint64 executionDuration() const noexcept;
+
+    /**
+     * Returns true if the request was sampled to be exported.
+     */
+    [[nodiscard]] bool isSampled() const noexcept;
+
+    /**
+     * Returns the trace id as 32 hexadecimal digits.
+     */
+    [[nodiscard]] QByteArray traceId() const;
+
+    /**
+     * Returns the \c traceparent header value to propagate the trace of this request
+     * to the services it calls.
+     */
+    [[nodiscard]] QByteArray traceParent() const;
+
+    /**
+     * Returns the spans as a \c Server-Timing header value, with the kind of each span as
+     * the metric name, its name as description and the total time of the request last.
+     */
+    [[nodiscard]] QByteArray serverTiming() const;
+
+    /**
+     * Returns the spans in the OTLP/JSON format, the request is the root span and
+     * \a requestName its name.
+     */
+    [[nodiscard]] QJsonArray toOtlpSpans(const QString &requestName) const;
+
     /**
      * Returns a text report of collected timmings
      */
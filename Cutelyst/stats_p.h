@@ -1,5 +1,5 @@
 /*
- * SPDX-FileCopyrightText: (C) 2015-2022 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-FileCopyrightText: (C) 2015-2026 Daniel Nicoletti <dantti12@gmail.com>
  * SPDX-License-Identifier: BSD-3-Clause
  */
 #ifndef STATS_P_H
@@ -8,22 +8,42 @@
 #include <chrono>
 #include <vector>
 
-#include <QString>
+#include <QtGlobal>
 
 namespace Cutelyst {
 
-struct StatsAction {
-    QString action;
-    std::chrono::time_point<std::chrono::steady_clock> begin;
-    std::optional<std::chrono::time_point<std::chrono::steady_clock>> end;
+struct StatsSpan {
+    quint32 name;
+    // Index of the span it's nested in, -1 for the top level
+    qint32 parent;
+    // Nanoseconds since the request started
+    qint64 begin;
+    qint64 end = -1;
 };
 
 class EngineRequest;
 class StatsPrivate
 {
 public:
-    std::vector<StatsAction> actions;
+    inline qint64 elapsed() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - start)
+            .count();
+    }
+
+    std::vector<StatsSpan> spans;
+    // Indexes of the spans not ended yet, the last one is the innermost
+    std::vector<int> open;
     EngineRequest *engineRequest;
+    std::chrono::time_point<std::chrono::steady_clock> start;
+    qint64 startUnixNs;
+    qint64 duration      = -1;
+    quint64 traceIdHigh  = 0;
+    quint64 traceIdLow   = 0;
+    quint64 spanId       = 0;
+    quint64 parentSpanId = 0;
+    bool sampled;
 };
 
 } // namespace Cutelyst
@@ -60,6 +60,7 @@ TestEngine::TestResponse TestEngine::createRequest(const QByteArray &method,
     ret.body       = req.m_responseData;
     ret.statusCode = req.m_statusCode;
     ret.headers    = req.m_headers;
+    ret.earlyHints = req.m_earlyHints;
 
     return ret;
 }
@@ -125,6 +126,12 @@ bool TestEngineConnection::writeHeaders(quint16 status, const Headers &headers)
     return true;
 }
 
+bool TestEngineConnection::sendEarlyHints(const Headers &headers)
+{
+    m_earlyHints.append(headers);
+    return true;
+}
+
 void TestEngineConnection::processingFinished()
 {
     m_eventLoop.quit();
@@ -22,6 +22,7 @@ public:
     struct TestResponse {
         QByteArray body;
         Headers headers;
+        QList<Headers> earlyHints;
         quint16 statusCode;
     };
 
@@ -29,6 +29,8 @@ class TestEngineConnection final : public Cutelyst::EngineRequest
 public:
     TestEngineConnection();
 
+    bool sendEarlyHints(const Headers &headers) override;
+
 protected:
     qint64 doWrite(const char *data, qint64 len) override;
     bool writeHeaders(quint16 status, const Headers &headers) override;
@@ -38,5 +40,6 @@ public:
     QEventLoop m_eventLoop;
     QByteArray m_responseData;
     Headers m_headers;
+    QList<Headers> m_earlyHints;
     quint16 m_statusCode = 0;
 };
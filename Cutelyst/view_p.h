@@ -11,6 +11,8 @@ namespace Cutelyst {
 class ViewPrivate : public ComponentPrivate
 {
 public:
+    ViewPrivate() { isView = true; }
+
     qint32 minimalSizeToDeflate = -1;
 };
 } // namespace Cutelyst
@@ -0,0 +1,358 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#include "context_p.h"
+#include "enginerequest.h"
+#include "websockethub_p.h"
+
+#include <algorithm>
+
+#include <QThread>
+
+using namespace Cutelyst;
+
+namespace {
+
+QByteArray createFrame(quint8 opcode, QByteArrayView payload)
+{
+    const auto len = quint64(payload.size());
+
+    QByteArray frame;
+    frame.reserve(payload.size() + 10);
+    frame.append(char(0x80 | opcode));
+    if (len < 126) {
+        frame.append(char(len));
+    } else if (len <= 0xffff) {
+        frame.append(char(126));
+        frame.append(char(len >> 8));
+        frame.append(char(len));
+    } else {
+        frame.append(char(127));
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            frame.append(char(len >> shift));
+        }
+    }
+    frame.append(payload);
+
+    return frame;
+}
+
+// Created on the first subscription of a thread and deleted once the thread finishes
+thread_local WebSocketHubThread *t_threadData = nullptr;
+
+} // namespace
+
+WebSocketHub::WebSocketHub()
+    : d_ptr(new WebSocketHubPrivate)
+{
+}
+
+WebSocketHub::~WebSocketHub()
+{
+    delete d_ptr;
+}
+
+WebSocketHub *WebSocketHub::instance()
+{
+    static WebSocketHub hub;
+    return &hub;
+}
+
+bool WebSocketHub::subscribe(Context *c, const QString &channel)
+{
+    Q_D(WebSocketHub);
+    Q_ASSERT_X(c->thread() == QThread::currentThread(),
+               "WebSocketHub::subscribe",
+               "Context must live in the current thread");
+    return d->threadData()->subscribe(c, channel);
+}
+
+void WebSocketHub::unsubscribe(Context *c, const QString &channel)
+{
+    Q_D(WebSocketHub);
+    Q_ASSERT_X(c->thread() == QThread::currentThread(),
+               "WebSocketHub::unsubscribe",
+               "Context must live in the current thread");
+    d->threadData()->unsubscribe(c, channel);
+}
+
+void WebSocketHub::publishText(const QString &channel, const QString &message)
+{
+    Q_D(WebSocketHub);
+    d->publish(channel, createFrame(0x1, message.toUtf8()));
+}
+
+void WebSocketHub::publishBinary(const QString &channel, const QByteArray &message)
+{
+    Q_D(WebSocketHub);
+    d->publish(channel, createFrame(0x2, message));
+}
+
+quint64 WebSocketHub::published() const noexcept
+{
+    Q_D(const WebSocketHub);
+    return d->published.load(std::memory_order_relaxed);
+}
+
+quint64 WebSocketHub::delivered() const noexcept
+{
+    Q_D(const WebSocketHub);
+    return d->delivered.load(std::memory_order_relaxed);
+}
+
+WebSocketHubThread *WebSocketHubPrivate::threadData()
+{
+    if (!t_threadData) {
+        t_threadData = new WebSocketHubThread(this);
+    }
+    return t_threadData;
+}
+
+void WebSocketHubPrivate::publish(const QString &channel, QByteArray frame)
+{
+    published.fetch_add(1, std::memory_order_relaxed);
+
+    QReadLocker locker(&lock);
+    for (auto data : threads) {
+        // Only the reference count of the frame is touched per thread
+        data->enqueue(new WebSocketHubMessage{channel, frame});
+    }
+}
+
+void WebSocketHubPrivate::attach(WebSocketHubThread *data)
+{
+    QWriteLocker locker(&lock);
+    threads.push_back(data);
+}
+
+void WebSocketHubPrivate::detach(WebSocketHubThread *data)
+{
+    // Once it returns no publisher holds the thread data anymore
+    QWriteLocker locker(&lock);
+    std::erase(threads, data);
+}
+
+WebSocketHubThread::WebSocketHubThread(WebSocketHubPrivate *hub)
+    : m_hub(hub)
+{
+    connect(QThread::currentThread(),
+            &QThread::finished,
+            this,
+            &WebSocketHubThread::threadFinished,
+            Qt::DirectConnection);
+}
+
+WebSocketHubThread::~WebSocketHubThread()
+{
+    auto message = m_queue.exchange(nullptr, std::memory_order_acquire);
+    while (message) {
+        auto next = message->next;
+        delete message;
+        message = next;
+    }
+}
+
+void WebSocketHubThread::enqueue(WebSocketHubMessage *message)
+{
+    message->next = m_queue.load(std::memory_order_relaxed);
+    while (!m_queue.compare_exchange_weak(
+        message->next, message, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+
+    // Only the message that found the queue empty needs to wake the thread up
+    if (!message->next) {
+        QMetaObject::invokeMethod(this, &WebSocketHubThread::drain, Qt::QueuedConnection);
+    }
+}
+
+bool WebSocketHubThread::subscribe(Context *c, const QString &channel)
+{
+    auto it = m_contexts.find(c);
+    if (it == m_contexts.end()) {
+        connect(c, &QObject::destroyed, this, &WebSocketHubThread::contextDestroyed);
+        m_contexts.insert(c, {channel});
+    } else if (it->contains(channel)) {
+        return false;
+    } else {
+        it->append(channel);
+    }
+
+    if (m_subscriptions++ == 0) {
+        m_hub->attach(this);
+    }
+
+    if (m_draining) {
+        // Inserting a channel could rehash m_channels under drain()
+        m_pendingSubscribers.emplace_back(c, channel);
+    } else {
+        addSubscriber(c, channel);
+    }
+
+    return true;
+}
+
+void WebSocketHubThread::unsubscribe(Context *c, const QString &channel)
+{
+    auto it = m_contexts.find(c);
+    if (it == m_contexts.end() || !it->removeOne(channel)) {
+        return;
+    }
+
+    removeSubscriber(c, channel);
+
+    if (it->isEmpty()) {
+        m_contexts.erase(it);
+        disconnect(c, &QObject::destroyed, this, &WebSocketHubThread::contextDestroyed);
+    }
+}
+
+void WebSocketHubThread::drain()
+{
+    // The queue is a stack, reverse it to deliver in publishing order
+    WebSocketHubMessage *message = nullptr;
+    auto node                    = m_queue.exchange(nullptr, std::memory_order_acquire);
+    while (node) {
+        auto next  = node->next;
+        node->next = message;
+        message    = node;
+        node       = next;
+    }
+
+    quint64 delivered = 0;
+    m_draining        = true;
+    while (message) {
+        // Writes can run application code, which can't insert into or erase from
+        // m_channels while m_draining is set, so the iterator stays valid
+        auto it = m_channels.constFind(message->channel);
+        if (it != m_channels.constEnd()) {
+            const size_t count = it->subscribers.size();
+            for (size_t i = 0; i < count; ++i) {
+                // Subscribers closed by a failed write are set to null
+                Context *c = it->subscribers[i];
+                if (c && c->d_ptr->engineRequest->webSocketSendFrame(message->frame)) {
+                    ++delivered;
+                }
+            }
+        }
+
+        auto next = message->next;
+        delete message;
+        message = next;
+    }
+    m_draining = false;
+
+    compact();
+
+    m_hub->delivered.fetch_add(delivered, std::memory_order_relaxed);
+}
+
+void WebSocketHubThread::threadFinished()
+{
+    // Publishers skip this thread from now on
+    if (m_subscriptions > 0) {
+        m_subscriptions = 0;
+        m_hub->detach(this);
+    }
+    m_channels.clear();
+    m_contexts.clear();
+    m_pendingSubscribers.clear();
+
+    // Deferred deletes are still processed after QThread::finished
+    t_threadData = nullptr;
+    deleteLater();
+}
+
+void WebSocketHubThread::contextDestroyed(QObject *obj)
+{
+    // Only used as a key, the Context is already being destroyed
+    auto c = static_cast<Context *>(obj);
+
+    const QStringList channels = m_contexts.take(c);
+    for (const QString &channel : channels) {
+        removeSubscriber(c, channel);
+    }
+}
+
+void WebSocketHubThread::addSubscriber(Context *c, const QString &channel)
+{
+    Channel &data = m_channels[channel];
+    data.index.insert(c, data.subscribers.size());
+    data.subscribers.push_back(c);
+}
+
+void WebSocketHubThread::removeSubscriber(Context *c, const QString &channel)
+{
+    // Only called for subscriptions listed in m_contexts
+    if (--m_subscriptions == 0) {
+        // Messages already queued are still freed by drain()
+        m_hub->detach(this);
+    }
+
+    auto pending = std::ranges::find(m_pendingSubscribers, std::pair{c, channel});
+    if (pending != m_pendingSubscribers.end()) {
+        m_pendingSubscribers.erase(pending);
+        return;
+    }
+
+    auto it = m_channels.find(channel);
+    if (it == m_channels.end()) {
+        return;
+    }
+
+    auto ix = it->index.find(c);
+    if (ix == it->index.end()) {
+        return;
+    }
+    const size_t pos = ix.value();
+    it->index.erase(ix);
+
+    if (m_draining) {
+        // Keep positions stable while the list is being iterated
+        it->subscribers[pos] = nullptr;
+        if (!m_dirtyChannels.contains(channel)) {
+            m_dirtyChannels.append(channel);
+        }
+        return;
+    }
+
+    if (pos != it->subscribers.size() - 1) {
+        Context *last        = it->subscribers.back();
+        it->subscribers[pos] = last;
+        it->index[last]      = pos;
+    }
+    it->subscribers.pop_back();
+
+    if (it->subscribers.empty()) {
+        m_channels.erase(it);
+    }
+}
+
+void WebSocketHubThread::compact()
+{
+    for (const QString &channel : std::as_const(m_dirtyChannels)) {
+        auto it = m_channels.find(channel);
+        if (it == m_channels.end()) {
+            continue;
+        }
+
+        std::erase(it->subscribers, nullptr);
+        if (it->subscribers.empty()) {
+            m_channels.erase(it);
+            continue;
+        }
+
+        it->index.clear();
+        for (size_t i = 0; i < it->subscribers.size(); ++i) {
+            it->index.insert(it->subscribers[i], i);
+        }
+    }
+    m_dirtyChannels.clear();
+
+    for (const auto &[c, channel] : std::as_const(m_pendingSubscribers)) {
+        addSubscriber(c, channel);
+    }
+    m_pendingSubscribers.clear();
+}
+
+#include "moc_websockethub_p.cpp"
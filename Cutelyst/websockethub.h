@@ -0,0 +1,98 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <Cutelyst/cutelyst_export.h>
+
+#include <QByteArray>
+#include <QString>
+
+namespace Cutelyst {
+
+class Context;
+class WebSocketHubPrivate;
+
+/**
+ * \ingroup core
+ * \class WebSocketHub websockethub.h Cutelyst/WebSocketHub
+ * \brief Publishes WebSocket messages to every connection subscribed to a named channel.
+ *
+ * Connections that completed the WebSocket handshake are subscribed to channels
+ * from the thread that owns their Context, a message published on a channel is
+ * encoded into a single immutable frame which is then queued on a lock-free queue
+ * of each engine thread that has subscribers, where it is written to them once the
+ * thread gets back to its event loop.
+ *
+ * \code{.cpp}
+ * void Root::ws(Context *c)
+ * {
+ *     if (c->response()->webSocketHandshake()) {
+ *         WebSocketHub::instance()->subscribe(c, u"news"_s);
+ *     }
+ * }
+ *
+ * // from any thread
+ * WebSocketHub::instance()->publishText(u"news"_s, u"Hello"_s);
+ * \endcode
+ *
+ * Subscriptions are removed automatically when the Context is destroyed. The hub is
+ * shared by all threads of a process, it does not reach connections of other processes.
+ *
+ * \since Cutelyst 5.1.0
+ */
+class CUTELYST_EXPORT WebSocketHub
+{
+    Q_DECLARE_PRIVATE(WebSocketHub)
+public:
+    /**
+     * Returns the process wide hub.
+     */
+    static WebSocketHub *instance();
+
+    /**
+     * Subscribes the WebSocket connection of \a c to \a channel, this must be called from
+     * the thread \a c lives in.
+     *
+     * Returns false if \a c was already subscribed to \a channel.
+     */
+    bool subscribe(Context *c, const QString &channel);
+
+    /**
+     * Removes the subscription of \a c to \a channel, this must be called from
+     * the thread \a c lives in.
+     */
+    void unsubscribe(Context *c, const QString &channel);
+
+    /**
+     * Sends the text \a message to all connections subscribed to \a channel,
+     * this can be called from any thread.
+     */
+    void publishText(const QString &channel, const QString &message);
+
+    /**
+     * Sends the binary \a message to all connections subscribed to \a channel,
+     * this can be called from any thread.
+     */
+    void publishBinary(const QString &channel, const QByteArray &message);
+
+    /**
+     * Returns the number of messages published so far.
+     */
+    [[nodiscard]] quint64 published() const noexcept;
+
+    /**
+     * Returns the number of frames written to subscribers so far.
+     */
+    [[nodiscard]] quint64 delivered() const noexcept;
+
+private:
+    WebSocketHub();
+    ~WebSocketHub();
+    Q_DISABLE_COPY(WebSocketHub)
+
+    WebSocketHubPrivate *d_ptr;
+};
+
+} // namespace Cutelyst
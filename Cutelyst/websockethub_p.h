@@ -0,0 +1,80 @@
+/*
+ * SPDX-FileCopyrightText: (C) 2026 Daniel Nicoletti <dantti12@gmail.com>
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include "websockethub.h"
+
+#include <atomic>
+#include <vector>
+
+#include <QHash>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QStringList>
+
+namespace Cutelyst {
+
+struct WebSocketHubMessage {
+    QString channel;
+    // Complete frame shared by every thread and subscriber
+    QByteArray frame;
+    WebSocketHubMessage *next = nullptr;
+};
+
+class WebSocketHubThread final : public QObject
+{
+    Q_OBJECT
+public:
+    explicit WebSocketHubThread(WebSocketHubPrivate *hub);
+    ~WebSocketHubThread() override;
+
+    // Safe to call from any thread
+    void enqueue(WebSocketHubMessage *message);
+
+    bool subscribe(Context *c, const QString &channel);
+    void unsubscribe(Context *c, const QString &channel);
+
+    struct Channel {
+        std::vector<Context *> subscribers;
+        QHash<Context *, size_t> index;
+    };
+
+private:
+    void drain();
+    void threadFinished();
+    void contextDestroyed(QObject *obj);
+    void addSubscriber(Context *c, const QString &channel);
+    void removeSubscriber(Context *c, const QString &channel);
+    void compact();
+
+    WebSocketHubPrivate *m_hub;
+    // Only touched by the owning thread, it is registered while it has subscribers
+    int m_subscriptions = 0;
+    // Multiple producers push, the owning thread takes the whole list at once
+    std::atomic<WebSocketHubMessage *> m_queue{nullptr};
+    QHash<QString, Channel> m_channels;
+    QHash<Context *, QStringList> m_contexts;
+    QStringList m_dirtyChannels;
+    // Subscribed by application code while drain() iterates m_channels, added by compact()
+    std::vector<std::pair<Context *, QString>> m_pendingSubscribers;
+    bool m_draining = false;
+};
+
+class WebSocketHubPrivate
+{
+public:
+    WebSocketHubThread *threadData();
+    void publish(const QString &channel, QByteArray frame);
+    void attach(WebSocketHubThread *data);
+    void detach(WebSocketHubThread *data);
+
+    // Threads with subscribers, publishers only hold the lock for reading
+    QReadWriteLock lock;
+    std::vector<WebSocketHubThread *> threads;
+    std::atomic<quint64> published{0};
+    std::atomic<quint64> delivered{0};
+};
+
+} // namespace Cutelyst
@@ -0,0 +1,190 @@
+#ifndef BENCHFASTCGIWRITE_H
+#define BENCHFASTCGIWRITE_H
+
+#include "fastcgiwriter.h"
+
+#include <QIODevice>
+#include <QTest>
+
+using namespace Cutelyst;
+
+// Keeps what was written so it can be decoded, and counts the write calls
+class RecordSink : public QIODevice
+{
+public:
+    RecordSink() { open(QIODevice::WriteOnly); }
+
+    void reset()
+    {
+        data.resize(0);
+        writes = 0;
+    }
+
+    QByteArray data;
+    qint64 writes = 0;
+
+protected:
+    qint64 readData(char *, qint64) override { return -1; }
+    qint64 writeData(const char *buf, qint64 len) override
+    {
+        ++writes;
+        data.append(buf, len);
+        return len;
+    }
+};
+
+class BenchFastCGIWrite : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BenchFastCGIWrite(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void writeResponse_data();
+    void writeResponse();
+
+private:
+    static void writeRecordPieces(QIODevice *io,
+                                  quint8 type,
+                                  quint16 requestId,
+                                  const char *data,
+                                  quint16 len);
+    static void writeResponsePieces(QIODevice *io,
+                                    quint16 requestId,
+                                    const QByteArray &headers,
+                                    const QByteArray &body);
+    static void writeResponseCoalesced(QIODevice *io,
+                                       quint16 requestId,
+                                       const QByteArray &headers,
+                                       const QByteArray &body);
+    static QByteArray decodeStdout(const QByteArray &records, bool *ended);
+
+    QByteArray m_headers;
+};
+
+void BenchFastCGIWrite::initTestCase()
+{
+    m_headers = QByteArrayLiteral("Status: 200\r\n"
+                                  "Content-Type: text/html; charset=utf-8\r\n"
+                                  "Date: Mon, 19 Oct 2026 10:00:00 GMT\r\n\r\n");
+}
+
+// The record writer used before, header, content and padding written separately
+void BenchFastCGIWrite::writeRecordPieces(QIODevice *io,
+                                          quint8 type,
+                                          quint16 requestId,
+                                          const char *data,
+                                          quint16 len)
+{
+    const auto pad   = quint8(((len + 7) & ~7) - len);
+    const char fr[8] = {
+        1,
+        char(type),
+        char(requestId >> 8),
+        char(requestId),
+        char(len >> 8),
+        char(len),
+        char(pad),
+        0,
+    };
+    io->write(fr, sizeof(fr));
+    if (len) {
+        io->write(data, len);
+    }
+    if (pad) {
+        io->write("\0\0\0\0\0\0\0\0", pad);
+    }
+}
+
+void BenchFastCGIWrite::writeResponsePieces(QIODevice *io,
+                                            quint16 requestId,
+                                            const QByteArray &headers,
+                                            const QByteArray &body)
+{
+    writeRecordPieces(io, 6, requestId, headers.constData(), quint16(headers.size()));
+    qint64 pos = 0;
+    while (pos < body.size()) {
+        const auto len = quint16(qMin<qint64>(body.size() - pos, 0xffff));
+        writeRecordPieces(io, 6, requestId, body.constData() + pos, len);
+        pos += len;
+    }
+    writeRecordPieces(io, 6, requestId, nullptr, 0);
+    const char end[8] = {};
+    writeRecordPieces(io, 3, requestId, end, sizeof(end));
+}
+
+// Mirrors FastCGIRequest, small bodies are held and written with the end of the request
+void BenchFastCGIWrite::writeResponseCoalesced(QIODevice *io,
+                                               quint16 requestId,
+                                               const QByteArray &headers,
+                                               const QByteArray &body)
+{
+    if (headers.size() + body.size() < FastCGIWriter::CoalesceSize) {
+        FastCGIWriter::writeStdout(io, requestId, headers + body, {}, true);
+    } else {
+        FastCGIWriter::writeStdout(io, requestId, headers, body, false);
+        FastCGIWriter::writeStdout(io, requestId, {}, {}, true);
+    }
+}
+
+QByteArray BenchFastCGIWrite::decodeStdout(const QByteArray &records, bool *ended)
+{
+    QByteArray ret;
+    *ended  = false;
+    int pos = 0;
+    while (pos + 8 <= records.size()) {
+        const auto *fr = reinterpret_cast<const quint8 *>(records.constData() + pos);
+        const int len  = (fr[4] << 8) | fr[5];
+        if (fr[1] == 6) {
+            ret.append(records.constData() + pos + 8, len);
+        } else if (fr[1] == 3) {
+            *ended = pos + 8 + len + fr[6] == records.size();
+        }
+        pos += 8 + len + fr[6];
+    }
+    return ret;
+}
+
+void BenchFastCGIWrite::writeResponse_data()
+{
+    QTest::addColumn<bool>("coalesced");
+    QTest::addColumn<int>("bodySize");
+
+    for (int bodySize : {0, 512, 8 * 1024, 128 * 1024}) {
+        QTest::addRow("pieces-%d", bodySize) << false << bodySize;
+        QTest::addRow("coalesced-%d", bodySize) << true << bodySize;
+    }
+}
+
+void BenchFastCGIWrite::writeResponse()
+{
+    QFETCH(bool, coalesced);
+    QFETCH(int, bodySize);
+
+    const QByteArray body(bodySize, 'x');
+    RecordSink sink;
+
+    QBENCHMARK {
+        sink.reset();
+        if (coalesced) {
+            writeResponseCoalesced(&sink, 1, m_headers, body);
+        } else {
+            writeResponsePieces(&sink, 1, m_headers, body);
+        }
+    }
+
+    bool ended = false;
+    QCOMPARE(decodeStdout(sink.data, &ended), m_headers + body);
+    QVERIFY(ended);
+    qInfo() << "write calls per response" << sink.writes << "bytes" << sink.data.size();
+}
+
+QTEST_MAIN(BenchFastCGIWrite)
+
+#include "benchfastcgiwrite.moc"
+
+#endif // BENCHFASTCGIWRITE_H
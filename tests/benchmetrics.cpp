@@ -0,0 +1,141 @@
+#ifndef BENCHMETRICS_H
+#define BENCHMETRICS_H
+
+#include "metrics.h"
+
+#include <Cutelyst/Action>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <QTest>
+
+using namespace Cutelyst;
+using namespace Qt::StringLiterals;
+
+namespace {
+// Each benchmark iteration records this many requests, divide its time by it
+constexpr int Records = 1000;
+} // namespace
+
+class BenchMetrics : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BenchMetrics(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void bucketOf();
+    void record_data();
+    void record();
+    void clock();
+    void render();
+};
+
+void BenchMetrics::bucketOf()
+{
+    QCOMPARE(MetricsSeries::bucketOf(0), 0);
+    QCOMPARE(MetricsSeries::bucketOf(11'999), 0);
+    QCOMPARE(MetricsSeries::bucketOf(12'000), 1);
+    QCOMPARE(MetricsSeries::bucketOf(16'000), 2);
+    QCOMPARE(MetricsSeries::bucketOf(quint64(1) << 62), MetricsSeries::BucketCount - 1);
+
+    // Every value is below the upper bound of its bucket
+    for (quint64 usecs : {1, 8, 12, 100, 1'000, 12'345, 1'000'000}) {
+        const int bucket = MetricsSeries::bucketOf(usecs * 1000);
+        QVERIFY(usecs < MetricsSeries::upperBound(bucket));
+        QVERIFY(bucket == 0 || usecs >= MetricsSeries::upperBound(bucket - 1));
+    }
+}
+
+void BenchMetrics::record_data()
+{
+    QTest::addColumn<int>("actions");
+    QTest::addColumn<int>("statuses");
+
+    QTest::addRow("1-series") << 1 << 1;
+    QTest::addRow("8-actions-3-statuses") << 8 << 3;
+}
+
+void BenchMetrics::record()
+{
+    QFETCH(int, actions);
+    QFETCH(int, statuses);
+
+    Metrics metrics(1, 1);
+    metrics.postFork(0);
+    MetricsRecorder *recorder = metrics.recorder(0);
+    QVERIFY(recorder);
+
+    std::vector<std::unique_ptr<Action>> actionList;
+    for (int i = 0; i < actions; ++i) {
+        auto action = std::make_unique<Action>();
+        action->setReverse(u"action%1"_s.arg(i));
+        actionList.push_back(std::move(action));
+    }
+    const quint16 statusList[] = {200, 404, 500};
+
+    QBENCHMARK {
+        for (int i = 0; i < Records; ++i) {
+            recorder->record(actionList[size_t(i % actions)].get(),
+                             statusList[i % statuses],
+                             Protocol::Type::Http11,
+                             quint64(i) * 1000);
+        }
+    }
+
+    const QByteArray text = metrics.render({});
+    QVERIFY(text.contains("action=\"action0\",status=\"2xx\",protocol=\"http/1.1\""));
+    QVERIFY(text.endsWith("# EOF\n"));
+}
+
+// The clock is read once per request too, on top of record()
+void BenchMetrics::clock()
+{
+    std::chrono::steady_clock::time_point last;
+    QBENCHMARK {
+        for (int i = 0; i < Records; ++i) {
+            last = std::chrono::steady_clock::now();
+        }
+    }
+    QVERIFY(last != std::chrono::steady_clock::time_point{});
+}
+
+void BenchMetrics::render()
+{
+    Metrics metrics(2, 2);
+    std::vector<std::unique_ptr<Action>> actionList;
+    for (int i = 0; i < 32; ++i) {
+        auto action = std::make_unique<Action>();
+        action->setReverse(u"action%1"_s.arg(i));
+        actionList.push_back(std::move(action));
+    }
+
+    // Same series on every thread, so they are merged
+    for (int worker = 0; worker < 2; ++worker) {
+        metrics.postFork(worker);
+        for (int core = 0; core < 2; ++core) {
+            for (const auto &action : actionList) {
+                metrics.recorder(core)->record(action.get(), 200, Protocol::Type::Http2, 50'000);
+            }
+        }
+    }
+
+    QByteArray text;
+    QBENCHMARK {
+        text = metrics.render({{u"workers"_s, 2}});
+    }
+    QVERIFY(text.contains("cutelyst_request_duration_seconds_count{action=\"action31\","
+                          "status=\"2xx\",protocol=\"h2\"} 4\n"));
+    QVERIFY(text.contains("cutelyst_workers 2\n"));
+}
+
+QTEST_MAIN(BenchMetrics)
+
+#include "benchmetrics.moc"
+
+#endif // BENCHMETRICS_H
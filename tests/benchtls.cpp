@@ -0,0 +1,239 @@
+#ifndef BENCHTLS_H
+#define BENCHTLS_H
+
+#include <Cutelyst/Server/server.h>
+#include <Cutelyst/application.h>
+#include <Cutelyst/context.h>
+#include <Cutelyst/controller.h>
+#include <Cutelyst/response.h>
+
+#include <QEventLoop>
+#include <QSignalSpy>
+#include <QSslSocket>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+
+using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+constexpr qsizetype PayloadSize = 1024 * 1024;
+constexpr quint16 QtPort        = 31711;
+constexpr quint16 OpenSslPort   = 31712;
+} // namespace
+
+class BenchTlsController : public Controller
+{
+    Q_OBJECT
+    C_NAMESPACE("")
+public:
+    explicit BenchTlsController(QObject *parent)
+        : Controller(parent)
+    {
+    }
+
+    C_ATTR(hello, :Local :AutoArgs)
+    void hello(Context *c) { c->response()->setBody("Hello World!"_ba); }
+
+    C_ATTR(payload, :Local :AutoArgs)
+    void payload(Context *c) { c->response()->setBody(m_payload); }
+
+private:
+    const QByteArray m_payload = QByteArray(PayloadSize, 'x');
+};
+
+class BenchTlsApplication : public Application
+{
+    Q_OBJECT
+public:
+    explicit BenchTlsApplication(QObject *parent = nullptr)
+        : Application(parent)
+    {
+    }
+
+    bool init() override
+    {
+        new BenchTlsController(this);
+        return true;
+    }
+};
+
+class BenchTls : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BenchTls(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void handshake_data();
+    void handshake();
+    void throughput_data();
+    void throughput();
+    void cleanupTestCase();
+
+private:
+    void backends();
+    bool startServer(const QString &backend, quint16 port);
+
+    QTemporaryDir m_dir;
+    QString m_certPath;
+    QString m_keyPath;
+    QList<Server *> m_servers;
+};
+
+void BenchTls::initTestCase()
+{
+    if (!QSslSocket::supportsSsl()) {
+        QSKIP("Qt was built without a TLS backend");
+    }
+
+    // Keep the dispatcher already installed by QTEST_MAIN
+    qputenv("CUTELYST_QT_EVENT_LOOP", "1");
+
+    QVERIFY(m_dir.isValid());
+    m_certPath = m_dir.filePath(u"cert.pem"_s);
+    m_keyPath  = m_dir.filePath(u"key.pem"_s);
+
+    EVP_PKEY *key = EVP_EC_gen("P-256");
+    QVERIFY(key);
+
+    X509 *cert = X509_new();
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME *name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(
+        name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    QVERIFY(X509_sign(cert, key, EVP_sha256()) > 0);
+
+    BIO *certBio = BIO_new_file(m_certPath.toLocal8Bit().constData(), "w");
+    BIO *keyBio  = BIO_new_file(m_keyPath.toLocal8Bit().constData(), "w");
+    QVERIFY(PEM_write_bio_X509(certBio, cert));
+    QVERIFY(PEM_write_bio_PrivateKey(keyBio, key, nullptr, nullptr, 0, nullptr, nullptr));
+    BIO_free(certBio);
+    BIO_free(keyBio);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+
+    QVERIFY(startServer(u"qt"_s, QtPort));
+    QVERIFY(startServer(u"openssl"_s, OpenSslPort));
+}
+
+bool BenchTls::startServer(const QString &backend, quint16 port)
+{
+    auto server = new Server(this);
+    server->setHttpsSocket({u"127.0.0.1:%1,%2,%3,ec"_s.arg(port).arg(m_certPath, m_keyPath)});
+    server->setTlsBackend(backend);
+    server->setSocketTimeout(0);
+    m_servers.append(server);
+    return server->start(new BenchTlsApplication(server));
+}
+
+void BenchTls::cleanupTestCase()
+{
+    for (Server *server : std::as_const(m_servers)) {
+        QSignalSpy stopped(server, &Server::stopped);
+        server->stop();
+        QVERIFY(stopped.wait());
+    }
+}
+
+void BenchTls::backends()
+{
+    QTest::addColumn<quint16>("port");
+
+    QTest::addRow("qt") << QtPort;
+    QTest::addRow("openssl") << OpenSslPort;
+}
+
+void BenchTls::handshake_data()
+{
+    backends();
+}
+
+void BenchTls::handshake()
+{
+    QFETCH(quint16, port);
+
+    // A new connection per request, so this measures the handshake rate
+    QByteArray reply;
+    QBENCHMARK {
+        QSslSocket sock;
+        sock.setPeerVerifyMode(QSslSocket::VerifyNone);
+        QEventLoop loop;
+        connect(&sock, &QSslSocket::disconnected, &loop, &QEventLoop::quit);
+        connect(&sock, &QSslSocket::errorOccurred, &loop, &QEventLoop::quit);
+        connect(&sock, &QSslSocket::encrypted, &sock, [&sock] {
+            sock.write("GET /hello HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n"_ba);
+        });
+
+        sock.connectToHostEncrypted(u"127.0.0.1"_s, port);
+
+        // The server runs on this thread, qWaitFor() would add its polling interval
+        loop.exec();
+        reply = sock.readAll();
+    }
+
+    QVERIFY(reply.startsWith("HTTP/1.1 200"));
+    QVERIFY(reply.endsWith("Hello World!"));
+}
+
+void BenchTls::throughput_data()
+{
+    backends();
+}
+
+void BenchTls::throughput()
+{
+    QFETCH(quint16, port);
+
+    QSslSocket sock;
+    sock.setPeerVerifyMode(QSslSocket::VerifyNone);
+    QSignalSpy encrypted(&sock, &QSslSocket::encrypted);
+    sock.connectToHostEncrypted(u"127.0.0.1"_s, port);
+    QVERIFY(encrypted.wait());
+
+    QByteArray reply;
+    qsizetype expected = -1;
+    QEventLoop loop;
+    connect(&sock, &QSslSocket::disconnected, &loop, &QEventLoop::quit);
+    connect(&sock, &QSslSocket::readyRead, &loop, [&] {
+        reply.append(sock.readAll());
+        if (expected == -1) {
+            const qsizetype headersEnd = reply.indexOf("\r\n\r\n");
+            if (headersEnd != -1) {
+                expected = headersEnd + 4 + PayloadSize;
+            }
+        }
+        if (expected != -1 && reply.size() >= expected) {
+            loop.quit();
+        }
+    });
+
+    // Each iteration moves PayloadSize bytes over the same connection
+    QBENCHMARK {
+        reply.clear();
+        expected = -1;
+        sock.write("GET /payload HTTP/1.1\r\nHost: localhost\r\n\r\n"_ba);
+        loop.exec();
+    }
+
+    QCOMPARE(reply.size(), expected);
+    QVERIFY(reply.startsWith("HTTP/1.1 200"));
+}
+
+QTEST_MAIN(BenchTls)
+
+#include "benchtls.moc"
+
+#endif // BENCHTLS_H
@@ -0,0 +1,201 @@
+#ifndef BENCHUWSGI_H
+#define BENCHUWSGI_H
+
+#include <Cutelyst/Server/server.h>
+#include <Cutelyst/application.h>
+#include <Cutelyst/context.h>
+#include <Cutelyst/controller.h>
+#include <Cutelyst/response.h>
+
+#include <QEventLoop>
+#include <QLocalSocket>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
+
+class BenchUwsgiController : public Controller
+{
+    Q_OBJECT
+    C_NAMESPACE("")
+public:
+    explicit BenchUwsgiController(QObject *parent)
+        : Controller(parent)
+    {
+    }
+
+    C_ATTR(hello, :Local :AutoArgs)
+    void hello(Context *c) { c->response()->setBody("Hello World!"_ba); }
+};
+
+class BenchUwsgiApplication : public Application
+{
+    Q_OBJECT
+public:
+    explicit BenchUwsgiApplication(QObject *parent = nullptr)
+        : Application(parent)
+    {
+    }
+
+    bool init() override
+    {
+        new BenchUwsgiController(this);
+        return true;
+    }
+};
+
+class BenchUwsgi : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BenchUwsgi(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void request_data();
+    void request();
+    void cleanupTestCase();
+
+private:
+    static QByteArray fastcgiRequest(const QList<std::pair<QByteArray, QByteArray>> &params);
+    static QByteArray uwsgiRequest(const QList<std::pair<QByteArray, QByteArray>> &vars);
+
+    QTemporaryDir m_dir;
+    Server *m_server = nullptr;
+};
+
+void BenchUwsgi::initTestCase()
+{
+    // Keep the dispatcher already installed by QTEST_MAIN
+    qputenv("CUTELYST_QT_EVENT_LOOP", "1");
+
+    QVERIFY(m_dir.isValid());
+    m_server = new Server(this);
+    m_server->setFastcgiSocket({m_dir.filePath(u"fastcgi.sock"_s)});
+    m_server->setUwsgiSocket({m_dir.filePath(u"uwsgi.sock"_s)});
+    m_server->setSocketTimeout(0);
+    QVERIFY(m_server->start(new BenchUwsgiApplication(m_server)));
+}
+
+void BenchUwsgi::cleanupTestCase()
+{
+    QSignalSpy stopped(m_server, &Server::stopped);
+    m_server->stop();
+    QVERIFY(stopped.wait());
+}
+
+// BEGIN_REQUEST without FCGI_KEEP_CONN, PARAMS and an empty STDIN as nginx sends them
+QByteArray BenchUwsgi::fastcgiRequest(const QList<std::pair<QByteArray, QByteArray>> &params)
+{
+    auto record = [](quint8 type, const QByteArray &content) {
+        const auto padding = quint8((8 - content.size() % 8) % 8);
+        QByteArray ret;
+        ret.append(char(1));
+        ret.append(char(type));
+        ret.append(char(0));
+        ret.append(char(1));
+        ret.append(char(content.size() >> 8));
+        ret.append(char(content.size()));
+        ret.append(char(padding));
+        ret.append(char(0));
+        ret.append(content);
+        ret.append(padding, '\0');
+        return ret;
+    };
+
+    QByteArray pairs;
+    for (const auto &[name, value] : params) {
+        pairs.append(char(name.size()));
+        pairs.append(char(value.size()));
+        pairs.append(name);
+        pairs.append(value);
+    }
+
+    return record(1, QByteArray("\x00\x01\x00\x00\x00\x00\x00\x00", 8)) + record(4, pairs) +
+           record(4, {}) + record(5, {});
+}
+
+QByteArray BenchUwsgi::uwsgiRequest(const QList<std::pair<QByteArray, QByteArray>> &vars)
+{
+    QByteArray block;
+    for (const auto &[key, value] : vars) {
+        block.append(char(key.size()));
+        block.append(char(key.size() >> 8));
+        block.append(key);
+        block.append(char(value.size()));
+        block.append(char(value.size() >> 8));
+        block.append(value);
+    }
+
+    QByteArray ret;
+    ret.append(char(0));
+    ret.append(char(block.size()));
+    ret.append(char(block.size() >> 8));
+    ret.append(char(0));
+    return ret + block;
+}
+
+void BenchUwsgi::request_data()
+{
+    QTest::addColumn<QString>("socket");
+    QTest::addColumn<QByteArray>("data");
+
+    // What nginx sends from its default fastcgi_params and uwsgi_params
+    const QList<std::pair<QByteArray, QByteArray>> vars = {
+        {"QUERY_STRING"_ba, {}},
+        {"REQUEST_METHOD"_ba, "GET"_ba},
+        {"CONTENT_TYPE"_ba, {}},
+        {"CONTENT_LENGTH"_ba, {}},
+        {"REQUEST_URI"_ba, "/hello"_ba},
+        {"PATH_INFO"_ba, "/hello"_ba},
+        {"DOCUMENT_ROOT"_ba, "/usr/share/nginx/html"_ba},
+        {"SERVER_PROTOCOL"_ba, "HTTP/1.1"_ba},
+        {"REQUEST_SCHEME"_ba, "http"_ba},
+        {"REMOTE_ADDR"_ba, "127.0.0.1"_ba},
+        {"REMOTE_PORT"_ba, "51234"_ba},
+        {"SERVER_PORT"_ba, "80"_ba},
+        {"SERVER_NAME"_ba, "localhost"_ba},
+        {"HTTP_HOST"_ba, "localhost"_ba},
+        {"HTTP_USER_AGENT"_ba, "Mozilla/5.0 (X11; Linux x86_64; rv:140.0) Gecko/20100101"_ba},
+        {"HTTP_ACCEPT"_ba, "text/html,application/xhtml+xml,application/xml;q=0.9"_ba},
+        {"HTTP_ACCEPT_ENCODING"_ba, "gzip, deflate, br"_ba},
+    };
+
+    QTest::addRow("fastcgi") << m_dir.filePath(u"fastcgi.sock"_s) << fastcgiRequest(vars);
+    QTest::addRow("uwsgi") << m_dir.filePath(u"uwsgi.sock"_s) << uwsgiRequest(vars);
+}
+
+void BenchUwsgi::request()
+{
+    QFETCH(QString, socket);
+    QFETCH(QByteArray, data);
+
+    // Both frontends close the connection once the response is complete
+    QByteArray reply;
+    QBENCHMARK {
+        QLocalSocket sock;
+        QEventLoop loop;
+        connect(&sock, &QLocalSocket::disconnected, &loop, &QEventLoop::quit);
+
+        sock.connectToServer(socket);
+        QVERIFY(sock.waitForConnected());
+        sock.write(data);
+
+        // The server runs on this thread, qWaitFor() would add its polling interval
+        loop.exec();
+        reply = sock.readAll();
+    }
+
+    QVERIFY(reply.contains("Hello World!"));
+}
+
+QTEST_MAIN(BenchUwsgi)
+
+#include "benchuwsgi.moc"
+
+#endif // BENCHUWSGI_H
@@ -0,0 +1,133 @@
+#ifndef BENCHWEBSOCKETDEFLATE_H
+#define BENCHWEBSOCKETDEFLATE_H
+
+#include "websocketdeflate.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTest>
+
+using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
+
+class BenchWebSocketDeflate : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BenchWebSocketDeflate(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void compress_data();
+    void compress();
+    void decompress_data();
+    void decompress();
+
+private:
+    static QList<QByteArray> feedMessages(int items);
+};
+
+QList<QByteArray> BenchWebSocketDeflate::feedMessages(int items)
+{
+    // Realtime feed like messages, similar but not identical
+    QList<QByteArray> ret;
+    for (int i = 0; i < 64; ++i) {
+        QJsonArray quotes;
+        for (int j = 0; j < items; ++j) {
+            quotes.append(QJsonObject{
+                {u"symbol"_s, u"SYM%1"_s.arg(j)},
+                {u"price"_s, 100.0 + ((i * 31 + j * 17) % 1000) / 100.0},
+                {u"volume"_s, (i + 1) * (j + 3) * 7},
+                {u"change"_s, ((i * 7 + j) % 21 - 10) / 10.0},
+            });
+        }
+        const QJsonObject message{
+            {u"type"_s, u"quotes"_s},
+            {u"sequence"_s, i},
+            {u"quotes"_s, quotes},
+        };
+        ret.append(QJsonDocument(message).toJson(QJsonDocument::Compact));
+    }
+    return ret;
+}
+
+void BenchWebSocketDeflate::compress_data()
+{
+    QTest::addColumn<int>("items");
+    QTest::addColumn<int>("windowBits");
+    QTest::addColumn<int>("memLevel");
+    QTest::addColumn<bool>("noContextTakeover");
+
+    for (int items : {2, 200}) {
+        QTest::addRow("%d-items-default", items) << items << 15 << 8 << false;
+        QTest::addRow("%d-items-no-context-takeover", items) << items << 15 << 8 << true;
+        QTest::addRow("%d-items-low-memory", items) << items << 10 << 4 << false;
+    }
+}
+
+void BenchWebSocketDeflate::compress()
+{
+    QFETCH(int, items);
+    QFETCH(int, windowBits);
+    QFETCH(int, memLevel);
+    QFETCH(bool, noContextTakeover);
+
+    const QList<QByteArray> messages = feedMessages(items);
+    WebSocketDeflate deflate(windowBits, 15, memLevel, noContextTakeover, false);
+
+    QByteArray out;
+    qint64 inBytes  = 0;
+    qint64 outBytes = 0;
+    int ix          = 0;
+    QBENCHMARK {
+        const QByteArray &message = messages.at(ix++ % messages.size());
+        QVERIFY(deflate.compress(message, out));
+        inBytes += message.size();
+        outBytes += out.size();
+    }
+
+    qInfo().nospace() << "bytes per message " << inBytes / ix << " -> " << outBytes / ix << " ("
+                      << (outBytes * 100 / inBytes) << "%)";
+}
+
+void BenchWebSocketDeflate::decompress_data()
+{
+    QTest::addColumn<int>("items");
+
+    QTest::addRow("2-items") << 2;
+    QTest::addRow("200-items") << 200;
+}
+
+void BenchWebSocketDeflate::decompress()
+{
+    QFETCH(int, items);
+
+    // Compressed independently so they can be inflated in any order
+    const QList<QByteArray> messages = feedMessages(items);
+    WebSocketDeflate deflate(15, 15, 8, true, false);
+    QList<QByteArray> compressed;
+    for (const auto &message : messages) {
+        QByteArray out;
+        QVERIFY(deflate.compress(message, out));
+        compressed.append(out);
+    }
+
+    WebSocketDeflate inflate(15, 15, 8, false, true);
+    QByteArray out;
+    int ix = 0;
+    QBENCHMARK {
+        out.clear();
+        const int current = ix++ % compressed.size();
+        QVERIFY(inflate.decompress(compressed.at(current), true, out, 1024 * 1024));
+        QCOMPARE(out.size(), messages.at(current).size());
+    }
+}
+
+QTEST_MAIN(BenchWebSocketDeflate)
+
+#include "benchwebsocketdeflate.moc"
+
+#endif // BENCHWEBSOCKETDEFLATE_H
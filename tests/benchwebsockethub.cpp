@@ -0,0 +1,152 @@
+#ifndef BENCHWEBSOCKETHUB_H
+#define BENCHWEBSOCKETHUB_H
+
+#include "context_p.h"
+
+#include <Cutelyst/websockethub.h>
+
+#include <QElapsedTimer>
+#include <QTest>
+#include <QThread>
+
+using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
+
+class BenchRequest final : public EngineRequest
+{
+public:
+    bool webSocketSendFrame(const QByteArray &frame) override
+    {
+        bytes += frame.size();
+        return true;
+    }
+
+    qint64 bytes = 0;
+
+protected:
+    qint64 doWrite(const char *, qint64 len) override { return len; }
+    bool writeHeaders(quint16, const Headers &) override { return true; }
+};
+
+class BenchContext final : public Context
+{
+public:
+    explicit BenchContext(ContextPrivate *priv)
+        : Context(priv)
+    {
+    }
+};
+
+// Owns the subscribers of one thread
+class SubscriberGroup : public QObject
+{
+    Q_OBJECT
+public:
+    void subscribe(int count)
+    {
+        for (int i = 0; i < count; ++i) {
+            auto request        = new BenchRequest;
+            auto priv           = new ContextPrivate(nullptr, nullptr, nullptr, {});
+            request->context    = new BenchContext(priv);
+            priv->engineRequest = request;
+            requests.append(request);
+            WebSocketHub::instance()->subscribe(request->context, u"bench"_s);
+        }
+    }
+
+    void clear()
+    {
+        // Deletes the contexts as well
+        qDeleteAll(requests);
+        requests.clear();
+    }
+
+    QList<BenchRequest *> requests;
+};
+
+class BenchWebSocketHub : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BenchWebSocketHub(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void publish_data();
+    void publish();
+};
+
+void BenchWebSocketHub::publish_data()
+{
+    QTest::addColumn<int>("subscribers");
+    QTest::addColumn<int>("threads");
+    QTest::addColumn<int>("size");
+
+    for (int subscribers : {10000, 100000}) {
+        for (int threads : {1, 4}) {
+            QTest::addRow("%d-subscribers-%d-threads-small", subscribers, threads)
+                << subscribers << threads << 64;
+            QTest::addRow("%d-subscribers-%d-threads-large", subscribers, threads)
+                << subscribers << threads << 16 * 1024;
+        }
+    }
+}
+
+void BenchWebSocketHub::publish()
+{
+    QFETCH(int, subscribers);
+    QFETCH(int, threads);
+    QFETCH(int, size);
+
+    QList<QThread *> workers;
+    QList<SubscriberGroup *> groups;
+    for (int i = 0; i < threads; ++i) {
+        auto thread = new QThread;
+        auto group  = new SubscriberGroup;
+        group->moveToThread(thread);
+        thread->start();
+        QMetaObject::invokeMethod(
+            group,
+            [group, count = subscribers / threads] { group->subscribe(count); },
+            Qt::BlockingQueuedConnection);
+        workers.append(thread);
+        groups.append(group);
+    }
+
+    WebSocketHub *hub     = WebSocketHub::instance();
+    const QString message = QString(size, u'x');
+    quint64 target        = hub->delivered();
+    qint64 published      = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        hub->publishText(u"bench"_s, message);
+        target += quint64(subscribers / threads * threads);
+        while (hub->delivered() < target) {
+            QThread::yieldCurrentThread();
+        }
+        ++published;
+    }
+    const qint64 elapsed = qMax(timer.nsecsElapsed(), qint64(1));
+
+    qInfo().nospace() << published * (subscribers / threads * threads) * 1000000000 / elapsed
+                      << " messages/s delivered";
+
+    for (int i = 0; i < threads; ++i) {
+        QMetaObject::invokeMethod(
+            groups[i], [group = groups[i]] { group->clear(); }, Qt::BlockingQueuedConnection);
+        workers[i]->quit();
+        workers[i]->wait();
+        delete groups[i];
+        delete workers[i];
+    }
+}
+
+QTEST_MAIN(BenchWebSocketHub)
+
+#include "benchwebsockethub.moc"
+
+#endif // BENCHWEBSOCKETHUB_H
@@ -0,0 +1,112 @@
+#ifndef BENCHWEBSOCKETUNMASK_H
+#define BENCHWEBSOCKETUNMASK_H
+
+#include "protocolwebsocket.h"
+
+#include <QTest>
+
+using namespace Cutelyst;
+
+class BenchWebSocketUnmask : public QObject
+{
+    Q_OBJECT
+public:
+    explicit BenchWebSocketUnmask(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void unmask_data();
+    void unmask();
+    void unmaskChunked_data();
+    void unmaskChunked();
+
+private:
+    static void unmaskBytewise(char *data, qint64 len, quint32 mask, quint64 offset);
+};
+
+// The per byte loop used before, kept as a baseline and to verify the results
+void BenchWebSocketUnmask::unmaskBytewise(char *data, qint64 len, quint32 mask, quint64 offset)
+{
+    const auto *bytes = reinterpret_cast<const quint8 *>(&mask);
+    for (qint64 i = 0; i < len; ++i) {
+        data[i] = char(data[i] ^ bytes[(offset + quint64(i)) % 4]);
+    }
+}
+
+void BenchWebSocketUnmask::unmask_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<bool>("bytewise");
+
+    for (int size : {16, 125, 4 * 1024, 64 * 1024, 1024 * 1024}) {
+        QTest::addRow("%d-bytes-bytewise", size) << size << true;
+        QTest::addRow("%d-bytes-vectorized", size) << size << false;
+    }
+}
+
+void BenchWebSocketUnmask::unmask()
+{
+    QFETCH(int, size);
+    QFETCH(bool, bytewise);
+
+    const quint32 mask = 0x9a3c17e5;
+    QByteArray payload(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i) {
+        payload[i] = char(i * 7);
+    }
+
+    QByteArray expected = payload;
+    unmaskBytewise(expected.data(), expected.size(), mask, 0);
+
+    QByteArray data = payload;
+    websocket_unmask(data.data(), data.size(), mask, 0);
+    QCOMPARE(data, expected);
+
+    QBENCHMARK {
+        if (bytewise) {
+            unmaskBytewise(data.data(), data.size(), mask, 0);
+        } else {
+            websocket_unmask(data.data(), data.size(), mask, 0);
+        }
+    }
+}
+
+void BenchWebSocketUnmask::unmaskChunked_data()
+{
+    QTest::addColumn<int>("chunk");
+
+    // Large payloads arrive in socket sized pieces at arbitrary offsets
+    QTest::addRow("1461-bytes-chunks") << 1461;
+    QTest::addRow("16381-bytes-chunks") << 16381;
+}
+
+void BenchWebSocketUnmask::unmaskChunked()
+{
+    QFETCH(int, chunk);
+
+    const quint32 mask = 0x9a3c17e5;
+    QByteArray payload(1024 * 1024, Qt::Uninitialized);
+    for (int i = 0; i < payload.size(); ++i) {
+        payload[i] = char(i * 13);
+    }
+
+    QByteArray expected = payload;
+    unmaskBytewise(expected.data(), expected.size(), mask, 0);
+
+    QBENCHMARK {
+        QByteArray data = payload;
+        for (qsizetype offset = 0; offset < data.size(); offset += chunk) {
+            const qsizetype len = qMin(qsizetype(chunk), data.size() - offset);
+            websocket_unmask(data.data() + offset, len, mask, quint64(offset));
+        }
+        QCOMPARE(data, expected);
+    }
+}
+
+QTEST_MAIN(BenchWebSocketUnmask)
+
+#include "benchwebsocketunmask.moc"
+
+#endif // BENCHWEBSOCKETUNMASK_H
@@ -0,0 +1,166 @@
+#include "serverprocess.h"
+
+#include <Cutelyst/Response>
+
+#include <QJsonDocument>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTest>
+
+#include <csignal>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace Cutelyst;
+using namespace Qt::StringLiterals;
+
+void CountersController::counters(Context *c)
+{
+    auto server = qobject_cast<Server *>(c->app()->parent());
+    c->response()->setJsonObjectBody(QJsonObject::fromVariantMap(server->counters()));
+}
+
+ServerProcess::ServerProcess()
+    : m_port(freePort())
+{
+}
+
+ServerProcess::~ServerProcess()
+{
+    stop();
+}
+
+quint16 ServerProcess::freePort()
+{
+    // Closed right away, the server binds it again with SO_REUSEADDR
+    QTcpServer server;
+    if (!server.listen(QHostAddress::LocalHost, 0)) {
+        return 0;
+    }
+    return server.serverPort();
+}
+
+bool ServerProcess::start(const Configure &configure, const CreateApplication &createApplication)
+{
+    int ready[2];
+    if (pipe(ready) != 0) {
+        return false;
+    }
+
+    m_pid = fork();
+    if (m_pid == -1) {
+        close(ready[0]);
+        close(ready[1]);
+        return false;
+    }
+
+    if (m_pid == 0) {
+        close(ready[0]);
+
+        auto server = new Server;
+        server->setHttpSocket({u"127.0.0.1:%1"_s.arg(m_port)});
+        server->setMaster(true);
+        configure(server);
+
+        // Emitted by each worker process once its engines accept connections
+        const int readyFd = ready[1];
+        QObject::connect(server, &Server::ready, server, [readyFd] {
+            const qint64 pid   = getpid();
+            const auto written = write(readyFd, &pid, sizeof(pid));
+            Q_UNUSED(written)
+        });
+
+        _exit(server->exec(createApplication(server)));
+    }
+
+    close(ready[1]);
+    m_readyFd = ready[0];
+    fcntl(m_readyFd, F_SETFL, O_NONBLOCK);
+    return true;
+}
+
+QList<qint64> ServerProcess::waitForWorkers(int count, std::chrono::milliseconds timeout)
+{
+    QList<qint64> ret;
+    QTest::qWaitFor(
+        [this, count, &ret] {
+            qint64 pid;
+            while (ret.size() < count && read(m_readyFd, &pid, sizeof(pid)) == sizeof(pid)) {
+                ret.push_back(pid);
+            }
+            return ret.size() == count;
+        },
+        int(timeout.count()));
+    return ret;
+}
+
+void ServerProcess::signal(int signal) const
+{
+    if (m_pid > 0) {
+        ::kill(m_pid, signal);
+    }
+}
+
+int ServerProcess::stop()
+{
+    if (m_pid <= 0) {
+        return -1;
+    }
+
+    ::kill(m_pid, SIGINT);
+    int status = 0;
+    waitpid(m_pid, &status, 0);
+    m_pid = -1;
+
+    close(m_readyFd);
+    m_readyFd = -1;
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int ServerProcess::waitForExit(std::chrono::milliseconds timeout)
+{
+    if (m_pid <= 0) {
+        return -1;
+    }
+
+    int status = 0;
+    if (!QTest::qWaitFor([this, &status] { return waitpid(m_pid, &status, WNOHANG) == m_pid; },
+                         int(timeout.count()))) {
+        return -1;
+    }
+    m_pid = -1;
+
+    close(m_readyFd);
+    m_readyFd = -1;
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+QByteArray ServerProcess::get(const QByteArray &path, const QByteArray &extraHeaders) const
+{
+    QTcpSocket sock;
+    sock.connectToHost(u"127.0.0.1"_s, m_port);
+    if (!sock.waitForConnected(1000)) {
+        return {};
+    }
+
+    sock.write("GET " + path + " HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n" +
+               extraHeaders + "\r\n");
+    // The server closes the connection once the reply is written
+    QByteArray reply;
+    while (sock.waitForReadyRead(5000)) {
+        reply.append(sock.readAll());
+    }
+
+    const qsizetype headersEnd = reply.indexOf("\r\n\r\n");
+    return headersEnd == -1 ? QByteArray{} : reply.mid(headersEnd + 4);
+}
+
+QJsonObject ServerProcess::counters() const
+{
+    return QJsonDocument::fromJson(get("/counters")).object();
+}
+
+#include "moc_serverprocess.cpp"
@@ -0,0 +1,104 @@
+#ifndef SERVERPROCESS_H
+#define SERVERPROCESS_H
+
+#include <Cutelyst/Application>
+#include <Cutelyst/Context>
+#include <Cutelyst/Controller>
+#include <Cutelyst/Server/server.h>
+
+#include <QJsonObject>
+#include <QList>
+
+#include <chrono>
+#include <functional>
+
+#include <sys/types.h>
+
+/**
+ * Answers /counters with the counters of the server, as JSON.
+ */
+class CountersController : public Cutelyst::Controller
+{
+    Q_OBJECT
+    C_NAMESPACE("")
+public:
+    explicit CountersController(QObject *parent)
+        : Controller(parent)
+    {
+    }
+
+    C_ATTR(counters, :Local :AutoArgs)
+    void counters(Cutelyst::Context *c);
+};
+
+/**
+ * Runs a server with a master process in a child of the test, so that the test can put load
+ * on its workers and send signals to it. Every worker process writes its pid to a pipe once
+ * it is ready, so the test waits for workers instead of polling the server.
+ */
+class ServerProcess
+{
+public:
+    using Configure         = std::function<void(Cutelyst::Server *server)>;
+    using CreateApplication = std::function<Cutelyst::Application *(Cutelyst::Server *server)>;
+
+    // Listens on a free port, kept across restarts
+    ServerProcess();
+    ~ServerProcess();
+
+    /**
+     * Returns a port nothing listens on, picked by the kernel, so tests running in
+     * parallel don't collide.
+     */
+    static quint16 freePort();
+
+    /**
+     * Forks the master, which listens for HTTP on port(), is configured by \a configure and
+     * runs the application created by \a createApplication.
+     */
+    bool start(const Configure &configure, const CreateApplication &createApplication);
+
+    /**
+     * Waits up to \a timeout for \a count more workers to be ready, either started or
+     * respawned, and returns their pids. Events are processed meanwhile.
+     */
+    QList<qint64> waitForWorkers(int count,
+                                 std::chrono::milliseconds timeout = std::chrono::seconds{20});
+
+    /**
+     * Sends \a signal to the master.
+     */
+    void signal(int signal) const;
+
+    /**
+     * Stops the master with SIGINT and waits for it to exit, returns its exit code.
+     */
+    int stop();
+
+    /**
+     * Waits up to \a timeout for the master to exit on its own, returns its exit code or -1
+     * if it is still running. Events are processed meanwhile.
+     */
+    int waitForExit(std::chrono::milliseconds timeout = std::chrono::seconds{20});
+
+    [[nodiscard]] pid_t pid() const { return m_pid; }
+    [[nodiscard]] quint16 port() const { return m_port; }
+
+    /**
+     * Returns the body of the reply to a GET of \a path on a new connection, adding
+     * \a extraHeaders to the request, or an empty one if the server can't be reached.
+     */
+    QByteArray get(const QByteArray &path, const QByteArray &extraHeaders = {}) const;
+
+    /**
+     * Returns the counters, the application must have a CountersController.
+     */
+    QJsonObject counters() const;
+
+private:
+    pid_t m_pid    = -1;
+    int m_readyFd  = -1;
+    quint16 m_port = 0;
+};
+
+#endif // SERVERPROCESS_H
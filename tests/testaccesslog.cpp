@@ -0,0 +1,150 @@
+#ifndef TESTACCESSLOG_H
+#define TESTACCESSLOG_H
+
+#include "coverageobject.h"
+#include "serverprocess.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <csignal>
+
+namespace {
+constexpr int Requests = 10;
+} // namespace
+
+class AccessLogController : public Controller
+{
+    Q_OBJECT
+    C_NAMESPACE("")
+public:
+    explicit AccessLogController(QObject *parent)
+        : Controller(parent)
+    {
+    }
+
+    C_ATTR(hello, :Local :AutoArgs)
+    void hello(Context *c)
+    {
+        c->response()->setHeader("X-Reply"_ba, "done"_ba);
+        c->response()->setBody("Hello World!"_ba);
+    }
+};
+
+class AccessLogApplication : public Application
+{
+    Q_OBJECT
+public:
+    explicit AccessLogApplication(QObject *parent = nullptr)
+        : Application(parent)
+    {
+    }
+
+    bool init() override
+    {
+        new AccessLogController(this);
+        return true;
+    }
+};
+
+class TestAccessLog : public CoverageObject
+{
+    Q_OBJECT
+public:
+    explicit TestAccessLog(QObject *parent = nullptr)
+        : CoverageObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void testFormat();
+    void testReopen();
+    void cleanupTestCase();
+
+private:
+    QByteArrayList lines(const QString &path, const QByteArray &containing);
+
+    ServerProcess m_server;
+    QTemporaryDir m_dir;
+    QString m_logPath;
+};
+
+void TestAccessLog::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    m_logPath = m_dir.filePath(u"access.log"_s);
+
+    QVERIFY(m_server.start(
+        [this](Server *server) {
+            server->setProcesses(u"2"_s);
+            server->setAccessLog(m_logPath);
+            server->setAccessLogFormat(
+                uR"($request_method ${uri}?$args $status "$request" )"
+                uR"($http_x_test $sent_http_x_reply $upstream_response_time)"_s);
+        },
+        [](Server *server) { return new AccessLogApplication(server); }));
+
+    QCOMPARE(m_server.waitForWorkers(2).size(), 2);
+}
+
+void TestAccessLog::testFormat()
+{
+    for (int i = 0; i < Requests; ++i) {
+        QCOMPARE(m_server.get("/hello?n=" + QByteArray::number(i), "X-Test: a\"b\r\n"_ba),
+                 "Hello World!"_ba);
+    }
+
+    // Written by the background thread of each worker
+    QTRY_COMPARE(lines(m_logPath, "?n="_ba).size(), Requests);
+
+    const QByteArrayList logged = lines(m_logPath, "?n=3 "_ba);
+    QCOMPARE(logged.size(), 1);
+    QVERIFY(logged.first().startsWith(
+        R"(GET /hello?n=3 200 "GET /hello?n=3 HTTP/1.1" a\x22b done )"));
+    // Seconds taken by the application, with a milliseconds resolution
+    QVERIFY(logged.first().endsWith(".000") || logged.first().split(' ').last().toDouble() > 0);
+}
+
+void TestAccessLog::testReopen()
+{
+    const QString rotated = m_logPath + u".1"_s;
+    QVERIFY(QFile::rename(m_logPath, rotated));
+
+    // The master forwards it to the workers
+    m_server.signal(SIGUSR1);
+    QTRY_VERIFY(QFile::exists(m_logPath));
+
+    QCOMPARE(m_server.get("/hello?rotated=1"), "Hello World!"_ba);
+    QTRY_COMPARE(lines(m_logPath, "?rotated=1 "_ba).size(), 1);
+    QVERIFY(lines(rotated, "?rotated=1 "_ba).isEmpty());
+}
+
+void TestAccessLog::cleanupTestCase()
+{
+    m_server.stop();
+}
+
+QByteArrayList TestAccessLog::lines(const QString &path, const QByteArray &containing)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    QByteArrayList ret;
+    const QByteArrayList all = file.readAll().split('\n');
+    for (const QByteArray &line : all) {
+        if (line.contains(containing)) {
+            ret.append(line);
+        }
+    }
+    return ret;
+}
+
+QTEST_MAIN(TestAccessLog)
+
+#include "testaccesslog.moc"
+
+#endif // TESTACCESSLOG_H
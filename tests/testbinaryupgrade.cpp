@@ -0,0 +1,166 @@
+#ifndef TESTBINARYUPGRADE_H
+#define TESTBINARYUPGRADE_H
+
+#include "coverageobject.h"
+#include "serverprocess.h"
+
+#include <QTest>
+
+#include <csignal>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef Q_OS_LINUX
+#    include <sys/prctl.h>
+#endif
+
+namespace {
+// Same as SD_LISTEN_FDS_START, where the new master finds the inherited sockets
+constexpr int ListenFdsStart = 3;
+
+// The port the first inherited descriptor listens on, or 0
+quint16 inheritedPort()
+{
+    sockaddr_in addr{};
+    socklen_t len    = sizeof(addr);
+    int listening    = 0;
+    socklen_t optLen = sizeof(listening);
+    if (getsockname(ListenFdsStart, reinterpret_cast<sockaddr *>(&addr), &len) != 0 ||
+        getsockopt(ListenFdsStart, SOL_SOCKET, SO_ACCEPTCONN, &listening, &optLen) != 0 ||
+        !listening) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+void configureServer(Server *server)
+{
+    server->setProcesses(u"2"_s);
+}
+} // namespace
+
+class UpgradeController : public Controller
+{
+    Q_OBJECT
+    C_NAMESPACE("")
+public:
+    explicit UpgradeController(QObject *parent)
+        : Controller(parent)
+    {
+    }
+
+    C_ATTR(master, :Local :AutoArgs)
+    void master(Context *c) { c->response()->setBody(QByteArray::number(getppid())); }
+
+    C_ATTR(listenfd, :Local :AutoArgs)
+    void listenfd(Context *c)
+    {
+        const quint16 port = inheritedPort();
+        c->response()->setBody(port ? QByteArray::number(port) : "none"_ba);
+    }
+};
+
+class UpgradeApplication : public Application
+{
+    Q_OBJECT
+public:
+    explicit UpgradeApplication(QObject *parent = nullptr)
+        : Application(parent)
+    {
+    }
+
+    bool init() override
+    {
+        new UpgradeController(this);
+        return true;
+    }
+};
+
+class TestBinaryUpgrade : public CoverageObject
+{
+    Q_OBJECT
+public:
+    explicit TestBinaryUpgrade(QObject *parent = nullptr)
+        : CoverageObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void testUpgrade();
+    void cleanupTestCase();
+
+private:
+    ServerProcess m_server;
+    qint64 m_newMaster = 0;
+};
+
+void TestBinaryUpgrade::initTestCase()
+{
+#ifdef Q_OS_LINUX
+    // The new master outlives its parent, the old master, it's reaped here
+    QCOMPARE(prctl(PR_SET_CHILD_SUBREAPER, 1), 0);
+#else
+    QSKIP("The new master can only be reaped on Linux");
+#endif
+
+    QVERIFY(m_server.start(configureServer,
+                           [](Server *server) { return new UpgradeApplication(server); }));
+    QCOMPARE(m_server.waitForWorkers(2).size(), 2);
+}
+
+void TestBinaryUpgrade::testUpgrade()
+{
+    const qint64 oldMaster = m_server.pid();
+    QCOMPARE(m_server.get("/master").toLongLong(), oldMaster);
+
+    // Execs this binary again, which runs the server from main() as it sees the upgrade
+    m_server.signal(SIGUSR2);
+
+    // The old master exits once the workers of the new one are ready
+    QCOMPARE(m_server.waitForExit(), 0);
+
+    m_newMaster = m_server.get("/master").toLongLong();
+    QVERIFY(m_newMaster > 0);
+    QVERIFY(m_newMaster != oldMaster);
+
+    // Requests are served from the listening socket the old master handed over
+    QCOMPARE(m_server.get("/listenfd"), QByteArray::number(m_server.port()));
+    for (int i = 0; i < 10; ++i) {
+        QCOMPARE(m_server.get("/master").toLongLong(), m_newMaster);
+    }
+}
+
+void TestBinaryUpgrade::cleanupTestCase()
+{
+    if (m_newMaster > 0) {
+        ::kill(pid_t(m_newMaster), SIGINT);
+        int status = 0;
+        QCOMPARE(waitpid(pid_t(m_newMaster), &status, 0), pid_t(m_newMaster));
+    }
+    m_server.stop();
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    if (qEnvironmentVariableIsSet("CUTELYST_UPGRADE_PID")) {
+        // Started by the old master, same server it runs but with the inherited sockets
+        auto server = new Server;
+        server->setHttpSocket({u"127.0.0.1:%1"_s.arg(inheritedPort())});
+        server->setMaster(true);
+        configureServer(server);
+        return server->exec(new UpgradeApplication(server));
+    }
+
+    TestBinaryUpgrade test;
+    QTEST_SET_MAIN_SOURCE_PATH
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "testbinaryupgrade.moc"
+
+#endif // TESTBINARYUPGRADE_H
@@ -0,0 +1,143 @@
+#ifndef TESTCHEAPER_H
+#define TESTCHEAPER_H
+
+#include "coverageobject.h"
+#include "serverprocess.h"
+
+#include <QElapsedTimer>
+#include <QTcpSocket>
+#include <QTest>
+
+namespace {
+constexpr int Clients = 8;
+
+const QByteArray BusyRequest = "GET /busy HTTP/1.1\r\nHost: localhost\r\n\r\n"_ba;
+} // namespace
+
+class CheaperController : public Controller
+{
+    Q_OBJECT
+    C_NAMESPACE("")
+public:
+    explicit CheaperController(QObject *parent)
+        : Controller(parent)
+    {
+    }
+
+    // Keeps the event loop busy like a CPU bound action would
+    C_ATTR(busy, :Local :AutoArgs)
+    void busy(Context *c)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        while (!timer.hasExpired(20)) {
+        }
+        c->response()->setBody("busy"_ba);
+    }
+};
+
+class CheaperApplication : public Application
+{
+    Q_OBJECT
+public:
+    explicit CheaperApplication(QObject *parent = nullptr)
+        : Application(parent)
+    {
+    }
+
+    bool init() override
+    {
+        new CheaperController(this);
+        new CountersController(this);
+        return true;
+    }
+};
+
+class TestCheaper : public CoverageObject
+{
+    Q_OBJECT
+public:
+    explicit TestCheaper(QObject *parent = nullptr)
+        : CoverageObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void testScaling();
+    void cleanupTestCase();
+
+private:
+    int workers();
+    void startLoad();
+    void stopLoad();
+
+    ServerProcess m_server;
+    QList<QTcpSocket *> m_clients;
+};
+
+void TestCheaper::initTestCase()
+{
+    // The master and its workers run apart, this process only generates load
+    QVERIFY(m_server.start(
+        [](Server *server) {
+            server->setProcesses(u"3"_s);
+            server->setCheaper(1);
+            server->setCheaperCooldown(1);
+        },
+        [](Server *server) { return new CheaperApplication(server); }));
+
+    QCOMPARE(m_server.waitForWorkers(1).size(), 1);
+    QCOMPARE(workers(), 1);
+}
+
+void TestCheaper::testScaling()
+{
+    // A single worker can't keep up with the clients
+    startLoad();
+    QCOMPARE(m_server.waitForWorkers(1).size(), 1);
+    QVERIFY(workers() > 1);
+
+    // Once idle the extra workers are stopped
+    stopLoad();
+    QTRY_COMPARE_WITH_TIMEOUT(workers(), 1, 30000);
+}
+
+void TestCheaper::cleanupTestCase()
+{
+    stopLoad();
+    m_server.stop();
+}
+
+int TestCheaper::workers()
+{
+    return m_server.counters().value(u"workers"_s).toInt(-1);
+}
+
+void TestCheaper::startLoad()
+{
+    for (int i = 0; i < Clients; ++i) {
+        auto client = new QTcpSocket(this);
+        connect(client, &QTcpSocket::connected, client, [client] { client->write(BusyRequest); });
+        // The next request as soon as the previous one is answered
+        connect(client, &QTcpSocket::readyRead, client, [client] {
+            if (client->readAll().endsWith("busy")) {
+                client->write(BusyRequest);
+            }
+        });
+        client->connectToHost(u"127.0.0.1"_s, m_server.port());
+        m_clients.push_back(client);
+    }
+}
+
+void TestCheaper::stopLoad()
+{
+    qDeleteAll(m_clients);
+    m_clients.clear();
+}
+
+QTEST_MAIN(TestCheaper)
+
+#include "testcheaper.moc"
+
+#endif // TESTCHEAPER_H
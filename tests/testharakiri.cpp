@@ -0,0 +1,106 @@
+#ifndef TESTHARAKIRI_H
+#define TESTHARAKIRI_H
+
+#include "coverageobject.h"
+#include "serverprocess.h"
+
+#include <QTcpSocket>
+#include <QTest>
+#include <QThread>
+
+class HarakiriController : public Controller
+{
+    Q_OBJECT
+    C_NAMESPACE("")
+public:
+    explicit HarakiriController(QObject *parent)
+        : Controller(parent)
+    {
+    }
+
+    // Blocks its thread like a call without a timeout would
+    C_ATTR(stuck, :Local :AutoArgs)
+    void stuck(Context *c)
+    {
+        QThread::sleep(60);
+        c->response()->setBody("unstuck"_ba);
+    }
+};
+
+class HarakiriApplication : public Application
+{
+    Q_OBJECT
+public:
+    explicit HarakiriApplication(QObject *parent = nullptr)
+        : Application(parent)
+    {
+    }
+
+    bool init() override
+    {
+        new HarakiriController(this);
+        new CountersController(this);
+        return true;
+    }
+};
+
+class TestHarakiri : public CoverageObject
+{
+    Q_OBJECT
+public:
+    explicit TestHarakiri(QObject *parent = nullptr)
+        : CoverageObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void testStuckRequest();
+    void cleanupTestCase();
+
+private:
+    ServerProcess m_server;
+};
+
+void TestHarakiri::initTestCase()
+{
+    QVERIFY(m_server.start(
+        [](Server *server) {
+            server->setProcesses(u"2"_s);
+            server->setHarakiri(1);
+            // Longer than the test waits, stuck workers don't get it
+            server->setWorkerReloadMercy(60);
+        },
+        [](Server *server) { return new HarakiriApplication(server); }));
+
+    QCOMPARE(m_server.waitForWorkers(2).size(), 2);
+}
+
+void TestHarakiri::testStuckRequest()
+{
+    QTcpSocket stuck;
+    stuck.connectToHost(u"127.0.0.1"_s, m_server.port());
+    QVERIFY(stuck.waitForConnected(1000));
+    stuck.write("GET /stuck HTTP/1.1\r\nHost: localhost\r\n\r\n"_ba);
+    QVERIFY(stuck.waitForBytesWritten(1000));
+
+    // The stuck worker is replaced, then killed, so its connection is closed without a reply
+    QCOMPARE(m_server.waitForWorkers(1).size(), 1);
+    QCOMPARE(m_server.counters().value(u"harakiri"_s).toInt(), 1);
+    QTRY_COMPARE_WITH_TIMEOUT(stuck.state(), QAbstractSocket::UnconnectedState, 20000);
+    QVERIFY(!stuck.readAll().contains("unstuck"));
+
+    QTRY_COMPARE_WITH_TIMEOUT(m_server.counters().value(u"workers"_s).toInt(), 2, 20000);
+    QCOMPARE(m_server.counters().value(u"workers_ready"_s).toInt(), 2);
+}
+
+void TestHarakiri::cleanupTestCase()
+{
+    m_server.stop();
+}
+
+QTEST_MAIN(TestHarakiri)
+
+#include "testharakiri.moc"
+
+#endif // TESTHARAKIRI_H
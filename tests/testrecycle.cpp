@@ -0,0 +1,205 @@
+#ifndef TESTRECYCLE_H
+#define TESTRECYCLE_H
+
+#include "coverageobject.h"
+#include "serverprocess.h"
+
+#include <QFile>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <csignal>
+#include <unistd.h>
+
+namespace {
+constexpr int MaxRequests = 20;
+constexpr int Requests    = MaxRequests * 4;
+
+// Workers fail to start while this file exists
+QString failMarker;
+} // namespace
+
+class RecycleController : public Controller
+{
+    Q_OBJECT
+    C_NAMESPACE("")
+public:
+    explicit RecycleController(QObject *parent)
+        : Controller(parent)
+    {
+    }
+
+    C_ATTR(pid, :Local :AutoArgs)
+    void pid(Context *c) { c->response()->setBody(QByteArray::number(getpid())); }
+};
+
+class RecycleApplication : public Application
+{
+    Q_OBJECT
+public:
+    explicit RecycleApplication(QObject *parent = nullptr)
+        : Application(parent)
+    {
+    }
+
+    bool init() override
+    {
+        new RecycleController(this);
+        new CountersController(this);
+        return true;
+    }
+
+    bool postFork() override { return !QFile::exists(failMarker); }
+};
+
+class TestRecycle : public CoverageObject
+{
+    Q_OBJECT
+public:
+    explicit TestRecycle(QObject *parent = nullptr)
+        : CoverageObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void testMaxRequests();
+    void testMetrics();
+    void testReplacementFails();
+    void cleanupTestCase();
+
+private:
+    qint64 requestCount() const;
+
+    QTemporaryDir m_dir;
+    ServerProcess m_server;
+    QList<qint64> m_workers;
+};
+
+void TestRecycle::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    failMarker = m_dir.filePath(u"fail"_s);
+
+    QVERIFY(m_server.start(
+        [](Server *server) {
+            server->setProcesses(u"2"_s);
+            server->setMaxRequests(MaxRequests);
+            server->setMetrics(u"/metrics"_s);
+        },
+        [](Server *server) { return new RecycleApplication(server); }));
+
+    m_workers = m_server.waitForWorkers(2);
+    QCOMPARE(m_workers.size(), 2);
+}
+
+void TestRecycle::testMaxRequests()
+{
+    // More requests than both workers together may serve
+    QSet<QByteArray> pids;
+    for (int i = 0; i < Requests; ++i) {
+        pids.insert(m_server.get("/pid"));
+    }
+    pids.remove({});
+    QVERIFY(!pids.isEmpty());
+
+    // A worker reaching the limit is replaced once the new one is ready
+    const QList<qint64> replacements = m_server.waitForWorkers(1);
+    QCOMPARE(replacements.size(), 1);
+    QVERIFY(!m_workers.contains(replacements.first()));
+    QVERIFY(m_server.counters().value(u"recycles_max_requests"_s).toInt() > 0);
+
+    // The old worker is retired, the replacement serves requests
+    QTRY_COMPARE_WITH_TIMEOUT(m_server.counters().value(u"workers"_s).toInt(), 2, 20000);
+    QCOMPARE(m_server.counters().value(u"workers_ready"_s).toInt(), 2);
+    QTRY_VERIFY_WITH_TIMEOUT(m_server.get("/pid").toLongLong() == replacements.first(), 20000);
+}
+
+void TestRecycle::testMetrics()
+{
+    const qint64 recycles = m_server.counters().value(u"recycles_max_requests"_s).toInteger();
+    qint64 served         = 0;
+    qint64 last           = requestCount();
+    QVERIFY(last > 0);
+
+    // The histograms of recycled workers keep counting in the merged ones
+    for (int round = 0; round < 4; ++round) {
+        for (int i = 0; i < MaxRequests; ++i) {
+            if (!m_server.get("/pid").isEmpty()) {
+                ++served;
+            }
+        }
+
+        for (int i = 0; i < 10; ++i) {
+            const qint64 count = requestCount();
+            QCOMPARE_GE(count, last);
+            last = count;
+            QTest::qWait(100);
+        }
+    }
+
+    QVERIFY(m_server.counters().value(u"recycles_max_requests"_s).toInteger() > recycles);
+    QVERIFY(last >= served);
+}
+
+void TestRecycle::testReplacementFails()
+{
+    // A single worker, so it's the one reaching the limit
+    m_server.stop();
+    QVERIFY(m_server.start(
+        [](Server *server) {
+            server->setProcesses(u"1"_s);
+            server->setMaxRequests(MaxRequests);
+        },
+        [](Server *server) { return new RecycleApplication(server); }));
+    const QList<qint64> workers = m_server.waitForWorkers(1);
+    QCOMPARE(workers.size(), 1);
+    const qint64 old = workers.first();
+
+    QFile marker(failMarker);
+    QVERIFY(marker.open(QIODevice::WriteOnly));
+    marker.close();
+
+    for (int i = 0; i < MaxRequests * 2; ++i) {
+        QCOMPARE(m_server.get("/pid").toLongLong(), old);
+    }
+
+    // Its replacements exit during startup, it keeps serving meanwhile
+    QTest::qWait(6000);
+    QCOMPARE(m_server.get("/pid").toLongLong(), old);
+    QCOMPARE(m_server.counters().value(u"workers"_s).toInt(), 1);
+    QCOMPARE(m_server.counters().value(u"recycles_max_requests"_s).toInt(), 1);
+
+    // And it's still recycled once a replacement starts
+    QVERIFY(QFile::remove(failMarker));
+    const QList<qint64> replacements = m_server.waitForWorkers(1);
+    QCOMPARE(replacements.size(), 1);
+    QVERIFY(replacements.first() != old);
+    QTRY_VERIFY_WITH_TIMEOUT(::kill(pid_t(old), 0) != 0, 20000);
+    QTRY_VERIFY_WITH_TIMEOUT(m_server.get("/pid").toLongLong() == replacements.first(), 20000);
+}
+
+void TestRecycle::cleanupTestCase()
+{
+    m_server.stop();
+}
+
+qint64 TestRecycle::requestCount() const
+{
+    const QByteArray text = m_server.get("/metrics");
+    const QByteArray key  = "cutelyst_request_duration_seconds_count{action=\"pid\",status=\"2xx\","
+                           "protocol=\"http/1.1\"} ";
+    const qsizetype start = text.indexOf(key);
+    if (start == -1) {
+        return -1;
+    }
+    return text.mid(start + key.size(), text.indexOf('\n', start) - start - key.size())
+        .toLongLong();
+}
+
+QTEST_MAIN(TestRecycle)
+
+#include "testrecycle.moc"
+
+#endif // TESTRECYCLE_H
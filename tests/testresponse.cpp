@@ -38,6 +38,8 @@ private Q_SLOTS:
     void testController_data();
     void testController() { doTest(); }
 
+    void testEarlyHints();
+
     void cleanupTestCase();
 
 private:
@@ -223,6 +225,24 @@ public:
         QJsonArray array;
         c->response()->setJsonArrayBody(array);
     }
+
+    C_ATTR(earlyHints, :Local :AutoArgs)
+    void earlyHints(Context *c)
+    {
+        Headers hints;
+        hints.pushHeader("Link"_ba, "</style.css>; rel=preload; as=style"_ba);
+        c->response()->sendEarlyHints(hints);
+
+        hints.pushHeader("Link"_ba, "</script.js>; rel=preload; as=script"_ba);
+        c->response()->sendEarlyHints(hints);
+
+        // Writing finalizes the headers
+        c->response()->write("final");
+
+        if (c->response()->sendEarlyHints(hints)) {
+            c->response()->write(" unexpected hints");
+        }
+    }
 };
 
 void TestResponse::initTestCase()
@@ -243,6 +263,22 @@ TestEngine *TestResponse::getEngine()
     return engine;
 }
 
+void TestResponse::testEarlyHints()
+{
+    QByteArray body;
+    auto result =
+        m_engine->createRequest("GET"_ba, u"/response/test/earlyHints"_s, {}, {}, &body);
+
+    QCOMPARE(result.statusCode, 200);
+    QCOMPARE(result.body, "final"_ba);
+    QCOMPARE(result.earlyHints.size(), 2);
+    QCOMPARE(result.earlyHints.at(0).header("Link"),
+             "</style.css>; rel=preload; as=style"_ba);
+    QCOMPARE(result.earlyHints.at(1).headers("Link"),
+             QByteArrayList({"</style.css>; rel=preload; as=style"_ba,
+                             "</script.js>; rel=preload; as=script"_ba}));
+}
+
 void TestResponse::cleanupTestCase()
 {
     delete m_engine;
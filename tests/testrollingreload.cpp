@@ -0,0 +1,203 @@
+#ifndef TESTROLLINGRELOAD_H
+#define TESTROLLINGRELOAD_H
+
+#include "coverageobject.h"
+#include "serverprocess.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QThread>
+
+#include <csignal>
+#include <unistd.h>
+
+namespace {
+constexpr int Processes = 3;
+
+// Replacement workers fail to start while this file exists
+QString failMarker;
+
+bool isRunning(qint64 pid)
+{
+    return ::kill(pid_t(pid), 0) == 0;
+}
+} // namespace
+
+class RollingReloadController : public Controller
+{
+    Q_OBJECT
+    C_NAMESPACE("")
+public:
+    explicit RollingReloadController(QObject *parent)
+        : Controller(parent)
+    {
+    }
+
+    C_ATTR(pid, :Local :AutoArgs)
+    void pid(Context *c) { c->response()->setBody(QByteArray::number(getpid())); }
+
+    C_ATTR(stuck, :Local :AutoArgs)
+    void stuck(Context *c)
+    {
+        // Never drains, the master has to kill the worker
+        QThread::sleep(60);
+        c->response()->setBody("done"_ba);
+    }
+};
+
+class RollingReloadApplication : public Application
+{
+    Q_OBJECT
+public:
+    explicit RollingReloadApplication(QObject *parent = nullptr)
+        : Application(parent)
+    {
+    }
+
+    bool init() override
+    {
+        new RollingReloadController(this);
+        new CountersController(this);
+        return true;
+    }
+
+    bool postFork() override { return !QFile::exists(failMarker); }
+};
+
+class TestRollingReload : public CoverageObject
+{
+    Q_OBJECT
+public:
+    explicit TestRollingReload(QObject *parent = nullptr)
+        : CoverageObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void testReload();
+    void testStuckWorkerKilled();
+    void testAbortWhenNotReady();
+    void cleanupTestCase();
+
+private:
+    bool waitForReloads(int reloads);
+
+    QTemporaryDir m_dir;
+    ServerProcess m_server;
+    QList<qint64> m_workers;
+};
+
+void TestRollingReload::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    failMarker = m_dir.filePath(u"fail"_s);
+
+    QVERIFY(m_server.start(
+        [](Server *server) {
+            server->setProcesses(QString::number(Processes));
+            server->setRollingReload(1);
+            server->setWorkerReloadMercy(2);
+        },
+        [](Server *server) { return new RollingReloadApplication(server); }));
+
+    m_workers = m_server.waitForWorkers(Processes);
+    QCOMPARE(m_workers.size(), Processes);
+}
+
+bool TestRollingReload::waitForReloads(int reloads)
+{
+    return QTest::qWaitFor(
+        [this, reloads] {
+            const QJsonObject counters = m_server.counters();
+            return counters.value(u"reloads"_s).toInt() == reloads &&
+                   !counters.value(u"reload_in_progress"_s).toBool();
+        },
+        20000);
+}
+
+void TestRollingReload::testReload()
+{
+    m_server.signal(SIGHUP);
+
+    // Each old worker is only retired once its replacement is ready
+    const QList<qint64> replacements = m_server.waitForWorkers(Processes);
+    QCOMPARE(replacements.size(), Processes);
+    for (qint64 pid : replacements) {
+        QVERIFY(!m_workers.contains(pid));
+    }
+
+    QVERIFY(waitForReloads(1));
+    const QJsonObject counters = m_server.counters();
+    QCOMPARE(counters.value(u"reload_min_workers_ready"_s).toInt(), Processes);
+    QCOMPARE(counters.value(u"workers"_s).toInt(), Processes);
+    QCOMPARE(counters.value(u"workers_ready"_s).toInt(), Processes);
+
+    // The retired workers exited
+    for (qint64 pid : std::as_const(m_workers)) {
+        QTRY_VERIFY(!isRunning(pid));
+    }
+    m_workers = replacements;
+}
+
+void TestRollingReload::testStuckWorkerKilled()
+{
+    QTcpSocket stuck;
+    stuck.connectToHost(u"127.0.0.1"_s, m_server.port());
+    QVERIFY(stuck.waitForConnected(1000));
+    stuck.write("GET /stuck HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    QVERIFY(stuck.waitForBytesWritten(1000));
+    QTest::qWait(200);
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    m_server.signal(SIGHUP);
+
+    const QList<qint64> replacements = m_server.waitForWorkers(Processes);
+    QCOMPARE(replacements.size(), Processes);
+    QVERIFY(waitForReloads(2));
+
+    // Killed once the mercy is over, long before the request would finish
+    for (qint64 pid : std::as_const(m_workers)) {
+        QTRY_VERIFY_WITH_TIMEOUT(!isRunning(pid), 15000);
+    }
+    QVERIFY(elapsed.elapsed() < 30000);
+    QTRY_COMPARE(stuck.state(), QAbstractSocket::UnconnectedState);
+    QVERIFY(!stuck.readAll().contains("done"));
+
+    m_workers = replacements;
+}
+
+void TestRollingReload::testAbortWhenNotReady()
+{
+    QFile marker(failMarker);
+    QVERIFY(marker.open(QIODevice::WriteOnly));
+    marker.close();
+
+    m_server.signal(SIGHUP);
+    QVERIFY(waitForReloads(3));
+    QVERIFY(QFile::remove(failMarker));
+
+    // The replacement never got ready, so no old worker was retired
+    const QJsonObject counters = m_server.counters();
+    QCOMPARE(counters.value(u"workers"_s).toInt(), Processes);
+    QCOMPARE(counters.value(u"workers_ready"_s).toInt(), Processes);
+    for (qint64 pid : std::as_const(m_workers)) {
+        QVERIFY(isRunning(pid));
+    }
+    QVERIFY(m_server.waitForWorkers(1, std::chrono::milliseconds{500}).isEmpty());
+}
+
+void TestRollingReload::cleanupTestCase()
+{
+    m_server.stop();
+}
+
+QTEST_MAIN(TestRollingReload)
+
+#include "testrollingreload.moc"
+
+#endif // TESTROLLINGRELOAD_H
@@ -0,0 +1,218 @@
+#ifndef TESTSCOREBOARD_H
+#define TESTSCOREBOARD_H
+
+#include "coverageobject.h"
+#include "serverprocess.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTcpSocket>
+#include <QTest>
+#include <QThread>
+
+#include <algorithm>
+#include <csignal>
+
+namespace {
+constexpr int Requests = 10;
+} // namespace
+
+class ScoreboardController : public Controller
+{
+    Q_OBJECT
+    C_NAMESPACE("")
+public:
+    explicit ScoreboardController(QObject *parent)
+        : Controller(parent)
+    {
+    }
+
+    C_ATTR(hello, :Local :AutoArgs)
+    void hello(Context *c) { c->response()->setBody("Hello World!"_ba); }
+
+    // Keeps its worker draining for a while after a reload
+    C_ATTR(slow, :Local :AutoArgs)
+    void slow(Context *c)
+    {
+        QThread::sleep(8);
+        c->response()->setBody("done"_ba);
+    }
+};
+
+class ScoreboardApplication : public Application
+{
+    Q_OBJECT
+public:
+    explicit ScoreboardApplication(QObject *parent = nullptr)
+        : Application(parent)
+    {
+    }
+
+    bool init() override
+    {
+        new ScoreboardController(this);
+        return true;
+    }
+};
+
+class TestScoreboard : public CoverageObject
+{
+    Q_OBJECT
+public:
+    explicit TestScoreboard(QObject *parent = nullptr)
+        : CoverageObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void testStats();
+    void testMetrics();
+    void testReload();
+    void cleanupTestCase();
+
+private:
+    QJsonObject stats();
+    qint64 sum(const QJsonObject &stats, const QString &key);
+
+    ServerProcess m_server;
+    const quint16 m_statsPort = ServerProcess::freePort();
+};
+
+void TestScoreboard::initTestCase()
+{
+    QVERIFY(m_server.start(
+        [statsPort = m_statsPort](Server *server) {
+            server->setProcesses(u"2"_s);
+            server->setRollingReload(1);
+            server->setStats(u"127.0.0.1:%1"_s.arg(statsPort));
+            server->setMetrics(u"/metrics"_s);
+        },
+        [](Server *server) { return new ScoreboardApplication(server); }));
+
+    QCOMPARE(m_server.waitForWorkers(2).size(), 2);
+}
+
+void TestScoreboard::testStats()
+{
+    for (int i = 0; i < Requests; ++i) {
+        QCOMPARE(m_server.get("/hello"), "Hello World!"_ba);
+    }
+
+    // Each worker keeps its own slots, the master serves them all
+    const QJsonObject json = stats();
+    QCOMPARE(json.value(u"workers"_s).toArray().size(), 2);
+    QCOMPARE(sum(json, u"requests"_s), qint64(Requests));
+    QCOMPARE(sum(json, u"in_flight"_s), qint64(0));
+    QVERIFY(sum(json, u"bytes_in"_s) > 0);
+    QVERIFY(sum(json, u"bytes_out"_s) > 0);
+
+    bool dispatched          = false;
+    const QJsonArray workers = json.value(u"workers"_s).toArray();
+    for (const auto &worker : workers) {
+        QVERIFY(worker[u"pid"_s].toInteger() > 0);
+        QVERIFY(worker[u"rss"_s].toInteger() > 0);
+        const QJsonArray threads = worker[u"threads"_s].toArray();
+        for (const auto &thread : threads) {
+            dispatched |= thread[u"action"_s].toString() == u"hello";
+        }
+    }
+    QVERIFY(dispatched);
+}
+
+void TestScoreboard::testMetrics()
+{
+    // Histograms of both workers are merged by the one answering
+    const QByteArray text = m_server.get("/metrics");
+    QVERIFY(text.contains("cutelyst_request_duration_seconds_count{action=\"hello\",status=\"2xx\","
+                          "protocol=\"http/1.1\"} " +
+                          QByteArray::number(Requests) + '\n'));
+    QVERIFY(text.contains("# TYPE cutelyst_event_loop_lag_seconds histogram\n"));
+    QVERIFY(text.contains("cutelyst_event_loop_lag_seconds_bucket{le=\"+Inf\"} "));
+    QVERIFY(text.contains("cutelyst_workers_ready 2\n"));
+    QVERIFY(text.endsWith("# EOF\n"));
+}
+
+void TestScoreboard::testReload()
+{
+    QTcpSocket slow;
+    slow.connectToHost(u"127.0.0.1"_s, m_server.port());
+    QVERIFY(slow.waitForConnected(1000));
+    slow.write("GET /slow HTTP/1.1\r\nHost: localhost\r\n\r\n"_ba);
+    QVERIFY(slow.waitForBytesWritten(1000));
+    QTRY_COMPARE(sum(stats(), u"in_flight"_s), qint64(1));
+
+    m_server.signal(SIGHUP);
+    const QList<qint64> replacements = m_server.waitForWorkers(2);
+    QCOMPARE(replacements.size(), 2);
+
+    // The worker serving the slow request drains in its own slot, next to its replacement
+    QTRY_COMPARE(stats().value(u"workers"_s).toArray().size(), 3);
+    const QJsonArray draining = stats().value(u"workers"_s).toArray();
+    QList<int> ids;
+    for (const auto &worker : draining) {
+        const bool replacement = replacements.contains(worker[u"pid"_s].toInteger());
+        QCOMPARE(worker[u"in_flight"_s].toInteger(), replacement ? 0 : 1);
+        ids.push_back(worker[u"id"_s].toInt());
+    }
+    std::ranges::sort(ids);
+    QCOMPARE(ids.first(), 1);
+    QCOMPARE(ids.last(), 2);
+
+    QByteArray reply;
+    QTRY_VERIFY_WITH_TIMEOUT((reply += slow.readAll()).contains("done"), 15000);
+
+    // Left out once it exits
+    QTRY_COMPARE_WITH_TIMEOUT(stats().value(u"workers"_s).toArray().size(), 2, 10000);
+    const QJsonArray workers = stats().value(u"workers"_s).toArray();
+    for (const auto &worker : workers) {
+        QVERIFY(replacements.contains(worker[u"pid"_s].toInteger()));
+    }
+
+    // The replacements took other slots, so the histograms of the old workers are kept
+    const QByteArray text = m_server.get("/metrics");
+    QVERIFY(text.contains("cutelyst_request_duration_seconds_count{action=\"hello\",status=\"2xx\","
+                          "protocol=\"http/1.1\"} " +
+                          QByteArray::number(Requests) + '\n'));
+    QVERIFY(text.contains("cutelyst_request_duration_seconds_count{action=\"slow\",status=\"2xx\","
+                          "protocol=\"http/1.1\"} 1\n"));
+}
+
+void TestScoreboard::cleanupTestCase()
+{
+    m_server.stop();
+}
+
+QJsonObject TestScoreboard::stats()
+{
+    QTcpSocket sock;
+    sock.connectToHost(u"127.0.0.1"_s, m_statsPort);
+    if (!sock.waitForConnected(1000)) {
+        return {};
+    }
+
+    // The master writes the document and closes the connection
+    QByteArray reply;
+    while (sock.waitForReadyRead(5000)) {
+        reply.append(sock.readAll());
+    }
+
+    return QJsonDocument::fromJson(reply).object();
+}
+
+qint64 TestScoreboard::sum(const QJsonObject &stats, const QString &key)
+{
+    qint64 total             = 0;
+    const QJsonArray workers = stats.value(u"workers"_s).toArray();
+    for (const auto &worker : workers) {
+        total += worker[key].toInteger();
+    }
+    return total;
+}
+
+QTEST_MAIN(TestScoreboard)
+
+#include "testscoreboard.moc"
+
+#endif // TESTSCOREBOARD_H
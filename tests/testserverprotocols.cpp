@@ -0,0 +1,1255 @@
+#ifndef TESTSERVERPROTOCOLS_H
+#define TESTSERVERPROTOCOLS_H
+
+#include "coverageobject.h"
+
+#include <Cutelyst/Server/server.h>
+#include <Cutelyst/application.h>
+#include <Cutelyst/context.h>
+#include <Cutelyst/controller.h>
+#include <Cutelyst/request.h>
+#include <Cutelyst/response.h>
+#include <Cutelyst/websockethub.h>
+
+#include <QRandomGenerator>
+#include <QScopeGuard>
+#include <QSignalSpy>
+#include <QTcpSocket>
+#include <QTest>
+
+#include <algorithm>
+#include <array>
+#include <ctime>
+#include <functional>
+#include <limits>
+
+#ifdef HAS_ZLIB
+#    include <zlib.h>
+#endif
+
+using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
+
+namespace {
+constexpr quint16 HttpPort  = 31701;
+constexpr quint16 Http2Port = 31702;
+
+constexpr quint16 KeepAlivePort = 31703;
+constexpr quint16 FastCgiPort   = 31704;
+constexpr quint16 UwsgiPort     = 31705;
+constexpr quint16 ProxyPort     = 31706;
+
+constexpr quint8 H2FrameData      = 0x0;
+constexpr quint8 H2FrameHeaders   = 0x1;
+constexpr quint8 H2FrameRstStream = 0x3;
+constexpr quint8 H2FrameSettings  = 0x4;
+constexpr quint8 H2FrameGoaway    = 0x7;
+
+constexpr quint8 H2FlagEndStream  = 0x1;
+constexpr quint8 H2FlagEndHeaders = 0x4;
+
+struct H2ClientFrame {
+    QByteArray payload;
+    quint32 streamId;
+    quint8 type;
+    quint8 flags;
+};
+
+constexpr quint8 FcgiBeginRequest    = 1;
+constexpr quint8 FcgiEndRequest      = 3;
+constexpr quint8 FcgiParams          = 4;
+constexpr quint8 FcgiStdin           = 5;
+constexpr quint8 FcgiStdout          = 6;
+constexpr quint8 FcgiGetValues       = 9;
+constexpr quint8 FcgiGetValuesResult = 10;
+
+constexpr quint8 FcgiRequestComplete = 0;
+constexpr quint8 FcgiOverloaded      = 2;
+
+struct FcgiClientRecord {
+    QByteArray content;
+    quint16 requestId;
+    quint8 type;
+};
+
+struct WebSocketServerFrame {
+    QByteArray payload;
+    quint8 header;
+};
+
+QByteArray randomBytes(quint32 seed)
+{
+    QByteArray data(8 * 1024, Qt::Uninitialized);
+    QRandomGenerator generator(seed);
+    generator.fillRange(reinterpret_cast<quint32 *>(data.data()), data.size() / 4);
+    return data;
+}
+
+QByteArray floodMessage(int index)
+{
+    // The second half repeats the first one of the previous message, so it is compressed as a
+    // reference to it, which a client that never got that message can't resolve
+    QByteArray message = randomBytes(quint32(index + 1)) + randomBytes(quint32(index));
+    message[0]         = char(index);
+    return message;
+}
+} // namespace
+
+class ProtocolsController : public Controller
+{
+    Q_OBJECT
+    C_NAMESPACE("")
+public:
+    explicit ProtocolsController(QObject *parent)
+        : Controller(parent)
+    {
+    }
+
+    C_ATTR(hints, :Local :AutoArgs)
+    void hints(Context *c)
+    {
+        Headers hints;
+        hints.pushHeader("Link"_ba, "</style.css>; rel=preload; as=style"_ba);
+        c->response()->sendEarlyHints(hints);
+        c->response()->setBody("final"_ba);
+    }
+
+    C_ATTR(fcgi, :Local :AutoArgs)
+    void fcgi(Context *c)
+    {
+        Request *request = c->request();
+        c->response()->setBody(request->queryParam(u"id"_s).toLatin1() + ':' +
+                               request->body()->readAll());
+    }
+
+    C_ATTR(peer, :Local :AutoArgs)
+    void peer(Context *c)
+    {
+        Request *request = c->request();
+        c->response()->setBody(request->address().toString().toLatin1() + ' ' +
+                               QByteArray::number(request->port()));
+    }
+
+    C_ATTR(ws, :Local :AutoArgs)
+    void ws(Context *c)
+    {
+        Response *response = c->response();
+        if (response->webSocketHandshake()) {
+            connect(c->request(),
+                    &Request::webSocketTextMessage,
+                    c,
+                    [response](const QString &message) {
+                response->webSocketTextMessage(message);
+            });
+            connect(c->request(),
+                    &Request::webSocketBinaryMessage,
+                    c,
+                    [response](const QByteArray &message) {
+                response->webSocketBinaryMessage(message);
+            });
+        }
+    }
+
+    C_ATTR(flood, :Local :AutoArgs)
+    void flood(Context *c)
+    {
+        Response *response = c->response();
+        if (response->webSocketHandshake()) {
+            connect(c->request(), &Request::webSocketWritable, c, [response] {
+                response->webSocketTextMessage(u"writable"_s);
+            });
+
+            // Nothing reaches the socket before returning to the event loop
+            for (int i = 0; i < 100; ++i) {
+                response->webSocketBinaryMessage(floodMessage(i));
+            }
+        }
+    }
+
+    C_ATTR(hub, :Local :AutoArgs)
+    void hub(Context *c, const QString &channel)
+    {
+        if (c->response()->webSocketHandshake()) {
+            WebSocketHub::instance()->subscribe(c, channel);
+        }
+    }
+};
+
+class ProtocolsApplication : public Application
+{
+    Q_OBJECT
+public:
+    explicit ProtocolsApplication(QObject *parent = nullptr)
+        : Application(parent)
+    {
+    }
+
+    bool init() override
+    {
+        new ProtocolsController(this);
+        return true;
+    }
+};
+
+class TestServerProtocols : public CoverageObject
+{
+    Q_OBJECT
+public:
+    explicit TestServerProtocols(QObject *parent = nullptr)
+        : CoverageObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void testHttp11EarlyHints();
+    void testHttp10EarlyHintsIgnored();
+    void testHttp2EarlyHints();
+    void testHttp2MaxConcurrentStreams();
+    void testHttp2InflightQueue();
+    void testHttp2RapidReset();
+    void testWebSocketDeflate_data();
+    void testWebSocketDeflate();
+    void testWebSocketFraming_data();
+    void testWebSocketFraming();
+    void testWebSocketHub();
+    void testWebSocketSlowConsumer();
+    void testWebSocketSlowConsumerDeflate();
+    void testWebSocketKeepAlive();
+    void testFastCgiGetValues();
+    void testFastCgiMultiplexing();
+    void testUwsgi();
+    void testProxyProtocol_data();
+    void testProxyProtocol();
+    void testProxyProtocolSplitHeader();
+    void cleanupTestCase();
+
+private:
+    QByteArray request(quint16 port,
+                       const QByteArray &data,
+                       const std::function<bool(const QByteArray &)> &isComplete);
+
+    static QByteArray h2Frame(quint8 type, quint8 flags, quint32 streamId, const QByteArray &data);
+    static QList<H2ClientFrame> h2ParseFrames(const QByteArray &data);
+    static QByteArray h2RequestHeaders(const QByteArray &path);
+    static QByteArray h2Preface();
+    static quint32 h2ErrorCode(const H2ClientFrame &frame);
+
+    static QByteArray fcgiRecord(quint8 type, quint16 requestId, const QByteArray &content);
+    static QByteArray fcgiPairs(const QList<std::pair<QByteArray, QByteArray>> &pairs);
+    static QList<FcgiClientRecord> fcgiParseRecords(const QByteArray &data);
+
+    static QByteArray uwsgiPacket(const QList<std::pair<QByteArray, QByteArray>> &vars);
+
+    Server *m_server = nullptr;
+};
+
+void TestServerProtocols::initTestCase()
+{
+    // Keep the dispatcher already installed by QTEST_MAIN
+    qputenv("CUTELYST_QT_EVENT_LOOP", "1");
+
+    m_server = new Server(this);
+    m_server->setHttpSocket({u"127.0.0.1:%1"_s.arg(HttpPort), u"127.0.0.1:%1"_s.arg(ProxyPort)});
+    m_server->setHttp2Socket({u"127.0.0.1:%1"_s.arg(Http2Port)});
+    m_server->setFastcgiSocket({u"127.0.0.1:%1"_s.arg(FastCgiPort)});
+    m_server->setUwsgiSocket({u"127.0.0.1:%1"_s.arg(UwsgiPort)});
+    m_server->setProxyProtocol({u"127.0.0.1:%1"_s.arg(ProxyPort)});
+    m_server->setSocketTimeout(0);
+    m_server->setHttp2MaxConcurrentStreams(2);
+    m_server->setHttp2MaxInflightRequests(1);
+    m_server->setHttp2MaxResetStreams(4);
+    m_server->setWebsocketCompression(true);
+    m_server->setWebsocketWriteHighWatermark(64);
+    m_server->setWebsocketSlowConsumerPolicy(u"drop-oldest"_s);
+    m_server->setFastcgiMaxRequests(2);
+    QVERIFY(m_server->start(new ProtocolsApplication(m_server)));
+}
+
+void TestServerProtocols::cleanupTestCase()
+{
+    QSignalSpy stopped(m_server, &Server::stopped);
+    m_server->stop();
+    QVERIFY(stopped.wait());
+}
+
+QByteArray TestServerProtocols::request(quint16 port,
+                                        const QByteArray &data,
+                                        const std::function<bool(const QByteArray &)> &isComplete)
+{
+    QTcpSocket sock;
+    QByteArray ret;
+    connect(&sock, &QTcpSocket::readyRead, this, [&] { ret.append(sock.readAll()); });
+
+    sock.connectToHost(u"127.0.0.1"_s, port);
+    if (!QTest::qWaitFor([&] { return sock.state() == QAbstractSocket::ConnectedState; })) {
+        return {};
+    }
+    sock.write(data);
+
+    // The server runs on this thread so we must spin the event loop
+    QTest::qWaitFor([&] { return isComplete(ret); }, 5000);
+    return ret;
+}
+
+QByteArray TestServerProtocols::h2Frame(quint8 type,
+                                        quint8 flags,
+                                        quint32 streamId,
+                                        const QByteArray &data)
+{
+    QByteArray ret;
+    ret.append(char(data.size() >> 16));
+    ret.append(char(data.size() >> 8));
+    ret.append(char(data.size()));
+    ret.append(char(type));
+    ret.append(char(flags));
+    ret.append(char(streamId >> 24));
+    ret.append(char(streamId >> 16));
+    ret.append(char(streamId >> 8));
+    ret.append(char(streamId));
+    ret.append(data);
+    return ret;
+}
+
+QList<H2ClientFrame> TestServerProtocols::h2ParseFrames(const QByteArray &data)
+{
+    QList<H2ClientFrame> ret;
+    qsizetype pos = 0;
+    while (data.size() - pos >= 9) {
+        const auto ptr    = reinterpret_cast<const quint8 *>(data.constData() + pos);
+        const quint32 len = (ptr[0] << 16) | (ptr[1] << 8) | ptr[2];
+        if (data.size() - pos - 9 < len) {
+            break;
+        }
+
+        H2ClientFrame frame;
+        frame.type     = ptr[3];
+        frame.flags    = ptr[4];
+        frame.streamId = ((ptr[5] & 0x7f) << 24) | (ptr[6] << 16) | (ptr[7] << 8) | ptr[8];
+        frame.payload  = data.mid(pos + 9, len);
+        ret.append(frame);
+        pos += 9 + len;
+    }
+    return ret;
+}
+
+QByteArray TestServerProtocols::h2RequestHeaders(const QByteArray &path)
+{
+    QByteArray block;
+    block.append(char(0x82)); // :method GET
+    block.append(char(0x86)); // :scheme http
+    block.append(char(0x04)); // :path literal without indexing
+    block.append(char(path.size()));
+    block.append(path);
+    block.append(char(0x01)); // :authority literal without indexing
+    block.append(char(9));
+    block.append("localhost");
+    return block;
+}
+
+QByteArray TestServerProtocols::h2Preface()
+{
+    QByteArray data = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"_ba;
+    data.append(h2Frame(H2FrameSettings, 0, 0, {}));
+    return data;
+}
+
+quint32 TestServerProtocols::h2ErrorCode(const H2ClientFrame &frame)
+{
+    // RST_STREAM carries only the error code, GOAWAY has the last stream id first
+    const auto ptr = reinterpret_cast<const quint8 *>(frame.payload.constData()) +
+                     (frame.type == H2FrameGoaway ? 4 : 0);
+    return (ptr[0] << 24) | (ptr[1] << 16) | (ptr[2] << 8) | ptr[3];
+}
+
+QByteArray TestServerProtocols::fcgiRecord(quint8 type,
+                                           quint16 requestId,
+                                           const QByteArray &content)
+{
+    const auto padding = quint8((8 - content.size() % 8) % 8);
+
+    QByteArray ret;
+    ret.append(char(1)); // FCGI_VERSION_1
+    ret.append(char(type));
+    ret.append(char(requestId >> 8));
+    ret.append(char(requestId));
+    ret.append(char(content.size() >> 8));
+    ret.append(char(content.size()));
+    ret.append(char(padding));
+    ret.append(char(0));
+    ret.append(content);
+    ret.append(padding, '\0');
+    return ret;
+}
+
+QByteArray TestServerProtocols::fcgiPairs(const QList<std::pair<QByteArray, QByteArray>> &pairs)
+{
+    // Short names and values use a single byte length
+    QByteArray ret;
+    for (const auto &[name, value] : pairs) {
+        ret.append(char(name.size()));
+        ret.append(char(value.size()));
+        ret.append(name);
+        ret.append(value);
+    }
+    return ret;
+}
+
+QByteArray TestServerProtocols::uwsgiPacket(const QList<std::pair<QByteArray, QByteArray>> &vars)
+{
+    QByteArray block;
+    for (const auto &[key, value] : vars) {
+        block.append(char(key.size()));
+        block.append(char(key.size() >> 8));
+        block.append(key);
+        block.append(char(value.size()));
+        block.append(char(value.size() >> 8));
+        block.append(value);
+    }
+
+    // modifier1 0, little endian size, modifier2 0
+    QByteArray ret;
+    ret.append(char(0));
+    ret.append(char(block.size()));
+    ret.append(char(block.size() >> 8));
+    ret.append(char(0));
+    ret.append(block);
+    return ret;
+}
+
+QList<FcgiClientRecord> TestServerProtocols::fcgiParseRecords(const QByteArray &data)
+{
+    QList<FcgiClientRecord> ret;
+    qsizetype pos = 0;
+    while (data.size() - pos >= 8) {
+        const auto ptr    = reinterpret_cast<const quint8 *>(data.constData() + pos);
+        const quint32 len = (ptr[4] << 8) | ptr[5];
+        if (data.size() - pos - 8 < len + ptr[6]) {
+            break;
+        }
+
+        FcgiClientRecord record;
+        record.type      = ptr[1];
+        record.requestId = quint16((ptr[2] << 8) | ptr[3]);
+        record.content   = data.mid(pos + 8, len);
+        ret.append(record);
+        pos += 8 + len + ptr[6];
+    }
+    return ret;
+}
+
+void TestServerProtocols::testHttp11EarlyHints()
+{
+    const QByteArray reply =
+        request(HttpPort,
+                "GET /hints HTTP/1.1\r\nHost: localhost\r\n\r\n"_ba,
+                [](const QByteArray &data) { return data.endsWith("final"); });
+
+    QVERIFY(reply.startsWith("HTTP/1.1 103 Early Hints\r\n"
+                             "Link: </style.css>; rel=preload; as=style\r\n\r\n"
+                             "HTTP/1.1 200 OK\r\n"));
+    QVERIFY(reply.endsWith("\r\n\r\nfinal"));
+
+    // The informational response must not carry the final response fields
+    const QByteArray hints = reply.left(reply.indexOf("\r\n\r\n"));
+    QVERIFY(!hints.contains("Connection:"));
+    QVERIFY(!hints.contains("Date:"));
+}
+
+void TestServerProtocols::testHttp10EarlyHintsIgnored()
+{
+    const QByteArray reply =
+        request(HttpPort,
+                "GET /hints HTTP/1.0\r\nHost: localhost\r\n\r\n"_ba,
+                [](const QByteArray &data) { return data.endsWith("final"); });
+
+    QVERIFY(reply.startsWith("HTTP/1.1 200 OK\r\n"));
+    QVERIFY(!reply.contains("103"));
+}
+
+void TestServerProtocols::testHttp2EarlyHints()
+{
+    QByteArray data = h2Preface();
+    data.append(
+        h2Frame(H2FrameHeaders, H2FlagEndStream | H2FlagEndHeaders, 1, h2RequestHeaders("/hints")));
+
+    const QByteArray reply = request(Http2Port, data, [](const QByteArray &data) {
+        const auto frames = h2ParseFrames(data);
+        return std::ranges::any_of(frames, [](const H2ClientFrame &frame) {
+            return frame.type == H2FrameData && frame.flags & H2FlagEndStream;
+        });
+    });
+
+    QList<H2ClientFrame> streamFrames;
+    for (const auto &frame : h2ParseFrames(reply)) {
+        if (frame.streamId == 1) {
+            streamFrames.append(frame);
+        }
+    }
+    QCOMPARE(streamFrames.size(), 3);
+
+    // 103 literal :status, no END_STREAM
+    const H2ClientFrame &hints = streamFrames.at(0);
+    QCOMPARE(hints.type, H2FrameHeaders);
+    QCOMPARE(hints.flags, H2FlagEndHeaders);
+    QVERIFY(hints.payload.startsWith("\x08\x03"
+                                     "103"));
+    QVERIFY(hints.payload.contains("link"));
+    QVERIFY(hints.payload.contains("</style.css>; rel=preload; as=style"));
+
+    // 200 indexed :status
+    const H2ClientFrame &final = streamFrames.at(1);
+    QCOMPARE(final.type, H2FrameHeaders);
+    QVERIFY(!(final.flags & H2FlagEndStream));
+    QCOMPARE(quint8(final.payload.at(0)), quint8(0x88));
+
+    const H2ClientFrame &body = streamFrames.at(2);
+    QCOMPARE(body.type, H2FrameData);
+    QCOMPARE(body.payload, "final"_ba);
+}
+
+void TestServerProtocols::testHttp2MaxConcurrentStreams()
+{
+    // Three streams waiting for their body, the third is above the limit of 2
+    QByteArray data = h2Preface();
+    for (quint32 streamId : {1, 3, 5}) {
+        data.append(
+            h2Frame(H2FrameHeaders, H2FlagEndHeaders, streamId, h2RequestHeaders("/hints")));
+    }
+    // DATA already in flight for the refused stream must not kill the connection
+    for (quint32 streamId : {5, 1, 3}) {
+        data.append(h2Frame(H2FrameData, H2FlagEndStream, streamId, {}));
+    }
+
+    const QByteArray reply = request(Http2Port, data, [](const QByteArray &data) {
+        const auto frames = h2ParseFrames(data);
+        return std::ranges::count_if(frames, [](const H2ClientFrame &frame) {
+                   return frame.type == H2FrameData && frame.flags & H2FlagEndStream;
+               }) == 2;
+    });
+    const auto frames = h2ParseFrames(reply);
+
+    // SETTINGS_MAX_CONCURRENT_STREAMS is advertised
+    const H2ClientFrame &settings = frames.value(0);
+    QCOMPARE(settings.type, H2FrameSettings);
+    QVERIFY(settings.payload.contains(QByteArray::fromHex("000300000002")));
+
+    auto rst = std::ranges::find_if(
+        frames, [](const H2ClientFrame &frame) { return frame.type == H2FrameRstStream; });
+    QVERIFY(rst != frames.end());
+    QCOMPARE(rst->streamId, quint32(5));
+    QCOMPARE(h2ErrorCode(*rst), quint32(0x7)); // REFUSED_STREAM
+
+    QVERIFY(std::ranges::none_of(
+        frames, [](const H2ClientFrame &frame) { return frame.type == H2FrameGoaway; }));
+    for (quint32 streamId : {1, 3}) {
+        QVERIFY(std::ranges::any_of(frames, [streamId](const H2ClientFrame &frame) {
+            return frame.streamId == streamId && frame.type == H2FrameData &&
+                   frame.payload == "final";
+        }));
+    }
+
+    QVERIFY(m_server->counters().value(u"http2_refused_streams"_s).toULongLong() > 0);
+}
+
+void TestServerProtocols::testHttp2InflightQueue()
+{
+    const quint64 queued = m_server->counters().value(u"http2_queued_requests"_s).toULongLong();
+
+    // Both requests are complete but only one is processed at a time
+    QByteArray data = h2Preface();
+    for (quint32 streamId : {1, 3}) {
+        data.append(h2Frame(H2FrameHeaders,
+                            H2FlagEndStream | H2FlagEndHeaders,
+                            streamId,
+                            h2RequestHeaders("/hints")));
+    }
+
+    const QByteArray reply = request(Http2Port, data, [](const QByteArray &data) {
+        const auto frames = h2ParseFrames(data);
+        return std::ranges::count_if(frames, [](const H2ClientFrame &frame) {
+                   return frame.type == H2FrameData && frame.flags & H2FlagEndStream;
+               }) == 2;
+    });
+
+    QList<quint32> finished;
+    for (const auto &frame : h2ParseFrames(reply)) {
+        if (frame.type == H2FrameData && frame.flags & H2FlagEndStream) {
+            finished.append(frame.streamId);
+        }
+    }
+    QCOMPARE(finished, QList<quint32>({1, 3}));
+
+    QCOMPARE(m_server->counters().value(u"http2_queued_requests"_s).toULongLong(), queued + 1);
+}
+
+void TestServerProtocols::testHttp2RapidReset()
+{
+    const QByteArray cancel = QByteArray::fromHex("00000008");
+
+    // Open and cancel more streams than the 4 allowed per second
+    QByteArray data = h2Preface();
+    for (quint32 streamId = 1; streamId <= 11; streamId += 2) {
+        data.append(
+            h2Frame(H2FrameHeaders, H2FlagEndHeaders, streamId, h2RequestHeaders("/hints")));
+        data.append(h2Frame(H2FrameRstStream, 0, streamId, cancel));
+    }
+
+    const QByteArray reply = request(Http2Port, data, [](const QByteArray &data) {
+        const auto frames = h2ParseFrames(data);
+        return std::ranges::any_of(
+            frames, [](const H2ClientFrame &frame) { return frame.type == H2FrameGoaway; });
+    });
+    const auto frames = h2ParseFrames(reply);
+
+    auto goaway = std::ranges::find_if(
+        frames, [](const H2ClientFrame &frame) { return frame.type == H2FrameGoaway; });
+    QVERIFY(goaway != frames.end());
+    QCOMPARE(h2ErrorCode(*goaway), quint32(0xB)); // ENHANCE_YOUR_CALM
+
+    QVERIFY(m_server->counters().value(u"http2_reset_flood_goaways"_s).toULongLong() > 0);
+}
+
+void TestServerProtocols::testWebSocketDeflate_data()
+{
+    QTest::addColumn<QByteArray>("offer");
+    QTest::addColumn<QByteArray>("extensions");
+
+    QTest::newRow("none") << QByteArray{} << QByteArray{};
+    QTest::newRow("default") << "permessage-deflate; client_max_window_bits"_ba
+                             << "permessage-deflate"_ba;
+    QTest::newRow("no-context-takeover")
+        << "permessage-deflate; server_no_context_takeover"_ba
+        << "permessage-deflate; server_no_context_takeover"_ba;
+    QTest::newRow("window-bits") << "permessage-deflate; server_max_window_bits=10"_ba
+                                 << "permessage-deflate; server_max_window_bits=10"_ba;
+    QTest::newRow("second-offer")
+        << "permessage-deflate; server_max_window_bits=8, permessage-deflate"_ba
+        << "permessage-deflate"_ba;
+    QTest::newRow("unknown-param") << "permessage-deflate; foo=1"_ba << QByteArray{};
+}
+
+void TestServerProtocols::testWebSocketDeflate()
+{
+    QFETCH(QByteArray, offer);
+    QFETCH(QByteArray, extensions);
+#ifndef HAS_ZLIB
+    if (!extensions.isEmpty()) {
+        QSKIP("Server built without zlib");
+    }
+#endif
+
+    QTcpSocket sock;
+    QByteArray reply;
+    connect(&sock, &QTcpSocket::readyRead, this, [&] { reply.append(sock.readAll()); });
+    sock.connectToHost(u"127.0.0.1"_s, HttpPort);
+    QTRY_COMPARE(sock.state(), QAbstractSocket::ConnectedState);
+
+    QByteArray handshake = "GET /ws HTTP/1.1\r\n"
+                           "Host: localhost\r\n"
+                           "Upgrade: websocket\r\n"
+                           "Connection: Upgrade\r\n"
+                           "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                           "Sec-WebSocket-Version: 13\r\n"_ba;
+    if (!offer.isEmpty()) {
+        handshake.append("Sec-WebSocket-Extensions: " + offer + "\r\n");
+    }
+    sock.write(handshake + "\r\n");
+
+    QTRY_VERIFY(reply.contains("\r\n\r\n"));
+    QVERIFY(reply.startsWith("HTTP/1.1 101 Switching Protocols\r\n"));
+    const QByteArray headers = reply.left(reply.indexOf("\r\n\r\n") + 2).toLower();
+    if (extensions.isEmpty()) {
+        QVERIFY(!headers.contains("sec-websocket-extensions:"));
+    } else {
+        QVERIFY(headers.contains("\r\nsec-websocket-extensions: " + extensions.toLower() + "\r\n"));
+    }
+    reply.clear();
+
+    // "Hello" compressed as in RFC 7692 7.2.3.1
+    const QByteArray compressedHello = QByteArray::fromHex("f248cdc9c90700");
+    const bool compressed            = !extensions.isEmpty();
+    const QByteArray payload         = compressed ? compressedHello : "Hello"_ba;
+
+    // Masked with a zero key so the payload goes as is
+    QByteArray frame;
+    frame.append(char(compressed ? 0xc1 : 0x81));
+    frame.append(char(0x80 | payload.size()));
+    frame.append(4, '\0');
+    frame.append(payload);
+    sock.write(frame);
+
+    QTRY_COMPARE(reply.size(), 2 + payload.size());
+    QCOMPARE(quint8(reply.at(0)), quint8(compressed ? 0xc1 : 0x81));
+    QCOMPARE(reply.mid(2), payload);
+}
+
+void TestServerProtocols::testWebSocketFraming_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("headerSize");
+
+    QTest::newRow("empty") << 0 << 2;
+    QTest::newRow("7-bits-length") << 125 << 2;
+    QTest::newRow("16-bits-length") << 126 << 4;
+    QTest::newRow("64-bits-length") << 300001 << 10;
+}
+
+void TestServerProtocols::testWebSocketFraming()
+{
+    QFETCH(int, size);
+    QFETCH(int, headerSize);
+
+    QTcpSocket sock;
+    QByteArray reply;
+    connect(&sock, &QTcpSocket::readyRead, this, [&] { reply.append(sock.readAll()); });
+    sock.connectToHost(u"127.0.0.1"_s, HttpPort);
+    QTRY_COMPARE(sock.state(), QAbstractSocket::ConnectedState);
+
+    sock.write("GET /ws HTTP/1.1\r\n"
+               "Host: localhost\r\n"
+               "Upgrade: websocket\r\n"
+               "Connection: Upgrade\r\n"
+               "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+               "Sec-WebSocket-Version: 13\r\n\r\n");
+    QTRY_VERIFY(reply.contains("\r\n\r\n"));
+    QVERIFY(reply.startsWith("HTTP/1.1 101 Switching Protocols\r\n"));
+    reply.clear();
+
+    QByteArray payload(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i) {
+        payload[i] = char(i * 31);
+    }
+
+    // Masked binary frame using the shortest payload length encoding
+    const QByteArray mask = "\x37\xfa\x21\x3d"_ba;
+    QByteArray frame("\x82"_ba);
+    if (size < 126) {
+        frame.append(char(0x80 | size));
+    } else if (size <= 0xffff) {
+        frame.append(char(0x80 | 126));
+        frame.append(char(size >> 8));
+        frame.append(char(size));
+    } else {
+        frame.append(char(0x80 | 127));
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            frame.append(char(quint64(size) >> shift));
+        }
+    }
+    frame.append(mask);
+    for (int i = 0; i < size; ++i) {
+        frame.append(char(payload[i] ^ mask[i % 4]));
+    }
+
+    // Split the header and the payload so both are parsed from partial reads
+    const QList<qsizetype> splits{1, headerSize + 1, headerSize + 4 + size / 3};
+    qsizetype pos = 0;
+    for (qsizetype split : splits) {
+        if (split > pos && split < frame.size()) {
+            sock.write(frame.mid(pos, split - pos));
+            QVERIFY(sock.waitForBytesWritten());
+            QTest::qWait(10);
+            pos = split;
+        }
+    }
+    sock.write(frame.mid(pos));
+
+    QTRY_COMPARE(reply.size(), headerSize + size);
+    QCOMPARE(quint8(reply.at(0)), quint8(0x82));
+    QCOMPARE(reply.mid(headerSize), payload);
+}
+
+void TestServerProtocols::testWebSocketHub()
+{
+    struct Client {
+        QTcpSocket sock;
+        QByteArray reply;
+    };
+    std::array<Client, 3> clients;
+    const std::array<QByteArray, 3> channels{"news"_ba, "news"_ba, "sports"_ba};
+
+    for (size_t i = 0; i < clients.size(); ++i) {
+        Client &client = clients[i];
+        connect(&client.sock, &QTcpSocket::readyRead, this, [&client] {
+            client.reply.append(client.sock.readAll());
+        });
+        client.sock.connectToHost(u"127.0.0.1"_s, HttpPort);
+        QTRY_COMPARE(client.sock.state(), QAbstractSocket::ConnectedState);
+
+        client.sock.write("GET /hub/" + channels[i] +
+                          " HTTP/1.1\r\n"
+                          "Host: localhost\r\n"
+                          "Upgrade: websocket\r\n"
+                          "Connection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                          "Sec-WebSocket-Version: 13\r\n\r\n");
+        QTRY_VERIFY(client.reply.contains("\r\n\r\n"));
+        QVERIFY(client.reply.startsWith("HTTP/1.1 101 Switching Protocols\r\n"));
+        client.reply.clear();
+    }
+
+    WebSocketHub *hub       = WebSocketHub::instance();
+    const quint64 delivered = hub->delivered();
+
+    hub->publishText(u"news"_s, u"Hello"_s);
+    hub->publishBinary(u"sports"_s, "\x01\x02"_ba);
+    hub->publishText(u"weather"_s, u"Nobody listens"_s);
+
+    const QByteArray text = "\x81\x05Hello"_ba;
+    QTRY_COMPARE(clients[0].reply, text);
+    QTRY_COMPARE(clients[1].reply, text);
+    QTRY_COMPARE(clients[2].reply, "\x82\x02\x01\x02"_ba);
+    QCOMPARE(hub->delivered(), delivered + 3);
+
+    // Subscriptions go away with the connection
+    clients[1].sock.disconnectFromHost();
+    QTest::qWait(100);
+    hub->publishText(u"news"_s, u"Again"_s);
+    QTRY_COMPARE(hub->delivered(), delivered + 4);
+    QTRY_COMPARE(clients[0].reply, text + "\x81\x05" "Again"_ba);
+}
+
+void TestServerProtocols::testWebSocketSlowConsumer()
+{
+    QTcpSocket sock;
+    QByteArray reply;
+    connect(&sock, &QTcpSocket::readyRead, this, [&] { reply.append(sock.readAll()); });
+    sock.connectToHost(u"127.0.0.1"_s, HttpPort);
+    QTRY_COMPARE(sock.state(), QAbstractSocket::ConnectedState);
+
+    const quint64 dropped =
+        m_server->counters().value(u"websocket_slow_consumer_dropped"_s).toULongLong();
+
+    sock.write("GET /flood HTTP/1.1\r\n"
+               "Host: localhost\r\n"
+               "Upgrade: websocket\r\n"
+               "Connection: Upgrade\r\n"
+               "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+               "Sec-WebSocket-Version: 13\r\n\r\n");
+    QTRY_VERIFY(reply.contains("\r\n\r\n"));
+    QVERIFY(reply.startsWith("HTTP/1.1 101 Switching Protocols\r\n"));
+    QTRY_VERIFY(reply.endsWith("\x81\x08writable"));
+    reply.remove(0, reply.indexOf("\r\n\r\n") + 4);
+
+    // Server frames are not masked, binary ones use the 16 bits length
+    QList<int> received;
+    qsizetype pos = 0;
+    while (pos < reply.size() && quint8(reply.at(pos)) == 0x82) {
+        QCOMPARE(quint8(reply.at(pos + 1)), quint8(126));
+        const int size = (quint8(reply.at(pos + 2)) << 8) | quint8(reply.at(pos + 3));
+        QCOMPARE(size, 16 * 1024);
+        received.append(quint8(reply.at(pos + 4)));
+        pos += 4 + size;
+    }
+    QCOMPARE(reply.mid(pos), "\x81\x08writable"_ba);
+
+    // The oldest held back messages were dropped, the newest ones are delivered in order
+    QVERIFY(received.size() < 100);
+    QCOMPARE(received.constFirst(), 0);
+    QCOMPARE(received.constLast(), 99);
+    QVERIFY(std::ranges::is_sorted(received));
+
+    const quint64 nowDropped =
+        m_server->counters().value(u"websocket_slow_consumer_dropped"_s).toULongLong();
+    QCOMPARE(nowDropped - dropped, quint64(100 - received.size()));
+    QCOMPARE(m_server->counters().value(u"websocket_held_back_bytes"_s).toLongLong(), 0);
+}
+
+void TestServerProtocols::testWebSocketSlowConsumerDeflate()
+{
+#ifndef HAS_ZLIB
+    QSKIP("Server built without zlib");
+#else
+    QTcpSocket sock;
+    QByteArray reply;
+    connect(&sock, &QTcpSocket::readyRead, this, [&] { reply.append(sock.readAll()); });
+    sock.connectToHost(u"127.0.0.1"_s, HttpPort);
+    QTRY_COMPARE(sock.state(), QAbstractSocket::ConnectedState);
+
+    const quint64 dropped =
+        m_server->counters().value(u"websocket_slow_consumer_dropped"_s).toULongLong();
+
+    sock.write("GET /flood HTTP/1.1\r\n"
+               "Host: localhost\r\n"
+               "Upgrade: websocket\r\n"
+               "Connection: Upgrade\r\n"
+               "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+               "Sec-WebSocket-Extensions: permessage-deflate\r\n"
+               "Sec-WebSocket-Version: 13\r\n\r\n");
+    QTRY_VERIFY(reply.contains("\r\n\r\n"));
+    QVERIFY(reply.startsWith("HTTP/1.1 101 Switching Protocols\r\n"));
+    const qsizetype headersEnd = reply.indexOf("\r\n\r\n") + 4;
+    QVERIFY(reply.left(headersEnd).toLower().contains(
+        "\r\nsec-websocket-extensions: permessage-deflate\r\n"));
+    reply.remove(0, headersEnd);
+
+    // Server frames are not masked, the text one is the last
+    QList<WebSocketServerFrame> frames;
+    const auto takeFrames = [&] {
+        while (reply.size() >= 2) {
+            quint64 size  = quint8(reply.at(1)) & 0x7f;
+            qsizetype pos = 2;
+            if (size == 126) {
+                if (reply.size() < 4) {
+                    break;
+                }
+                size = (quint8(reply.at(2)) << 8) | quint8(reply.at(3));
+                pos  = 4;
+            } else if (size == 127) {
+                if (reply.size() < 10) {
+                    break;
+                }
+                size = 0;
+                for (int i = 2; i < 10; ++i) {
+                    size = (size << 8) | quint8(reply.at(i));
+                }
+                pos = 10;
+            }
+
+            if (reply.size() < pos + qsizetype(size)) {
+                break;
+            }
+            frames.append({reply.mid(pos, qsizetype(size)), quint8(reply.at(0))});
+            reply.remove(0, pos + qsizetype(size));
+        }
+        return !frames.isEmpty() && (frames.constLast().header & 0x0f) == 0x1;
+    };
+    QTRY_VERIFY(takeFrames());
+    QVERIFY(reply.isEmpty());
+
+    // Messages are inflated with the context of the previous ones, like a client does
+    z_stream inflater{};
+    QCOMPARE(inflateInit2(&inflater, -15), Z_OK);
+    auto cleanup = qScopeGuard([&inflater] { inflateEnd(&inflater); });
+
+    QList<int> received;
+    for (const WebSocketServerFrame &frame : std::as_const(frames)) {
+        // Every message is compressed, RSV1 is set
+        QCOMPARE(frame.header & 0xf0, 0xc0);
+
+        QByteArray payload = frame.payload + "\x00\x00\xff\xff"_ba;
+        inflater.next_in   = reinterpret_cast<Bytef *>(payload.data());
+        inflater.avail_in  = uInt(payload.size());
+
+        QByteArray message;
+        do {
+            const qsizetype used = message.size();
+            message.resize(used + 16 * 1024);
+            inflater.next_out  = reinterpret_cast<Bytef *>(message.data() + used);
+            inflater.avail_out = 16 * 1024;
+
+            const int ret = inflate(&inflater, Z_SYNC_FLUSH);
+            QVERIFY(ret == Z_OK || ret == Z_BUF_ERROR);
+            message.resize(message.size() - inflater.avail_out);
+        } while (inflater.avail_out == 0);
+
+        if ((frame.header & 0x0f) == 0x1) {
+            QCOMPARE(message, "writable"_ba);
+        } else {
+            QVERIFY(!message.isEmpty());
+            received.append(quint8(message.at(0)));
+            QCOMPARE(message, floodMessage(received.constLast()));
+        }
+    }
+
+    // The oldest held back messages were dropped before being compressed
+    QVERIFY(received.size() < 100);
+    QCOMPARE(received.constFirst(), 0);
+    QCOMPARE(received.constLast(), 99);
+    QVERIFY(std::ranges::is_sorted(received));
+
+    const quint64 nowDropped =
+        m_server->counters().value(u"websocket_slow_consumer_dropped"_s).toULongLong();
+    QCOMPARE(nowDropped - dropped, quint64(100 - received.size()));
+#endif
+}
+
+void TestServerProtocols::testWebSocketKeepAlive()
+{
+    // A server of its own so pings don't show up in the other websocket tests
+    Server server;
+    server.setHttpSocket({u"127.0.0.1:%1"_s.arg(KeepAlivePort)});
+    server.setSocketTimeout(0);
+    server.setWebsocketPingInterval(1);
+    server.setWebsocketPongTimeout(1);
+    server.setWebsocketIdleTimeout(3);
+    QVERIFY(server.start(new ProtocolsApplication(&server)));
+
+    struct Client {
+        QTcpSocket sock;
+        QByteArray reply;
+        int pongs = 0;
+    };
+    // The first client answers every ping but never sends a message,
+    // the second answers only the first ping and then plays dead
+    std::array<Client, 2> clients;
+    const std::array<int, 2> maxPongs{std::numeric_limits<int>::max(), 1};
+    for (size_t i = 0; i < clients.size(); ++i) {
+        auto &client = clients[i];
+        connect(&client.sock, &QTcpSocket::readyRead, this, [&client, max = maxPongs[i]] {
+            const QByteArray data = client.sock.readAll();
+            client.reply.append(data);
+            if (data.contains("\x89\x00"_ba) && client.pongs < max) {
+                ++client.pongs;
+                client.sock.write("\x8a\x80\x00\x00\x00\x00"_ba);
+            }
+        });
+        client.sock.connectToHost(u"127.0.0.1"_s, KeepAlivePort);
+        QTRY_COMPARE(client.sock.state(), QAbstractSocket::ConnectedState);
+        client.sock.write("GET /ws HTTP/1.1\r\n"
+                          "Host: localhost\r\n"
+                          "Upgrade: websocket\r\n"
+                          "Connection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                          "Sec-WebSocket-Version: 13\r\n\r\n");
+        QTRY_VERIFY(client.reply.contains("\r\n\r\n"));
+        QVERIFY(client.reply.startsWith("HTTP/1.1 101 Switching Protocols\r\n"));
+    }
+
+    // Close frames with code 1001 (Going Away)
+    QTRY_VERIFY_WITH_TIMEOUT(clients[1].reply.endsWith("\x88\x0e\x03\xe9Ping timeout"_ba), 8000);
+    QTRY_VERIFY_WITH_TIMEOUT(clients[0].reply.endsWith("\x88\x0e\x03\xe9Idle timeout"_ba), 8000);
+    QCOMPARE(clients[1].pongs, 1);
+    QVERIFY(clients[0].pongs >= 1);
+
+    const QVariantMap counters = server.counters();
+    QVERIFY(counters.value(u"websocket_keepalive_pings"_s).toULongLong() >= 3);
+    QCOMPARE(counters.value(u"websocket_pong_timeouts"_s).toULongLong(), quint64(1));
+    QCOMPARE(counters.value(u"websocket_idle_closes"_s).toULongLong(), quint64(1));
+
+    QSignalSpy stopped(&server, &Server::stopped);
+    server.stop();
+    QVERIFY(stopped.wait());
+}
+
+void TestServerProtocols::testFastCgiGetValues()
+{
+    const QByteArray query = fcgiPairs({
+        {"FCGI_MAX_CONNS"_ba, {}},
+        {"FCGI_MAX_REQS"_ba, {}},
+        {"FCGI_MPXS_CONNS"_ba, {}},
+        {"FCGI_UNKNOWN"_ba, {}},
+    });
+    const QByteArray reply = request(FastCgiPort,
+                                     fcgiRecord(FcgiGetValues, 0, query),
+                                     [](const QByteArray &data) {
+        return !fcgiParseRecords(data).isEmpty();
+    });
+
+    const QList<FcgiClientRecord> records = fcgiParseRecords(reply);
+    QCOMPARE(records.size(), 1);
+    QCOMPARE(records[0].type, FcgiGetValuesResult);
+    QCOMPARE(records[0].requestId, quint16(0));
+
+    QMap<QByteArray, QByteArray> values;
+    const QByteArray &content = records[0].content;
+    for (qsizetype pos = 0; pos + 2 <= content.size();) {
+        const int nameLen  = quint8(content[pos]);
+        const int valueLen = quint8(content[pos + 1]);
+        values.insert(content.mid(pos + 2, nameLen), content.mid(pos + 2 + nameLen, valueLen));
+        pos += 2 + nameLen + valueLen;
+    }
+
+    QCOMPARE(values.size(), 3);
+    QVERIFY(values.value("FCGI_MAX_CONNS"_ba).toUInt() > 0);
+    QCOMPARE(values.value("FCGI_MAX_REQS"_ba), "2"_ba);
+    QCOMPARE(values.value("FCGI_MPXS_CONNS"_ba), "1"_ba);
+}
+
+void TestServerProtocols::testFastCgiMultiplexing()
+{
+    QTcpSocket sock;
+    QByteArray reply;
+    connect(&sock, &QTcpSocket::readyRead, this, [&] { reply.append(sock.readAll()); });
+    sock.connectToHost(u"127.0.0.1"_s, FastCgiPort);
+    QTRY_COMPARE(sock.state(), QAbstractSocket::ConnectedState);
+
+    const QVariantMap counters = m_server->counters();
+    const quint64 multiplexed  = counters.value(u"fastcgi_multiplexed_requests"_s).toULongLong();
+    const quint64 rejected     = counters.value(u"fastcgi_rejected_requests"_s).toULongLong();
+
+    // FCGI_RESPONDER role with FCGI_KEEP_CONN
+    const QByteArray begin("\x00\x01\x01\x00\x00\x00\x00\x00", 8);
+    const QByteArray params1 = fcgiPairs({
+        {"REQUEST_METHOD"_ba, "POST"_ba},
+        {"REQUEST_URI"_ba, "/fcgi?id=one"_ba},
+        {"SERVER_PROTOCOL"_ba, "HTTP/1.1"_ba},
+        {"CONTENT_LENGTH"_ba, "5"_ba},
+    });
+    const QByteArray params2 = fcgiPairs({
+        {"REQUEST_METHOD"_ba, "POST"_ba},
+        {"REQUEST_URI"_ba, "/fcgi?id=two"_ba},
+        {"SERVER_PROTOCOL"_ba, "HTTP/1.1"_ba},
+        {"CONTENT_LENGTH"_ba, "3"_ba},
+    });
+
+    QByteArray data;
+    data.append(fcgiRecord(FcgiBeginRequest, 1, begin));
+    data.append(fcgiRecord(FcgiBeginRequest, 2, begin));
+    // A name-value pair of the first request is split across records
+    data.append(fcgiRecord(FcgiParams, 1, params1.left(10)));
+    data.append(fcgiRecord(FcgiParams, 2, params2));
+    data.append(fcgiRecord(FcgiParams, 1, params1.mid(10)));
+    // Above FCGI_MAX_REQS
+    data.append(fcgiRecord(FcgiBeginRequest, 3, begin));
+    data.append(fcgiRecord(FcgiParams, 2, {}));
+    data.append(fcgiRecord(FcgiParams, 1, {}));
+    data.append(fcgiRecord(FcgiStdin, 1, "hel"_ba));
+    data.append(fcgiRecord(FcgiStdin, 2, "abc"_ba));
+    data.append(fcgiRecord(FcgiStdin, 1, "lo"_ba));
+    data.append(fcgiRecord(FcgiStdin, 2, {}));
+    data.append(fcgiRecord(FcgiStdin, 1, {}));
+
+    // Records cut in the middle must wait for the rest
+    sock.write(data.left(data.size() / 2 + 3));
+    QTest::qWait(50);
+    sock.write(data.mid(data.size() / 2 + 3));
+
+    QList<quint16> ended;
+    QMap<quint16, QByteArray> output;
+    QMap<quint16, quint8> protocolStatus;
+    auto allEnded = [&] {
+        ended.clear();
+        output.clear();
+        for (const auto &record : fcgiParseRecords(reply)) {
+            if (record.type == FcgiStdout) {
+                output[record.requestId].append(record.content);
+            } else if (record.type == FcgiEndRequest) {
+                ended.append(record.requestId);
+                protocolStatus[record.requestId] = quint8(record.content.at(4));
+            }
+        }
+        return ended.size() == 3;
+    };
+    QTRY_VERIFY(allEnded());
+
+    // The rejected request is answered at once, the others as they complete
+    QCOMPARE(ended, (QList<quint16>{3, 2, 1}));
+    QCOMPARE(protocolStatus.value(3), FcgiOverloaded);
+    QCOMPARE(protocolStatus.value(2), FcgiRequestComplete);
+    QCOMPARE(protocolStatus.value(1), FcgiRequestComplete);
+    QVERIFY(output.value(1).startsWith("Status: 200\r\n"));
+    QVERIFY(output.value(1).endsWith("\r\n\r\none:hello"));
+    QVERIFY(output.value(2).endsWith("\r\n\r\ntwo:abc"));
+    QVERIFY(!output.contains(3));
+
+    // FCGI_KEEP_CONN keeps the connection open
+    QTest::qWait(50);
+    QCOMPARE(sock.state(), QAbstractSocket::ConnectedState);
+
+    const QVariantMap nowCounters = m_server->counters();
+    QCOMPARE(nowCounters.value(u"fastcgi_multiplexed_requests"_s).toULongLong() - multiplexed,
+             quint64(1));
+    QCOMPARE(nowCounters.value(u"fastcgi_rejected_requests"_s).toULongLong() - rejected,
+             quint64(1));
+}
+
+void TestServerProtocols::testUwsgi()
+{
+    QTcpSocket sock;
+    QByteArray reply;
+    connect(&sock, &QTcpSocket::readyRead, this, [&] { reply.append(sock.readAll()); });
+    sock.connectToHost(u"127.0.0.1"_s, UwsgiPort);
+    QTRY_COMPARE(sock.state(), QAbstractSocket::ConnectedState);
+
+    const QByteArray data = uwsgiPacket({
+        {"REQUEST_METHOD"_ba, "POST"_ba},
+        {"REQUEST_URI"_ba, "/fcgi?id=uwsgi"_ba},
+        {"SERVER_PROTOCOL"_ba, "HTTP/1.1"_ba},
+        {"CONTENT_LENGTH"_ba, "11"_ba},
+        {"HTTP_HOST"_ba, "example.com"_ba},
+    });
+
+    // The vars block is cut in the middle and the body arrives in two parts
+    sock.write(data.left(data.size() / 2));
+    QTest::qWait(50);
+    sock.write(data.mid(data.size() / 2) + "hello"_ba);
+    QTest::qWait(50);
+    sock.write(" world"_ba);
+
+    // The response ends when the server closes the connection
+    QTRY_COMPARE(sock.state(), QAbstractSocket::UnconnectedState);
+    reply.append(sock.readAll());
+    QVERIFY(reply.startsWith("HTTP/1.1 200 OK\r\n"));
+    QVERIFY(reply.endsWith("\r\n\r\nuwsgi:hello world"));
+}
+
+void TestServerProtocols::testProxyProtocol_data()
+{
+    QTest::addColumn<QByteArray>("header");
+    QTest::addColumn<QByteArray>("peer");
+
+    QTest::addRow("v1-tcp4") << "PROXY TCP4 192.0.2.1 192.0.2.2 4242 80\r\n"_ba
+                             << "192.0.2.1 4242"_ba;
+    QTest::addRow("v1-tcp6") << "PROXY TCP6 2001:db8::1 2001:db8::2 4243 443\r\n"_ba
+                             << "2001:db8::1 4243"_ba;
+
+    // Signature, PROXY command, TCP over IPv4, 12 address bytes and a 3 bytes TLV
+    QByteArray v2("\r\n\r\n\0\r\nQUIT\n\x21\x11\x00\x0f", 16);
+    v2.append("\xc6\x33\x64\x07\xc0\x00\x02\x02\x10\x92\x00\x50", 12);
+    v2.append("\x04\x00\x00", 3);
+    QTest::addRow("v2-tcp4") << v2 << "198.51.100.7 4242"_ba;
+
+    // Health checks keep the address of the balancer itself
+    QTest::addRow("v1-unknown") << "PROXY UNKNOWN\r\n"_ba << "127.0.0.1 "_ba;
+    QTest::addRow("v2-local") << QByteArray("\r\n\r\n\0\r\nQUIT\n\x20\x00\x00\x00", 16)
+                              << "127.0.0.1 "_ba;
+
+    QTest::addRow("missing") << QByteArray{} << QByteArray{};
+    QTest::addRow("invalid") << "PROXY TCP4 not-an-address 192.0.2.2 4242 80\r\n"_ba
+                             << QByteArray{};
+}
+
+void TestServerProtocols::testProxyProtocol()
+{
+    QFETCH(QByteArray, header);
+    QFETCH(QByteArray, peer);
+
+    QTcpSocket sock;
+    QByteArray reply;
+    connect(&sock, &QTcpSocket::readyRead, this, [&] { reply.append(sock.readAll()); });
+    sock.connectToHost(u"127.0.0.1"_s, ProxyPort);
+    QTRY_COMPARE(sock.state(), QAbstractSocket::ConnectedState);
+
+    // The header may arrive apart from the request it precedes
+    sock.write(header.left(10));
+    QTest::qWait(50);
+    sock.write(header.mid(10) + "GET /peer HTTP/1.1\r\nHost: example.com\r\n\r\n"_ba);
+
+    if (peer.isEmpty()) {
+        QTRY_COMPARE(sock.state(), QAbstractSocket::UnconnectedState);
+        QVERIFY(reply.isEmpty());
+        return;
+    }
+
+    QTRY_VERIFY(reply.contains("\r\n\r\n" + peer));
+    QVERIFY(reply.startsWith("HTTP/1.1 200 OK\r\n"));
+}
+
+void TestServerProtocols::testProxyProtocolSplitHeader()
+{
+    QTcpSocket sock;
+    QByteArray reply;
+    connect(&sock, &QTcpSocket::readyRead, this, [&] { reply.append(sock.readAll()); });
+    sock.connectToHost(u"127.0.0.1"_s, ProxyPort);
+    QTRY_COMPARE(sock.state(), QAbstractSocket::ConnectedState);
+
+    sock.write("PROXY TCP4 192.0.2.1 ");
+    QVERIFY(sock.waitForBytesWritten());
+
+    // The server shares this thread, it must sleep while waiting for the rest of the header
+    const std::clock_t cpu = std::clock();
+    QTest::qWait(300);
+    QCOMPARE_LT(std::clock() - cpu, CLOCKS_PER_SEC / 10);
+    QCOMPARE(sock.state(), QAbstractSocket::ConnectedState);
+
+    sock.write("192.0.2.2 4242 80\r\nGET /peer HTTP/1.1\r\nHost: example.com\r\n\r\n");
+    QTRY_VERIFY(reply.contains("\r\n\r\n192.0.2.1 4242"));
+    QVERIFY(reply.startsWith("HTTP/1.1 200 OK\r\n"));
+}
+
+QTEST_MAIN(TestServerProtocols)
+
+#include "testserverprotocols.moc"
+
+#endif // TESTSERVERPROTOCOLS_H
@@ -0,0 +1,156 @@
+#ifndef TESTSLOWREQUEST_H
+#define TESTSLOWREQUEST_H
+
+#include "coverageobject.h"
+#include "serverprocess.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QThread>
+
+namespace {
+constexpr int LogSlow = 100;
+
+// Where the server process writes the messages of the slow request category
+QString logPath;
+QtMessageHandler previousHandler = nullptr;
+
+void slowRequestHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+    if (qstrcmp(context.category, "cutelyst.server.slow") != 0) {
+        previousHandler(type, context, msg);
+        return;
+    }
+
+    QFile file(logPath);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        file.write(msg.toUtf8().append('\n'));
+    }
+}
+} // namespace
+
+class SlowRequestController : public Controller
+{
+    Q_OBJECT
+    C_NAMESPACE("")
+public:
+    explicit SlowRequestController(QObject *parent)
+        : Controller(parent)
+    {
+    }
+
+    C_ATTR(fast, :Local :AutoArgs)
+    void fast(Context *c) { c->response()->setBody("fast"_ba); }
+
+    C_ATTR(slow, :Local :AutoArgs)
+    void slow(Context *c)
+    {
+        QThread::msleep(LogSlow * 3);
+        c->response()->setBody("slow"_ba);
+    }
+};
+
+class SlowRequestApplication : public Application
+{
+    Q_OBJECT
+public:
+    explicit SlowRequestApplication(QObject *parent = nullptr)
+        : Application(parent)
+    {
+    }
+
+    bool init() override
+    {
+        new SlowRequestController(this);
+        return true;
+    }
+};
+
+class TestSlowRequest : public CoverageObject
+{
+    Q_OBJECT
+public:
+    explicit TestSlowRequest(QObject *parent = nullptr)
+        : CoverageObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void testFastRequest();
+    void testSlowRequest();
+    void cleanupTestCase();
+
+private:
+    QByteArrayList lines() const;
+
+    QTemporaryDir m_dir;
+    ServerProcess m_server;
+};
+
+void TestSlowRequest::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    logPath = m_dir.filePath(u"slow.log"_s);
+
+    QVERIFY(m_server.start(
+        [](Server *server) {
+            // Inherited by the worker processes
+            previousHandler = qInstallMessageHandler(slowRequestHandler);
+            server->setProcesses(u"1"_s);
+            server->setLogSlow(LogSlow);
+        },
+        [](Server *server) { return new SlowRequestApplication(server); }));
+
+    QCOMPARE(m_server.waitForWorkers(1).size(), 1);
+}
+
+void TestSlowRequest::testFastRequest()
+{
+    for (int i = 0; i < 10; ++i) {
+        QCOMPARE(m_server.get("/fast"), "fast"_ba);
+    }
+    QVERIFY(lines().isEmpty());
+}
+
+void TestSlowRequest::testSlowRequest()
+{
+    QCOMPARE(m_server.get("/slow"), "slow"_ba);
+
+    // Logged once the response is finished, which is before the connection is closed
+    QTRY_COMPARE(lines().size(), 1);
+    const QByteArray line = lines().constFirst();
+    QVERIFY2(line.startsWith("Slow request GET /slow kept its thread busy for "),
+             line.constData());
+    QVERIFY2(line.contains(", mostly in handleRequest (handleRequest "), line.constData());
+    // Stats aren't collected just for the log, so there are no actions to list
+    QVERIFY2(line.endsWith(" before dispatch)"), line.constData());
+
+    const qsizetype start = line.indexOf("busy for ") + 9;
+    const double busy     = line.mid(start, line.indexOf("ms,", start) - start).toDouble();
+    QVERIFY2(busy >= LogSlow * 3, line.constData());
+}
+
+void TestSlowRequest::cleanupTestCase()
+{
+    m_server.stop();
+}
+
+QByteArrayList TestSlowRequest::lines() const
+{
+    QFile file(logPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    QByteArrayList ret = file.readAll().split('\n');
+    ret.removeAll(QByteArray{});
+    return ret;
+}
+
+QTEST_MAIN(TestSlowRequest)
+
+#include "testslowrequest.moc"
+
+#endif // TESTSLOWREQUEST_H
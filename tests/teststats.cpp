@@ -0,0 +1,221 @@
+#ifndef STATSTEST_H
+#define STATSTEST_H
+
+#include "coverageobject.h"
+
+#include <Cutelyst/application.h>
+#include <Cutelyst/controller.h>
+#include <Cutelyst/headers.h>
+#include <Cutelyst/stats.h>
+#include <Cutelyst/view.h>
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QObject>
+#include <QTest>
+
+using namespace Cutelyst;
+using namespace Qt::Literals::StringLiterals;
+
+class TestStats : public CoverageObject
+{
+    Q_OBJECT
+public:
+    explicit TestStats(QObject *parent = nullptr)
+        : CoverageObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testServerTiming();
+    void testDurations();
+    void testTraceParent();
+    void testTraceParentNotSampled();
+    void testInvalidTraceParent();
+
+    void cleanupTestCase();
+
+private:
+    TestEngine *m_engine = nullptr;
+    QJsonArray m_spans;
+    QByteArray m_traceParent;
+    qint64 m_duration          = 0;
+    qint64 m_viewDuration      = 0;
+    qint64 m_executionDuration = 0;
+    int m_traced               = 0;
+
+    TestEngine *getEngine();
+};
+
+class StatsView : public View
+{
+    Q_OBJECT
+public:
+    explicit StatsView(QObject *parent)
+        : View(parent, {})
+    {
+    }
+
+    QByteArray render(Context *) const override { return "rendered"_ba; }
+};
+
+class StatsTest : public Controller
+{
+    Q_OBJECT
+public:
+    explicit StatsTest(QObject *parent)
+        : Controller(parent)
+    {
+    }
+
+    C_ATTR(hello, :Local :AutoArgs)
+    void hello(Context *c) { c->response()->setContentType("text/plain"_ba); }
+
+private:
+    C_ATTR(Begin,)
+    bool Begin(Context *) { return true; }
+
+    C_ATTR(Auto,)
+    bool Auto(Context *) { return true; }
+
+    C_ATTR(End,)
+    bool End(Context *c) { return c->forward(c->view()); }
+};
+
+void TestStats::initTestCase()
+{
+    m_engine = getEngine();
+    QVERIFY(m_engine);
+}
+
+TestEngine *TestStats::getEngine()
+{
+    auto app    = new TestApplication;
+    auto engine = new TestEngine(app, QVariantMap());
+    engine->setConfig({
+        {u"Cutelyst"_s,
+         QVariantMap{
+             {u"trace_sample_rate"_s, 1.0},
+             {u"server_timing"_s, true},
+         }},
+    });
+    new StatsTest(app);
+    new StatsView(app);
+    if (!engine->init()) {
+        return nullptr;
+    }
+
+    connect(app, &Application::requestTraced, this, [this](Context *, const Stats *stats) {
+        ++m_traced;
+        m_spans             = stats->toOtlpSpans(u"GET /stats/test/hello"_s);
+        m_traceParent       = stats->traceParent();
+        m_duration          = stats->duration();
+        m_viewDuration      = stats->duration(Stats::SpanKind::View);
+        m_executionDuration = stats->executionDuration();
+    });
+
+    return engine;
+}
+
+void TestStats::testServerTiming()
+{
+    auto result = m_engine->createRequest("GET"_ba, u"/stats/test/hello"_s, {}, {}, nullptr);
+
+    QCOMPARE(result.statusCode, 200);
+    QCOMPARE(result.body, "rendered"_ba);
+
+    const QByteArray serverTiming = result.headers.header("Server-Timing");
+    QVERIFY(serverTiming.startsWith(R"(begin;desc="/stats/test/Begin";dur=)"));
+    QVERIFY(serverTiming.contains(R"(auto;desc="/stats/test/Auto";dur=)"));
+    QVERIFY(serverTiming.contains(R"(action;desc="/stats/test/hello";dur=)"));
+    QVERIFY(serverTiming.contains(R"(end;desc="/stats/test/End";dur=)"));
+    QVERIFY(serverTiming.contains(R"(view;desc="StatsView";dur=)"));
+    QVERIFY(serverTiming.contains(", total;dur="));
+}
+
+void TestStats::testDurations()
+{
+    auto result = m_engine->createRequest("GET"_ba, u"/stats/test/hello"_s, {}, {}, nullptr);
+
+    QCOMPARE(result.statusCode, 200);
+    QVERIFY(m_viewDuration > 0);
+    // The view is rendered by End, only top level spans are summed
+    QVERIFY(m_executionDuration >= m_viewDuration);
+    QVERIFY(m_duration >= m_executionDuration);
+}
+
+void TestStats::testTraceParent()
+{
+    m_traced = 0;
+
+    Headers headers;
+    headers.setHeader("traceparent"_ba,
+                      "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-01"_ba);
+    auto result = m_engine->createRequest("GET"_ba, u"/stats/test/hello"_s, {}, headers, nullptr);
+
+    QCOMPARE(result.statusCode, 200);
+    QCOMPARE(m_traced, 1);
+    QVERIFY(m_traceParent.startsWith("00-0af7651916cd43dd8448eb211c80319c-"));
+    QVERIFY(m_traceParent.endsWith("-01"));
+
+    // The request span is a child of the caller, actions are children of the request
+    const QJsonObject root = m_spans.first().toObject();
+    QCOMPARE(root[u"traceId"_s].toString(), u"0af7651916cd43dd8448eb211c80319c"_s);
+    QCOMPARE(root[u"parentSpanId"_s].toString(), u"b7ad6b7169203331"_s);
+    QCOMPARE(root[u"name"_s].toString(), u"GET /stats/test/hello"_s);
+
+    QHash<QString, QJsonObject> spans;
+    for (const auto &value : std::as_const(m_spans)) {
+        const QJsonObject span = value.toObject();
+        QCOMPARE(span[u"traceId"_s], root[u"traceId"_s]);
+        QVERIFY(span[u"startTimeUnixNano"_s].toString().toLongLong() <=
+                span[u"endTimeUnixNano"_s].toString().toLongLong());
+        spans.insert(span[u"name"_s].toString(), span);
+    }
+    QCOMPARE(spans[u"/stats/test/hello"_s][u"parentSpanId"_s], root[u"spanId"_s]);
+    QCOMPARE(spans[u"StatsView"_s][u"parentSpanId"_s],
+             spans[u"/stats/test/End"_s][u"spanId"_s]);
+}
+
+void TestStats::testTraceParentNotSampled()
+{
+    m_traced = 0;
+
+    Headers headers;
+    headers.setHeader("traceparent"_ba,
+                      "00-0af7651916cd43dd8448eb211c80319c-b7ad6b7169203331-00"_ba);
+    auto result = m_engine->createRequest("GET"_ba, u"/stats/test/hello"_s, {}, headers, nullptr);
+
+    QCOMPARE(result.statusCode, 200);
+    QCOMPARE(m_traced, 0);
+    QVERIFY(!result.headers.contains("Server-Timing"));
+}
+
+void TestStats::testInvalidTraceParent()
+{
+    m_traced = 0;
+
+    // An invalid header starts a new trace sampled by the configured rate
+    Headers headers;
+    headers.setHeader("traceparent"_ba,
+                      "00-00000000000000000000000000000000-b7ad6b7169203331-00"_ba);
+    auto result = m_engine->createRequest("GET"_ba, u"/stats/test/hello"_s, {}, headers, nullptr);
+
+    QCOMPARE(result.statusCode, 200);
+    QCOMPARE(m_traced, 1);
+    QVERIFY(!m_traceParent.contains("-00000000000000000000000000000000-"));
+    QVERIFY(!m_spans.first().toObject().contains(u"parentSpanId"_s));
+}
+
+void TestStats::cleanupTestCase()
+{
+    delete m_engine;
+}
+
+QTEST_MAIN(TestStats)
+
+#include "teststats.moc"
+
+#endif
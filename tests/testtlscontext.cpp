@@ -0,0 +1,186 @@
+#ifndef TESTTLSCONTEXT_H
+#define TESTTLSCONTEXT_H
+
+#include "coverageobject.h"
+#include "tlscontext.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <memory>
+#include <thread>
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#ifdef Q_OS_LINUX
+#    include <arpa/inet.h>
+#    include <netinet/in.h>
+#    include <sys/socket.h>
+#    include <unistd.h>
+#endif
+
+using namespace Cutelyst;
+
+class TestTlsContext : public CoverageObject
+{
+    Q_OBJECT
+public:
+    explicit TestTlsContext(QObject *parent = nullptr)
+        : CoverageObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void testInvalidFiles();
+    void testKtlsLoopback_data();
+    void testKtlsLoopback();
+
+private:
+    QTemporaryDir m_dir;
+    QString m_certPath;
+    QString m_keyPath;
+};
+
+void TestTlsContext::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    m_certPath = m_dir.filePath(u"cert.pem"_s);
+    m_keyPath  = m_dir.filePath(u"key.pem"_s);
+
+    EVP_PKEY *key = EVP_EC_gen("P-256");
+    QVERIFY(key);
+
+    X509 *cert = X509_new();
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME *name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(
+        name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    QVERIFY(X509_sign(cert, key, EVP_sha256()) > 0);
+
+    BIO *certBio = BIO_new_file(m_certPath.toLocal8Bit().constData(), "w");
+    BIO *keyBio  = BIO_new_file(m_keyPath.toLocal8Bit().constData(), "w");
+    QVERIFY(PEM_write_bio_X509(certBio, cert));
+    QVERIFY(PEM_write_bio_PrivateKey(keyBio, key, nullptr, nullptr, 0, nullptr, nullptr));
+    BIO_free(certBio);
+    BIO_free(keyBio);
+    X509_free(cert);
+    EVP_PKEY_free(key);
+}
+
+void TestTlsContext::testInvalidFiles()
+{
+    QString error;
+    std::unique_ptr<TlsContext> ctx(
+        TlsContext::create(m_dir.filePath(u"missing.pem"_s), m_keyPath, &error));
+    QVERIFY(!ctx);
+    QVERIFY(error.contains(u"missing.pem"_s));
+
+    // The certificate isn't a key
+    ctx.reset(TlsContext::create(m_certPath, m_certPath, &error));
+    QVERIFY(!ctx);
+
+    ctx.reset(TlsContext::create(m_certPath, m_keyPath, &error));
+    QVERIFY(ctx);
+}
+
+void TestTlsContext::testKtlsLoopback_data()
+{
+    QTest::addColumn<int>("version");
+
+    QTest::addRow("tls1.2") << TLS1_2_VERSION;
+    QTest::addRow("tls1.3") << TLS1_3_VERSION;
+}
+
+void TestTlsContext::testKtlsLoopback()
+{
+#ifdef Q_OS_LINUX
+    QFETCH(int, version);
+
+    QString error;
+    std::unique_ptr<TlsContext> ctx(TlsContext::create(m_certPath, m_keyPath, &error));
+    QVERIFY2(ctx, qPrintable(error));
+    ctx->setKtls(true);
+    SSL_CTX_set_max_proto_version(ctx->handle(), version);
+
+    // The kernel only offloads TCP sockets
+    const int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen    = sizeof(addr);
+    QVERIFY(bind(listener, reinterpret_cast<sockaddr *>(&addr), addrLen) == 0);
+    QVERIFY(listen(listener, 1) == 0);
+    QVERIFY(getsockname(listener, reinterpret_cast<sockaddr *>(&addr), &addrLen) == 0);
+
+    const int clientFd = socket(AF_INET, SOCK_STREAM, 0);
+    QVERIFY(::connect(clientFd, reinterpret_cast<sockaddr *>(&addr), addrLen) == 0);
+    const int serverFd = accept(listener, nullptr, nullptr);
+    QVERIFY(serverFd != -1);
+    close(listener);
+
+    const QByteArray payload(256 * 1024, 'k');
+    QByteArray received;
+    std::thread client([clientFd, &received, size = payload.size()] {
+        SSL_CTX *clientCtx = SSL_CTX_new(TLS_client_method());
+        SSL *ssl           = SSL_new(clientCtx);
+        SSL_set_fd(ssl, clientFd);
+        if (SSL_connect(ssl) == 1) {
+            char buf[16 * 1024];
+            int len;
+            while (received.size() < size && (len = SSL_read(ssl, buf, sizeof(buf))) > 0) {
+                received.append(buf, len);
+            }
+            SSL_write(ssl, "done", 4);
+        }
+        SSL_free(ssl);
+        SSL_CTX_free(clientCtx);
+    });
+
+    SSL *ssl = SSL_new(ctx->handle());
+    SSL_set_fd(ssl, serverFd);
+    const bool accepted = SSL_accept(ssl) == 1;
+    const auto state    = TlsContext::ktlsState(ssl);
+
+    qint64 written = 0;
+    while (accepted && written < payload.size()) {
+        const int len =
+            SSL_write(ssl, payload.constData() + written, int(payload.size() - written));
+        if (len <= 0) {
+            break;
+        }
+        written += len;
+    }
+    char ack[4];
+    const bool acked = SSL_read(ssl, ack, sizeof(ack)) == 4;
+
+    client.join();
+    SSL_free(ssl);
+    close(serverFd);
+    close(clientFd);
+
+    // Whether offloaded or not the client must see the same stream
+    QVERIFY(accepted);
+    QVERIFY(acked);
+    QCOMPARE(received, payload);
+
+    if (!state.testFlag(TlsContext::KtlsSend)) {
+        QSKIP("Kernel TLS is not available, the connection fell back to userspace TLS");
+    }
+#else
+    QSKIP("Kernel TLS is only available on Linux");
+#endif
+}
+
+QTEST_MAIN(TestTlsContext)
+
+#include "testtlscontext.moc"
+
+#endif // TESTTLSCONTEXT_H
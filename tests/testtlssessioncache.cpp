@@ -0,0 +1,213 @@
+#ifndef TESTTLSSESSIONCACHE_H
+#define TESTTLSSESSIONCACHE_H
+
+#include "coverageobject.h"
+#include "tlssessioncache.h"
+
+#include <QTest>
+
+#include <memory>
+
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+using namespace Cutelyst;
+
+namespace {
+struct SslCtxDeleter {
+    void operator()(SSL_CTX *ctx) const { SSL_CTX_free(ctx); }
+};
+using SslCtxPtr = std::unique_ptr<SSL_CTX, SslCtxDeleter>;
+
+struct SslSessionDeleter {
+    void operator()(SSL_SESSION *session) const { SSL_SESSION_free(session); }
+};
+using SslSessionPtr = std::unique_ptr<SSL_SESSION, SslSessionDeleter>;
+} // namespace
+
+class TestTlsSessionCache : public CoverageObject
+{
+    Q_OBJECT
+public:
+    explicit TestTlsSessionCache(QObject *parent = nullptr)
+        : CoverageObject(parent)
+    {
+    }
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testResumption_data();
+    void testResumption();
+    void testForeignTicket();
+
+private:
+    // Each context plays a worker, in production they live in different processes
+    SslCtxPtr serverContext(TlsSessionCache *cache, int version, bool tickets) const;
+    static SslCtxPtr clientContext(int version);
+    static bool handshake(SSL_CTX *serverCtx,
+                          SSL_CTX *clientCtx,
+                          SSL_SESSION *resume,
+                          SslSessionPtr &session,
+                          bool &reused);
+
+    EVP_PKEY *m_key = nullptr;
+    X509 *m_cert    = nullptr;
+};
+
+void TestTlsSessionCache::initTestCase()
+{
+    m_key = EVP_EC_gen("P-256");
+    QVERIFY(m_key);
+
+    m_cert = X509_new();
+    ASN1_INTEGER_set(X509_get_serialNumber(m_cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(m_cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(m_cert), 3600);
+    X509_set_pubkey(m_cert, m_key);
+    X509_NAME *name = X509_get_subject_name(m_cert);
+    X509_NAME_add_entry_by_txt(
+        name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(m_cert, name);
+    QVERIFY(X509_sign(m_cert, m_key, EVP_sha256()) > 0);
+}
+
+void TestTlsSessionCache::cleanupTestCase()
+{
+    X509_free(m_cert);
+    EVP_PKEY_free(m_key);
+}
+
+SslCtxPtr
+    TestTlsSessionCache::serverContext(TlsSessionCache *cache, int version, bool tickets) const
+{
+    SslCtxPtr ctx(SSL_CTX_new(TLS_server_method()));
+    SSL_CTX_set_min_proto_version(ctx.get(), version);
+    SSL_CTX_set_max_proto_version(ctx.get(), version);
+    SSL_CTX_use_certificate(ctx.get(), m_cert);
+    SSL_CTX_use_PrivateKey(ctx.get(), m_key);
+    if (!tickets) {
+        SSL_CTX_set_options(ctx.get(), SSL_OP_NO_TICKET);
+    }
+    cache->install(ctx.get());
+    return ctx;
+}
+
+SslCtxPtr TestTlsSessionCache::clientContext(int version)
+{
+    SslCtxPtr ctx(SSL_CTX_new(TLS_client_method()));
+    SSL_CTX_set_min_proto_version(ctx.get(), version);
+    SSL_CTX_set_max_proto_version(ctx.get(), version);
+    SSL_CTX_set_verify(ctx.get(), SSL_VERIFY_NONE, nullptr);
+    return ctx;
+}
+
+bool TestTlsSessionCache::handshake(SSL_CTX *serverCtx,
+                                    SSL_CTX *clientCtx,
+                                    SSL_SESSION *resume,
+                                    SslSessionPtr &session,
+                                    bool &reused)
+{
+    SSL *server = SSL_new(serverCtx);
+    SSL *client = SSL_new(clientCtx);
+    BIO *serverBio;
+    BIO *clientBio;
+    BIO_new_bio_pair(&serverBio, 0, &clientBio, 0);
+    SSL_set_bio(server, serverBio, serverBio);
+    SSL_set_bio(client, clientBio, clientBio);
+    SSL_set_accept_state(server);
+    SSL_set_connect_state(client);
+    if (resume) {
+        SSL_set_session(client, resume);
+    }
+
+    bool ok = false;
+    for (int i = 0; i < 10 && !ok; ++i) {
+        const int clientRet = SSL_do_handshake(client);
+        const int serverRet = SSL_do_handshake(server);
+        ok                  = clientRet == 1 && serverRet == 1;
+    }
+
+    if (ok) {
+        // TLS 1.3 tickets arrive after the handshake, along with the first data
+        char data = 'x';
+        ok        = SSL_write(server, &data, 1) == 1 && SSL_read(client, &data, 1) == 1;
+    }
+
+    reused = SSL_session_reused(client);
+    session.reset(SSL_get1_session(client));
+
+    // Sessions of connections closed without close_notify can't be resumed
+    SSL_shutdown(client);
+    SSL_shutdown(server);
+    SSL_free(client);
+    SSL_free(server);
+    return ok;
+}
+
+void TestTlsSessionCache::testResumption_data()
+{
+    QTest::addColumn<int>("version");
+    QTest::addColumn<bool>("tickets");
+
+    QTest::addRow("tls1.2-tickets") << TLS1_2_VERSION << true;
+    QTest::addRow("tls1.2-session-id") << TLS1_2_VERSION << false;
+    QTest::addRow("tls1.3-tickets") << TLS1_3_VERSION << true;
+    QTest::addRow("tls1.3-stateful") << TLS1_3_VERSION << false;
+}
+
+void TestTlsSessionCache::testResumption()
+{
+    QFETCH(int, version);
+    QFETCH(bool, tickets);
+
+    std::unique_ptr<TlsSessionCache> cache(TlsSessionCache::create(64, std::chrono::hours{1}));
+    QVERIFY(cache);
+
+    const SslCtxPtr worker1 = serverContext(cache.get(), version, tickets);
+    const SslCtxPtr worker2 = serverContext(cache.get(), version, tickets);
+    const SslCtxPtr client  = clientContext(version);
+
+    SslSessionPtr session;
+    bool reused;
+    QVERIFY(handshake(worker1.get(), client.get(), nullptr, session, reused));
+    QVERIFY(!reused);
+    QVERIFY(session);
+
+    // The client returns to another worker
+    SslSessionPtr resumed;
+    QVERIFY(handshake(worker2.get(), client.get(), session.get(), resumed, reused));
+    QVERIFY(reused);
+
+    QCOMPARE(cache->fullHandshakes(), quint64(1));
+    QCOMPARE(cache->resumedHandshakes(), quint64(1));
+}
+
+void TestTlsSessionCache::testForeignTicket()
+{
+    std::unique_ptr<TlsSessionCache> cache(TlsSessionCache::create(64, std::chrono::hours{1}));
+    std::unique_ptr<TlsSessionCache> other(TlsSessionCache::create(64, std::chrono::hours{1}));
+    QVERIFY(cache && other);
+
+    const SslCtxPtr worker = serverContext(cache.get(), TLS1_3_VERSION, true);
+    const SslCtxPtr stray  = serverContext(other.get(), TLS1_3_VERSION, true);
+    const SslCtxPtr client = clientContext(TLS1_3_VERSION);
+
+    SslSessionPtr session;
+    bool reused;
+    QVERIFY(handshake(worker.get(), client.get(), nullptr, session, reused));
+
+    // Tickets of a different key set can't be decrypted, a full handshake is done
+    SslSessionPtr fresh;
+    QVERIFY(handshake(stray.get(), client.get(), session.get(), fresh, reused));
+    QVERIFY(!reused);
+    QCOMPARE(other->fullHandshakes(), quint64(1));
+    QCOMPARE(other->resumedHandshakes(), quint64(0));
+}
+
+QTEST_MAIN(TestTlsSessionCache)
+
+#include "testtlssessioncache.moc"
+
+#endif // TESTTLSSESSIONCACHE_H